@@ -0,0 +1,121 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/*
+ * Minimal Arduino core for the host (Linux/macOS) build.
+ *
+ * Only what the communication and telemetry modules use is provided:
+ * String, Serial, millis()/micros()/delay()/yield() and min()/max().
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+class String {
+public:
+    String(const char* str = "");
+    String(const String& other);
+    explicit String(char c);
+    explicit String(int value);
+    explicit String(unsigned int value);
+    explicit String(long value);
+    explicit String(unsigned long value);
+    explicit String(float value, unsigned int decimalPlaces = 2);
+
+    String& operator=(const String& other);
+    String& operator=(const char* str);  // nullptr clears the string
+
+    bool concat(const String& other);
+    bool concat(const char* str);
+    bool concat(const char* str, unsigned int length);
+    bool concat(char c);
+
+    String& operator+=(const String& other);
+    String& operator+=(const char* str);
+    String& operator+=(char c);
+
+    bool operator==(const String& other) const;
+    bool operator==(const char* str) const;
+    bool operator!=(const String& other) const;
+    bool operator!=(const char* str) const;
+    char operator[](unsigned int index) const;
+
+    unsigned int length() const;
+    const char* c_str() const;
+    bool isEmpty() const;
+    bool reserve(unsigned int size);
+    bool startsWith(const String& prefix) const;
+    int indexOf(char c, unsigned int fromIndex = 0) const;
+    String substring(unsigned int beginIndex) const;
+    String substring(unsigned int beginIndex, unsigned int endIndex) const;
+    long toInt() const;
+    void trim();
+
+private:
+    std::string value;
+};
+
+// ArduinoJson's String adapter refers to this type by name
+class StringSumHelper : public String {
+public:
+    StringSumHelper(const String& str) : String(str) {}
+    StringSumHelper(const char* str) : String(str) {}
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+
+class HostSerial {
+public:
+    void begin(unsigned long baud);
+    void setQuiet(bool quiet);  // Host only - drop all output (for benchmarks)
+
+    int available();
+    int read();
+    void flush();
+
+    size_t print(const char* str);
+    size_t print(const String& str);
+    size_t print(char c);
+    size_t print(int value);
+    size_t print(unsigned int value);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    size_t println(const char* str);
+    size_t println(const String& str);
+    size_t println(char c);
+    size_t println(int value);
+    size_t println(unsigned int value);
+    size_t println(long value);
+    size_t println(unsigned long value);
+    size_t println(double value, int digits = 2);
+
+    size_t printf(const char* format, ...);
+
+    operator bool() const { return true; }
+
+private:
+    bool quiet = false;
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,463 @@
+#include "WebSocketsClient.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define WS_HOST_CONNECT_TIMEOUT_MS 5000
+#define WS_HOST_RECV_CHUNK 16384
+
+enum {
+    WS_OP_CONTINUATION = 0x0,
+    WS_OP_TEXT = 0x1,
+    WS_OP_BINARY = 0x2,
+    WS_OP_CLOSE = 0x8,
+    WS_OP_PING = 0x9,
+    WS_OP_PONG = 0xA
+};
+
+WebSocketsClient::WebSocketsClient() :
+    sock(-1),
+    connected(false),
+    port(0),
+    reconnectInterval(500),
+    lastConnectAttempt(0),
+    connectPending(false),
+    callback(nullptr),
+    pingInterval(0),
+    pongTimeout(0),
+    disconnectTimeoutCount(0),
+    lastPingSent(0),
+    awaitingPong(false),
+    missedPongs(0) {
+}
+
+WebSocketsClient::~WebSocketsClient() {
+    closeSocket(false);
+}
+
+void WebSocketsClient::begin(const char* host, uint16_t port, const char* url, const char* protocol) {
+    this->host = host;
+    this->port = port;
+    this->url = url;
+    this->protocol = protocol;
+    connectPending = true;  // First attempt happens on the next loop()
+}
+
+void WebSocketsClient::beginSSL(const char* host, uint16_t port, const char* url, const char*, const char* protocol) {
+    Serial.println("[WS_HOST] TLS is not available in the host build - connecting without it");
+    begin(host, port, url, protocol);
+}
+
+void WebSocketsClient::beginSslWithCA(const char* host, uint16_t port, const char* url, const char*, const char* protocol) {
+    beginSSL(host, port, url, "", protocol);
+}
+
+void WebSocketsClient::onEvent(WebSocketClientEvent cbEvent) {
+    callback = cbEvent;
+}
+
+void WebSocketsClient::setReconnectInterval(unsigned long time) {
+    reconnectInterval = time;
+}
+
+void WebSocketsClient::enableHeartbeat(uint32_t interval, uint32_t timeout, uint8_t count) {
+    pingInterval = interval;
+    pongTimeout = timeout;
+    disconnectTimeoutCount = count;
+}
+
+void WebSocketsClient::disableHeartbeat() {
+    pingInterval = 0;
+}
+
+bool WebSocketsClient::isConnected() {
+    return connected;
+}
+
+void WebSocketsClient::loop() {
+    if (!connected) {
+        if (host.isEmpty()) {
+            return;
+        }
+        // Like the device library: retry on its own every reconnectInterval
+        if (connectPending || millis() - lastConnectAttempt >= reconnectInterval) {
+            connectPending = false;
+            lastConnectAttempt = millis();
+            connectNow();
+        }
+        return;
+    }
+
+    pumpReceive();
+    if (connected) {
+        runHeartbeat();
+    }
+}
+
+void WebSocketsClient::disconnect() {
+    if (connected) {
+        uint8_t code[2] = { 0x03, 0xE8 };  // 1000 normal closure
+        sendFrame(WS_OP_CLOSE, code, sizeof(code));
+    }
+    closeSocket(true);
+}
+
+bool WebSocketsClient::sendTXT(uint8_t* payload, size_t length, bool headerToPayload) {
+    if (headerToPayload) {
+        return sendFrame(WS_OP_TEXT, payload + WEBSOCKETS_MAX_HEADER_SIZE, length);
+    }
+    return sendTXT((const uint8_t*)payload, length);
+}
+
+bool WebSocketsClient::sendTXT(const uint8_t* payload, size_t length) {
+    if (length == 0) {
+        length = strlen((const char*)payload);
+    }
+    return sendFrame(WS_OP_TEXT, payload, length);
+}
+
+bool WebSocketsClient::sendTXT(char* payload, size_t length, bool headerToPayload) {
+    return sendTXT((uint8_t*)payload, length, headerToPayload);
+}
+
+bool WebSocketsClient::sendTXT(const char* payload, size_t length) {
+    return sendTXT((const uint8_t*)payload, length);
+}
+
+bool WebSocketsClient::sendTXT(String& payload) {
+    return sendFrame(WS_OP_TEXT, (const uint8_t*)payload.c_str(), payload.length());
+}
+
+bool WebSocketsClient::sendBIN(uint8_t* payload, size_t length, bool headerToPayload) {
+    return sendFrame(WS_OP_BINARY, headerToPayload ? payload + WEBSOCKETS_MAX_HEADER_SIZE : payload, length);
+}
+
+bool WebSocketsClient::sendBIN(const uint8_t* payload, size_t length) {
+    return sendFrame(WS_OP_BINARY, payload, length);
+}
+
+bool WebSocketsClient::sendPing(uint8_t* payload, size_t length) {
+    return sendFrame(WS_OP_PING, payload, length);
+}
+
+bool WebSocketsClient::connectNow() {
+    closeSocket(false);
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    char portString[8];
+    snprintf(portString, sizeof(portString), "%u", port);
+
+    struct addrinfo* info = nullptr;
+    if (getaddrinfo(host.c_str(), portString, &hints, &info) != 0 || info == nullptr) {
+        Serial.printf("[WS_HOST] Cannot resolve %s\n", host.c_str());
+        return false;
+    }
+
+    sock = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (sock < 0) {
+        freeaddrinfo(info);
+        return false;
+    }
+
+    // Non-blocking connect so an unreachable server can't hang the loop forever
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+    int result = ::connect(sock, info->ai_addr, info->ai_addrlen);
+    freeaddrinfo(info);
+
+    if (result < 0 && errno != EINPROGRESS) {
+        closeSocket(false);
+        return false;
+    }
+
+    struct pollfd pfd = { sock, POLLOUT, 0 };
+    int error = 0;
+    socklen_t errorLength = sizeof(error);
+    if (poll(&pfd, 1, WS_HOST_CONNECT_TIMEOUT_MS) <= 0 ||
+        getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &errorLength) < 0 || error != 0) {
+        Serial.printf("[WS_HOST] Connection to %s:%u failed\n", host.c_str(), port);
+        closeSocket(false);
+        return false;
+    }
+
+    int noDelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    if (!upgrade()) {
+        // Same as the device library: a failed upgrade reports a disconnect
+        closeSocket(false);
+        deliver(WStype_DISCONNECTED, nullptr, 0);
+        return false;
+    }
+
+    connected = true;
+    awaitingPong = false;
+    missedPongs = 0;
+    lastPingSent = millis();
+    deliver(WStype_CONNECTED, (const uint8_t*)url.c_str(), url.length());
+    return true;
+}
+
+bool WebSocketsClient::upgrade() {
+    static const char keyChars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char key[25];
+    for (int i = 0; i < 22; i++) {
+        key[i] = keyChars[rand() % 64];
+    }
+    key[22] = '=';
+    key[23] = '=';
+    key[24] = '\0';
+
+    String request = String("GET ") + url + " HTTP/1.1\r\n" +
+                     "Host: " + host + ":" + String((unsigned int)port) + "\r\n" +
+                     "Upgrade: websocket\r\nConnection: Upgrade\r\n" +
+                     "Sec-WebSocket-Key: " + key + "\r\n" +
+                     "Sec-WebSocket-Version: 13\r\n" +
+                     "Sec-WebSocket-Protocol: " + protocol + "\r\n" +
+                     "User-Agent: arduino-WebSocket-Client\r\n\r\n";
+    if (!writeAll((const uint8_t*)request.c_str(), request.length())) {
+        return false;
+    }
+
+    // Read the response header; anything after it is the first frame data
+    rxBuffer.clear();
+    unsigned long start = millis();
+    while (millis() - start < WS_HOST_CONNECT_TIMEOUT_MS) {
+        struct pollfd pfd = { sock, POLLIN, 0 };
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+
+        uint8_t chunk[1024];
+        ssize_t received = recv(sock, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            return false;
+        }
+        rxBuffer.insert(rxBuffer.end(), chunk, chunk + received);
+
+        std::string text(rxBuffer.begin(), rxBuffer.end());
+        size_t headerEnd = text.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) {
+            continue;
+        }
+
+        if (text.compare(0, 12, "HTTP/1.1 101") != 0) {
+            Serial.printf("[WS_HOST] Upgrade rejected: %s\n", text.substr(0, text.find("\r\n")).c_str());
+            return false;
+        }
+
+        rxBuffer.erase(rxBuffer.begin(), rxBuffer.begin() + headerEnd + 4);
+        return true;
+    }
+
+    Serial.println("[WS_HOST] Upgrade timed out");
+    return false;
+}
+
+void WebSocketsClient::pumpReceive() {
+    uint8_t chunk[WS_HOST_RECV_CHUNK];
+
+    while (connected) {
+        ssize_t received = recv(sock, chunk, sizeof(chunk), 0);
+        if (received > 0) {
+            rxBuffer.insert(rxBuffer.end(), chunk, chunk + received);
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        // Orderly shutdown or reset by the peer
+        closeSocket(true);
+        return;
+    }
+
+    while (connected && parseFrame()) {
+    }
+}
+
+bool WebSocketsClient::parseFrame() {
+    if (rxBuffer.size() < 2) {
+        return false;
+    }
+
+    const uint8_t* data = rxBuffer.data();
+    bool fin = (data[0] & 0x80) != 0;
+    uint8_t opcode = data[0] & 0x0F;
+    bool masked = (data[1] & 0x80) != 0;
+    uint64_t length = data[1] & 0x7F;
+    size_t header = 2;
+
+    if (length == 126) {
+        if (rxBuffer.size() < 4) return false;
+        length = ((uint64_t)data[2] << 8) | data[3];
+        header = 4;
+    } else if (length == 127) {
+        if (rxBuffer.size() < 10) return false;
+        length = 0;
+        for (int i = 0; i < 8; i++) {
+            length = (length << 8) | data[2 + i];
+        }
+        header = 10;
+    }
+
+    size_t maskOffset = header;
+    if (masked) {
+        header += 4;
+    }
+    if (rxBuffer.size() < header + length) {
+        return false;
+    }
+
+    // Copy out with a terminator, like the device library does for text
+    payloadBuffer.resize(length + 1);
+    memcpy(payloadBuffer.data(), data + header, length);
+    if (masked) {
+        for (uint64_t i = 0; i < length; i++) {
+            payloadBuffer[i] ^= data[maskOffset + (i & 3)];
+        }
+    }
+    payloadBuffer[length] = '\0';
+    rxBuffer.erase(rxBuffer.begin(), rxBuffer.begin() + header + length);
+
+    uint8_t* payload = payloadBuffer.data();
+    switch (opcode) {
+        case WS_OP_TEXT:
+            deliver(fin ? WStype_TEXT : WStype_FRAGMENT_TEXT_START, payload, length);
+            break;
+        case WS_OP_BINARY:
+            deliver(fin ? WStype_BIN : WStype_FRAGMENT_BIN_START, payload, length);
+            break;
+        case WS_OP_CONTINUATION:
+            deliver(fin ? WStype_FRAGMENT_FIN : WStype_FRAGMENT, payload, length);
+            break;
+        case WS_OP_PING:
+            sendFrame(WS_OP_PONG, payload, length);
+            deliver(WStype_PING, payload, length);
+            break;
+        case WS_OP_PONG:
+            awaitingPong = false;
+            missedPongs = 0;
+            deliver(WStype_PONG, payload, length);
+            break;
+        case WS_OP_CLOSE:
+            sendFrame(WS_OP_CLOSE, payload, length >= 2 ? 2 : 0);
+            closeSocket(true);
+            return false;
+        default:
+            Serial.printf("[WS_HOST] Ignoring frame with opcode 0x%X\n", opcode);
+            break;
+    }
+    return true;
+}
+
+void WebSocketsClient::runHeartbeat() {
+    if (pingInterval == 0) {
+        return;
+    }
+
+    unsigned long now = millis();
+    if (awaitingPong && now - lastPingSent >= pongTimeout) {
+        awaitingPong = false;
+        if (++missedPongs >= disconnectTimeoutCount) {
+            Serial.println("[WS_HOST] Heartbeat timed out");
+            closeSocket(true);
+            return;
+        }
+    }
+
+    if (!awaitingPong && now - lastPingSent >= pingInterval) {
+        lastPingSent = now;
+        awaitingPong = sendPing();
+    }
+}
+
+void WebSocketsClient::deliver(WStype_t type, const uint8_t* data, size_t length) {
+    if (callback) {
+        callback(type, (uint8_t*)data, length);
+    }
+}
+
+bool WebSocketsClient::sendFrame(uint8_t opcode, const uint8_t* payload, size_t length) {
+    if (!connected && opcode != WS_OP_CLOSE) {
+        return false;
+    }
+    if (sock < 0) {
+        return false;
+    }
+
+    // Client frames are always masked (RFC 6455 5.3)
+    uint8_t mask[4];
+    for (int i = 0; i < 4; i++) {
+        mask[i] = (uint8_t)rand();
+    }
+
+    txBuffer.clear();
+    txBuffer.push_back(0x80 | opcode);
+    if (length < 126) {
+        txBuffer.push_back(0x80 | (uint8_t)length);
+    } else if (length < 65536) {
+        txBuffer.push_back(0x80 | 126);
+        txBuffer.push_back((uint8_t)(length >> 8));
+        txBuffer.push_back((uint8_t)length);
+    } else {
+        txBuffer.push_back(0x80 | 127);
+        for (int i = 7; i >= 0; i--) {
+            txBuffer.push_back((uint8_t)((uint64_t)length >> (i * 8)));
+        }
+    }
+    txBuffer.insert(txBuffer.end(), mask, mask + 4);
+
+    size_t offset = txBuffer.size();
+    txBuffer.resize(offset + length);
+    for (size_t i = 0; i < length; i++) {
+        txBuffer[offset + i] = payload[i] ^ mask[i & 3];
+    }
+
+    if (!writeAll(txBuffer.data(), txBuffer.size())) {
+        closeSocket(true);
+        return false;
+    }
+    return true;
+}
+
+bool WebSocketsClient::writeAll(const uint8_t* data, size_t length) {
+    size_t sent = 0;
+    while (sent < length) {
+        ssize_t written = send(sock, data + sent, length - sent, MSG_NOSIGNAL);
+        if (written > 0) {
+            sent += written;
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = { sock, POLLOUT, 0 };
+            if (poll(&pfd, 1, WS_HOST_CONNECT_TIMEOUT_MS) > 0) {
+                continue;
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+void WebSocketsClient::closeSocket(bool notify) {
+    bool wasConnected = connected;
+    connected = false;
+    if (sock >= 0) {
+        close(sock);
+        sock = -1;
+    }
+    rxBuffer.clear();
+    lastConnectAttempt = millis();
+
+    if (notify && wasConnected) {
+        deliver(WStype_DISCONNECTED, nullptr, 0);
+    }
+}
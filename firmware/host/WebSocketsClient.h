@@ -0,0 +1,102 @@
+#ifndef HOST_WEBSOCKETS_CLIENT_H
+#define HOST_WEBSOCKETS_CLIENT_H
+
+/*
+ * Host stand-in for links2004/WebSockets' WebSocketsClient over plain POSIX
+ * sockets. Same connect-in-loop() model, event types and fragment events as
+ * the device library, so ElevenLabsClient runs unchanged against a local
+ * server (see tools/mock_elevenlabs_server.py).
+ *
+ * There is no TLS: beginSSL()/beginSslWithCA() connect in plain text.
+ */
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+typedef enum {
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN,
+    WStype_FRAGMENT_TEXT_START,
+    WStype_FRAGMENT_BIN_START,
+    WStype_FRAGMENT,
+    WStype_FRAGMENT_FIN,
+    WStype_PING,
+    WStype_PONG,
+} WStype_t;
+
+// Room callers reserve in front of the payload when passing headerToPayload
+#define WEBSOCKETS_MAX_HEADER_SIZE (14)
+
+class WebSocketsClient {
+public:
+    typedef std::function<void(WStype_t type, uint8_t* payload, size_t length)> WebSocketClientEvent;
+
+    WebSocketsClient();
+    ~WebSocketsClient();
+
+    void begin(const char* host, uint16_t port, const char* url = "/", const char* protocol = "arduino");
+    void beginSSL(const char* host, uint16_t port, const char* url = "/", const char* fingerprint = "",
+                  const char* protocol = "arduino");
+    void beginSslWithCA(const char* host, uint16_t port, const char* url = "/", const char* CA_cert = NULL,
+                        const char* protocol = "arduino");
+
+    void loop();
+    void onEvent(WebSocketClientEvent cbEvent);
+
+    bool sendTXT(uint8_t* payload, size_t length = 0, bool headerToPayload = false);
+    bool sendTXT(const uint8_t* payload, size_t length = 0);
+    bool sendTXT(char* payload, size_t length = 0, bool headerToPayload = false);
+    bool sendTXT(const char* payload, size_t length = 0);
+    bool sendTXT(String& payload);
+
+    bool sendBIN(uint8_t* payload, size_t length, bool headerToPayload = false);
+    bool sendBIN(const uint8_t* payload, size_t length);
+
+    bool sendPing(uint8_t* payload = NULL, size_t length = 0);
+
+    void disconnect();
+    void setReconnectInterval(unsigned long time);
+    void enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount);
+    void disableHeartbeat();
+    bool isConnected();
+
+private:
+    int sock;
+    bool connected;
+    String host;
+    uint16_t port;
+    String url;
+    String protocol;
+    unsigned long reconnectInterval;
+    unsigned long lastConnectAttempt;
+    bool connectPending;
+    WebSocketClientEvent callback;
+
+    // Heartbeat
+    uint32_t pingInterval;
+    uint32_t pongTimeout;
+    uint8_t disconnectTimeoutCount;
+    unsigned long lastPingSent;
+    bool awaitingPong;
+    uint8_t missedPongs;
+
+    std::vector<uint8_t> rxBuffer;
+    std::vector<uint8_t> payloadBuffer;
+    std::vector<uint8_t> txBuffer;
+
+    bool connectNow();
+    bool upgrade();
+    void pumpReceive();
+    bool parseFrame();
+    void deliver(WStype_t type, const uint8_t* data, size_t length);
+    bool sendFrame(uint8_t opcode, const uint8_t* payload, size_t length);
+    bool writeAll(const uint8_t* data, size_t length);
+    void closeSocket(bool notify);
+    void runHeartbeat();
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+/*
+ * Host stand-in for the ESP32 WiFi class. The station is always
+ * "connected"; setStatus()/setRSSI() let a host driver simulate link loss
+ * and weak signal.
+ */
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class IPAddress {
+public:
+    IPAddress();
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d);
+
+    uint8_t operator[](int index) const;
+    bool operator==(const IPAddress& other) const;
+    bool operator!=(const IPAddress& other) const;
+    String toString() const;
+
+private:
+    uint8_t octets[4];
+};
+
+class HostWiFi {
+public:
+    wl_status_t status();
+    int hostByName(const char* host, IPAddress& result);
+    int8_t RSSI();
+    IPAddress localIP();
+
+    // Host only - link simulation
+    void setStatus(wl_status_t status);
+    void setRSSI(int8_t rssi);
+
+private:
+    wl_status_t currentStatus = WL_CONNECTED;
+    int8_t currentRssi = -55;
+};
+
+extern HostWiFi WiFi;
+
+#endif
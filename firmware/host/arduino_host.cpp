@@ -0,0 +1,294 @@
+#include "Arduino.h"
+#include "WiFi.h"
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+
+HostSerial Serial;
+HostWiFi WiFi;
+
+// --- Time -----------------------------------------------------------------
+
+static uint64_t monotonicMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static const uint64_t bootMicros = monotonicMicros();
+
+unsigned long millis() {
+    return (unsigned long)((monotonicMicros() - bootMicros) / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)(monotonicMicros() - bootMicros);
+}
+
+void delay(unsigned long ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&ts, nullptr);
+}
+
+void yield() {
+}
+
+// --- String ---------------------------------------------------------------
+
+String::String(const char* str) : value(str ? str : "") {}
+String::String(const String& other) : value(other.value) {}
+String::String(char c) : value(1, c) {}
+String::String(int v) : value(std::to_string(v)) {}
+String::String(unsigned int v) : value(std::to_string(v)) {}
+String::String(long v) : value(std::to_string(v)) {}
+String::String(unsigned long v) : value(std::to_string(v)) {}
+
+String::String(float v, unsigned int decimalPlaces) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimalPlaces, (double)v);
+    value = buffer;
+}
+
+String& String::operator=(const String& other) {
+    value = other.value;
+    return *this;
+}
+
+String& String::operator=(const char* str) {
+    value = str ? str : "";
+    return *this;
+}
+
+bool String::concat(const String& other) {
+    value += other.value;
+    return true;
+}
+
+bool String::concat(const char* str) {
+    if (str) {
+        value += str;
+    }
+    return str != nullptr;
+}
+
+bool String::concat(const char* str, unsigned int length) {
+    if (str) {
+        value.append(str, length);
+    }
+    return str != nullptr;
+}
+
+bool String::concat(char c) {
+    value += c;
+    return true;
+}
+
+String& String::operator+=(const String& other) { concat(other); return *this; }
+String& String::operator+=(const char* str) { concat(str); return *this; }
+String& String::operator+=(char c) { concat(c); return *this; }
+
+bool String::operator==(const String& other) const { return value == other.value; }
+bool String::operator==(const char* str) const { return value == (str ? str : ""); }
+bool String::operator!=(const String& other) const { return !(*this == other); }
+bool String::operator!=(const char* str) const { return !(*this == str); }
+
+char String::operator[](unsigned int index) const {
+    return index < value.size() ? value[index] : 0;
+}
+
+unsigned int String::length() const { return (unsigned int)value.size(); }
+const char* String::c_str() const { return value.c_str(); }
+bool String::isEmpty() const { return value.empty(); }
+
+bool String::reserve(unsigned int size) {
+    value.reserve(size);
+    return true;
+}
+
+bool String::startsWith(const String& prefix) const {
+    return value.compare(0, prefix.value.size(), prefix.value) == 0;
+}
+
+int String::indexOf(char c, unsigned int fromIndex) const {
+    size_t pos = value.find(c, fromIndex);
+    return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex) const {
+    return substring(beginIndex, length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) {
+        std::swap(beginIndex, endIndex);
+    }
+    if (beginIndex >= value.size()) {
+        return String();
+    }
+    return String(value.substr(beginIndex, endIndex - beginIndex).c_str());
+}
+
+long String::toInt() const {
+    return strtol(value.c_str(), nullptr, 10);
+}
+
+void String::trim() {
+    size_t first = value.find_first_not_of(" \t\r\n");
+    size_t last = value.find_last_not_of(" \t\r\n");
+    value = first == std::string::npos ? "" : value.substr(first, last - first + 1);
+}
+
+String operator+(const String& lhs, const String& rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(const String& lhs, const char* rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(const char* lhs, const String& rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+String operator+(const String& lhs, char rhs) {
+    String result(lhs);
+    result.concat(rhs);
+    return result;
+}
+
+// --- Serial ---------------------------------------------------------------
+
+void HostSerial::begin(unsigned long) {
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+}
+
+void HostSerial::setQuiet(bool enable) {
+    quiet = enable;
+}
+
+int HostSerial::available() {
+    struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+    return poll(&pfd, 1, 0) > 0 ? 1 : 0;
+}
+
+int HostSerial::read() {
+    unsigned char c;
+    return ::read(STDIN_FILENO, &c, 1) == 1 ? c : -1;
+}
+
+void HostSerial::flush() {
+    fflush(stdout);
+}
+
+size_t HostSerial::print(const char* str) {
+    if (quiet || str == nullptr) {
+        return 0;
+    }
+    fputs(str, stdout);
+    return strlen(str);
+}
+
+size_t HostSerial::print(const String& str) { return print(str.c_str()); }
+size_t HostSerial::print(char c) { return printf("%c", c); }
+size_t HostSerial::print(int value) { return printf("%d", value); }
+size_t HostSerial::print(unsigned int value) { return printf("%u", value); }
+size_t HostSerial::print(long value) { return printf("%ld", value); }
+size_t HostSerial::print(unsigned long value) { return printf("%lu", value); }
+size_t HostSerial::print(double value, int digits) { return printf("%.*f", digits, value); }
+
+size_t HostSerial::println() { return print("\n"); }
+size_t HostSerial::println(const char* str) { return print(str) + println(); }
+size_t HostSerial::println(const String& str) { return print(str) + println(); }
+size_t HostSerial::println(char c) { return print(c) + println(); }
+size_t HostSerial::println(int value) { return print(value) + println(); }
+size_t HostSerial::println(unsigned int value) { return print(value) + println(); }
+size_t HostSerial::println(long value) { return print(value) + println(); }
+size_t HostSerial::println(unsigned long value) { return print(value) + println(); }
+size_t HostSerial::println(double value, int digits) { return print(value, digits) + println(); }
+
+size_t HostSerial::printf(const char* format, ...) {
+    if (quiet) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    int written = vprintf(format, args);
+    va_end(args);
+    return written > 0 ? (size_t)written : 0;
+}
+
+// --- WiFi -----------------------------------------------------------------
+
+IPAddress::IPAddress() : octets{0, 0, 0, 0} {}
+
+IPAddress::IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+
+uint8_t IPAddress::operator[](int index) const {
+    return octets[index & 3];
+}
+
+bool IPAddress::operator==(const IPAddress& other) const {
+    return memcmp(octets, other.octets, sizeof(octets)) == 0;
+}
+
+bool IPAddress::operator!=(const IPAddress& other) const {
+    return !(*this == other);
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buffer);
+}
+
+wl_status_t HostWiFi::status() {
+    return currentStatus;
+}
+
+int HostWiFi::hostByName(const char* host, IPAddress& result) {
+    if (currentStatus != WL_CONNECTED) {
+        return 0;
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* info = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &info) != 0 || info == nullptr) {
+        return 0;
+    }
+
+    const uint8_t* addr = (const uint8_t*)&((struct sockaddr_in*)info->ai_addr)->sin_addr.s_addr;
+    result = IPAddress(addr[0], addr[1], addr[2], addr[3]);
+    freeaddrinfo(info);
+    return 1;
+}
+
+int8_t HostWiFi::RSSI() {
+    return currentStatus == WL_CONNECTED ? currentRssi : 0;
+}
+
+IPAddress HostWiFi::localIP() {
+    return currentStatus == WL_CONNECTED ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+void HostWiFi::setStatus(wl_status_t status) {
+    currentStatus = status;
+}
+
+void HostWiFi::setRSSI(int8_t rssi) {
+    currentRssi = rssi;
+}
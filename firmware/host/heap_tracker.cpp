@@ -0,0 +1,93 @@
+#include "heap_tracker.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+}
+
+// Single-threaded host program - plain counters are enough
+static HeapStats stats = { 0, 0, 0, 0 };
+
+static void trackAlloc(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    stats.currentBytes += malloc_usable_size(ptr);
+    stats.allocations++;
+    if (stats.currentBytes > stats.peakBytes) {
+        stats.peakBytes = stats.currentBytes;
+    }
+}
+
+static void trackFree(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    size_t size = malloc_usable_size(ptr);
+    // Blocks from memalign & co. were never counted
+    stats.currentBytes = stats.currentBytes > size ? stats.currentBytes - size : 0;
+    stats.frees++;
+}
+
+extern "C" void* malloc(size_t size) {
+    void* ptr = __libc_malloc(size);
+    trackAlloc(ptr);
+    return ptr;
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    void* ptr = __libc_calloc(count, size);
+    trackAlloc(ptr);
+    return ptr;
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    trackFree(ptr);
+    void* result = __libc_realloc(ptr, size);
+    if (result == nullptr && ptr != nullptr && size != 0) {
+        // Original block is still live
+        stats.currentBytes += malloc_usable_size(ptr);
+        stats.frees--;
+        return nullptr;
+    }
+    trackAlloc(result);
+    return result;
+}
+
+extern "C" void free(void* ptr) {
+    trackFree(ptr);
+    __libc_free(ptr);
+}
+
+bool heapTrackerAvailable() {
+    return true;
+}
+
+HeapStats heapTrackerSnapshot() {
+    return stats;
+}
+
+void heapTrackerResetPeak() {
+    stats.peakBytes = stats.currentBytes;
+}
+
+#else
+
+bool heapTrackerAvailable() {
+    return false;
+}
+
+HeapStats heapTrackerSnapshot() {
+    HeapStats empty = { 0, 0, 0, 0 };
+    return empty;
+}
+
+void heapTrackerResetPeak() {
+}
+
+#endif
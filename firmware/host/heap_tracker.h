@@ -0,0 +1,26 @@
+#ifndef HOST_HEAP_TRACKER_H
+#define HOST_HEAP_TRACKER_H
+
+/*
+ * Heap accounting for the host build. On glibc, malloc/calloc/realloc/free
+ * are interposed (operator new goes through them too), so every allocation
+ * the client makes - ArduinoJson documents, Strings, decode buffers - is
+ * counted. Elsewhere heapTrackerAvailable() returns false and the counters
+ * stay at zero.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct HeapStats {
+    size_t currentBytes;
+    size_t peakBytes;
+    uint64_t allocations;
+    uint64_t frees;
+};
+
+bool heapTrackerAvailable();
+HeapStats heapTrackerSnapshot();
+void heapTrackerResetPeak();  // Peak restarts from the current usage
+
+#endif
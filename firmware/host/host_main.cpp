@@ -0,0 +1,519 @@
+/*
+ * Host driver for ElevenLabsClient.
+ *
+ * Runs the unmodified client against a local server (normally
+ * tools/mock_elevenlabs_server.py), plays the part of the microphone by
+ * streaming 250 ms PCM chunks for each user turn, and reports downlink
+ * throughput and conversation latency when done:
+ *
+ *   pio run -e host
+ *   .pio/build/host/program --port 8765 --turns 5 --quiet
+ *
+ * Exits non-zero if no turn produced agent audio, so it can gate a
+ * regression script.
+ *
+ * --record FILE saves every inbound message of the session as a trace;
+ * --replay FILE feeds a trace back through the client without a server:
+ *
+ *   .pio/build/host/program --replay session.trace --repeat 20 --quiet
+ *
+ * --network-task runs the client in its own thread, as NETWORK_TASK_ENABLED
+ * does on the device; --app-block-ms N makes every audio callback block
+ * like a speaker write, to compare delivery latency and poll gaps with the
+ * client polled inline.
+ *
+ * --event-loop sleeps the host loop in EventLoop::wait() (woken by the
+ * network task and timers), as the device loop does, instead of delay(1).
+ *
+ * Scripted client_tool_call events for "wag_tail" run through the tool
+ * registry; --tool-ms N makes the tool take N ms (timeout: 1 s).
+ *
+ * --standby enables the hot-standby connection; --weak-rssi-after S drops
+ * the simulated RSSI to -85 dBm after S seconds so the standby opens, and
+ * `kill -USR2 <server pid>` then drops the active connection:
+ *
+ *   .pio/build/host/program --turns 6 --standby --weak-rssi-after 1
+ *
+ * --expect-fragments fails the run unless fragmented messages were
+ * reassembled and none dropped; run it against a server started with
+ * --fragment-size (tools/fragment_check.py does both):
+ *
+ *   .pio/build/host/program --turns 2 --expect-fragments --quiet
+ *
+ * --bench-serializers N times the outbound control messages built with
+ * ArduinoJson against the fixed-shape writers and checks they match.
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <math.h>
+#include "communication/websocket_client.h"
+#include "communication/network_task.h"
+#include "communication/tool_registry.h"
+#include "system/event_loop.h"
+#include "telemetry/latency_telemetry.h"
+#include "telemetry/turn_tracer.h"
+#include "trace_replay.h"
+#include "serializer_bench.h"
+
+#define HOST_CHUNK_MS 250
+#define HOST_SAMPLE_RATE 16000
+#define HOST_CHUNK_BYTES (HOST_SAMPLE_RATE * HOST_CHUNK_MS / 1000 * 2)
+#define HOST_TURN_SETTLE_MS 1000    // Downlink quiet this long ends the agent's turn
+#define HOST_TURN_TIMEOUT_MS 15000
+#define HOST_TRACE_BUFFER_SIZE (64 * 1024 * 1024)
+#define HOST_TOOL_TIMEOUT_MS 1000
+
+struct HostOptions {
+    const char* host = "127.0.0.1";
+    uint16_t port = 8765;
+    const char* agentId = "mock-agent";
+    int turns = 3;
+    unsigned long speakMs = 1000;
+    unsigned long durationMs = 120000;
+    bool quiet = false;
+    bool binaryAudio = false;
+    uint32_t playbackRate = 0;
+    bool networkTask = false;
+    bool eventLoop = false;
+    bool expectFragments = false;
+    unsigned long appBlockMs = 0;
+    unsigned long toolMs = 100;
+    bool standby = false;
+    long weakRssiAfterMs = -1;
+    const char* recordPath = nullptr;
+    const char* turnTracePath = nullptr;
+    const char* replayPath = nullptr;
+    int benchIterations = 0;
+    TraceReplayOptions replay;
+};
+
+enum HostTurnState {
+    TURN_WAITING_FOR_INIT,
+    TURN_SPEAKING,
+    TURN_AWAITING_AGENT,
+    TURN_DONE
+};
+
+static ElevenLabsClient client;
+static NetworkTask network;
+static ToolRegistry tools;
+static EventLoop events;
+static LatencyTelemetry telemetry;
+static TurnTracer turnTracer;
+static ConversationTrace trace;
+
+static bool initialized = false;
+static bool replaying = false;
+static unsigned long audioFrames = 0;
+static unsigned long audioBytes = 0;
+static unsigned long turnFirstAudioMs = 0;
+static unsigned long lastAudioMs = 0;
+static unsigned long audioActiveMs = 0;     // Sum of first-to-last audio time over all turns
+static unsigned long lastDownlinkMs = 0;
+static unsigned long connects = 0;
+static unsigned long errors = 0;
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--host H] [--port P] [--agent ID] [--turns N] [--speak-ms MS] [--duration S]\n"
+            "          [--binary-audio] [--playback-rate HZ] [--network-task] [--event-loop]\n"
+            "          [--app-block-ms MS] [--tool-ms MS] [--standby] [--weak-rssi-after S] [--record FILE]\n"
+            "          [--turn-trace FILE] [--expect-fragments] [--quiet]\n"
+            "       %s --replay FILE [--paced] [--repeat N] [--quiet]\n"
+            "       %s --bench-serializers N\n",
+            program, program, program);
+}
+
+static bool parseOptions(int argc, char** argv, HostOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+            continue;
+        }
+        if (strcmp(arg, "--binary-audio") == 0) {
+            options.binaryAudio = true;
+            continue;
+        }
+        if (strcmp(arg, "--standby") == 0) {
+            options.standby = true;
+            continue;
+        }
+        if (strcmp(arg, "--network-task") == 0) {
+            options.networkTask = true;
+            continue;
+        }
+        if (strcmp(arg, "--event-loop") == 0) {
+            options.eventLoop = true;
+            continue;
+        }
+        if (strcmp(arg, "--expect-fragments") == 0) {
+            options.expectFragments = true;
+            continue;
+        }
+        if (strcmp(arg, "--paced") == 0) {
+            options.replay.paced = true;
+            continue;
+        }
+        if (value == nullptr) {
+            return false;
+        }
+
+        if (strcmp(arg, "--host") == 0) {
+            options.host = value;
+        } else if (strcmp(arg, "--port") == 0) {
+            options.port = (uint16_t)atoi(value);
+        } else if (strcmp(arg, "--agent") == 0) {
+            options.agentId = value;
+        } else if (strcmp(arg, "--turns") == 0) {
+            options.turns = atoi(value);
+        } else if (strcmp(arg, "--playback-rate") == 0) {
+            options.playbackRate = strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--speak-ms") == 0) {
+            options.speakMs = strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--duration") == 0) {
+            options.durationMs = strtoul(value, nullptr, 10) * 1000;
+        } else if (strcmp(arg, "--app-block-ms") == 0) {
+            options.appBlockMs = strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--weak-rssi-after") == 0) {
+            options.weakRssiAfterMs = strtol(value, nullptr, 10) * 1000;
+        } else if (strcmp(arg, "--tool-ms") == 0) {
+            options.toolMs = strtoul(value, nullptr, 10);
+        } else if (strcmp(arg, "--record") == 0) {
+            options.recordPath = value;
+        } else if (strcmp(arg, "--turn-trace") == 0) {
+            options.turnTracePath = value;
+        } else if (strcmp(arg, "--replay") == 0) {
+            options.replayPath = value;
+        } else if (strcmp(arg, "--bench-serializers") == 0) {
+            options.benchIterations = atoi(value);
+        } else if (strcmp(arg, "--repeat") == 0) {
+            options.replay.repeat = atoi(value);
+        } else {
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
+static void fillChunk(uint8_t* chunk, size_t bytes, unsigned long& phase) {
+    int16_t* samples = (int16_t*)chunk;
+    for (size_t i = 0; i < bytes / 2; i++, phase++) {
+        samples[i] = (int16_t)(6000 * sin(2.0 * M_PI * 220.0 * phase / HOST_SAMPLE_RATE));
+    }
+}
+
+// Sleeps until the network task posts or the turn logic has a deadline,
+// the way scheduleWakeups() arranges it on the device
+static void waitForWork(HostTurnState state, unsigned long now, unsigned long nextChunkMs,
+                        unsigned long turnStartMs, const HostOptions& options) {
+    if (!network.isThreaded()) {
+        events.setTimer(EVENT_LOOP_POLL_MS);
+    }
+
+    uint32_t toolTimeoutMs = tools.getMsUntilTimeout();
+    if (toolTimeoutMs != UINT32_MAX) {
+        events.setTimer(toolTimeoutMs);
+    }
+
+    if (state == TURN_SPEAKING) {
+        unsigned long speakEndMs = turnStartMs + options.speakMs;
+        unsigned long dueMs = nextChunkMs < speakEndMs ? nextChunkMs : speakEndMs;
+        events.setTimer(dueMs > now ? dueMs - now : 0);
+    } else if (state == TURN_AWAITING_AGENT) {
+        // Settling is only checked once audio arrived; otherwise the turn timeout
+        unsigned long settleMs = lastDownlinkMs + HOST_TURN_SETTLE_MS;
+        unsigned long timeoutMs = turnStartMs + HOST_TURN_TIMEOUT_MS;
+        unsigned long dueMs = settleMs > now ? settleMs : timeoutMs;
+        events.setTimer(dueMs > now ? dueMs - now : 0);
+    }
+
+    events.wait();
+}
+
+// Target is the bare client for replay, the network task otherwise
+template <typename Target>
+static void registerCallbacks(Target& target, unsigned long appBlockMs) {
+    target.onConversationInit([](const char* conversation_id) {
+        initialized = true;
+        connects++;
+        if (!replaying) {
+            fprintf(stderr, "[HOST] Conversation %s ready\n", conversation_id);
+        }
+    });
+
+    target.onTranscript([](const char* transcript) {
+        turnTracer.mark(TURN_USER_TRANSCRIPT, millis());
+    });
+
+    target.onAgentResponse([](const char* response) {
+        telemetry.markAgentResponse(millis());
+        turnTracer.mark(TURN_AGENT_RESPONSE, millis());
+        lastDownlinkMs = millis();
+    });
+
+    target.onAudioData([appBlockMs](const uint8_t* pcm_data, size_t size, uint32_t event_id) {
+        unsigned long now = millis();
+        telemetry.markAudio(now);
+        turnTracer.mark(TURN_FIRST_AUDIO, now);
+        if (turnFirstAudioMs == 0) {
+            turnFirstAudioMs = now;
+        }
+        audioFrames++;
+        audioBytes += size;
+        lastAudioMs = now;
+        lastDownlinkMs = now;
+
+        // Stand-in for a blocking I2S write on the application task
+        if (appBlockMs > 0) {
+            delay(appBlockMs);
+        }
+        turnTracer.mark(TURN_FIRST_SAMPLE, millis());
+    });
+
+    target.onPing([](uint32_t event_id, uint32_t ping_ms) {
+        telemetry.recordPing(ping_ms);
+    });
+
+    target.onToolCall([&target](const char* tool_name, const char* tool_call_id, JsonObjectConst parameters) {
+        target.sendToolResult(tool_call_id, "ok");
+    });
+
+    target.onError([](const char* error_message) {
+        errors++;
+        if (strcmp(error_message, "WebSocket connection lost") == 0) {
+            initialized = false;
+        }
+    });
+}
+
+int main(int argc, char** argv) {
+    HostOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Serial.begin(115200);
+    Serial.setQuiet(options.quiet);
+
+    if (options.benchIterations > 0) {
+        return runSerializerBenchmark(options.benchIterations);
+    }
+
+    if (options.replayPath) {
+        replaying = true;
+        registerCallbacks(client, 0);
+        return runTraceReplay(client, options.replayPath, options.replay);
+    }
+
+    if (options.recordPath) {
+        if (!trace.begin(HOST_TRACE_BUFFER_SIZE)) {
+            fprintf(stderr, "[HOST] Cannot allocate trace buffer\n");
+            return 2;
+        }
+    }
+
+    client.setServer(options.host, options.port, false);
+    client.enableBinaryAudio(options.binaryAudio);
+    client.setPlaybackSampleRate(options.playbackRate);
+    client.enableHotStandby(options.standby);
+    client.begin(options.agentId);
+
+    registerCallbacks(network, options.appBlockMs);
+    network.onToolCallJson([](const char* tool_name, const char* tool_call_id, const char* parameters_json) {
+        tools.handleToolCall(tool_name, tool_call_id, parameters_json);
+    });
+
+    unsigned long toolMs = options.toolMs;
+    tools.registerTool("wag_tail", [toolMs](JsonObjectConst parameters, char* result, size_t result_size) {
+        delay(toolMs);   // Stand-in for a motor move
+        snprintf(result, result_size, "wagged %d times", parameters["times"] | 1);
+        return true;
+    }, HOST_TOOL_TIMEOUT_MS);
+    tools.begin([](const char* tool_call_id, const char* result, bool is_error) {
+        return network.sendToolResult(tool_call_id, result, is_error);
+    });
+    if (options.eventLoop) {
+        events.begin();
+        network.onWake([]() {
+            events.post(EVENT_NETWORK);
+        });
+    }
+    if (!network.begin(client, options.networkTask)) {
+        fprintf(stderr, "[HOST] Cannot start network task\n");
+        return 2;
+    }
+    if (options.recordPath) {
+        network.startTrace(&trace);   // Recorded on the network task, as on the device
+    }
+
+    static uint8_t chunk[HOST_CHUNK_BYTES];
+    unsigned long phase = 0;
+    HostTurnState state = TURN_WAITING_FOR_INIT;
+    int turnsStarted = 0;
+    int turnsWithAudio = 0;
+    unsigned long turnStartMs = 0;
+    unsigned long nextChunkMs = 0;
+    unsigned long audioFramesAtTurnStart = 0;
+    unsigned long startMs = millis();
+    uint32_t tracedUplinkMs = 0;
+    turnTracer.onTurn([](const TurnRecord& record) {
+        char line[160];
+        TurnTracer::formatTurn(record, line, sizeof(line));
+        fprintf(stderr, "[HOST] %s\n", line);
+    });
+
+    while (state != TURN_DONE && millis() - startMs < options.durationMs) {
+        // Uplink completions before dispatch(), as on the device
+        uint32_t sentMs = network.getLastAudioSentMs();
+        if (sentMs != tracedUplinkMs) {
+            tracedUplinkMs = sentMs;
+            turnTracer.mark(TURN_UPLINK_SENT, sentMs);
+        }
+        network.dispatch();
+        tools.loop();
+        unsigned long now = millis();
+
+        if (options.weakRssiAfterMs >= 0 && now - startMs >= (unsigned long)options.weakRssiAfterMs) {
+            WiFi.setRSSI(-85);
+        }
+
+        switch (state) {
+            case TURN_WAITING_FOR_INIT:
+                if (initialized) {
+                    state = TURN_SPEAKING;
+                    turnStartMs = now;
+                    nextChunkMs = now;
+                    audioFramesAtTurnStart = audioFrames;
+                    turnsStarted++;
+                }
+                break;
+
+            case TURN_SPEAKING:
+                if (!initialized) {
+                    state = TURN_WAITING_FOR_INIT;
+                } else if (now - turnStartMs >= options.speakMs) {
+                    state = TURN_AWAITING_AGENT;
+                    turnStartMs = now;
+                    lastDownlinkMs = now;
+                } else if (now >= nextChunkMs) {
+                    // Paced like the microphone: one chunk per HOST_CHUNK_MS
+                    fillChunk(chunk, sizeof(chunk), phase);
+                    turnTracer.mark(TURN_MIC_CAPTURE, millis());
+                    network.sendRealtimeAudioChunk(chunk, sizeof(chunk));
+                    telemetry.markUplinkChunk(millis());
+                    nextChunkMs += HOST_CHUNK_MS;
+                }
+                break;
+
+            case TURN_AWAITING_AGENT: {
+                bool gotAudio = audioFrames > audioFramesAtTurnStart;
+                bool settled = gotAudio && now - lastDownlinkMs >= HOST_TURN_SETTLE_MS;
+                if (settled || now - turnStartMs >= HOST_TURN_TIMEOUT_MS || !initialized) {
+                    if (gotAudio) {
+                        turnsWithAudio++;
+                        audioActiveMs += lastAudioMs - turnFirstAudioMs;
+                        // No speaker here: the last chunk's arrival stands in for the end of playback
+                        turnTracer.mark(TURN_PLAYBACK_END, lastAudioMs);
+                        turnTracer.flush(now);
+                    }
+                    turnFirstAudioMs = 0;
+                    fprintf(stderr, "[HOST] Turn %d: %lu audio frames\n", turnsStarted,
+                            audioFrames - audioFramesAtTurnStart);
+                    state = (turnsStarted >= options.turns) ? TURN_DONE : TURN_WAITING_FOR_INIT;
+                }
+                break;
+            }
+
+            case TURN_DONE:
+                break;
+        }
+
+        if (options.eventLoop) {
+            waitForWork(state, now, nextChunkMs, turnStartMs, options);
+        } else {
+            // Stand-in for the device loop's yield()/delay(1)
+            delay(1);
+        }
+    }
+    tools.end();
+    network.end();
+
+    double seconds = audioActiveMs / 1000.0;
+    fprintf(stderr, "[HOST] %d/%d turns with audio, %lu connects, %lu errors\n",
+            turnsWithAudio, turnsStarted, connects, errors);
+    fprintf(stderr, "[HOST] Downlink: %lu audio frames, %lu PCM bytes in %lu ms (%.1f frames/s, %.1f KB/s)\n",
+            audioFrames, audioBytes, audioActiveMs,
+            seconds > 0 ? audioFrames / seconds : 0.0,
+            seconds > 0 ? audioBytes / seconds / 1024.0 : 0.0);
+
+    const ReconnectTiming& timing = client.getReconnectTiming();
+    fprintf(stderr, "[HOST] Last connect: attempt=%u%s handshake=%ums init=%ums total=%ums, %u failovers\n",
+            timing.attempt, timing.failover ? " (failover)" : "", timing.handshakeMs, timing.initMs,
+            timing.totalMs, client.getFailoverCount());
+
+    const FragmentAssembler& fragments = client.getFragmentAssembler();
+    fprintf(stderr, "[HOST] Fragments: %u messages from %u frames, %llu bytes (%.1f KB/s), %u dropped\n",
+            fragments.getMessagesAssembled(), fragments.getFragmentsReceived(),
+            (unsigned long long)fragments.getBytesAssembled(),
+            seconds > 0 ? fragments.getBytesAssembled() / seconds / 1024.0 : 0.0,
+            fragments.getMessagesDropped());
+
+    char line[256];
+    telemetry.format(line, sizeof(line));
+    fprintf(stderr, "[HOST] %s\n", line);
+    turnTracer.format(line, sizeof(line));
+    fprintf(stderr, "[HOST] %s\n", line);
+    network.format(line, sizeof(line));
+    fprintf(stderr, "[HOST] %s\n", line);
+    if (options.eventLoop) {
+        events.format(line, sizeof(line));
+        fprintf(stderr, "[HOST] %s\n", line);
+    }
+    for (size_t i = 0; i < tools.getToolCount(); i++) {
+        if (tools.getStats(i).calls > 0) {
+            tools.format(i, line, sizeof(line));
+            fprintf(stderr, "[HOST] %s\n", line);
+        }
+    }
+
+    client.disconnect();
+
+    if (options.recordPath) {
+        trace.stop();
+        if (!saveTrace(trace, options.recordPath)) {
+            fprintf(stderr, "[HOST] Cannot write %s\n", options.recordPath);
+            return 2;
+        }
+        fprintf(stderr, "[HOST] Recorded %u messages (%zu bytes%s) to %s\n", trace.getRecordCount(),
+                trace.size(), trace.isTruncated() ? ", truncated" : "", options.recordPath);
+    }
+
+    if (options.turnTracePath) {
+        static uint8_t data[TURN_EXPORT_HEADER_SIZE + TURN_TRACE_CAPACITY * TURN_EXPORT_RECORD_SIZE];
+        size_t size = turnTracer.exportBinary(data, sizeof(data));
+        FILE* f = fopen(options.turnTracePath, "wb");
+        if (f == nullptr || fwrite(data, 1, size, f) != size) {
+            fprintf(stderr, "[HOST] Cannot write %s\n", options.turnTracePath);
+            if (f != nullptr) {
+                fclose(f);
+            }
+            return 2;
+        }
+        fclose(f);
+        fprintf(stderr, "[HOST] Wrote %u turns to %s\n", (unsigned int)turnTracer.getTurnCount(),
+                options.turnTracePath);
+    }
+
+    if (options.expectFragments &&
+        (fragments.getMessagesAssembled() == 0 || fragments.getMessagesDropped() > 0)) {
+        fprintf(stderr, "[HOST] Expected reassembled fragments and no drops\n");
+        return 1;
+    }
+    return turnsWithAudio > 0 ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include "serializer_bench.h"
+#include "heap_tracker.h"
+#include "communication/websocket_client.h"
+#include "communication/outbound_messages.h"
+
+#define BENCH_FRAME_SIZE 4096
+
+// Shaped like real traffic: escapes in the text, a long tool result
+static const char BENCH_TEXT[] = "Turn left, then say \"hello\"\nto the cat.";
+static const char BENCH_TOOL_CALL_ID[] = "toolu_01A09q90qw90lq917835lq9";
+static const char BENCH_TOOL_RESULT[] =
+    "{\"temperature\":21.5,\"humidity\":40,\"battery\":\"87%\",\"note\":\"all sensors nominal\\tok\"}";
+
+enum BenchMessage {
+    BENCH_USER_MESSAGE,
+    BENCH_USER_ACTIVITY,
+    BENCH_CONTEXTUAL_UPDATE,
+    BENCH_TOOL_RESULT_MESSAGE,
+    BENCH_PONG,
+    BENCH_INITIATION,
+    BENCH_MESSAGE_COUNT
+};
+
+static const char* const BENCH_NAMES[BENCH_MESSAGE_COUNT] = {
+    "user_message", "user_activity", "contextual_update", "client_tool_result", "pong",
+    "conversation_initiation"
+};
+
+struct BenchResult {
+    double nsPerMessage;
+    double allocationsPerMessage;
+    size_t length;
+};
+
+// The client's previous path: arena document, measure, serialize
+static size_t buildWithArduinoJson(BenchMessage message, uint32_t value, JsonArena& arena,
+                                   JsonArenaAllocator& allocator, char* out, size_t size) {
+    JsonArenaScope scope(arena);
+    JsonDocument doc(&allocator);
+
+    switch (message) {
+        case BENCH_USER_MESSAGE:
+            doc["type"] = "user_message";
+            doc["text"] = BENCH_TEXT;
+            break;
+        case BENCH_USER_ACTIVITY:
+            doc["type"] = "user_activity";
+            break;
+        case BENCH_CONTEXTUAL_UPDATE:
+            doc["type"] = "contextual_update";
+            doc["text"] = BENCH_TEXT;
+            break;
+        case BENCH_TOOL_RESULT_MESSAGE:
+            doc["type"] = "client_tool_result";
+            doc["tool_call_id"] = BENCH_TOOL_CALL_ID;
+            doc["result"] = BENCH_TOOL_RESULT;
+            doc["is_error"] = false;
+            break;
+        case BENCH_PONG:
+            doc["type"] = "pong";
+            doc["event_id"] = value;
+            break;
+        default:
+            doc["type"] = "conversation_initiation_client_data";
+            doc["conversation_config_override"]["override_agent_output_audio"] = true;
+            break;
+    }
+
+    size_t length = measureJson(doc);
+    if (length + 1 > size) {
+        return 0;
+    }
+    serializeJson(doc, out, length + 1);
+    return length;
+}
+
+static JsonWriter& writeFixed(BenchMessage message, uint32_t value, JsonWriter& writer) {
+    switch (message) {
+        case BENCH_USER_MESSAGE:
+            return OutboundMessages::userMessage(writer, BENCH_TEXT);
+        case BENCH_USER_ACTIVITY:
+            return OutboundMessages::userActivity(writer);
+        case BENCH_CONTEXTUAL_UPDATE:
+            return OutboundMessages::contextualUpdate(writer, BENCH_TEXT);
+        case BENCH_TOOL_RESULT_MESSAGE:
+            return OutboundMessages::toolResult(writer, BENCH_TOOL_CALL_ID, BENCH_TOOL_RESULT, false);
+        case BENCH_PONG:
+            return OutboundMessages::pong(writer, value);
+        default:
+            return OutboundMessages::conversationInitiation(writer, true);
+    }
+}
+
+// Same two passes as ElevenLabsClient::sendFixed
+static size_t buildFixed(BenchMessage message, uint32_t value, char* out, size_t size) {
+    JsonWriter measure(nullptr, 0);
+    size_t length = writeFixed(message, value, measure).length();
+    if (length + 1 > size) {
+        return 0;
+    }
+    JsonWriter writer(out, length + 1);
+    writeFixed(message, value, writer);
+    return length;
+}
+
+template <typename Build>
+static BenchResult timeBuild(int iterations, Build build) {
+    HeapStats before = heapTrackerSnapshot();
+    unsigned long start = micros();
+    size_t length = 0;
+    for (int i = 0; i < iterations; i++) {
+        length = build((uint32_t)i);
+    }
+    unsigned long elapsed = micros() - start;
+    HeapStats after = heapTrackerSnapshot();
+
+    BenchResult result;
+    result.nsPerMessage = iterations > 0 ? elapsed * 1000.0 / iterations : 0.0;
+    result.allocationsPerMessage = iterations > 0 ? (double)(after.allocations - before.allocations) / iterations : 0.0;
+    result.length = length;
+    return result;
+}
+
+int runSerializerBenchmark(int iterations) {
+    JsonArena arena;
+    if (!arena.begin(JSON_ARENA_SIZE)) {
+        fprintf(stderr, "[BENCH] Cannot allocate JSON arena\n");
+        return 2;
+    }
+    JsonArenaAllocator allocator(arena);
+
+    static char expected[BENCH_FRAME_SIZE];
+    static char actual[BENCH_FRAME_SIZE];
+    int mismatches = 0;
+
+    fprintf(stderr, "[BENCH] %d messages of each kind\n", iterations);
+    fprintf(stderr, "[BENCH] %-24s %6s %14s %14s %8s %12s %12s\n",
+            "message", "bytes", "arduinojson_ns", "fixed_ns", "speedup", "aj_allocs", "fixed_allocs");
+
+    for (int m = 0; m < BENCH_MESSAGE_COUNT; m++) {
+        BenchMessage message = (BenchMessage)m;
+
+        // Identical output first, for a value with every digit count
+        for (uint32_t value : {0u, 7u, 12345u, 4294967295u}) {
+            size_t a = buildWithArduinoJson(message, value, arena, allocator, expected, sizeof(expected));
+            size_t b = buildFixed(message, value, actual, sizeof(actual));
+            if (a != b || memcmp(expected, actual, a) != 0) {
+                fprintf(stderr, "[BENCH] %s differs:\n  arduinojson: %s\n  fixed:       %s\n",
+                        BENCH_NAMES[m], expected, actual);
+                mismatches++;
+                break;
+            }
+        }
+
+        BenchResult json = timeBuild(iterations, [&](uint32_t value) {
+            return buildWithArduinoJson(message, value, arena, allocator, expected, sizeof(expected));
+        });
+        BenchResult fixed = timeBuild(iterations, [&](uint32_t value) {
+            return buildFixed(message, value, actual, sizeof(actual));
+        });
+
+        fprintf(stderr, "[BENCH] %-24s %6zu %14.0f %14.0f %7.1fx %12.2f %12.2f\n",
+                BENCH_NAMES[m], fixed.length, json.nsPerMessage, fixed.nsPerMessage,
+                fixed.nsPerMessage > 0 ? json.nsPerMessage / fixed.nsPerMessage : 0.0,
+                json.allocationsPerMessage, fixed.allocationsPerMessage);
+    }
+
+    fprintf(stderr, "[BENCH] JSON arena high-water %zu B\n", arena.getHighWater());
+    if (mismatches > 0) {
+        fprintf(stderr, "[BENCH] %d message kind(s) serialize differently\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
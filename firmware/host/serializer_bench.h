@@ -0,0 +1,12 @@
+#ifndef HOST_SERIALIZER_BENCH_H
+#define HOST_SERIALIZER_BENCH_H
+
+/**
+ * @brief Time every outbound control message built with ArduinoJson (the
+ *        old sendJson path) against the fixed-shape OutboundMessages writers
+ * @param iterations Messages of each kind per variant
+ * @return 0 if both paths produced identical bytes for every message
+ */
+int runSerializerBenchmark(int iterations);
+
+#endif
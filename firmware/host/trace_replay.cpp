@@ -0,0 +1,212 @@
+#include "trace_replay.h"
+#include "heap_tracker.h"
+#include "communication/binary_audio_frame.h"
+#include "telemetry/latency_histogram.h"
+#include <vector>
+
+#define REPLAY_MAX_TYPES 16
+#define REPLAY_TYPE_NAME_SIZE 40
+
+struct MessageTypeStats {
+    char name[REPLAY_TYPE_NAME_SIZE];
+    uint32_t count;
+    uint64_t bytes;
+    uint64_t totalUs;
+    uint64_t allocations;
+    size_t peakBytes;           // Largest heap growth while handling one message
+    LatencyHistogram costUs;
+};
+
+static bool loadFile(const char* path, std::vector<uint8_t>& contents) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    uint8_t chunk[65536];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        contents.insert(contents.end(), chunk, chunk + read);
+    }
+    fclose(file);
+    return true;
+}
+
+// Top-level "type" value of a JSON message, "audio (binary)", "binary" or "unknown"
+static void classify(const TraceRecord& record, char* name, size_t size) {
+    snprintf(name, size, "%s", record.binary ? "binary" : "unknown");
+    if (record.binary) {
+        BinaryAudioFrame frame;
+        if (parseBinaryAudioFrame(record.data, record.length, frame)) {
+            snprintf(name, size, "audio (binary)");
+        }
+        return;
+    }
+
+    std::string text((const char*)record.data, record.length);
+    size_t key = text.find("\"type\"");
+    if (key == std::string::npos) {
+        return;
+    }
+    size_t open = text.find('"', text.find(':', key) + 1);
+    size_t close = open == std::string::npos ? open : text.find('"', open + 1);
+    if (close != std::string::npos) {
+        snprintf(name, size, "%.*s", (int)(close - open - 1), text.c_str() + open + 1);
+    }
+}
+
+static MessageTypeStats* findType(std::vector<MessageTypeStats>& table, const char* name) {
+    for (MessageTypeStats& entry : table) {
+        if (strcmp(entry.name, name) == 0) {
+            return &entry;
+        }
+    }
+    if (table.size() >= REPLAY_MAX_TYPES) {
+        return &table.back();
+    }
+
+    table.emplace_back();
+    MessageTypeStats& entry = table.back();
+    snprintf(entry.name, sizeof(entry.name), "%s", table.size() == REPLAY_MAX_TYPES ? "(other)" : name);
+    entry.count = 0;
+    entry.bytes = 0;
+    entry.totalUs = 0;
+    entry.allocations = 0;
+    entry.peakBytes = 0;
+    return &entry;
+}
+
+int runTraceReplay(ElevenLabsClient& client, const char* path, const TraceReplayOptions& options) {
+    std::vector<uint8_t> image;
+    if (!loadFile(path, image)) {
+        fprintf(stderr, "[REPLAY] Cannot read %s\n", path);
+        return 2;
+    }
+
+    TraceReader reader;
+    if (!reader.open(image.data(), image.size())) {
+        fprintf(stderr, "[REPLAY] %s is not a trace file\n", path);
+        return 2;
+    }
+
+    std::vector<MessageTypeStats> types;
+    types.reserve(REPLAY_MAX_TYPES);
+    std::vector<uint8_t> scratch;
+
+    // The live path hands the client a fresh, null-terminated buffer per frame
+    TraceRecord record;
+    size_t largest = 0;
+    while (reader.next(record)) {
+        largest = record.length > largest ? record.length : largest;
+    }
+    scratch.resize(largest + 1);
+
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t busyUs = 0;
+    uint32_t maxLagMs = 0;
+    uint64_t passMessages = 0;
+    uint64_t passAllocations = 0;
+    HeapStats baseline = heapTrackerSnapshot();
+    size_t peakBytes = baseline.currentBytes;
+    unsigned long wallStart = millis();
+
+    for (int pass = 0; pass < options.repeat; pass++) {
+        reader.rewind();
+        unsigned long passStart = millis();
+        passMessages = 0;
+        passAllocations = 0;
+
+        while (reader.next(record)) {
+            if (options.paced) {
+                unsigned long due = passStart + record.timestampMs;
+                while (millis() < due) {
+                    delay(1);
+                }
+                uint32_t lag = millis() - due;
+                maxLagMs = lag > maxLagMs ? lag : maxLagMs;
+            }
+
+            char name[REPLAY_TYPE_NAME_SIZE];
+            classify(record, name, sizeof(name));
+            MessageTypeStats* type = findType(types, name);
+
+            memcpy(scratch.data(), record.data, record.length);
+            scratch[record.length] = '\0';
+
+            HeapStats before = heapTrackerSnapshot();
+            heapTrackerResetPeak();
+            unsigned long start = micros();
+            client.replayMessage(scratch.data(), record.length, record.binary);
+            uint32_t elapsed = micros() - start;
+            HeapStats after = heapTrackerSnapshot();
+
+            size_t growth = after.peakBytes - before.currentBytes;
+            type->count++;
+            type->bytes += record.length;
+            type->totalUs += elapsed;
+            type->allocations += after.allocations - before.allocations;
+            type->peakBytes = growth > type->peakBytes ? growth : type->peakBytes;
+            type->costUs.record(elapsed);
+
+            peakBytes = after.peakBytes > peakBytes ? after.peakBytes : peakBytes;
+            messages++;
+            passMessages++;
+            passAllocations += after.allocations - before.allocations;
+            bytes += record.length;
+            busyUs += elapsed;
+        }
+    }
+
+    unsigned long wallMs = millis() - wallStart;
+    double busySeconds = busyUs / 1e6;
+    HeapStats end = heapTrackerSnapshot();
+
+    fprintf(stderr, "[REPLAY] %llu messages, %llu bytes, %d pass(es) in %lu ms wall, %.1f ms in client\n",
+            (unsigned long long)messages, (unsigned long long)bytes, options.repeat, wallMs, busyUs / 1000.0);
+    if (busySeconds > 0) {
+        fprintf(stderr, "[REPLAY] Throughput: %.0f msg/s, %.2f MB/s\n",
+                messages / busySeconds, bytes / busySeconds / (1024.0 * 1024.0));
+    }
+    if (options.paced) {
+        fprintf(stderr, "[REPLAY] Paced: worst lag behind recorded timing %u ms\n", maxLagMs);
+    }
+    if (heapTrackerAvailable()) {
+        fprintf(stderr, "[REPLAY] Heap: peak %zu B above baseline, %llu allocations (%.1f per message), %zd B retained\n",
+                peakBytes - baseline.currentBytes,
+                (unsigned long long)(end.allocations - baseline.allocations),
+                messages ? (double)(end.allocations - baseline.allocations) / messages : 0.0,
+                (ssize_t)end.currentBytes - (ssize_t)baseline.currentBytes);
+        // One-time buffers are set up during the first pass
+        fprintf(stderr, "[REPLAY] Steady state (last pass): %llu allocations over %llu messages (%.2f per message)\n",
+                (unsigned long long)passAllocations, (unsigned long long)passMessages,
+                passMessages ? (double)passAllocations / passMessages : 0.0);
+    } else {
+        fprintf(stderr, "[REPLAY] Heap: not tracked on this platform\n");
+    }
+
+    const JsonArena& arena = client.getJsonArena();
+    fprintf(stderr, "[REPLAY] JSON arena: high-water %zu of %zu B, %u failed allocations\n",
+            arena.getHighWater(), arena.capacity(), arena.getFailures());
+
+    fprintf(stderr, "[REPLAY] %-34s %7s %10s %9s %8s %8s %8s %10s %9s\n",
+            "type", "count", "bytes", "msg/s", "p50_us", "p99_us", "max_us", "allocs/msg", "peak_B");
+    for (const MessageTypeStats& type : types) {
+        double seconds = type.totalUs / 1e6;
+        fprintf(stderr, "[REPLAY] %-34s %7u %10llu %9.0f %8u %8u %8u %10.1f %9zu\n",
+                type.name, type.count, (unsigned long long)type.bytes,
+                seconds > 0 ? type.count / seconds : 0.0,
+                type.costUs.getPercentile(50), type.costUs.getPercentile(99), type.costUs.getMax(),
+                type.count ? (double)type.allocations / type.count : 0.0, type.peakBytes);
+    }
+    return 0;
+}
+
+bool saveTrace(const ConversationTrace& trace, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(trace.data(), 1, trace.size(), file) == trace.size();
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,26 @@
+#ifndef HOST_TRACE_REPLAY_H
+#define HOST_TRACE_REPLAY_H
+
+#include "communication/websocket_client.h"
+
+struct TraceReplayOptions {
+    bool paced = false;   // Honour recorded timestamps instead of running flat out
+    int repeat = 1;       // Passes over the trace
+};
+
+/**
+ * @brief Feed a recorded trace through the client's inbound path and report
+ *        frames/s, bytes/s, heap usage and per-message-type cost
+ * @param client Client to drive (need not be connected)
+ * @param path Trace file written by --record or tools/trace_tool.py
+ * @return 0 on success, non-zero if the trace could not be read
+ */
+int runTraceReplay(ElevenLabsClient& client, const char* path, const TraceReplayOptions& options);
+
+/**
+ * @brief Write a recorded trace to a file
+ * @return true on success
+ */
+bool saveTrace(const ConversationTrace& trace, const char* path);
+
+#endif
@@ -0,0 +1,365 @@
+#include "audio_graph.h"
+#include <stdio.h>
+#include <string.h>
+
+AudioNode::AudioNode(const char* name) :
+    name(name) {
+    resetStats();
+}
+
+const char* AudioNode::getName() const {
+    return name;
+}
+
+uint32_t AudioNode::getFrames() const {
+    return frames;
+}
+
+uint32_t AudioNode::getAverageCycles() const {
+    return frames > 0 ? (uint32_t)(totalCycles / frames) : 0;
+}
+
+uint32_t AudioNode::getMaxCycles() const {
+    return maxCycles;
+}
+
+void AudioNode::resetStats() {
+    frames = 0;
+    totalCycles = 0;
+    maxCycles = 0;
+}
+
+void AudioNode::account(uint32_t cycles) {
+    frames++;
+    totalCycles += cycles;
+    if (cycles > maxCycles) {
+        maxCycles = cycles;
+    }
+}
+
+AudioGraph::AudioGraph(const char* name) :
+    name(name),
+    source(nullptr),
+    filterCount(0),
+    sinkCount(0),
+    buffer(nullptr),
+    bufferCapacity(0),
+    clock(nullptr),
+    frames(0),
+    dropped(0) {
+}
+
+void AudioGraph::setSource(AudioSource* source) {
+    this->source = source;
+}
+
+bool AudioGraph::addFilter(AudioFilter* filter) {
+    if (filter == nullptr || filterCount >= AUDIO_GRAPH_MAX_FILTERS) {
+        return false;
+    }
+    filters[filterCount++] = filter;
+    return true;
+}
+
+bool AudioGraph::addSink(AudioSink* sink) {
+    if (sink == nullptr || sinkCount >= AUDIO_GRAPH_MAX_SINKS) {
+        return false;
+    }
+    sinks[sinkCount++] = sink;
+    return true;
+}
+
+bool AudioGraph::removeSink(AudioSink* sink) {
+    for (size_t i = 0; i < sinkCount; i++) {
+        if (sinks[i] == sink) {
+            // Keep the order: the first sink offering storage wins
+            memmove(&sinks[i], &sinks[i + 1], (sinkCount - i - 1) * sizeof(sinks[0]));
+            sinkCount--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void AudioGraph::setBuffer(int16_t* buffer, size_t capacity) {
+    this->buffer = buffer;
+    bufferCapacity = buffer != nullptr ? capacity : 0;
+}
+
+void AudioGraph::setClock(AudioCycleClock clock) {
+    this->clock = clock;
+}
+
+bool AudioGraph::run() {
+    if (source == nullptr) {
+        return false;
+    }
+
+    AudioFrame frame;
+    frame.samples = nullptr;
+    frame.capacity = 0;
+    for (size_t i = 0; i < sinkCount && frame.samples == nullptr; i++) {
+        size_t capacity = 0;
+        int16_t* storage = sinks[i]->acquire(capacity);
+        if (storage != nullptr && capacity > 0) {
+            frame.samples = storage;
+            frame.capacity = capacity;
+        }
+    }
+    if (frame.samples == nullptr) {
+        frame.samples = buffer;
+        frame.capacity = bufferCapacity;
+    }
+    if (frame.samples == nullptr || frame.capacity == 0) {
+        return false;
+    }
+    frame.count = 0;
+    frame.channels = 1;
+
+    uint32_t start = now();
+    if (!source->read(frame) || frame.count == 0) {
+        return false;
+    }
+    if (frame.count > frame.capacity) {
+        frame.count = frame.capacity;
+    }
+    uint32_t end = now();
+    source->account(end - start);
+
+    for (size_t i = 0; i < filterCount; i++) {
+        start = end;
+        bool keep = filters[i]->process(frame);
+        end = now();
+        filters[i]->account(end - start);
+        if (!keep || frame.count == 0) {
+            dropped++;
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < sinkCount; i++) {
+        start = end;
+        sinks[i]->consume(frame);
+        end = now();
+        sinks[i]->account(end - start);
+    }
+    frames++;
+    return true;
+}
+
+const char* AudioGraph::getName() const {
+    return name;
+}
+
+uint32_t AudioGraph::getFrames() const {
+    return frames;
+}
+
+uint32_t AudioGraph::getDropped() const {
+    return dropped;
+}
+
+void AudioGraph::resetStats() {
+    frames = 0;
+    dropped = 0;
+    if (source != nullptr) {
+        source->resetStats();
+    }
+    for (size_t i = 0; i < filterCount; i++) {
+        filters[i]->resetStats();
+    }
+    for (size_t i = 0; i < sinkCount; i++) {
+        sinks[i]->resetStats();
+    }
+}
+
+size_t AudioGraph::format(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "AUDIO %s frames=%lu drop=%lu |", name,
+                           (unsigned long)frames, (unsigned long)dropped);
+
+    // Source, then filters, then sinks: the order a frame visits them
+    const AudioNode* nodes[1 + AUDIO_GRAPH_MAX_FILTERS + AUDIO_GRAPH_MAX_SINKS];
+    size_t nodeCount = 0;
+    if (source != nullptr) {
+        nodes[nodeCount++] = source;
+    }
+    for (size_t i = 0; i < filterCount; i++) {
+        nodes[nodeCount++] = filters[i];
+    }
+    for (size_t i = 0; i < sinkCount; i++) {
+        nodes[nodeCount++] = sinks[i];
+    }
+
+    for (size_t i = 0; i < nodeCount && written >= 0 && (size_t)written < size; i++) {
+        if (nodes[i]->getFrames() == 0) {
+            written += snprintf(out + written, size - written, " %s=-", nodes[i]->getName());
+        } else {
+            written += snprintf(out + written, size - written, " %s=%lu/%lu", nodes[i]->getName(),
+                                (unsigned long)nodes[i]->getAverageCycles(), (unsigned long)nodes[i]->getMaxCycles());
+        }
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+uint32_t AudioGraph::now() const {
+    return clock != nullptr ? clock() : 0;
+}
+
+GainFilter::GainFilter(const char* name, float gain) :
+    AudioFilter(name),
+    gain(gain) {
+}
+
+void GainFilter::setGain(float gain) {
+    this->gain = gain;
+}
+
+float GainFilter::getGain() const {
+    return gain;
+}
+
+bool GainFilter::process(AudioFrame& frame) {
+    float gain = this->gain;
+    if (gain == 1.0f) {
+        return true;
+    }
+
+    for (size_t i = 0; i < frame.count; i++) {
+        int32_t sample = (int32_t)(frame.samples[i] * gain);
+        if (sample > INT16_MAX) {
+            sample = INT16_MAX;
+        } else if (sample < INT16_MIN) {
+            sample = INT16_MIN;
+        }
+        frame.samples[i] = (int16_t)sample;
+    }
+    return true;
+}
+
+MonoToStereoFilter::MonoToStereoFilter(const char* name) :
+    AudioFilter(name) {
+}
+
+bool MonoToStereoFilter::process(AudioFrame& frame) {
+    if (frame.channels != 1) {
+        return true;
+    }
+    if (frame.count * 2 > frame.capacity) {
+        return false;
+    }
+
+    // Back to front, so no sample is overwritten before it is duplicated
+    for (size_t i = frame.count; i-- > 0;) {
+        int16_t sample = frame.samples[i];
+        frame.samples[i * 2] = sample;
+        frame.samples[i * 2 + 1] = sample;
+    }
+    frame.count *= 2;
+    frame.channels = 2;
+    return true;
+}
+
+BlockSink::BlockSink(const char* name) :
+    AudioSink(name),
+    block(nullptr),
+    capacity(0),
+    blockSize(0),
+    fill(0),
+    callback(nullptr) {
+}
+
+void BlockSink::setBlock(int16_t* block, size_t blockSize) {
+    this->block = block;
+    this->blockSize = block != nullptr ? blockSize : 0;
+    capacity = this->blockSize;
+    fill = 0;
+}
+
+void BlockSink::resize(size_t blockSize) {
+    if (block == nullptr || blockSize == 0) {
+        return;
+    }
+    this->blockSize = blockSize < capacity ? blockSize : capacity;
+
+    // Shrunk below what was already collected: send it as it is
+    if (fill >= this->blockSize && callback != nullptr) {
+        callback(block, fill);
+        fill = 0;
+    }
+}
+
+size_t BlockSink::getBlockSize() const {
+    return blockSize;
+}
+
+void BlockSink::setCallback(AudioBlockCallback callback) {
+    this->callback = callback;
+}
+
+size_t BlockSink::getFill() const {
+    return fill;
+}
+
+bool BlockSink::isFull() const {
+    return block != nullptr && fill >= blockSize;
+}
+
+void BlockSink::reset() {
+    fill = 0;
+}
+
+void BlockSink::consume(const AudioFrame& frame) {
+    if (block == nullptr) {
+        return;
+    }
+
+    const int16_t* samples = frame.samples;
+    size_t remaining = frame.count;
+    while (remaining > 0 && fill < blockSize) {
+        size_t take = remaining < blockSize - fill ? remaining : blockSize - fill;
+        // Frames read into acquire()'s storage are already in place
+        if (samples != block + fill) {
+            memcpy(block + fill, samples, take * sizeof(int16_t));
+        }
+        fill += take;
+        samples += take;
+        remaining -= take;
+
+        if (fill >= blockSize && callback != nullptr) {
+            callback(block, blockSize);
+            fill = 0;
+        }
+    }
+}
+
+int16_t* BlockSink::acquire(size_t& capacity) {
+    if (block == nullptr || fill >= blockSize) {
+        capacity = 0;
+        return nullptr;
+    }
+    capacity = blockSize - fill;
+    return block + fill;
+}
+
+CallbackSink::CallbackSink(const char* name) :
+    AudioSink(name),
+    callback(nullptr) {
+}
+
+void CallbackSink::setCallback(AudioBlockCallback callback) {
+    this->callback = callback;
+}
+
+void CallbackSink::consume(const AudioFrame& frame) {
+    if (callback != nullptr) {
+        callback(frame.samples, frame.count);
+    }
+}
@@ -0,0 +1,260 @@
+#ifndef AUDIO_GRAPH_H
+#define AUDIO_GRAPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#ifndef AUDIO_GRAPH_MAX_FILTERS
+#define AUDIO_GRAPH_MAX_FILTERS 4
+#endif
+
+#ifndef AUDIO_GRAPH_MAX_SINKS
+#define AUDIO_GRAPH_MAX_SINKS 4
+#endif
+
+// One block of interleaved samples on its way through a graph. The buffer
+// belongs to whoever handed it out; nodes work on it in place.
+struct AudioFrame {
+    int16_t* samples;
+    size_t count;       // Samples in the frame, all channels
+    size_t capacity;    // Samples the buffer can hold
+    uint8_t channels;
+};
+
+// Free-running cycle counter for per-node accounting, e.g. ESP.getCycleCount
+typedef uint32_t (*AudioCycleClock)();
+
+// Receives a block of samples; the same shape as RealtimeAudioCallback
+typedef void (*AudioBlockCallback)(const int16_t* samples, size_t count);
+
+/**
+ * @class AudioNode
+ * @brief Name and cycle statistics shared by every graph node
+ */
+class AudioNode {
+public:
+    explicit AudioNode(const char* name);
+    virtual ~AudioNode() {}
+
+    const char* getName() const;
+    uint32_t getFrames() const;          // Frames the node has handled
+    uint32_t getAverageCycles() const;   // Per frame
+    uint32_t getMaxCycles() const;
+    void resetStats();
+
+private:
+    friend class AudioGraph;
+
+    const char* name;
+    uint32_t frames;
+    uint64_t totalCycles;
+    uint32_t maxCycles;
+
+    void account(uint32_t cycles);
+};
+
+/**
+ * @class AudioSource
+ * @brief Produces frames, e.g. from an I2S driver or a playback queue
+ */
+class AudioSource : public AudioNode {
+public:
+    explicit AudioSource(const char* name) : AudioNode(name) {}
+
+    /**
+     * @brief Fill frame.samples (at most frame.capacity) and set count and channels
+     * @return false if there was nothing to read
+     */
+    virtual bool read(AudioFrame& frame) = 0;
+};
+
+/**
+ * @class AudioFilter
+ * @brief Transforms a frame in place; the count may grow up to the capacity
+ */
+class AudioFilter : public AudioNode {
+public:
+    explicit AudioFilter(const char* name) : AudioNode(name) {}
+
+    /**
+     * @return false to drop the frame before it reaches the sinks
+     */
+    virtual bool process(AudioFrame& frame) = 0;
+};
+
+/**
+ * @class AudioSink
+ * @brief Final stage; every sink of a graph sees the same frame
+ */
+class AudioSink : public AudioNode {
+public:
+    explicit AudioSink(const char* name) : AudioNode(name) {}
+
+    virtual void consume(const AudioFrame& frame) = 0;
+
+    /**
+     * @brief Offer the storage the next frame should be read into, so a
+     *        sink that keeps samples gets them without a copy
+     * @param capacity Set to the samples the storage can take
+     * @return nullptr if the sink has nothing to offer
+     */
+    virtual int16_t* acquire(size_t& capacity) {
+        capacity = 0;
+        return nullptr;
+    }
+};
+
+/**
+ * @class AudioGraph
+ * @brief Pulls one frame at a time from a source through a chain of
+ *        filters and fans it out to up to AUDIO_GRAPH_MAX_SINKS sinks.
+ *
+ * Frames are never copied between nodes: the source reads into the storage
+ * offered by the first sink that has some (see AudioSink::acquire), or into
+ * the graph's own buffer, and every later node gets that frame by
+ * reference. With a clock set, the cycles each node spends are recorded.
+ *
+ * The graph does not own its nodes. It has no platform dependencies; the
+ * I2S nodes live with the microphone and speaker.
+ */
+class AudioGraph {
+public:
+    explicit AudioGraph(const char* name);
+
+    void setSource(AudioSource* source);
+    bool addFilter(AudioFilter* filter);     // Run in the order added; false when full
+    bool addSink(AudioSink* sink);           // false when full
+    bool removeSink(AudioSink* sink);
+
+    /**
+     * @brief Storage used when no sink offers any
+     */
+    void setBuffer(int16_t* buffer, size_t capacity);
+
+    void setClock(AudioCycleClock clock);
+
+    /**
+     * @brief Read one frame and pass it through the filters to the sinks
+     * @return true if a frame reached the sinks
+     */
+    bool run();
+
+    const char* getName() const;
+    uint32_t getFrames() const;              // Frames that reached the sinks
+    uint32_t getDropped() const;             // Frames a filter dropped
+    void resetStats();
+
+    /**
+     * @brief Format average/max cycles per frame of each node, e.g.
+     *        "AUDIO mic frames=1250 drop=0 | i2s_in=310/900 gain=2100/2300 chunker=40/60"
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t format(char* out, size_t size) const;
+
+private:
+    const char* name;
+    AudioSource* source;
+    AudioFilter* filters[AUDIO_GRAPH_MAX_FILTERS];
+    size_t filterCount;
+    AudioSink* sinks[AUDIO_GRAPH_MAX_SINKS];
+    size_t sinkCount;
+    int16_t* buffer;
+    size_t bufferCapacity;
+    AudioCycleClock clock;
+    uint32_t frames;
+    uint32_t dropped;
+
+    uint32_t now() const;
+};
+
+/**
+ * @class GainFilter
+ * @brief Scales samples, clamping to the int16 range
+ *
+ * The gain may be set from another task; each frame uses one value.
+ */
+class GainFilter : public AudioFilter {
+public:
+    GainFilter(const char* name, float gain);
+
+    void setGain(float gain);
+    float getGain() const;
+
+    bool process(AudioFrame& frame) override;
+
+private:
+    std::atomic<float> gain;
+};
+
+/**
+ * @class MonoToStereoFilter
+ * @brief Duplicates each sample to left and right, in place (back to
+ *        front), so the buffer must hold twice the mono samples
+ */
+class MonoToStereoFilter : public AudioFilter {
+public:
+    explicit MonoToStereoFilter(const char* name);
+
+    bool process(AudioFrame& frame) override;
+};
+
+/**
+ * @class BlockSink
+ * @brief Collects frames into a caller-owned block.
+ *
+ * Offers the rest of the block through acquire(), so the source reads
+ * straight into it. With a callback, each full block is delivered and
+ * filling starts over; without one, the sink stops at full. Frames read
+ * elsewhere are copied in.
+ */
+class BlockSink : public AudioSink {
+public:
+    explicit BlockSink(const char* name);
+
+    /**
+     * @brief Start filling a new block; nullptr detaches the sink
+     */
+    void setBlock(int16_t* block, size_t blockSize);
+    void setCallback(AudioBlockCallback callback);
+
+    /**
+     * @brief Change the block length within the storage given to setBlock(),
+     *        keeping what has been collected; if that already fills the new
+     *        length it is delivered at once. Don't call from the callback.
+     */
+    void resize(size_t blockSize);
+
+    size_t getBlockSize() const;
+    size_t getFill() const;
+    bool isFull() const;
+    void reset();                      // Discard what has been collected
+
+    void consume(const AudioFrame& frame) override;
+    int16_t* acquire(size_t& capacity) override;
+
+private:
+    int16_t* block;
+    size_t capacity;
+    size_t blockSize;
+    size_t fill;
+    AudioBlockCallback callback;
+};
+
+/**
+ * @class CallbackSink
+ * @brief Hands every frame to a callback, e.g. a detector
+ */
+class CallbackSink : public AudioSink {
+public:
+    explicit CallbackSink(const char* name);
+
+    void setCallback(AudioBlockCallback callback);   // nullptr to mute
+
+    void consume(const AudioFrame& frame) override;
+
+private:
+    AudioBlockCallback callback;
+};
+
+#endif
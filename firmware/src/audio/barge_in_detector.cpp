@@ -0,0 +1,92 @@
+#include "barge_in_detector.h"
+#include <math.h>
+
+static const uint32_t MIN_POWER = (uint32_t)BARGE_IN_MIN_RMS * BARGE_IN_MIN_RMS;
+
+BargeInDetector::BargeInDetector() {
+    reset();
+}
+
+void BargeInDetector::arm(uint32_t nowMs) {
+    armed = true;
+    armedMs = nowMs;
+    loudFrames = 0;
+    triggered = false;
+}
+
+bool BargeInDetector::processFrame(const int16_t* samples, size_t count, uint32_t nowMs) {
+    if (count == 0) {
+        return false;
+    }
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += (int32_t)samples[i] * samples[i];
+    }
+    uint32_t power = (uint32_t)(sum / count);
+
+    if (!haveFloor) {
+        floorPower = power;
+        haveFloor = true;
+    }
+
+    if (armed && nowMs - armedMs < BARGE_IN_ECHO_GRACE_MS) {
+        // Follow every frame so the floor lands on the echo level
+        floorPower = (uint32_t)((int64_t)floorPower + ((int64_t)power - floorPower) / 4);
+        loudFrames = 0;
+        return false;
+    }
+    armed = false;
+
+    uint64_t threshold = (uint64_t)floorPower * BARGE_IN_POWER_RATIO;
+    if (threshold < MIN_POWER) {
+        threshold = MIN_POWER;
+    }
+
+    if (power > threshold) {
+        if (loudFrames == 0) {
+            onsetMs = nowMs;
+        }
+        if (loudFrames < BARGE_IN_HOLD_FRAMES) {
+            loudFrames++;
+        }
+        if (loudFrames >= BARGE_IN_HOLD_FRAMES) {
+            lastSpeechMs = nowMs;
+        }
+        if (loudFrames >= BARGE_IN_HOLD_FRAMES && !triggered) {
+            triggered = true;
+            return true;
+        }
+        return false;
+    }
+
+    // Quiet frame: ends the burst and feeds the floor (fast down, slow up)
+    loudFrames = 0;
+    triggered = false;
+    int64_t delta = (int64_t)power - floorPower;
+    floorPower = (uint32_t)((int64_t)floorPower + delta / (delta < 0 ? 8 : 64));
+    return false;
+}
+
+uint32_t BargeInDetector::getOnsetMs() const {
+    return onsetMs;
+}
+
+uint32_t BargeInDetector::getLastSpeechMs() const {
+    return lastSpeechMs;
+}
+
+uint32_t BargeInDetector::getFloorRms() const {
+    return (uint32_t)sqrtf((float)floorPower);
+}
+
+void BargeInDetector::reset() {
+    floorPower = 0;
+    haveFloor = false;
+    armed = false;
+    armedMs = 0;
+    loudFrames = 0;
+    triggered = false;
+    onsetMs = 0;
+    lastSpeechMs = 0;
+}
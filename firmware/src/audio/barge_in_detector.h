@@ -0,0 +1,75 @@
+#ifndef BARGE_IN_DETECTOR_H
+#define BARGE_IN_DETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef BARGE_IN_MIN_RMS
+#define BARGE_IN_MIN_RMS 1200           // Frames quieter than this are never speech
+#endif
+
+#ifndef BARGE_IN_POWER_RATIO
+#define BARGE_IN_POWER_RATIO 10         // Speech must be this many times the floor's power (10 dB)
+#endif
+
+#ifndef BARGE_IN_HOLD_FRAMES
+#define BARGE_IN_HOLD_FRAMES 4          // Consecutive loud frames (~64 ms of 16 ms DMA reads)
+#endif
+
+#ifndef BARGE_IN_ECHO_GRACE_MS
+#define BARGE_IN_ECHO_GRACE_MS 300      // After arm(): learn the speaker echo, never trigger
+#endif
+
+/**
+ * @class BargeInDetector
+ * @brief Energy-based detector for the user talking over the agent.
+ *
+ * Runs on every microphone DMA read. A frame counts as speech when its
+ * power is BARGE_IN_POWER_RATIO above an adaptive floor (and above
+ * BARGE_IN_MIN_RMS); BARGE_IN_HOLD_FRAMES in a row trigger once per burst.
+ * The floor follows quiet frames - quickly down, slowly up - so steady
+ * noise and speaker echo are absorbed. arm() opens a short grace period in
+ * which the floor tracks every frame, letting it jump to the echo level
+ * when the agent starts talking.
+ */
+class BargeInDetector {
+public:
+    BargeInDetector();
+
+    /**
+     * @brief The agent started talking; relearn the floor for BARGE_IN_ECHO_GRACE_MS
+     */
+    void arm(uint32_t nowMs);
+
+    /**
+     * @brief Feed one frame of microphone samples
+     * @return true on the frame that completes a speech onset
+     */
+    bool processFrame(const int16_t* samples, size_t count, uint32_t nowMs);
+
+    /**
+     * @return Time of the first loud frame of the last onset
+     */
+    uint32_t getOnsetMs() const;
+
+    /**
+     * @return Time of the latest loud frame of a held burst; stops moving
+     *         when the user stops talking (0 before any speech)
+     */
+    uint32_t getLastSpeechMs() const;
+
+    uint32_t getFloorRms() const;
+    void reset();
+
+private:
+    uint32_t floorPower;        // Mean square of quiet frames
+    bool haveFloor;
+    bool armed;
+    uint32_t armedMs;
+    uint8_t loudFrames;
+    bool triggered;             // Until the burst ends
+    uint32_t onsetMs;
+    uint32_t lastSpeechMs;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "microphone.h"
 #include "../config.h"
+#include "../system/mem_tracker.h"
 #include "mbedtls/base64.h"
 
 #ifndef I2S_READ_TIMEOUT_MS
@@ -11,7 +12,10 @@ Microphone::Microphone() :
     bitsPerSample(16),
     bufferLen(256),
     recordingDuration(3),
-    gain(2.0f),  // Default gain factor
+    memoryPlan(nullptr),
+    recordingRegion(-1),
+    uplinkRegion(-1),
+    stagingRegion(-1),
     audioBuffer(nullptr),
     tempBuffer(nullptr),
     totalSamples(0),
@@ -21,11 +25,27 @@ Microphone::Microphone() :
     realtimeCallback(nullptr),
     realtimeBuffer(nullptr),
     realtimeChunkSize(0),
-    realtimeBufferIndex(0),
+    realtimeChunkMs(MIC_REALTIME_CHUNK_MS),
+    frameCallback(nullptr),
+    i2sInput(*this),
+    gainFilter("gain", 2.0f),  // Default gain factor
+    frameTap("frames"),
+    recorder("recorder"),
+    chunker("chunker"),
+    captureGraph("mic"),
     initialized(false),
     recording(false),
+    capturing(false),
     recordingComplete(false),
-    recordingStartTime(0) {
+    recordingStartTime(0),
+    eventQueue(nullptr) {
+    // The frame tap goes first so detectors see a read before its chunk is sent
+    captureGraph.setSource(&i2sInput);
+    captureGraph.addFilter(&gainFilter);
+    captureGraph.addSink(&frameTap);
+    captureGraph.addSink(&recorder);
+    captureGraph.addSink(&chunker);
+    captureGraph.setClock([]() -> uint32_t { return ESP.getCycleCount(); });
 }
 
 Microphone::~Microphone() {
@@ -33,6 +53,29 @@ Microphone::~Microphone() {
     freeBuffers();
 }
 
+bool Microphone::reserveMemory(MemoryPlan& plan, uint32_t sampleRate, int bufferLen) {
+    // The batch recording, the largest real-time chunk and one DMA read;
+    // the read is worked on in place, so it stays in internal RAM
+    recordingRegion = plan.add("mic_record", (size_t)sampleRate * MIC_MAX_RECORDING_SECONDS * sizeof(int16_t), MEM_PSRAM);
+    uplinkRegion = plan.add("uplink", (size_t)sampleRate * MIC_REALTIME_MAX_CHUNK_MS / 1000 * sizeof(int16_t), MEM_PSRAM);
+    stagingRegion = plan.add("mic_staging", bufferLen * sizeof(int16_t), MEM_INTERNAL);
+    if (recordingRegion < 0 || uplinkRegion < 0 || stagingRegion < 0) {
+        Serial.println("[MIC] ERROR: No room in the memory plan");
+        return false;
+    }
+    memoryPlan = &plan;
+    return true;
+}
+
+int16_t* Microphone::planned(int region, size_t& samples) const {
+    if (memoryPlan == nullptr) {
+        samples = 0;
+        return nullptr;
+    }
+    samples = memoryPlan->getSize(region) / sizeof(int16_t);
+    return (int16_t*)memoryPlan->get(region);
+}
+
 bool Microphone::begin(uint32_t sampleRate, uint8_t bitsPerSample, int bufferLen) {
     if (initialized) {
         Serial.println("[MIC] Already initialized");
@@ -81,16 +124,22 @@ bool Microphone::begin(uint32_t sampleRate, uint8_t bitsPerSample, int bufferLen
         return false;
     }
 
-    // Allocate temporary buffer (freed in stop())
-    tempBuffer = (int16_t*)malloc(bufferLen * sizeof(int16_t));
-    if (tempBuffer == nullptr) {
-        Serial.println("[MIC] ERROR: Failed to allocate temporary buffer");
+    // DMA staging buffer from the memory plan (detached in stop())
+    size_t stagingSamples = 0;
+    tempBuffer = planned(stagingRegion, stagingSamples);
+    if (tempBuffer == nullptr || stagingSamples < (size_t)bufferLen) {
+        Serial.println("[MIC] ERROR: No staging buffer; reserveMemory() and commit the plan before begin()");
+        tempBuffer = nullptr;
         i2s_stop(I2S_PORT);
         i2s_driver_uninstall(I2S_PORT);
         return false;
     }
+    captureGraph.setBuffer(tempBuffer, bufferLen);
 
+    // Idle until a recording or a real-time stream needs samples
     initialized = true;
+    capturing = true;
+    setCapture(false);
     Serial.println("[MIC] I2S microphone initialized successfully");
     return true;
 }
@@ -111,9 +160,10 @@ bool Microphone::startRecording(uint8_t durationSeconds) {
         return false;
     }
 
-    // Validate recording duration (max 60 seconds to prevent excessive PSRAM usage)
-    if (durationSeconds == 0 || durationSeconds > 60) {
-        Serial.printf("[MIC] ERROR: Invalid recording duration %d seconds (must be 1-60)\n", durationSeconds);
+    // Validate recording duration against the buffer reserved at boot
+    if (durationSeconds == 0 || durationSeconds > MIC_MAX_RECORDING_SECONDS) {
+        Serial.printf("[MIC] ERROR: Invalid recording duration %d seconds (must be 1-%d)\n", durationSeconds,
+                      MIC_MAX_RECORDING_SECONDS);
         return false;
     }
 
@@ -121,27 +171,21 @@ bool Microphone::startRecording(uint8_t durationSeconds) {
     this->totalSamples = sampleRate * recordingDuration;
     this->totalBytes = totalSamples * sizeof(int16_t);
 
-    // Validate total memory requirement
-    size_t psramFree = ESP.getFreePsram();
-    if (totalBytes > psramFree * 0.8) {  // Leave 20% free
-        Serial.printf("[MIC] ERROR: Recording requires %d bytes, but only %d bytes PSRAM available\n", 
-                      totalBytes, psramFree);
-        return false;
-    }
-
     Serial.printf("[MIC] Starting %d second recording...\n", recordingDuration);
     Serial.printf("[MIC] Sample rate: %d Hz\n", sampleRate);
     Serial.printf("[MIC] Total samples needed: %d\n", totalSamples);
     Serial.printf("[MIC] Total bytes needed: %d\n", totalBytes);
 
-    // Allocate PSRAM buffer for this recording
+    // Record into the planned PSRAM buffer
     if (!allocateBuffers()) {
         return false;
     }
 
     // Reset counters
+    recorder.setBlock(audioBuffer, totalSamples);
     samplesRecorded = 0;
     recordingComplete = false;
+    setCapture(true);
     recording = true;
     recordingStartTime = millis();
 
@@ -189,7 +233,7 @@ String Microphone::getBase64AudioData() {
     }
     
     // Allocate buffer for encoded data
-    char* encodedBuffer = (char*)malloc(encodedLen + 1);
+    char* encodedBuffer = (char*)memAlloc(MEM_TAG_MICROPHONE, encodedLen + 1);
     if (encodedBuffer == nullptr) {
         Serial.println("[MIC] ERROR: Failed to allocate encoding buffer");
         return "";
@@ -202,13 +246,13 @@ String Microphone::getBase64AudioData() {
     
     if (encodingResult != 0) {
         Serial.println("[MIC] ERROR: Base64 encoding failed");
-        free(encodedBuffer);
+        memFree(encodedBuffer);
         return "";
     }
     
     encodedBuffer[actualLen] = '\0';  // Null terminate
     String encodedData = String(encodedBuffer);
-    free(encodedBuffer);
+    memFree(encodedBuffer);
     
     Serial.printf("[MIC] Base64 encoding complete - Length: %d characters\n", encodedData.length());
     return encodedData;
@@ -261,22 +305,23 @@ void Microphone::stop() {
         i2s_stop(I2S_PORT);
         i2s_driver_uninstall(I2S_PORT);
         initialized = false;
+        capturing = false;
         Serial.println("[MIC] I2S driver stopped");
     }
     
-    // Free the temporary buffer here since it's allocated in begin()
+    // Detach the staging buffer here since it's attached in begin()
     if (tempBuffer != nullptr) {
-        free(tempBuffer);
+        captureGraph.setBuffer(nullptr, 0);
         tempBuffer = nullptr;
     }
 }
 
 void Microphone::setGain(float newGain) {
     if (newGain >= 0.1f && newGain <= 10.0f) {  // Reasonable range
-        gain = newGain;
-        Serial.printf("[MIC] Gain set to: %.2f\n", gain);
+        gainFilter.setGain(newGain);
+        Serial.printf("[MIC] Gain set to: %.2f\n", newGain);
     } else {
-        Serial.printf("[MIC] WARNING: Invalid gain value %.2f, keeping current value %.2f\n", newGain, gain);
+        Serial.printf("[MIC] WARNING: Invalid gain value %.2f, keeping current value %.2f\n", newGain, gainFilter.getGain());
     }
 }
 
@@ -288,12 +333,13 @@ bool Microphone::installI2S() {
         .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
         .communication_format = i2s_comm_format_t(I2S_COMM_FORMAT_STAND_I2S),
         .intr_alloc_flags = 0,
-        .dma_buf_count = 6,
+        .dma_buf_count = MIC_DMA_BUF_COUNT,
         .dma_buf_len = bufferLen,
         .use_apll = false
     };
 
-    esp_err_t err = i2s_driver_install(I2S_PORT, &i2s_config, 0, NULL);
+    // The driver posts I2S_EVENT_RX_DONE for every filled DMA buffer
+    esp_err_t err = i2s_driver_install(I2S_PORT, &i2s_config, MIC_EVENT_QUEUE_LENGTH, &eventQueue);
     if (err != ESP_OK) {
         Serial.printf("[MIC] ERROR: I2S driver install failed: %s\n", esp_err_to_name(err));
         return false;
@@ -323,23 +369,37 @@ bool Microphone::allocateBuffers() {
     // Free existing buffer if any
     freeBuffers();
 
-    // Allocate PSRAM buffer for audio data
-    audioBuffer = (int16_t*)ps_malloc(totalBytes);
-    if (audioBuffer == nullptr) {
-        Serial.printf("[MIC] ERROR: Failed to allocate %d bytes in PSRAM\n", totalBytes);
+    size_t capacity = 0;
+    audioBuffer = planned(recordingRegion, capacity);
+    if (audioBuffer == nullptr || capacity < totalSamples) {
+        Serial.printf("[MIC] ERROR: No planned buffer for %d bytes\n", totalBytes);
+        audioBuffer = nullptr;
         return false;
     }
 
-    Serial.printf("[MIC] Allocated %d bytes in PSRAM for audio buffer\n", totalBytes);
     return true;
 }
 
 void Microphone::freeBuffers() {
     if (audioBuffer != nullptr) {
-        free(audioBuffer);  // This is correct - ps_malloc memory is freed with regular free()
+        recorder.setBlock(nullptr, 0);
         audioBuffer = nullptr;
     }
-    // Note: tempBuffer is not freed here - it's managed separately in stop()
+    // Note: tempBuffer is not detached here - it's managed separately in stop()
+}
+
+void Microphone::setCapture(bool on) {
+    if (!initialized || on == capturing) {
+        return;
+    }
+
+    // Only the channel stops; the driver and its event queue stay installed
+    esp_err_t err = on ? i2s_start(I2S_PORT) : i2s_stop(I2S_PORT);
+    if (err != ESP_OK) {
+        Serial.printf("[MIC] ERROR: Failed to %s I2S: %s\n", on ? "start" : "stop", esp_err_to_name(err));
+        return;
+    }
+    capturing = on;
 }
 
 bool Microphone::recordChunk() {
@@ -351,34 +411,15 @@ bool Microphone::recordChunk() {
     if (tempBuffer == nullptr || audioBuffer == nullptr) {
         Serial.println("[MIC] ERROR: Buffers not allocated!");
         recording = false;
+        setCapture(realtimeStreaming);
         return false;
     }
 
-    size_t bytesIn = 0;
-    esp_err_t err = i2s_read(I2S_PORT, tempBuffer, bufferLen * sizeof(int16_t), &bytesIn, pdMS_TO_TICKS(I2S_READ_TIMEOUT_MS));  // 100ms timeout
-    
-    if (err == ESP_OK && bytesIn > 0) {
-        size_t samplesToCopy = bytesIn / sizeof(int16_t);
-        
-        // Make sure we don't exceed our buffer
-        if (samplesRecorded + samplesToCopy > totalSamples) {
-            samplesToCopy = totalSamples - samplesRecorded;
-        }
-        
-        // Copy samples to PSRAM buffer with configurable gain
-        // memcpy(&audioBuffer[samplesRecorded], tempBuffer, samplesToCopy * sizeof(int16_t));
-
-        for (size_t i = 0; i < samplesToCopy; ++i) {
-            int32_t amplifiedSample = static_cast<int32_t>(tempBuffer[i] * gain);
-
-            // Clip to int16_t range to avoid overflow
-            if (amplifiedSample > INT16_MAX) amplifiedSample = INT16_MAX;
-            if (amplifiedSample < INT16_MIN) amplifiedSample = INT16_MIN;
-
-            audioBuffer[samplesRecorded + i] = static_cast<int16_t>(amplifiedSample);
-        }
-
-        samplesRecorded += samplesToCopy;
+    // The recorder offers the rest of audioBuffer, so the read lands in
+    // place and the gain is applied there
+    i2sInput.setTimeout(I2S_READ_TIMEOUT_MS);
+    if (captureGraph.run()) {
+        samplesRecorded = recorder.getFill();
         
         // Progress indicator every second
         if (samplesRecorded % sampleRate == 0) {
@@ -387,23 +428,23 @@ bool Microphone::recordChunk() {
         }
         
         // Check if recording is complete
-        if (samplesRecorded >= totalSamples) {
+        if (recorder.isFull()) {
             recording = false;
             recordingComplete = true;
+            setCapture(realtimeStreaming);
             unsigned long recordingTime = millis() - recordingStartTime;
             Serial.printf("[MIC] Recording complete! Duration: %lu ms\n", recordingTime);
             Serial.printf("[MIC] Total samples recorded: %d\n", samplesRecorded);
             Serial.printf("[MIC] Total bytes recorded: %d\n", samplesRecorded * sizeof(int16_t));
             return false;
         }
-    } else if (err == ESP_ERR_TIMEOUT) {
-        // Timeout is normal during recording, just continue
-        return true;
-    } else {
-        Serial.printf("[MIC] ERROR: I2S read failed: %s\n", esp_err_to_name(err));
+    } else if (i2sInput.getLastError() != ESP_OK && i2sInput.getLastError() != ESP_ERR_TIMEOUT) {
+        Serial.printf("[MIC] ERROR: I2S read failed: %s\n", esp_err_to_name(i2sInput.getLastError()));
         recording = false;
+        setCapture(realtimeStreaming);
         return false;
     }
+    // Timeout is normal during recording, just continue
     
     return true; // Continue recording
 }
@@ -425,21 +466,27 @@ bool Microphone::startRealtimeStreaming(RealtimeAudioCallback callback) {
         return false;
     }
     
-    // Calculate 250ms chunk size (like Python SDK INPUT_FRAMES_PER_BUFFER=4000)
-    realtimeChunkSize = (sampleRate * 250) / 1000;  // 250ms at current sample rate
+    // 250ms by default (like Python SDK INPUT_FRAMES_PER_BUFFER=4000)
+    realtimeChunkSize = (sampleRate * realtimeChunkMs) / 1000;
     
-    // Allocate real-time buffer
-    realtimeBuffer = (int16_t*)ps_malloc(realtimeChunkSize * sizeof(int16_t));
-    if (!realtimeBuffer) {
-        Serial.println("[MIC] Failed to allocate real-time buffer");
+    // Planned for the largest chunk, so the length can change while streaming
+    size_t capacity = 0;
+    realtimeBuffer = planned(uplinkRegion, capacity);
+    if (!realtimeBuffer || capacity < realtimeChunkSize) {
+        Serial.println("[MIC] No planned real-time buffer");
+        realtimeBuffer = nullptr;
         return false;
     }
     
     realtimeCallback = callback;
-    realtimeBufferIndex = 0;
+    chunker.setBlock(realtimeBuffer, capacity);
+    chunker.resize(realtimeChunkSize);
+    chunker.setCallback(callback);
+    frameTap.setCallback(frameCallback);
+    setCapture(true);
     realtimeStreaming = true;
     
-    Serial.printf("[MIC] Started real-time streaming (250ms = %d samples)\n", realtimeChunkSize);
+    Serial.printf("[MIC] Started real-time streaming (%lums = %d samples)\n", (unsigned long)realtimeChunkMs, realtimeChunkSize);
     return true;
 }
 
@@ -449,48 +496,88 @@ void Microphone::stopRealtimeStreaming() {
     }
     
     realtimeStreaming = false;
+    setCapture(recording);
     realtimeCallback = nullptr;
+    chunker.setBlock(nullptr, 0);
+    chunker.setCallback(nullptr);
+    frameTap.setCallback(nullptr);
     
-    if (realtimeBuffer) {
-        free(realtimeBuffer);
-        realtimeBuffer = nullptr;
-    }
+    realtimeBuffer = nullptr;
     
-    realtimeBufferIndex = 0;
     Serial.println("[MIC] Stopped real-time streaming");
 }
 
+void Microphone::setRealtimeChunkMs(uint32_t chunkMs) {
+    if (chunkMs == 0 || chunkMs > MIC_REALTIME_MAX_CHUNK_MS) {
+        chunkMs = MIC_REALTIME_MAX_CHUNK_MS;
+    }
+    realtimeChunkMs = chunkMs;
+    // The chunker picks it up in realtimeLoop(), outside its own callback
+    realtimeChunkSize = (sampleRate * chunkMs) / 1000;
+}
+
+uint32_t Microphone::getRealtimeChunkMs() const {
+    return realtimeChunkMs;
+}
+
 bool Microphone::isRealtimeStreaming() {
     return realtimeStreaming && initialized;
 }
 
+void Microphone::setFrameCallback(RealtimeAudioCallback callback) {
+    frameCallback = callback;
+    if (realtimeStreaming) {
+        frameTap.setCallback(callback);
+    }
+}
+
+QueueHandle_t Microphone::getEventQueue() const {
+    return eventQueue;
+}
+
+const AudioGraph& Microphone::getAudioGraph() const {
+    return captureGraph;
+}
+
 void Microphone::realtimeLoop() {
     if (!realtimeStreaming || !initialized || !realtimeCallback) {
         return;
     }
     
-    // Read audio data
+    if (chunker.getBlockSize() != realtimeChunkSize) {
+        chunker.resize(realtimeChunkSize);
+    }
+
+    // The read lands in the chunk being built; every read goes to the
+    // frame tap and each full chunk to realtimeCallback
+    i2sInput.setTimeout(10);
+    captureGraph.run();
+}
+
+Microphone::I2SInput::I2SInput(Microphone& microphone) :
+    AudioSource("i2s_in"),
+    microphone(microphone),
+    timeoutMs(I2S_READ_TIMEOUT_MS),
+    lastError(ESP_OK) {
+}
+
+void Microphone::I2SInput::setTimeout(uint32_t timeoutMs) {
+    this->timeoutMs = timeoutMs;
+}
+
+esp_err_t Microphone::I2SInput::getLastError() const {
+    return lastError;
+}
+
+bool Microphone::I2SInput::read(AudioFrame& frame) {
+    size_t samples = min((size_t)microphone.bufferLen, frame.capacity);
     size_t bytesIn = 0;
-    esp_err_t err = i2s_read(I2S_PORT, tempBuffer, bufferLen * sizeof(int16_t), &bytesIn, pdMS_TO_TICKS(10));
-    
-    if (err == ESP_OK && bytesIn > 0) {
-        size_t samplesRead = bytesIn / sizeof(int16_t);
-        
-        for (size_t i = 0; i < samplesRead && realtimeBufferIndex < realtimeChunkSize; i++) {
-            // Apply gain
-            int32_t amplifiedSample = static_cast<int32_t>(tempBuffer[i] * gain);
-            if (amplifiedSample > INT16_MAX) amplifiedSample = INT16_MAX;
-            if (amplifiedSample < INT16_MIN) amplifiedSample = INT16_MIN;
-            
-            realtimeBuffer[realtimeBufferIndex++] = static_cast<int16_t>(amplifiedSample);
-            
-            // Check if chunk is complete
-            if (realtimeBufferIndex >= realtimeChunkSize) {
-                // Send 250ms chunk (like Python SDK)
-                realtimeCallback(realtimeBuffer, realtimeChunkSize);
-                realtimeBufferIndex = 0;
-                return; // Process next chunk in next call
-            }
-        }
+    lastError = i2s_read(I2S_PORT, frame.samples, samples * sizeof(int16_t), &bytesIn, pdMS_TO_TICKS(timeoutMs));
+    if (lastError != ESP_OK || bytesIn == 0) {
+        return false;
     }
+    
+    frame.count = bytesIn / sizeof(int16_t);
+    frame.channels = 1;
+    return true;
 }
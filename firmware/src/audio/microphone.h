@@ -3,6 +3,17 @@
 
 #include <driver/i2s.h>
 #include <Arduino.h>
+#include "audio_graph.h"
+#include "../system/memory_plan.h"
+
+#define MIC_DMA_BUF_COUNT 6
+#define MIC_EVENT_QUEUE_LENGTH 8  // I2S driver events (one per DMA buffer filled)
+#define MIC_REALTIME_CHUNK_MS 250       // Default real-time chunk (like Python SDK)
+#define MIC_REALTIME_MAX_CHUNK_MS 500   // Largest chunk setRealtimeChunkMs() accepts
+
+#ifndef MIC_MAX_RECORDING_SECONDS
+#define MIC_MAX_RECORDING_SECONDS 10    // Batch recording buffer reserved at boot
+#endif
 
 // Real-time audio callback type (like Python SDK input_callback)
 typedef void (*RealtimeAudioCallback)(const int16_t* audioData, size_t samples);
@@ -27,7 +38,18 @@ public:
     ~Microphone();
 
     /**
-     * @brief Initialize the I2S microphone with specified parameters
+     * @brief Reserve the recording, uplink chunk and DMA staging buffers in
+     *        the boot-time memory plan; call before the plan is committed
+     * @param plan Plan to add the regions to
+     * @param sampleRate Sample rate begin() will be called with
+     * @param bufferLen DMA buffer length begin() will be called with
+     * @return true if the regions were added
+     */
+    bool reserveMemory(MemoryPlan& plan, uint32_t sampleRate = 16000, int bufferLen = 256);
+
+    /**
+     * @brief Initialize the I2S microphone with specified parameters;
+     *        the memory plan must be committed by now
      * @param sampleRate Sample rate for recording (default from config.h)
      * @param bitsPerSample Bits per sample (16-bit)
      * @param bufferLen DMA buffer length
@@ -37,7 +59,7 @@ public:
 
     /**
      * @brief Start recording audio for specified duration
-     * @param durationSeconds Duration to record in seconds
+     * @param durationSeconds Duration to record in seconds, up to MIC_MAX_RECORDING_SECONDS
      * @return true if recording started successfully, false otherwise
      */
     bool startRecording(uint8_t durationSeconds = 3);
@@ -61,7 +83,8 @@ public:
     bool isRecordingComplete();
 
     /**
-     * @brief Get the recorded audio data as base64 encoded string
+     * @brief Get the recorded audio data as base64 encoded string. Allocates,
+     *        so it has no place on the audio path
      * @return String containing base64 encoded audio data
      */
     String getBase64AudioData();
@@ -105,6 +128,14 @@ public:
      */
     bool startRealtimeStreaming(RealtimeAudioCallback callback);
 
+    /**
+     * @brief Change the real-time chunk length, up to MIC_REALTIME_MAX_CHUNK_MS;
+     *        applied before the next read, keeping audio already collected
+     * @param chunkMs Chunk length in milliseconds
+     */
+    void setRealtimeChunkMs(uint32_t chunkMs);
+    uint32_t getRealtimeChunkMs() const;
+
     /**
      * @brief Stop real-time audio streaming
      */
@@ -121,7 +152,43 @@ public:
      */
     void realtimeLoop();
 
+    /**
+     * @brief Also receive every DMA read while streaming (after gain), e.g.
+     *        for barge-in detection; the 250ms chunk callback is unchanged
+     * @param callback Function to call per read, nullptr to remove
+     */
+    void setFrameCallback(RealtimeAudioCallback callback);
+
+    /**
+     * @brief I2S driver event queue; an I2S_EVENT_RX_DONE means a DMA buffer
+     *        is ready for loop() or realtimeLoop()
+     * @return Queue handle, or nullptr before begin()
+     */
+    QueueHandle_t getEventQueue() const;
+
+    /**
+     * @brief Capture graph (I2S -> gain -> frame tap, recorder, chunker),
+     *        for its per-node cycle statistics
+     */
+    const AudioGraph& getAudioGraph() const;
+
 private:
+    /**
+     * @brief Graph source: one DMA read into the frame
+     */
+    class I2SInput : public AudioSource {
+    public:
+        explicit I2SInput(Microphone& microphone);
+        void setTimeout(uint32_t timeoutMs);
+        esp_err_t getLastError() const;
+        bool read(AudioFrame& frame) override;
+
+    private:
+        Microphone& microphone;
+        uint32_t timeoutMs;
+        esp_err_t lastError;
+    };
+
     // I2S pin configuration for INMP441
     static const int I2S_WS_PIN = 42;
     static const int I2S_SD_PIN = 41;
@@ -133,9 +200,12 @@ private:
     uint8_t bitsPerSample;
     int bufferLen;
     uint8_t recordingDuration;
-    float gain;  // Audio gain factor
     
-    // Audio buffers
+    // Audio buffers, all regions of the memory plan
+    MemoryPlan* memoryPlan;
+    int recordingRegion;
+    int uplinkRegion;
+    int stagingRegion;
     int16_t* audioBuffer;
     int16_t* tempBuffer;
     size_t totalSamples;
@@ -146,14 +216,26 @@ private:
     bool realtimeStreaming;
     RealtimeAudioCallback realtimeCallback;
     int16_t* realtimeBuffer;
-    size_t realtimeChunkSize;  // 250ms worth of samples
-    size_t realtimeBufferIndex;
+    size_t realtimeChunkSize;  // Samples per chunk, 250ms by default
+    uint32_t realtimeChunkMs;
+    RealtimeAudioCallback frameCallback;
+    
+    // Capture graph. The recorder (batch) or the chunker (real-time) offers
+    // the tail of its buffer, so DMA reads land in place and gain runs there
+    I2SInput i2sInput;
+    GainFilter gainFilter;
+    CallbackSink frameTap;
+    BlockSink recorder;
+    BlockSink chunker;
+    AudioGraph captureGraph;
     
     // State management
     bool initialized;
     bool recording;
+    bool capturing;         // I2S channel running; only while recording or streaming
     bool recordingComplete;
     unsigned long recordingStartTime;
+    QueueHandle_t eventQueue;
 
     /**
      * @brief Install and configure I2S driver
@@ -168,16 +250,32 @@ private:
     bool configurePins();
 
     /**
-     * @brief Allocate PSRAM buffer for audio storage
+     * @brief Point the recorder at the planned recording buffer
      * @return true if successful, false otherwise
      */
     bool allocateBuffers();
 
     /**
-     * @brief Free allocated buffers
+     * @brief Detach the recording buffer; the plan keeps the memory
      */
     void freeBuffers();
 
+    /**
+     * @brief A committed plan region
+     * @param region Region id from reserveMemory()
+     * @param samples Set to the region's capacity in samples
+     * @return The region, or nullptr if there is none
+     */
+    int16_t* planned(int region, size_t& samples) const;
+
+    /**
+     * @brief Start or stop the I2S channel. A running channel holds the
+     *        driver's PM lock and raises a DMA event per buffer, so it is
+     *        stopped whenever nothing consumes samples
+     * @param on true while recording or real-time streaming
+     */
+    void setCapture(bool on);
+
     /**
      * @brief Internal recording loop - non-blocking
      * @return true if more recording needed, false if complete
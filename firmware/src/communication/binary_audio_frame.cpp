@@ -0,0 +1,42 @@
+#include "binary_audio_frame.h"
+
+bool parseBinaryAudioFrame(const uint8_t* frame, size_t size, BinaryAudioFrame& out) {
+    if (frame == nullptr || size < BINARY_AUDIO_HEADER_SIZE || frame[0] != BINARY_AUDIO_VERSION) {
+        return false;
+    }
+
+    uint32_t length = (uint32_t)frame[8] | ((uint32_t)frame[9] << 8) |
+                      ((uint32_t)frame[10] << 16) | ((uint32_t)frame[11] << 24);
+    if (length != size - BINARY_AUDIO_HEADER_SIZE || binaryAudioSampleRate(frame[1]) == 0) {
+        return false;
+    }
+
+    out.format = frame[1];
+    out.eventId = (uint32_t)frame[4] | ((uint32_t)frame[5] << 8) |
+                  ((uint32_t)frame[6] << 16) | ((uint32_t)frame[7] << 24);
+    out.pcm = frame + BINARY_AUDIO_HEADER_SIZE;
+    out.length = length;
+    return true;
+}
+
+size_t writeBinaryAudioHeader(uint8_t* out, uint8_t format, uint32_t eventId, uint32_t length) {
+    out[0] = BINARY_AUDIO_VERSION;
+    out[1] = format;
+    out[2] = 0;
+    out[3] = 0;
+    for (int i = 0; i < 4; i++) {
+        out[4 + i] = (uint8_t)(eventId >> (8 * i));
+        out[8 + i] = (uint8_t)(length >> (8 * i));
+    }
+    return BINARY_AUDIO_HEADER_SIZE;
+}
+
+uint32_t binaryAudioSampleRate(uint8_t format) {
+    switch (format) {
+        case BINARY_AUDIO_FORMAT_PCM_16000: return 16000;
+        case BINARY_AUDIO_FORMAT_PCM_22050: return 22050;
+        case BINARY_AUDIO_FORMAT_PCM_24000: return 24000;
+        case BINARY_AUDIO_FORMAT_PCM_44100: return 44100;
+        default: return 0;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef BINARY_AUDIO_FRAME_H
+#define BINARY_AUDIO_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary audio frame, sent by a compatible relay instead of a base64
+ * "audio" JSON event. All integers little-endian:
+ *
+ *   uint8  version   BINARY_AUDIO_VERSION
+ *   uint8  format    BINARY_AUDIO_FORMAT_*
+ *   uint16 reserved  0
+ *   uint32 event_id  Same meaning as audio_event.event_id
+ *   uint32 length    PCM payload bytes that follow the header
+ *
+ * The client asks for this transport by adding audio_transport=binary to
+ * the connection URL; servers that don't know the parameter ignore it and
+ * keep sending JSON.
+ */
+#define BINARY_AUDIO_VERSION 1
+#define BINARY_AUDIO_HEADER_SIZE 12
+
+#define BINARY_AUDIO_FORMAT_PCM_16000 1
+#define BINARY_AUDIO_FORMAT_PCM_22050 2
+#define BINARY_AUDIO_FORMAT_PCM_24000 3
+#define BINARY_AUDIO_FORMAT_PCM_44100 4
+
+struct BinaryAudioFrame {
+    uint8_t format;
+    uint32_t eventId;
+    const uint8_t* pcm;   // Points into the frame - no copy
+    size_t length;
+};
+
+/**
+ * @brief Validate a binary frame and locate its PCM payload
+ * @param frame Complete WebSocket binary message
+ * @param size Message size in bytes
+ * @param out Parsed header; out.pcm points into frame
+ * @return false if the header is malformed or the length doesn't match
+ */
+bool parseBinaryAudioFrame(const uint8_t* frame, size_t size, BinaryAudioFrame& out);
+
+/**
+ * @brief Write a frame header (used by tests and host tools)
+ * @param out Buffer of at least BINARY_AUDIO_HEADER_SIZE bytes
+ * @return Number of bytes written
+ */
+size_t writeBinaryAudioHeader(uint8_t* out, uint8_t format, uint32_t eventId, uint32_t length);
+
+/**
+ * @brief Sample rate of a format code
+ * @return Rate in Hz, or 0 for an unknown format
+ */
+uint32_t binaryAudioSampleRate(uint8_t format);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef CA_BUNDLE_H
+#define CA_BUNDLE_H
+
+/**
+ * @brief Root CAs that api.elevenlabs.io's certificate is checked against
+ *
+ * Several public roots rather than the one that signed today's
+ * certificate, so a change of certificate authority on the server side
+ * doesn't lock every device out. Run
+ * `tools/tls_resumption_check.py --host api.elevenlabs.io --firmware-roots`
+ * to check that the live chain ends at one of them.
+ */
+extern const char elevenlabs_ca_bundle[];
+
+#endif
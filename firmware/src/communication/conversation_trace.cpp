@@ -0,0 +1,189 @@
+#include "conversation_trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
+
+static void writeU32(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t readU32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+ConversationTrace::ConversationTrace() :
+    buffer(nullptr),
+    bufferCapacity(0),
+    used(0),
+    startMs(0),
+    recordCount(0),
+    recording(false),
+    truncated(false) {
+}
+
+ConversationTrace::~ConversationTrace() {
+    end();
+}
+
+bool ConversationTrace::begin(size_t capacity) {
+    if (buffer != nullptr && bufferCapacity == capacity) {
+        return true;
+    }
+    end();
+
+    if (capacity < TRACE_HEADER_SIZE) {
+        return false;
+    }
+
+#ifdef ESP_PLATFORM
+    buffer = (uint8_t*)heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buffer == nullptr) {
+        buffer = (uint8_t*)malloc(capacity);
+    }
+#else
+    buffer = (uint8_t*)malloc(capacity);
+#endif
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    bufferCapacity = capacity;
+    start(0);
+    recording = false;
+    return true;
+}
+
+void ConversationTrace::end() {
+    free(buffer);
+    buffer = nullptr;
+    bufferCapacity = 0;
+    used = 0;
+    recordCount = 0;
+    recording = false;
+    truncated = false;
+}
+
+void ConversationTrace::start(uint32_t nowMs) {
+    if (buffer == nullptr) {
+        return;
+    }
+
+    memcpy(buffer, TRACE_MAGIC, 8);
+    writeU32(buffer + 8, TRACE_VERSION);
+    writeU32(buffer + 12, 0);
+    used = TRACE_HEADER_SIZE;
+
+    startMs = nowMs;
+    recordCount = 0;
+    truncated = false;
+    recording = true;
+}
+
+void ConversationTrace::stop() {
+    recording = false;
+}
+
+bool ConversationTrace::record(uint32_t nowMs, bool binary, const uint8_t* payload, size_t length) {
+    if (!recording) {
+        return false;
+    }
+
+    if (used + TRACE_RECORD_HEADER_SIZE + length > bufferCapacity) {
+        truncated = true;
+        recording = false;
+        return false;
+    }
+
+    uint8_t* out = buffer + used;
+    writeU32(out, nowMs - startMs);
+    writeU32(out + 4, (uint32_t)length);
+    out[8] = binary ? TRACE_KIND_BINARY : TRACE_KIND_TEXT;
+    out[9] = out[10] = out[11] = 0;
+    if (length > 0) {
+        memcpy(out + TRACE_RECORD_HEADER_SIZE, payload, length);
+    }
+
+    used += TRACE_RECORD_HEADER_SIZE + length;
+    recordCount++;
+    return true;
+}
+
+bool ConversationTrace::isRecording() const {
+    return recording;
+}
+
+bool ConversationTrace::isTruncated() const {
+    return truncated;
+}
+
+const uint8_t* ConversationTrace::data() const {
+    return buffer;
+}
+
+size_t ConversationTrace::size() const {
+    return used;
+}
+
+size_t ConversationTrace::capacity() const {
+    return bufferCapacity;
+}
+
+uint32_t ConversationTrace::getRecordCount() const {
+    return recordCount;
+}
+
+TraceReader::TraceReader() :
+    data(nullptr),
+    size(0),
+    offset(0) {
+}
+
+bool TraceReader::open(const uint8_t* trace, size_t traceSize) {
+    data = nullptr;
+    size = 0;
+    offset = 0;
+
+    if (trace == nullptr || traceSize < TRACE_HEADER_SIZE) {
+        return false;
+    }
+    if (memcmp(trace, TRACE_MAGIC, 8) != 0 || readU32(trace + 8) != TRACE_VERSION) {
+        return false;
+    }
+
+    data = trace;
+    size = traceSize;
+    offset = TRACE_HEADER_SIZE;
+    return true;
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    if (data == nullptr || offset + TRACE_RECORD_HEADER_SIZE > size) {
+        return false;
+    }
+
+    const uint8_t* header = data + offset;
+    uint32_t length = readU32(header + 4);
+    if (offset + TRACE_RECORD_HEADER_SIZE + length > size) {
+        return false;
+    }
+
+    record.timestampMs = readU32(header);
+    record.length = length;
+    record.binary = header[8] == TRACE_KIND_BINARY;
+    record.data = header + TRACE_RECORD_HEADER_SIZE;
+
+    offset += TRACE_RECORD_HEADER_SIZE + length;
+    return true;
+}
+
+void TraceReader::rewind() {
+    if (data != nullptr) {
+        offset = TRACE_HEADER_SIZE;
+    }
+}
@@ -0,0 +1,127 @@
+#ifndef CONVERSATION_TRACE_H
+#define CONVERSATION_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE (512 * 1024)   // Device capture buffer (PSRAM)
+#endif
+
+/*
+ * Trace layout (all integers little-endian):
+ *
+ *   file header   "ELTRACE1" | uint32 version | uint32 reserved
+ *   each record   uint32 timestamp_ms | uint32 length | uint8 kind | 3 x reserved | payload
+ *
+ * timestamp_ms is relative to start(); kind is TRACE_KIND_TEXT or
+ * TRACE_KIND_BINARY. Payloads are complete (reassembled) inbound messages.
+ */
+#define TRACE_MAGIC "ELTRACE1"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 16
+#define TRACE_RECORD_HEADER_SIZE 12
+
+#define TRACE_KIND_TEXT 0
+#define TRACE_KIND_BINARY 1
+
+struct TraceRecord {
+    uint32_t timestampMs;
+    bool binary;
+    const uint8_t* data;
+    uint32_t length;
+};
+
+/**
+ * @class ConversationTrace
+ * @brief Records inbound WebSocket messages with timestamps into one
+ *        preallocated buffer, in a format the host replay driver reads.
+ *
+ * Recording stops (and the trace is marked truncated) when the buffer is
+ * full; it never reallocates.
+ */
+class ConversationTrace {
+public:
+    ConversationTrace();
+    ~ConversationTrace();
+
+    /**
+     * @brief Allocate the trace buffer (PSRAM on the device)
+     * @param capacity Buffer size in bytes, including the file header
+     * @return true if the buffer is available
+     */
+    bool begin(size_t capacity = TRACE_BUFFER_SIZE);
+
+    /**
+     * @brief Free the trace buffer
+     */
+    void end();
+
+    /**
+     * @brief Discard recorded messages and start a new trace
+     * @param nowMs Current time; record timestamps are relative to it
+     */
+    void start(uint32_t nowMs);
+
+    /**
+     * @brief Stop accepting records (the trace stays readable)
+     */
+    void stop();
+
+    /**
+     * @brief Append one inbound message
+     * @param nowMs Current time in milliseconds
+     * @param binary true for a binary frame, false for text
+     * @return false if not recording or the buffer is full
+     */
+    bool record(uint32_t nowMs, bool binary, const uint8_t* data, size_t length);
+
+    bool isRecording() const;
+    bool isTruncated() const;
+    const uint8_t* data() const;
+    size_t size() const;
+    size_t capacity() const;
+    uint32_t getRecordCount() const;
+
+private:
+    uint8_t* buffer;
+    size_t bufferCapacity;
+    size_t used;
+    uint32_t startMs;
+    uint32_t recordCount;
+    bool recording;
+    bool truncated;
+};
+
+/**
+ * @class TraceReader
+ * @brief Iterates over the records of a trace held in memory.
+ */
+class TraceReader {
+public:
+    TraceReader();
+
+    /**
+     * @brief Attach to a trace image and validate its header
+     * @return true if the header is valid
+     */
+    bool open(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Read the next record; record.data points into the trace image
+     * @return false at the end of the trace or on a truncated record
+     */
+    bool next(TraceRecord& record);
+
+    /**
+     * @brief Go back to the first record
+     */
+    void rewind();
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "fragment_assembler.h"
+#include <stdlib.h>
+#include <string.h>
+#include "../system/mem_tracker.h"
+
+FragmentAssembler::FragmentAssembler() :
+    buffer(nullptr),
+    bufferCapacity(0),
+    used(0),
+    binary(false),
+    assembling(false),
+    dropping(false),
+    messagesAssembled(0),
+    fragmentsReceived(0),
+    messagesDropped(0),
+    bytesAssembled(0) {
+}
+
+FragmentAssembler::~FragmentAssembler() {
+    end();
+}
+
+bool FragmentAssembler::begin(size_t capacity) {
+    if (buffer != nullptr) {
+        return true;  // Already allocated
+    }
+
+    // One extra byte for the null terminator
+    buffer = (uint8_t*)memAllocPsram(MEM_TAG_NETWORK, capacity + 1);
+    if (buffer == nullptr) {
+        bufferCapacity = 0;
+        return false;
+    }
+
+    bufferCapacity = capacity;
+    messagesAssembled = 0;
+    fragmentsReceived = 0;
+    messagesDropped = 0;
+    bytesAssembled = 0;
+    reset();
+    return true;
+}
+
+void FragmentAssembler::end() {
+    if (buffer != nullptr) {
+        memFree(buffer);
+        buffer = nullptr;
+    }
+    bufferCapacity = 0;
+    reset();
+}
+
+bool FragmentAssembler::start(const uint8_t* data, size_t length, bool binary) {
+    if (assembling && !dropping) {
+        // Previous message never finished - it can't be completed any more
+        messagesDropped++;
+    }
+
+    used = 0;
+    this->binary = binary;
+    assembling = true;
+    dropping = (buffer == nullptr);
+    if (dropping) {
+        messagesDropped++;
+    }
+
+    return store(data, length);
+}
+
+bool FragmentAssembler::append(const uint8_t* data, size_t length) {
+    if (!assembling) {
+        return false;  // Continuation without a start
+    }
+    return store(data, length);
+}
+
+bool FragmentAssembler::finish(const uint8_t* data, size_t length) {
+    if (!assembling) {
+        return false;
+    }
+
+    bool stored = store(data, length);
+    assembling = false;
+
+    if (!stored || dropping) {
+        used = 0;
+        return false;
+    }
+
+    buffer[used] = '\0';
+    messagesAssembled++;
+    bytesAssembled += used;
+    return true;
+}
+
+void FragmentAssembler::reset() {
+    used = 0;
+    binary = false;
+    assembling = false;
+    dropping = false;
+    if (buffer != nullptr) {
+        buffer[0] = '\0';
+    }
+}
+
+uint8_t* FragmentAssembler::data() {
+    return buffer;
+}
+
+size_t FragmentAssembler::length() const {
+    return used;
+}
+
+bool FragmentAssembler::isBinary() const {
+    return binary;
+}
+
+bool FragmentAssembler::isAssembling() const {
+    return assembling;
+}
+
+size_t FragmentAssembler::capacity() const {
+    return bufferCapacity;
+}
+
+uint32_t FragmentAssembler::getMessagesAssembled() const {
+    return messagesAssembled;
+}
+
+uint32_t FragmentAssembler::getFragmentsReceived() const {
+    return fragmentsReceived;
+}
+
+uint32_t FragmentAssembler::getMessagesDropped() const {
+    return messagesDropped;
+}
+
+uint64_t FragmentAssembler::getBytesAssembled() const {
+    return bytesAssembled;
+}
+
+bool FragmentAssembler::store(const uint8_t* data, size_t length) {
+    fragmentsReceived++;
+
+    if (dropping) {
+        return false;
+    }
+
+    if (length > bufferCapacity - used) {
+        // Too large for the preallocated buffer - drop the whole message
+        dropping = true;
+        messagesDropped++;
+        used = 0;
+        return false;
+    }
+
+    if (length > 0) {
+        memcpy(buffer + used, data, length);
+        used += length;
+    }
+    return true;
+}
@@ -0,0 +1,106 @@
+#ifndef FRAGMENT_ASSEMBLER_H
+#define FRAGMENT_ASSEMBLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef WS_FRAGMENT_BUFFER_SIZE
+#define WS_FRAGMENT_BUFFER_SIZE (128 * 1024)  // Largest reassembled message accepted
+#endif
+
+/**
+ * @class FragmentAssembler
+ * @brief Reassembles fragmented WebSocket messages into one preallocated buffer.
+ *
+ * The buffer is allocated once (in PSRAM on the ESP32) and reused for every
+ * message, so fragments never cause heap growth. Messages larger than the
+ * buffer are dropped as a whole and counted.
+ */
+class FragmentAssembler {
+public:
+    /**
+     * @brief Constructor - no memory is allocated until begin()
+     */
+    FragmentAssembler();
+
+    /**
+     * @brief Destructor - frees the reassembly buffer
+     */
+    ~FragmentAssembler();
+
+    /**
+     * @brief Allocate the reassembly buffer and clear statistics
+     * @param capacity Maximum message size in bytes
+     * @return true if the buffer is available, false if allocation failed
+     */
+    bool begin(size_t capacity = WS_FRAGMENT_BUFFER_SIZE);
+
+    /**
+     * @brief Free the reassembly buffer
+     */
+    void end();
+
+    /**
+     * @brief Start a new message with its first fragment
+     * @param data First fragment payload
+     * @param length First fragment length in bytes
+     * @param binary true for a binary message, false for text
+     * @return true if the fragment was stored, false if the message is dropped
+     */
+    bool start(const uint8_t* data, size_t length, bool binary);
+
+    /**
+     * @brief Append a continuation fragment
+     * @param data Fragment payload
+     * @param length Fragment length in bytes
+     * @return true if the fragment was stored, false if the message is dropped
+     */
+    bool append(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Append the final fragment
+     * @param data Final fragment payload
+     * @param length Final fragment length in bytes
+     * @return true if a complete message is ready in data()/length()
+     */
+    bool finish(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Discard any partially assembled message
+     */
+    void reset();
+
+    /**
+     * @brief Reassembled message, null-terminated so text can be parsed in place
+     * @return Pointer to the message, valid until the next start() or reset()
+     */
+    uint8_t* data();
+
+    size_t length() const;
+    bool isBinary() const;
+    bool isAssembling() const;
+    size_t capacity() const;
+
+    // Statistics
+    uint32_t getMessagesAssembled() const;
+    uint32_t getFragmentsReceived() const;
+    uint32_t getMessagesDropped() const;
+    uint64_t getBytesAssembled() const;
+
+private:
+    uint8_t* buffer;
+    size_t bufferCapacity;
+    size_t used;
+    bool binary;
+    bool assembling;
+    bool dropping;
+
+    uint32_t messagesAssembled;
+    uint32_t fragmentsReceived;
+    uint32_t messagesDropped;
+    uint64_t bytesAssembled;
+
+    bool store(const uint8_t* data, size_t length);
+};
+
+#endif
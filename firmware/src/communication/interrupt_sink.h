@@ -0,0 +1,26 @@
+#ifndef INTERRUPT_SINK_H
+#define INTERRUPT_SINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @class InterruptSink
+ * @brief Audio output that can drop queued speech when the user barges in.
+ *
+ * ElevenLabsClient forwards every interruption event ID to its attached sink
+ * as soon as the event is parsed, before any application callback runs.
+ */
+class InterruptSink {
+public:
+    virtual ~InterruptSink() {}
+
+    /**
+     * @brief Drop all queued audio with an event ID at or below the threshold
+     * @param eventId Event ID carried by the interruption event
+     * @return Number of chunks dropped
+     */
+    virtual size_t purgeUpToEvent(uint32_t eventId) = 0;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "json_arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include "../system/mem_tracker.h"
+
+// Each block is preceded by its requested size; 8 bytes keeps payloads aligned
+#define JSON_ARENA_ALIGN 8
+#define JSON_ARENA_HEADER 8
+
+JsonArena::JsonArena() :
+    buffer(nullptr),
+    bufferCapacity(0),
+    top(0),
+    lastBlock(0),
+    hasLastBlock(false),
+    highWater(0),
+    allocations(0),
+    failures(0) {
+}
+
+JsonArena::~JsonArena() {
+    end();
+}
+
+bool JsonArena::begin(size_t capacity) {
+    if (buffer != nullptr && bufferCapacity == capacity) {
+        reset();
+        return true;
+    }
+    end();
+
+    // PSRAM only - keeping JSON out of internal RAM is the point
+    buffer = (uint8_t*)memAllocPsram(MEM_TAG_NETWORK, capacity);
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    bufferCapacity = capacity;
+    reset();
+    highWater = 0;
+    allocations = 0;
+    failures = 0;
+    return true;
+}
+
+void JsonArena::end() {
+    memFree(buffer);
+    buffer = nullptr;
+    bufferCapacity = 0;
+    top = 0;
+    hasLastBlock = false;
+}
+
+void* JsonArena::allocate(size_t size) {
+    size_t needed = JSON_ARENA_HEADER + blockSize(size);
+    if (buffer == nullptr || needed > bufferCapacity - top) {
+        failures++;
+        return nullptr;
+    }
+
+    uint8_t* block = buffer + top;
+    memcpy(block, &size, sizeof(size));
+    lastBlock = top;
+    hasLastBlock = true;
+    top += needed;
+    highWater = top > highWater ? top : highWater;
+    allocations++;
+    return block + JSON_ARENA_HEADER;
+}
+
+void JsonArena::deallocate(void* ptr) {
+    if (!owns(ptr)) {
+        return;
+    }
+
+    size_t offset = (uint8_t*)ptr - buffer - JSON_ARENA_HEADER;
+    if (hasLastBlock && offset == lastBlock) {
+        top = lastBlock;
+        hasLastBlock = false;
+    }
+}
+
+void* JsonArena::reallocate(void* ptr, size_t newSize) {
+    if (ptr == nullptr) {
+        return allocate(newSize);
+    }
+    if (!owns(ptr)) {
+        return nullptr;
+    }
+
+    uint8_t* block = (uint8_t*)ptr - JSON_ARENA_HEADER;
+    size_t oldSize = 0;
+    memcpy(&oldSize, block, sizeof(oldSize));
+    size_t offset = block - buffer;
+    bool isLast = hasLastBlock && offset == lastBlock;
+
+    if (isLast) {
+        // Grow or shrink in place
+        size_t needed = JSON_ARENA_HEADER + blockSize(newSize);
+        if (needed > bufferCapacity - offset) {
+            failures++;
+            return nullptr;
+        }
+        memcpy(block, &newSize, sizeof(newSize));
+        top = offset + needed;
+        highWater = top > highWater ? top : highWater;
+        return ptr;
+    }
+
+    if (newSize <= oldSize) {
+        // Shrinking a buried block: keep it where it is
+        return ptr;
+    }
+
+    void* moved = allocate(newSize);
+    if (moved != nullptr) {
+        memcpy(moved, ptr, oldSize);
+    }
+    return moved;
+}
+
+size_t JsonArena::mark() const {
+    return top;
+}
+
+void JsonArena::release(size_t savedMark) {
+    if (savedMark <= top) {
+        top = savedMark;
+        hasLastBlock = false;
+    }
+}
+
+void JsonArena::reset() {
+    release(0);
+}
+
+bool JsonArena::isReady() const {
+    return buffer != nullptr;
+}
+
+bool JsonArena::owns(const void* ptr) const {
+    const uint8_t* p = (const uint8_t*)ptr;
+    return buffer != nullptr && p >= buffer + JSON_ARENA_HEADER && p < buffer + bufferCapacity;
+}
+
+size_t JsonArena::used() const {
+    return top;
+}
+
+size_t JsonArena::capacity() const {
+    return bufferCapacity;
+}
+
+size_t JsonArena::getHighWater() const {
+    return highWater;
+}
+
+uint32_t JsonArena::getAllocations() const {
+    return allocations;
+}
+
+uint32_t JsonArena::getFailures() const {
+    return failures;
+}
+
+size_t JsonArena::blockSize(size_t size) {
+    return (size + JSON_ARENA_ALIGN - 1) & ~(size_t)(JSON_ARENA_ALIGN - 1);
+}
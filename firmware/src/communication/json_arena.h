@@ -0,0 +1,91 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fragment_assembler.h"
+
+#ifndef JSON_ARENA_SIZE
+#define JSON_ARENA_SIZE (2 * WS_FRAGMENT_BUFFER_SIZE)   // Largest message + its decoded audio
+#endif
+
+/**
+ * @class JsonArena
+ * @brief Bump allocator for short-lived JSON documents and scratch buffers.
+ *
+ * One buffer is allocated up front (PSRAM on the device) and never grows:
+ * an allocation that doesn't fit fails instead of falling back to the heap.
+ * Memory is reclaimed in stack order with mark()/release() - normally via
+ * JsonArenaScope - so a message handler that sends a reply mid-parse can
+ * nest its own scope without disturbing the document being read.
+ *
+ * The last block can grow and shrink in place, which matches how a JSON
+ * parser builds strings.
+ */
+class JsonArena {
+public:
+    JsonArena();
+    ~JsonArena();
+
+    /**
+     * @brief Allocate the arena buffer
+     * @param capacity Hard cap in bytes
+     * @return true if the buffer is available
+     */
+    bool begin(size_t capacity = JSON_ARENA_SIZE);
+
+    /**
+     * @brief Free the arena buffer
+     */
+    void end();
+
+    void* allocate(size_t size);
+    void deallocate(void* ptr);   // Only reclaims the most recent block
+    void* reallocate(void* ptr, size_t newSize);
+
+    size_t mark() const;
+    void release(size_t mark);    // Drop everything allocated after mark()
+    void reset();
+
+    bool isReady() const;
+    bool owns(const void* ptr) const;
+    size_t used() const;
+    size_t capacity() const;
+    size_t getHighWater() const;
+    uint32_t getAllocations() const;
+    uint32_t getFailures() const;
+
+private:
+    uint8_t* buffer;
+    size_t bufferCapacity;
+    size_t top;
+    size_t lastBlock;
+    bool hasLastBlock;
+    size_t highWater;
+    uint32_t allocations;
+    uint32_t failures;
+
+    static size_t blockSize(size_t size);
+};
+
+/**
+ * @class JsonArenaScope
+ * @brief Releases everything allocated in the arena during its lifetime.
+ *
+ * Declare it before the JsonDocument it covers, so the document is
+ * destroyed first.
+ */
+class JsonArenaScope {
+public:
+    explicit JsonArenaScope(JsonArena& arena) : arena(arena), saved(arena.mark()) {}
+    ~JsonArenaScope() { arena.release(saved); }
+
+private:
+    JsonArena& arena;
+    size_t saved;
+
+    JsonArenaScope(const JsonArenaScope&);
+    JsonArenaScope& operator=(const JsonArenaScope&);
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include "json_writer.h"
+#include <string.h>
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+JsonWriter::JsonWriter(char* buffer, size_t capacity) :
+    buffer(buffer),
+    capacity(buffer != nullptr && capacity > 0 ? capacity - 1 : 0),
+    written(0) {
+    if (buffer != nullptr && capacity > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+JsonWriter& JsonWriter::raw(const char* text, size_t length) {
+    if (buffer != nullptr && written < capacity) {
+        size_t room = capacity - written;
+        size_t count = length < room ? length : room;
+        memcpy(buffer + written, text, count);
+        buffer[written + count] = '\0';
+    }
+    written += length;
+    return *this;
+}
+
+JsonWriter& JsonWriter::string(const char* text) {
+    if (text == nullptr) {
+        return literal("null");
+    }
+
+    put('"');
+    const char* run = text;
+    for (const char* p = text; ; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c != 0 && c != '"' && c != '\\' && c >= 0x20) {
+            continue;
+        }
+
+        // Copy the plain characters before this one in one go
+        raw(run, p - run);
+        run = p + 1;
+        if (c == 0) {
+            break;
+        }
+
+        put('\\');
+        switch (c) {
+            case '"':  put('"'); break;
+            case '\\': put('\\'); break;
+            case '\b': put('b'); break;
+            case '\f': put('f'); break;
+            case '\n': put('n'); break;
+            case '\r': put('r'); break;
+            case '\t': put('t'); break;
+            default: {
+                char escape[5] = {'u', '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0x0F]};
+                raw(escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    put('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::number(uint32_t value) {
+    char digits[10];
+    size_t count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    char text[10];
+    for (size_t i = 0; i < count; i++) {
+        text[i] = digits[count - 1 - i];
+    }
+    return raw(text, count);
+}
+
+JsonWriter& JsonWriter::boolean(bool value) {
+    return value ? literal("true") : literal("false");
+}
+
+bool JsonWriter::ok() const {
+    return buffer != nullptr && written <= capacity;
+}
+
+size_t JsonWriter::length() const {
+    return written;
+}
+
+void JsonWriter::put(char c) {
+    raw(&c, 1);
+}
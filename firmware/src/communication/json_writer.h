@@ -0,0 +1,59 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @class JsonWriter
+ * @brief Appends JSON tokens to a caller-owned buffer.
+ *
+ * For messages whose shape is fixed: the constant parts are string
+ * literals whose length is known at compile time, only values are
+ * formatted at run time. Never allocates. Constructed with a null buffer
+ * it only counts, which gives the exact size to reserve for a second,
+ * writing pass.
+ *
+ * Output that doesn't fit is truncated and ok() returns false.
+ */
+class JsonWriter {
+public:
+    JsonWriter(char* buffer, size_t capacity);
+
+    /**
+     * @brief Append a literal JSON fragment, e.g. "{\"type\":\"pong\""
+     */
+    template <size_t N>
+    JsonWriter& literal(const char (&text)[N]) {
+        return raw(text, N - 1);
+    }
+
+    JsonWriter& raw(const char* text, size_t length);
+
+    /**
+     * @brief Append a quoted, escaped string (null for nullptr)
+     */
+    JsonWriter& string(const char* text);
+
+    JsonWriter& number(uint32_t value);
+    JsonWriter& boolean(bool value);
+
+    /**
+     * @return false if the buffer was too small
+     */
+    bool ok() const;
+
+    /**
+     * @return Characters produced so far, including any that didn't fit
+     */
+    size_t length() const;
+
+private:
+    char* buffer;
+    size_t capacity;    // Room for characters, excluding the terminator
+    size_t written;
+
+    void put(char c);
+};
+
+#endif
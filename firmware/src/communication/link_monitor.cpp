@@ -0,0 +1,91 @@
+#include "link_monitor.h"
+
+RssiAverage::RssiAverage() :
+    averageX16(0),
+    valid(false) {
+}
+
+void RssiAverage::record(int8_t dbm) {
+    if (!valid) {
+        averageX16 = dbm * 16;
+        valid = true;
+    } else {
+        averageX16 += (dbm * 16 - averageX16) / 4;
+    }
+}
+
+bool RssiAverage::hasSample() const {
+    return valid;
+}
+
+int8_t RssiAverage::get() const {
+    return valid ? (int8_t)(averageX16 / 16) : 0;
+}
+
+void RssiAverage::reset() {
+    averageX16 = 0;
+    valid = false;
+}
+
+LinkMonitor::LinkMonitor() {
+    reset();
+}
+
+void LinkMonitor::recordRssi(int8_t dbm, uint32_t nowMs) {
+    rssi.record(dbm);
+    if (rssi.get() < LINK_RSSI_DEGRADED_DBM) {
+        markBad(SIGNAL_RSSI, nowMs);
+    }
+}
+
+void LinkMonitor::recordPing(uint32_t rttMs, uint32_t nowMs) {
+    if (rttMs > LINK_PING_DEGRADED_MS) {
+        markBad(SIGNAL_PING, nowMs);
+    }
+}
+
+void LinkMonitor::recordSend(bool ok, uint32_t nowMs) {
+    if (!ok) {
+        sendFailures++;
+        markBad(SIGNAL_SEND_FAILURE, nowMs);
+    }
+}
+
+bool LinkMonitor::isDegraded(uint32_t nowMs) const {
+    return degraded && nowMs - lastBadMs < LINK_RECOVERY_MS;
+}
+
+LinkMonitor::Signal LinkMonitor::getLastSignal() const {
+    return lastSignal;
+}
+
+const char* LinkMonitor::signalName(Signal signal) {
+    switch (signal) {
+        case SIGNAL_RSSI:         return "weak signal";
+        case SIGNAL_PING:         return "slow ping";
+        case SIGNAL_SEND_FAILURE: return "send failure";
+        default:                  return "none";
+    }
+}
+
+int8_t LinkMonitor::getRssi() const {
+    return rssi.get();
+}
+
+uint32_t LinkMonitor::getSendFailures() const {
+    return sendFailures;
+}
+
+void LinkMonitor::reset() {
+    rssi.reset();
+    degraded = false;
+    lastBadMs = 0;
+    lastSignal = SIGNAL_NONE;
+    sendFailures = 0;
+}
+
+void LinkMonitor::markBad(Signal signal, uint32_t nowMs) {
+    degraded = true;
+    lastBadMs = nowMs;
+    lastSignal = signal;
+}
@@ -0,0 +1,88 @@
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef LINK_RSSI_DEGRADED_DBM
+#define LINK_RSSI_DEGRADED_DBM -75      // Smoothed RSSI below this is weak
+#endif
+
+#ifndef LINK_PING_DEGRADED_MS
+#define LINK_PING_DEGRADED_MS 700       // Server-measured RTT above this is slow
+#endif
+
+#ifndef LINK_RECOVERY_MS
+#define LINK_RECOVERY_MS 20000          // Degraded until every signal has been fine this long
+#endif
+
+/**
+ * @class RssiAverage
+ * @brief Exponential average of Wi-Fi RSSI, weight 1/4 per sample, kept in
+ *        1/16 dBm so small steps aren't lost to rounding
+ */
+class RssiAverage {
+public:
+    RssiAverage();
+
+    void record(int8_t dbm);
+    bool hasSample() const;
+    int8_t get() const;              // 0 before the first sample
+    void reset();
+
+private:
+    int32_t averageX16;
+    bool valid;
+};
+
+/**
+ * @class LinkMonitor
+ * @brief Decides from RSSI, ping RTT and send failures whether the link to
+ *        the server is degraded.
+ *
+ * Any one bad signal marks the link degraded; it recovers only after
+ * LINK_RECOVERY_MS without another, so a flapping link doesn't flap the
+ * decision. RSSI is smoothed so one noisy sample doesn't count.
+ */
+class LinkMonitor {
+public:
+    enum Signal {
+        SIGNAL_NONE,
+        SIGNAL_RSSI,
+        SIGNAL_PING,
+        SIGNAL_SEND_FAILURE
+    };
+
+    LinkMonitor();
+
+    void recordRssi(int8_t dbm, uint32_t nowMs);
+    void recordPing(uint32_t rttMs, uint32_t nowMs);
+    void recordSend(bool ok, uint32_t nowMs);
+
+    /**
+     * @return true if a bad signal was seen within LINK_RECOVERY_MS
+     */
+    bool isDegraded(uint32_t nowMs) const;
+
+    /**
+     * @return The most recent bad signal
+     */
+    Signal getLastSignal() const;
+    static const char* signalName(Signal signal);
+
+    int8_t getRssi() const;          // Smoothed, 0 before the first sample
+    uint32_t getSendFailures() const;
+
+    void reset();
+
+private:
+    RssiAverage rssi;
+    bool degraded;
+    uint32_t lastBadMs;
+    Signal lastSignal;
+    uint32_t sendFailures;
+
+    void markBad(Signal signal, uint32_t nowMs);
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "message_queue.h"
+#include <stdlib.h>
+#include <string.h>
+#include "../system/mem_tracker.h"
+
+// Stored in front of every payload; payloads are padded to 4 bytes
+struct MessageHeader {
+    uint32_t length;
+    uint32_t arg;
+    uint32_t enqueuedUs;
+    uint8_t type;
+    uint8_t reserved[3];
+};
+
+#define MESSAGE_HEADER_SIZE sizeof(MessageHeader)
+#define MESSAGE_WRAP_MARKER 0xFFFFFFFFu   // Rest of the buffer is unused, continue at 0
+
+size_t MessageQueue::recordSize(size_t length) {
+    return MESSAGE_HEADER_SIZE + ((length + 3) & ~(size_t)3);
+}
+
+MessageQueue::MessageQueue() :
+    buffer(nullptr),
+    bufferCapacity(0),
+    head(0),
+    tail(0),
+    usedBytes(0),
+    highWater(0),
+    pushed(0),
+    dropped(0),
+    reservedOffset(0),
+    reservedLength(0),
+    reservedWraps(false) {
+}
+
+MessageQueue::~MessageQueue() {
+    end();
+}
+
+bool MessageQueue::begin(size_t capacity) {
+    end();
+
+    buffer = (uint8_t*)memAllocPsram(MEM_TAG_NETWORK, capacity);
+    if (buffer == nullptr) {
+        return false;
+    }
+
+    bufferCapacity = capacity;
+    highWater = 0;
+    pushed = 0;
+    dropped = 0;
+    return true;
+}
+
+void MessageQueue::end() {
+    std::lock_guard<std::mutex> guard(lock);
+    memFree(buffer);
+    buffer = nullptr;
+    bufferCapacity = 0;
+    head = 0;
+    tail = 0;
+    usedBytes = 0;
+}
+
+bool MessageQueue::push(uint8_t type, uint32_t arg, uint32_t nowUs, const void* data, size_t length) {
+    uint8_t* payload = reserve(length);
+    if (payload == nullptr) {
+        return false;
+    }
+    if (length > 0) {
+        memcpy(payload, data, length);
+    }
+    commit(type, arg, nowUs);
+    return true;
+}
+
+uint8_t* MessageQueue::reserve(size_t length) {
+    lock.lock();
+
+    size_t needed = recordSize(length);
+    if (buffer == nullptr || needed > bufferCapacity) {
+        dropped++;
+        lock.unlock();
+        return nullptr;
+    }
+
+    if (usedBytes == 0) {
+        // Empty: restart at the beginning for the most contiguous room
+        head = 0;
+        tail = 0;
+    }
+
+    bool full = usedBytes > 0 && head == tail;
+    reservedWraps = false;
+    if (!full && head >= tail) {
+        // Free space is [head, end) plus [0, tail)
+        if (bufferCapacity - head >= needed) {
+            reservedOffset = head;
+        } else if (tail >= needed) {
+            reservedOffset = 0;
+            reservedWraps = true;
+        } else {
+            full = true;
+        }
+    } else if (!full) {
+        // Free space is [head, tail)
+        if (tail - head >= needed) {
+            reservedOffset = head;
+        } else {
+            full = true;
+        }
+    }
+
+    if (full) {
+        dropped++;
+        lock.unlock();
+        return nullptr;
+    }
+
+    reservedLength = length;
+    return buffer + reservedOffset + MESSAGE_HEADER_SIZE;
+}
+
+void MessageQueue::commit(uint8_t type, uint32_t arg, uint32_t nowUs) {
+    if (reservedWraps) {
+        size_t skipped = bufferCapacity - head;
+        if (skipped >= MESSAGE_HEADER_SIZE) {
+            uint32_t marker = MESSAGE_WRAP_MARKER;
+            memcpy(buffer + head, &marker, sizeof(marker));
+        }
+        usedBytes += skipped;
+        head = 0;
+    }
+
+    MessageHeader header;
+    memset(&header, 0, sizeof(header));
+    header.length = (uint32_t)reservedLength;
+    header.arg = arg;
+    header.enqueuedUs = nowUs;
+    header.type = type;
+    memcpy(buffer + reservedOffset, &header, sizeof(header));
+
+    size_t needed = recordSize(reservedLength);
+    head = (reservedOffset + needed) % bufferCapacity;
+    usedBytes += needed;
+    highWater = usedBytes > highWater ? usedBytes : highWater;
+    pushed++;
+
+    lock.unlock();
+}
+
+void MessageQueue::cancel() {
+    lock.unlock();
+}
+
+bool MessageQueue::front(QueuedMessage& message) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (buffer == nullptr || usedBytes == 0) {
+        return false;
+    }
+    skipWrapLocked();
+
+    MessageHeader header;
+    memcpy(&header, buffer + tail, sizeof(header));
+    message.type = header.type;
+    message.arg = header.arg;
+    message.enqueuedUs = header.enqueuedUs;
+    message.data = buffer + tail + MESSAGE_HEADER_SIZE;
+    message.length = header.length;
+    return true;
+}
+
+void MessageQueue::pop() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (buffer == nullptr || usedBytes == 0) {
+        return;
+    }
+    skipWrapLocked();
+
+    MessageHeader header;
+    memcpy(&header, buffer + tail, sizeof(header));
+    size_t needed = recordSize(header.length);
+    tail = (tail + needed) % bufferCapacity;
+    usedBytes -= needed;
+}
+
+void MessageQueue::clear() {
+    std::lock_guard<std::mutex> guard(lock);
+    head = 0;
+    tail = 0;
+    usedBytes = 0;
+}
+
+bool MessageQueue::isEmpty() {
+    std::lock_guard<std::mutex> guard(lock);
+    return usedBytes == 0;
+}
+
+size_t MessageQueue::used() {
+    std::lock_guard<std::mutex> guard(lock);
+    return usedBytes;
+}
+
+size_t MessageQueue::capacity() const {
+    return bufferCapacity;
+}
+
+size_t MessageQueue::getHighWater() const {
+    return highWater;
+}
+
+uint32_t MessageQueue::getPushed() const {
+    return pushed;
+}
+
+uint32_t MessageQueue::getDropped() const {
+    return dropped;
+}
+
+void MessageQueue::skipWrapLocked() {
+    // The producer wrapped here: the tail of the buffer holds no message
+    size_t remaining = bufferCapacity - tail;
+    uint32_t length = 0;
+    if (remaining >= MESSAGE_HEADER_SIZE) {
+        memcpy(&length, buffer + tail, sizeof(length));
+    }
+    if (remaining < MESSAGE_HEADER_SIZE || length == MESSAGE_WRAP_MARKER) {
+        usedBytes -= remaining;
+        tail = 0;
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef MESSAGE_QUEUE_H
+#define MESSAGE_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+
+/**
+ * @brief One queued message, as seen by the consumer
+ *
+ * data points into the queue and stays valid until pop().
+ */
+struct QueuedMessage {
+    uint8_t type;
+    uint32_t arg;          // Small typed argument (event ID, flag, ...)
+    uint32_t enqueuedUs;   // Producer's micros() at push time
+    const uint8_t* data;
+    size_t length;
+};
+
+/**
+ * @class MessageQueue
+ * @brief Bounded FIFO of variable-length messages in one preallocated buffer.
+ *
+ * Carries typed events between the network task and the application task
+ * without per-message allocation: each message is a small header followed
+ * by its payload, stored contiguously so the consumer can read it in place.
+ * A full queue rejects the push (and counts the drop) rather than blocking.
+ *
+ * Producers may write from any task. There must be a single consumer.
+ */
+class MessageQueue {
+public:
+    MessageQueue();
+    ~MessageQueue();
+
+    /**
+     * @brief Allocate the queue buffer (PSRAM on the device)
+     * @param capacity Buffer size in bytes, headers included
+     * @return true if the buffer is available
+     */
+    bool begin(size_t capacity);
+
+    /**
+     * @brief Free the buffer and drop anything queued
+     */
+    void end();
+
+    /**
+     * @brief Copy a message into the queue
+     * @return false if the queue is full or not allocated
+     */
+    bool push(uint8_t type, uint32_t arg, uint32_t nowUs, const void* data, size_t length);
+
+    /**
+     * @brief Reserve room for a payload to be written in place
+     * @param length Payload size in bytes
+     * @return Payload buffer, or nullptr if it doesn't fit. On success the
+     *         queue stays locked until commit() or cancel().
+     */
+    uint8_t* reserve(size_t length);
+    void commit(uint8_t type, uint32_t arg, uint32_t nowUs);
+    void cancel();
+
+    /**
+     * @brief Look at the oldest message without removing it
+     * @return false if the queue is empty
+     */
+    bool front(QueuedMessage& message);
+
+    /**
+     * @brief Remove the message returned by front()
+     */
+    void pop();
+
+    /**
+     * @brief Drop every queued message
+     */
+    void clear();
+
+    bool isEmpty();
+    size_t used();
+    size_t capacity() const;
+    size_t getHighWater() const;
+    uint32_t getPushed() const;
+    uint32_t getDropped() const;
+
+    /**
+     * @brief Buffer space one message takes, header and padding included;
+     *        a queue needs at least this capacity to accept it
+     */
+    static size_t recordSize(size_t length);
+
+private:
+    uint8_t* buffer;
+    size_t bufferCapacity;
+    size_t head;           // Next write offset
+    size_t tail;           // Oldest message offset
+    size_t usedBytes;      // Including bytes skipped at the end when wrapping
+    size_t highWater;
+    uint32_t pushed;
+    uint32_t dropped;
+    std::mutex lock;
+
+    // Pending reservation
+    size_t reservedOffset;
+    size_t reservedLength;
+    bool reservedWraps;
+
+    void skipWrapLocked();
+};
+
+#endif
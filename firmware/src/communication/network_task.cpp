@@ -0,0 +1,741 @@
+#include "network_task.h"
+
+#ifndef ESP_PLATFORM
+#include <chrono>
+#endif
+
+// Inbound: server events for the application
+enum NetworkEventType {
+    NET_EVENT_AUDIO = 1,           // arg: event ID, payload: PCM
+    NET_EVENT_TRANSCRIPT,
+    NET_EVENT_AGENT_RESPONSE,
+    NET_EVENT_CONVERSATION_INIT,
+    NET_EVENT_TOOL_CALL,           // payload: name \0 id \0 parameters JSON
+    NET_EVENT_ERROR,
+    NET_EVENT_VAD_SCORE,           // arg: float bits
+    NET_EVENT_PING,                // arg: event ID, payload: uint32 ping_ms
+    NET_EVENT_CONVERSATION_END,
+    NET_EVENT_INTERRUPTION         // arg: event ID
+};
+
+// Outbound: requests for the network task
+enum NetworkCommandType {
+    NET_SEND_AUDIO = 1,
+    NET_SEND_REALTIME_AUDIO,
+    NET_SEND_TEXT,
+    NET_SEND_USER_ACTIVITY,
+    NET_SEND_CONTEXTUAL_UPDATE,
+    NET_SEND_TOOL_RESULT,          // arg: is_error, payload: id \0 result
+    NET_SET_STREAMING,             // arg: enable
+    NET_START_REALTIME,
+    NET_STOP_REALTIME,
+    NET_SET_NETWORK,               // arg: available
+    NET_ATTACH_TRACE               // payload: ConversationTrace*, nullptr to stop
+};
+
+NetworkTask::NetworkTask() :
+    client(nullptr),
+    outboundCapacity(NETWORK_OUTBOUND_QUEUE_SIZE),
+    threaded(false),
+    running(false),
+    stopped(true),
+    connected(false),
+    streamingAudio(true),
+    pendingInterruptId(0),
+    lastAudioSentMs(0),
+    lastUplinkUs(0),
+    uplinkCount(0),
+    traceRequested(false),
+    traceAttached(false),
+    activeTrace(nullptr),
+    staleAudioDropped(0),
+#ifdef ESP_PLATFORM
+    taskHandle(nullptr),
+#else
+    wakePending(false),
+#endif
+    lastPollMs(0),
+    interruptSink(nullptr),
+    wakeCallback(nullptr),
+    audioCallback(nullptr),
+    transcriptCallback(nullptr),
+    agentResponseCallback(nullptr),
+    conversationInitCallback(nullptr),
+    toolCallCallback(nullptr),
+    toolCallJsonCallback(nullptr),
+    errorCallback(nullptr),
+    vadScoreCallback(nullptr),
+    pingCallback(nullptr),
+    conversationEndCallback(nullptr),
+    interruptionCallback(nullptr) {
+}
+
+NetworkTask::~NetworkTask() {
+    end();
+}
+
+bool NetworkTask::begin(ElevenLabsClient& networkClient, bool runThreaded) {
+    end();
+
+    if (!inbound.begin(NETWORK_INBOUND_QUEUE_SIZE) || !outbound.begin(outboundCapacity)) {
+        Serial.println("[NET] Failed to allocate message queues");
+        inbound.end();
+        outbound.end();
+        return false;
+    }
+
+    client = &networkClient;
+    threaded = runThreaded;
+    streamingAudio = client->isStreamingAudioEnabled();
+    connected = client->isConnected();
+    lastPollMs = 0;
+    installClientCallbacks();
+
+    if (!threaded) {
+        Serial.println("[NET] Client runs inline in loop()");
+        return true;
+    }
+
+    running = true;
+    stopped = false;
+#ifdef ESP_PLATFORM
+    BaseType_t created = xTaskCreatePinnedToCore(taskEntry, "network", NETWORK_TASK_STACK_SIZE, this,
+                                                 NETWORK_TASK_PRIORITY, &taskHandle, NETWORK_TASK_CORE);
+    if (created != pdPASS) {
+        Serial.println("[NET] Failed to create network task - running inline");
+        running = false;
+        stopped = true;
+        threaded = false;
+        return true;
+    }
+    Serial.printf("[NET] Client runs in network task on core %d\n", NETWORK_TASK_CORE);
+#else
+    worker = std::thread(taskEntry, this);
+    Serial.println("[NET] Client runs in network thread");
+#endif
+    return true;
+}
+
+void NetworkTask::end() {
+    if (threaded && running) {
+        running = false;
+        wake();
+#ifdef ESP_PLATFORM
+        while (!stopped) {
+            delay(1);
+        }
+        taskHandle = nullptr;
+#else
+        worker.join();
+#endif
+    }
+    client = nullptr;
+    inbound.end();
+    outbound.end();
+}
+
+void NetworkTask::dispatch() {
+    if (client == nullptr) {
+        return;
+    }
+    if (!threaded) {
+        poll();
+    }
+
+    QueuedMessage message;
+    while (inbound.front(message)) {
+        deliver(message);
+        inbound.pop();
+    }
+}
+
+bool NetworkTask::isThreaded() const {
+    return threaded;
+}
+
+bool NetworkTask::isConnected() const {
+    if (client != nullptr && !threaded) {
+        return client->isConnected();
+    }
+    return connected;
+}
+
+bool NetworkTask::sendAudio(const uint8_t* pcm_data, size_t size) {
+    if (client != nullptr && !threaded) {
+        client->sendAudio(pcm_data, size);
+        lastAudioSentMs = millis();
+        return true;
+    }
+    return pushOutbound(NET_SEND_AUDIO, 0, pcm_data, size);
+}
+
+bool NetworkTask::sendRealtimeAudioChunk(const uint8_t* pcm_data, size_t size) {
+    if (client != nullptr && !threaded) {
+        uint32_t startUs = micros();
+        client->sendRealtimeAudioChunk(pcm_data, size);
+        lastAudioSentMs = millis();
+        lastUplinkUs = micros() - startUs;
+        uplinkCount++;
+        return true;
+    }
+    return pushOutbound(NET_SEND_REALTIME_AUDIO, 0, pcm_data, size);
+}
+
+bool NetworkTask::sendText(const char* text) {
+    if (client != nullptr && !threaded) {
+        client->sendText(text);
+        return true;
+    }
+    bool queued = pushText(outbound, NET_SEND_TEXT, 0, text);
+    wake();
+    return queued;
+}
+
+bool NetworkTask::sendUserActivity() {
+    if (client != nullptr && !threaded) {
+        client->sendUserActivity();
+        return true;
+    }
+    return pushOutbound(NET_SEND_USER_ACTIVITY, 0, nullptr, 0);
+}
+
+bool NetworkTask::sendContextualUpdate(const char* text) {
+    if (client != nullptr && !threaded) {
+        client->sendContextualUpdate(text);
+        return true;
+    }
+    bool queued = pushText(outbound, NET_SEND_CONTEXTUAL_UPDATE, 0, text);
+    wake();
+    return queued;
+}
+
+uint32_t NetworkTask::getLastAudioSentMs() const {
+    return lastAudioSentMs;
+}
+
+uint32_t NetworkTask::getLastUplinkUs() const {
+    return lastUplinkUs;
+}
+
+uint32_t NetworkTask::getUplinkCount() const {
+    return uplinkCount;
+}
+
+size_t NetworkTask::getOutboundBacklog() {
+    return threaded ? outbound.used() : 0;
+}
+
+bool NetworkTask::sendToolResult(const char* tool_call_id, const char* result, bool is_error) {
+    if (client != nullptr && !threaded) {
+        client->sendToolResult(tool_call_id, result, is_error);
+        return true;
+    }
+
+    size_t idLength = strlen(tool_call_id);
+    size_t resultLength = strlen(result);
+    uint8_t* payload = outbound.reserve(idLength + 1 + resultLength + 1);
+    if (payload == nullptr) {
+        return false;
+    }
+    memcpy(payload, tool_call_id, idLength + 1);
+    memcpy(payload + idLength + 1, result, resultLength + 1);
+    outbound.commit(NET_SEND_TOOL_RESULT, is_error ? 1 : 0, micros());
+    wake();
+    return true;
+}
+
+void NetworkTask::enableStreamingAudio(bool enable) {
+    streamingAudio = enable;
+    if (client != nullptr && !threaded) {
+        client->enableStreamingAudio(enable);
+        return;
+    }
+    pushOutbound(NET_SET_STREAMING, enable ? 1 : 0, nullptr, 0);
+}
+
+bool NetworkTask::isStreamingAudioEnabled() const {
+    return streamingAudio;
+}
+
+void NetworkTask::startRealtimeStreaming() {
+    if (!isConnected()) {
+        Serial.println("[REALTIME] Cannot start streaming: WebSocket not connected");
+        return;
+    }
+    streamingAudio = true;
+    if (client != nullptr && !threaded) {
+        client->startRealtimeStreaming();
+        return;
+    }
+    pushOutbound(NET_START_REALTIME, 0, nullptr, 0);
+}
+
+void NetworkTask::stopRealtimeStreaming() {
+    streamingAudio = false;
+    if (client != nullptr && !threaded) {
+        client->stopRealtimeStreaming();
+        return;
+    }
+    pushOutbound(NET_STOP_REALTIME, 0, nullptr, 0);
+}
+
+void NetworkTask::setNetworkAvailable(bool available) {
+    if (client != nullptr && !threaded) {
+        client->setNetworkAvailable(available);
+        return;
+    }
+    pushOutbound(NET_SET_NETWORK, available ? 1 : 0, nullptr, 0);
+}
+
+bool NetworkTask::startTrace(ConversationTrace* trace) {
+    if (client != nullptr && !threaded) {
+        attachTrace(trace);
+        traceRequested = true;
+        return true;
+    }
+    if (!pushOutbound(NET_ATTACH_TRACE, 0, &trace, sizeof(trace))) {
+        return false;
+    }
+    traceRequested = true;
+    return true;
+}
+
+bool NetworkTask::stopTrace() {
+    if (client != nullptr && !threaded) {
+        attachTrace(nullptr);
+        traceRequested = false;
+        return true;
+    }
+    ConversationTrace* none = nullptr;
+    if (!pushOutbound(NET_ATTACH_TRACE, 0, &none, sizeof(none))) {
+        return false;
+    }
+    traceRequested = false;
+    return true;
+}
+
+bool NetworkTask::isTracing() const {
+    return traceRequested;
+}
+
+bool NetworkTask::isTraceReleased() const {
+    return !traceRequested && !traceAttached;
+}
+
+// Callback registration methods
+void NetworkTask::onAudioData(AudioDataCallback callback) {
+    audioCallback = callback;
+}
+
+void NetworkTask::onTranscript(TranscriptCallback callback) {
+    transcriptCallback = callback;
+}
+
+void NetworkTask::onAgentResponse(AgentResponseCallback callback) {
+    agentResponseCallback = callback;
+}
+
+void NetworkTask::onConversationInit(ConversationInitCallback callback) {
+    conversationInitCallback = callback;
+}
+
+void NetworkTask::onToolCall(ToolCallCallback callback) {
+    toolCallCallback = callback;
+}
+
+void NetworkTask::onToolCallJson(ToolCallJsonCallback callback) {
+    toolCallJsonCallback = callback;
+}
+
+void NetworkTask::onError(ErrorCallback callback) {
+    errorCallback = callback;
+}
+
+void NetworkTask::onVadScore(VadScoreCallback callback) {
+    vadScoreCallback = callback;
+}
+
+void NetworkTask::onPing(PingCallback callback) {
+    pingCallback = callback;
+}
+
+void NetworkTask::onConversationEnd(ConversationEndCallback callback) {
+    conversationEndCallback = callback;
+}
+
+void NetworkTask::onInterruption(InterruptionCallback callback) {
+    interruptionCallback = callback;
+}
+
+void NetworkTask::attachInterruptSink(InterruptSink* sink) {
+    interruptSink = sink;
+}
+
+void NetworkTask::onWake(std::function<void()> callback) {
+    wakeCallback = callback;
+}
+
+void NetworkTask::reserveOutbound(size_t largestMessage) {
+    size_t needed = MessageQueue::recordSize(largestMessage);
+    if (needed > outboundCapacity) {
+        outboundCapacity = needed;
+    }
+}
+
+const LatencyHistogram& NetworkTask::getDeliveryLatency() const {
+    return deliveryUs;
+}
+
+const LatencyHistogram& NetworkTask::getPollGap() const {
+    return pollGapMs;
+}
+
+uint32_t NetworkTask::getDroppedEvents() const {
+    return inbound.getDropped();
+}
+
+void NetworkTask::resetStats() {
+    deliveryUs.reset();
+    pollGapMs.reset();
+    staleAudioDropped = 0;
+}
+
+size_t NetworkTask::format(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size,
+                           "NET %s deliver_us n=%lu p50=%lu p99=%lu max=%lu | poll_gap_ms p50=%lu p99=%lu max=%lu"
+                           " | dropped in=%lu out=%lu stale=%lu",
+                           threaded ? "task" : "inline",
+                           (unsigned long)deliveryUs.getCount(),
+                           (unsigned long)deliveryUs.getPercentile(50),
+                           (unsigned long)deliveryUs.getPercentile(99),
+                           (unsigned long)deliveryUs.getMax(),
+                           (unsigned long)pollGapMs.getPercentile(50),
+                           (unsigned long)pollGapMs.getPercentile(99),
+                           (unsigned long)pollGapMs.getMax(),
+                           (unsigned long)inbound.getDropped(),
+                           (unsigned long)outbound.getDropped(),
+                           (unsigned long)staleAudioDropped);
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+void NetworkTask::taskEntry(void* param) {
+    static_cast<NetworkTask*>(param)->run();
+#ifdef ESP_PLATFORM
+    vTaskDelete(nullptr);
+#endif
+}
+
+void NetworkTask::run() {
+    unsigned long lastTrafficMs = millis();
+    while (running) {
+        if (poll()) {
+            lastTrafficMs = millis();
+        }
+        // At least one tick either way, so the Wi-Fi stack and idle task run
+        bool active = millis() - lastTrafficMs < NETWORK_TASK_ACTIVE_MS;
+        waitForWork(active ? 1 : NETWORK_TASK_IDLE_POLL_MS);
+    }
+    stopped = true;
+}
+
+void NetworkTask::wake() {
+#ifdef ESP_PLATFORM
+    if (taskHandle != nullptr) {
+        xTaskNotifyGive(taskHandle);
+    }
+#else
+    {
+        std::lock_guard<std::mutex> guard(wakeLock);
+        wakePending = true;
+    }
+    wakeup.notify_one();
+#endif
+}
+
+void NetworkTask::waitForWork(uint32_t timeoutMs) {
+#ifdef ESP_PLATFORM
+    TickType_t ticks = pdMS_TO_TICKS(timeoutMs);
+    ulTaskNotifyTake(pdTRUE, ticks > 0 ? ticks : 1);
+#else
+    std::unique_lock<std::mutex> guard(wakeLock);
+    wakeup.wait_for(guard, std::chrono::milliseconds(timeoutMs), [this]() { return wakePending; });
+    wakePending = false;
+#endif
+}
+
+bool NetworkTask::pushOutbound(uint8_t type, uint32_t arg, const void* data, size_t length) {
+    bool queued = outbound.push(type, arg, micros(), data, length);
+    if (threaded) {
+        wake();
+    }
+    return queued;
+}
+
+bool NetworkTask::poll() {
+    // Gap between polls bounds how long a received frame can sit unread
+    unsigned long now = millis();
+    if (lastPollMs != 0) {
+        pollGapMs.record(now - lastPollMs);
+    }
+    lastPollMs = now;
+
+    bool sent = false;
+    QueuedMessage message;
+    while (outbound.front(message)) {
+        executeOutbound(message);
+        outbound.pop();
+        sent = true;
+    }
+
+    uint32_t pushedBefore = inbound.getPushed();
+    client->loop();
+    connected = client->isConnected();
+
+    bool received = inbound.getPushed() != pushedBefore;
+    if (threaded && wakeCallback && received) {
+        wakeCallback();
+    }
+    return sent || received;
+}
+
+void NetworkTask::installClientCallbacks() {
+    // These run wherever the client is polled and only copy into the queue
+    client->onAudioData([this](const uint8_t* pcm_data, size_t size, uint32_t event_id) {
+        inbound.push(NET_EVENT_AUDIO, event_id, micros(), pcm_data, size);
+    });
+
+    client->onTranscript([this](const char* transcript) {
+        pushText(inbound, NET_EVENT_TRANSCRIPT, 0, transcript);
+    });
+
+    client->onAgentResponse([this](const char* response) {
+        pushText(inbound, NET_EVENT_AGENT_RESPONSE, 0, response);
+    });
+
+    client->onConversationInit([this](const char* conversation_id) {
+        // Event IDs restart with the conversation; an old interruption
+        // would drop all of the new one's audio
+        pendingInterruptId = 0;
+        pushText(inbound, NET_EVENT_CONVERSATION_INIT, 0, conversation_id);
+    });
+
+    client->onToolCall([this](const char* tool_name, const char* tool_call_id, JsonObjectConst parameters) {
+        size_t nameLength = strlen(tool_name);
+        size_t idLength = strlen(tool_call_id);
+        size_t jsonLength = measureJson(parameters);
+        uint8_t* payload = inbound.reserve(nameLength + 1 + idLength + 1 + jsonLength + 1);
+        if (payload == nullptr) {
+            return;
+        }
+        memcpy(payload, tool_name, nameLength + 1);
+        memcpy(payload + nameLength + 1, tool_call_id, idLength + 1);
+        serializeJson(parameters, (char*)payload + nameLength + 1 + idLength + 1, jsonLength + 1);
+        inbound.commit(NET_EVENT_TOOL_CALL, 0, micros());
+    });
+
+    client->onError([this](const char* error_message) {
+        pushText(inbound, NET_EVENT_ERROR, 0, error_message);
+    });
+
+    client->onVadScore([this](float vad_score) {
+        uint32_t bits;
+        memcpy(&bits, &vad_score, sizeof(bits));
+        inbound.push(NET_EVENT_VAD_SCORE, bits, micros(), nullptr, 0);
+    });
+
+    client->onPing([this](uint32_t event_id, uint32_t ping_ms) {
+        inbound.push(NET_EVENT_PING, event_id, micros(), &ping_ms, sizeof(ping_ms));
+    });
+
+    client->onConversationEnd([this]() {
+        inbound.push(NET_EVENT_CONVERSATION_END, 0, micros(), nullptr, 0);
+    });
+
+    client->onInterruption([this](uint32_t event_id) {
+        // Visible to dispatch() at once, so audio queued ahead of the
+        // interruption is dropped instead of played
+        if (event_id > pendingInterruptId) {
+            pendingInterruptId = event_id;
+        }
+        inbound.push(NET_EVENT_INTERRUPTION, event_id, micros(), nullptr, 0);
+    });
+}
+
+void NetworkTask::attachTrace(ConversationTrace* trace) {
+    if (activeTrace != nullptr) {
+        activeTrace->stop();
+    }
+    if (trace != nullptr) {
+        trace->start(millis());
+    }
+    client->attachTraceRecorder(trace);
+    activeTrace = trace;
+    traceAttached = trace != nullptr;
+}
+
+bool NetworkTask::pushText(MessageQueue& queue, uint8_t type, uint32_t arg, const char* text) {
+    if (text == nullptr) {
+        text = "";
+    }
+    return queue.push(type, arg, micros(), text, strlen(text) + 1);
+}
+
+void NetworkTask::executeOutbound(const QueuedMessage& message) {
+    const char* text = (const char*)message.data;
+
+    switch (message.type) {
+        case NET_SEND_AUDIO:
+            client->sendAudio(message.data, message.length);
+            lastAudioSentMs = millis();
+            break;
+
+        case NET_SEND_REALTIME_AUDIO:
+            client->sendRealtimeAudioChunk(message.data, message.length);
+            lastAudioSentMs = millis();
+            lastUplinkUs = micros() - message.enqueuedUs;
+            uplinkCount++;
+            break;
+
+        case NET_SEND_TEXT:
+            client->sendText(text);
+            break;
+
+        case NET_SEND_USER_ACTIVITY:
+            client->sendUserActivity();
+            break;
+
+        case NET_SEND_CONTEXTUAL_UPDATE:
+            client->sendContextualUpdate(text);
+            break;
+
+        case NET_SEND_TOOL_RESULT:
+            client->sendToolResult(text, text + strlen(text) + 1, message.arg != 0);
+            break;
+
+        case NET_SET_STREAMING:
+            client->enableStreamingAudio(message.arg != 0);
+            break;
+
+        case NET_START_REALTIME:
+            client->startRealtimeStreaming();
+            break;
+
+        case NET_STOP_REALTIME:
+            client->stopRealtimeStreaming();
+            break;
+
+        case NET_SET_NETWORK:
+            client->setNetworkAvailable(message.arg != 0);
+            break;
+
+        case NET_ATTACH_TRACE: {
+            ConversationTrace* trace;
+            memcpy(&trace, message.data, sizeof(trace));
+            attachTrace(trace);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void NetworkTask::deliver(const QueuedMessage& message) {
+    const char* text = (const char*)message.data;
+
+    // Audio that an interruption has already made stale is never played
+    if (message.type == NET_EVENT_AUDIO && message.arg <= pendingInterruptId) {
+        staleAudioDropped++;
+        return;
+    }
+
+    deliveryUs.record(micros() - message.enqueuedUs);
+
+    switch (message.type) {
+        case NET_EVENT_AUDIO:
+            if (audioCallback) {
+                audioCallback(message.data, message.length, message.arg);
+            }
+            break;
+
+        case NET_EVENT_TRANSCRIPT:
+            if (transcriptCallback) {
+                transcriptCallback(text);
+            }
+            break;
+
+        case NET_EVENT_AGENT_RESPONSE:
+            if (agentResponseCallback) {
+                agentResponseCallback(text);
+            }
+            break;
+
+        case NET_EVENT_CONVERSATION_INIT:
+            if (conversationInitCallback) {
+                conversationInitCallback(text);
+            }
+            break;
+
+        case NET_EVENT_TOOL_CALL: {
+            const char* toolCallId = text + strlen(text) + 1;
+            const char* json = toolCallId + strlen(toolCallId) + 1;
+            if (toolCallJsonCallback) {
+                toolCallJsonCallback(text, toolCallId, json);
+            } else if (toolCallCallback) {
+                JsonDocument parameters;
+                deserializeJson(parameters, json);
+                toolCallCallback(text, toolCallId, parameters.as<JsonObjectConst>());
+            }
+            break;
+        }
+
+        case NET_EVENT_ERROR:
+            if (errorCallback) {
+                errorCallback(text);
+            }
+            break;
+
+        case NET_EVENT_VAD_SCORE:
+            if (vadScoreCallback) {
+                float score;
+                memcpy(&score, &message.arg, sizeof(score));
+                vadScoreCallback(score);
+            }
+            break;
+
+        case NET_EVENT_PING:
+            if (pingCallback) {
+                uint32_t pingMs;
+                memcpy(&pingMs, message.data, sizeof(pingMs));
+                pingCallback(message.arg, pingMs);
+            }
+            break;
+
+        case NET_EVENT_CONVERSATION_END:
+            if (conversationEndCallback) {
+                conversationEndCallback();
+            }
+            break;
+
+        case NET_EVENT_INTERRUPTION:
+            // Drop already-queued stale speech before anything else runs
+            if (interruptSink) {
+                interruptSink->purgeUpToEvent(message.arg);
+            }
+            if (interruptionCallback) {
+                interruptionCallback(message.arg);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
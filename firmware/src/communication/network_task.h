@@ -0,0 +1,249 @@
+#ifndef NETWORK_TASK_H
+#define NETWORK_TASK_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "websocket_client.h"
+#include "message_queue.h"
+#include "../telemetry/latency_histogram.h"
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#ifndef NETWORK_TASK_ENABLED
+#define NETWORK_TASK_ENABLED 1              // 0 runs the client inline from dispatch()
+#endif
+
+#ifndef NETWORK_TASK_CORE
+#define NETWORK_TASK_CORE 0                 // Wi-Fi/lwIP core; Arduino loop() runs on core 1
+#endif
+
+#ifndef NETWORK_TASK_STACK_SIZE
+#define NETWORK_TASK_STACK_SIZE (12 * 1024) // TLS handshake and JSON parsing run here
+#endif
+
+#ifndef NETWORK_TASK_PRIORITY
+#define NETWORK_TASK_PRIORITY 5
+#endif
+
+#ifndef NETWORK_TASK_ACTIVE_MS
+#define NETWORK_TASK_ACTIVE_MS 500          // Poll every tick this long after the last traffic
+#endif
+
+#ifndef NETWORK_TASK_IDLE_POLL_MS
+#define NETWORK_TASK_IDLE_POLL_MS 50        // Poll interval once idle; a send wakes the task at once
+#endif
+
+#ifndef NETWORK_INBOUND_QUEUE_SIZE
+#define NETWORK_INBOUND_QUEUE_SIZE (192 * 1024)   // ~6 s of 16 kHz agent audio if the app stalls
+#endif
+
+#ifndef NETWORK_OUTBOUND_QUEUE_SIZE
+#define NETWORK_OUTBOUND_QUEUE_SIZE (64 * 1024)   // ~2 s of microphone audio
+#endif
+
+// Tool call with its parameters still as the JSON text they were queued as
+using ToolCallJsonCallback = std::function<void(const char* tool_name, const char* tool_call_id, const char* parameters_json)>;  // Valid during the call only
+
+/**
+ * @class NetworkTask
+ * @brief Runs ElevenLabsClient away from the application loop.
+ *
+ * In threaded mode the client's socket I/O, TLS and parsing run in a task
+ * pinned to the network core, so speaker writes and serial handling in
+ * loop() no longer delay reads. Server events are copied into an inbound
+ * queue and delivered to the application callbacks by dispatch(), on the
+ * caller's task; send methods queue the message for the network task and
+ * are safe to call from any task.
+ *
+ * The task polls the client every tick while messages are moving and
+ * backs off to NETWORK_TASK_IDLE_POLL_MS once the link has been quiet for
+ * NETWORK_TASK_ACTIVE_MS, so an idle conversation lets the CPU sleep; a
+ * send wakes it straight away.
+ *
+ * Inline mode keeps the old single-loop behaviour (dispatch() polls the
+ * client itself) behind the same API, so the two can be compared with the
+ * same delivery and poll-gap statistics.
+ */
+class NetworkTask {
+public:
+    NetworkTask();
+    ~NetworkTask();
+
+    /**
+     * @brief Take over a client that has already been begin()'d
+     * @param client Client to run; don't call its methods directly afterwards
+     * @param threaded true to start the network task, false to run inline
+     * @return false if the queues or the task couldn't be created
+     */
+    bool begin(ElevenLabsClient& client, bool threaded = NETWORK_TASK_ENABLED);
+
+    /**
+     * @brief Stop the network task and drop anything still queued
+     */
+    void end();
+
+    /**
+     * @brief Deliver queued server events to the callbacks (call from loop())
+     */
+    void dispatch();
+
+    bool isThreaded() const;
+    bool isConnected() const;
+
+    // Thread-safe sends, queued for the network task
+    bool sendAudio(const uint8_t* pcm_data, size_t size);
+    bool sendRealtimeAudioChunk(const uint8_t* pcm_data, size_t size);
+    bool sendText(const char* text);
+    bool sendUserActivity();
+    bool sendContextualUpdate(const char* text);
+    bool sendToolResult(const char* tool_call_id, const char* result, bool is_error = false);
+
+    /**
+     * @return millis() when the last audio send finished on the network task, 0 if none yet
+     */
+    uint32_t getLastAudioSentMs() const;
+
+    /**
+     * @brief Real-time uplink progress, for adapting the chunk size
+     * @return Microseconds from sendRealtimeAudioChunk() to written for the
+     *         last chunk; getUplinkCount() tells when there's a new one
+     */
+    uint32_t getLastUplinkUs() const;
+    uint32_t getUplinkCount() const;
+
+    /**
+     * @brief Bytes queued for the network task but not yet sent, 0 inline
+     */
+    size_t getOutboundBacklog();
+
+    // Streaming control, applied on the network task
+    void enableStreamingAudio(bool enable);
+    bool isStreamingAudioEnabled() const;
+    void startRealtimeStreaming();
+    void stopRealtimeStreaming();
+
+    /**
+     * @brief Tell the client the Wi-Fi link went down or came back
+     */
+    void setNetworkAvailable(bool available);
+
+    /**
+     * @brief Record inbound messages into trace; start(), stop() and every
+     *        record() run on the network task
+     * @param trace Trace with its buffer allocated; leave it alone until
+     *        isTraceReleased() after stopTrace()
+     * @return false if the command queue is full; stopTrace() then needs a retry
+     */
+    bool startTrace(ConversationTrace* trace);
+    bool stopTrace();
+    bool isTracing() const;          // Between startTrace() and stopTrace()
+    bool isTraceReleased() const;    // The network task has let go of the trace
+
+    // Callbacks, delivered from dispatch()
+    void onAudioData(AudioDataCallback callback);
+    void onTranscript(TranscriptCallback callback);
+    void onAgentResponse(AgentResponseCallback callback);
+    void onConversationInit(ConversationInitCallback callback);
+    void onToolCall(ToolCallCallback callback);
+    void onToolCallJson(ToolCallJsonCallback callback);   // Skips the parse; replaces onToolCall()
+    void onError(ErrorCallback callback);
+    void onVadScore(VadScoreCallback callback);
+    void onPing(PingCallback callback);
+    void onConversationEnd(ConversationEndCallback callback);
+    void onInterruption(InterruptionCallback callback);
+
+    // Purged from dispatch(), before queued stale audio is delivered
+    void attachInterruptSink(InterruptSink* sink);
+
+    /**
+     * @brief Run on the network task after a poll queued server events, so
+     *        the application can sleep until dispatch() has work (set before begin())
+     */
+    void onWake(std::function<void()> callback);
+
+    /**
+     * @brief Grow the outbound queue so one message of this size fits, e.g.
+     *        a whole push-to-talk recording for sendAudio() (set before begin())
+     */
+    void reserveOutbound(size_t largestMessage);
+
+    // Delivery statistics
+    const LatencyHistogram& getDeliveryLatency() const;  // Microseconds, event parsed -> callback
+    const LatencyHistogram& getPollGap() const;          // Milliseconds between client polls
+    uint32_t getDroppedEvents() const;
+    void resetStats();
+
+    /**
+     * @brief Format delivery statistics as one line, e.g.
+     *        "NET task deliver_us p50=40 p99=900 max=1200 | poll_gap_ms p50=1 p99=2 max=9 | dropped in=0 out=0"
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t format(char* out, size_t size) const;
+
+private:
+    ElevenLabsClient* client;
+    MessageQueue inbound;
+    MessageQueue outbound;
+    size_t outboundCapacity;
+    bool threaded;
+    std::atomic<bool> running;
+    std::atomic<bool> stopped;
+    std::atomic<bool> connected;
+    std::atomic<bool> streamingAudio;
+    std::atomic<uint32_t> pendingInterruptId;
+    std::atomic<uint32_t> lastAudioSentMs;
+    std::atomic<uint32_t> lastUplinkUs;
+    std::atomic<uint32_t> uplinkCount;
+    std::atomic<bool> traceRequested;
+    std::atomic<bool> traceAttached;
+    ConversationTrace* activeTrace;      // Network task only
+    uint32_t staleAudioDropped;
+#ifdef ESP_PLATFORM
+    TaskHandle_t taskHandle;
+#else
+    std::thread worker;
+    std::mutex wakeLock;
+    std::condition_variable wakeup;
+    bool wakePending;
+#endif
+
+    LatencyHistogram deliveryUs;
+    LatencyHistogram pollGapMs;
+    unsigned long lastPollMs;
+
+    InterruptSink* interruptSink;
+    std::function<void()> wakeCallback;
+
+    AudioDataCallback audioCallback;
+    TranscriptCallback transcriptCallback;
+    AgentResponseCallback agentResponseCallback;
+    ConversationInitCallback conversationInitCallback;
+    ToolCallCallback toolCallCallback;
+    ToolCallJsonCallback toolCallJsonCallback;
+    ErrorCallback errorCallback;
+    VadScoreCallback vadScoreCallback;
+    PingCallback pingCallback;
+    ConversationEndCallback conversationEndCallback;
+    InterruptionCallback interruptionCallback;
+
+    static void taskEntry(void* param);
+    void run();
+    bool poll();
+    void wake();
+    void waitForWork(uint32_t timeoutMs);
+    bool pushOutbound(uint8_t type, uint32_t arg, const void* data, size_t length);
+    void installClientCallbacks();
+    void attachTrace(ConversationTrace* trace);
+    bool pushText(MessageQueue& queue, uint8_t type, uint32_t arg, const char* text);
+    void executeOutbound(const QueuedMessage& message);
+    void deliver(const QueuedMessage& message);
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef OUTBOUND_MESSAGES_H
+#define OUTBOUND_MESSAGES_H
+
+#include "json_writer.h"
+
+/**
+ * @brief Fixed-shape client -> server messages, written without ArduinoJson.
+ *
+ * Each message is its constant fragments (compile-time literals) with the
+ * values spliced in. Output is byte-for-byte what serializeJson() produces
+ * for the equivalent JsonDocument, so the server sees no difference.
+ */
+namespace OutboundMessages {
+
+constexpr char USER_MESSAGE[] = "{\"type\":\"user_message\",\"text\":";
+constexpr char USER_ACTIVITY[] = "{\"type\":\"user_activity\"}";
+constexpr char CONTEXTUAL_UPDATE[] = "{\"type\":\"contextual_update\",\"text\":";
+constexpr char TOOL_RESULT[] = "{\"type\":\"client_tool_result\",\"tool_call_id\":";
+constexpr char TOOL_RESULT_RESULT[] = ",\"result\":";
+constexpr char TOOL_RESULT_IS_ERROR[] = ",\"is_error\":";
+constexpr char PONG[] = "{\"type\":\"pong\",\"event_id\":";
+constexpr char INITIATION[] = "{\"type\":\"conversation_initiation_client_data\"";
+constexpr char INITIATION_OVERRIDE_AUDIO[] =
+    ",\"conversation_config_override\":{\"override_agent_output_audio\":true}";
+constexpr char END[] = "}";
+
+inline JsonWriter& userMessage(JsonWriter& writer, const char* text) {
+    return writer.literal(USER_MESSAGE).string(text).literal(END);
+}
+
+inline JsonWriter& userActivity(JsonWriter& writer) {
+    return writer.literal(USER_ACTIVITY);
+}
+
+inline JsonWriter& contextualUpdate(JsonWriter& writer, const char* text) {
+    return writer.literal(CONTEXTUAL_UPDATE).string(text).literal(END);
+}
+
+inline JsonWriter& toolResult(JsonWriter& writer, const char* tool_call_id, const char* result, bool is_error) {
+    return writer.literal(TOOL_RESULT).string(tool_call_id)
+                 .literal(TOOL_RESULT_RESULT).string(result)
+                 .literal(TOOL_RESULT_IS_ERROR).boolean(is_error)
+                 .literal(END);
+}
+
+inline JsonWriter& pong(JsonWriter& writer, uint32_t event_id) {
+    return writer.literal(PONG).number(event_id).literal(END);
+}
+
+inline JsonWriter& conversationInitiation(JsonWriter& writer, bool override_audio) {
+    writer.literal(INITIATION);
+    if (override_audio) {
+        writer.literal(INITIATION_OVERRIDE_AUDIO);
+    }
+    return writer.literal(END);
+}
+
+}  // namespace OutboundMessages
+
+#endif
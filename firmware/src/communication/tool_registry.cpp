@@ -0,0 +1,368 @@
+#include "tool_registry.h"
+#include "websocket_client.h"
+
+ToolRegistry::ToolRegistry() :
+    toolCount(0),
+    resultSink(nullptr),
+    threaded(false),
+    running(false),
+    stopped(true),
+#ifdef ESP_PLATFORM
+    taskHandle(nullptr),
+#else
+    wakePending(false),
+#endif
+    inFlight(false),
+    inFlightAnswered(false),
+    inFlightTool(0),
+    inFlightStartUs(0) {
+    inFlightId[0] = '\0';
+    result[0] = '\0';
+}
+
+ToolRegistry::~ToolRegistry() {
+    end();
+}
+
+bool ToolRegistry::registerTool(const char* name, ToolHandler handler, uint32_t timeoutMs) {
+    if (toolCount >= TOOL_MAX_TOOLS || strlen(name) >= sizeof(tools[0].name) || findTool(name) >= 0) {
+        Serial.printf("[TOOLS] Cannot register tool '%s'\n", name);
+        return false;
+    }
+
+    Tool& tool = tools[toolCount++];
+    strcpy(tool.name, name);
+    tool.handler = handler;
+    tool.timeoutMs = timeoutMs;
+    memset(&tool.stats, 0, sizeof(tool.stats));
+    tool.latencyMs.reset();
+    return true;
+}
+
+bool ToolRegistry::begin(ToolResultSink sink, bool runThreaded) {
+    end();
+
+    if (!calls.begin(TOOL_QUEUE_SIZE)) {
+        Serial.println("[TOOLS] Failed to allocate call queue");
+        return false;
+    }
+    if (!parametersArena.begin(TOOL_JSON_ARENA_SIZE)) {
+        Serial.printf("[TOOLS] WARNING: Failed to allocate %u byte JSON arena - parsing on the heap\n",
+                      (unsigned int)TOOL_JSON_ARENA_SIZE);
+    }
+
+    resultSink = sink;
+    threaded = runThreaded;
+    if (!threaded) {
+        return true;
+    }
+
+    running = true;
+    stopped = false;
+#ifdef ESP_PLATFORM
+    BaseType_t created = xTaskCreatePinnedToCore(taskEntry, "tools", TOOL_WORKER_STACK_SIZE, this,
+                                                 TOOL_WORKER_PRIORITY, &taskHandle, TOOL_WORKER_CORE);
+    if (created != pdPASS) {
+        Serial.println("[TOOLS] Failed to create worker task - running tools from loop()");
+        running = false;
+        stopped = true;
+        threaded = false;
+    }
+#else
+    worker = std::thread(taskEntry, this);
+#endif
+    return true;
+}
+
+void ToolRegistry::end() {
+    if (threaded && running) {
+        running = false;
+        wake();
+#ifdef ESP_PLATFORM
+        while (!stopped) {
+            delay(1);
+        }
+        taskHandle = nullptr;
+#else
+        worker.join();
+#endif
+    }
+    calls.end();
+    parametersArena.end();
+}
+
+void ToolRegistry::handleToolCall(const char* tool_name, const char* tool_call_id, JsonObjectConst parameters) {
+    int index;
+    size_t jsonLength = measureJson(parameters);
+    char* json = reserveCall(tool_name, tool_call_id, jsonLength, index);
+    if (json != nullptr) {
+        serializeJson(parameters, json, jsonLength + 1);
+        commitCall(index);
+    }
+}
+
+void ToolRegistry::handleToolCall(const char* tool_name, const char* tool_call_id, const char* parameters_json) {
+    int index;
+    size_t jsonLength = strlen(parameters_json);
+    char* json = reserveCall(tool_name, tool_call_id, jsonLength, index);
+    if (json != nullptr) {
+        memcpy(json, parameters_json, jsonLength + 1);
+        commitCall(index);
+    }
+}
+
+char* ToolRegistry::reserveCall(const char* tool_name, const char* tool_call_id, size_t jsonLength, int& index) {
+    index = findTool(tool_name);
+    if (index < 0) {
+        Serial.printf("[TOOLS] Unknown tool '%s'\n", tool_name);
+        char message[64];
+        snprintf(message, sizeof(message), "Unknown tool: %s", tool_name);
+        if (resultSink) {
+            resultSink(tool_call_id, message, true);
+        }
+        return nullptr;
+    }
+
+    // Queued as "id\0parameters JSON\0"
+    size_t idLength = strlen(tool_call_id);
+    uint8_t* payload = calls.reserve(idLength + 1 + jsonLength + 1);
+    if (payload == nullptr) {
+        Serial.printf("[TOOLS] Call queue full - rejecting '%s'\n", tool_name);
+        tools[index].stats.errors++;
+        if (resultSink) {
+            resultSink(tool_call_id, "Tool queue full", true);
+        }
+        return nullptr;
+    }
+    memcpy(payload, tool_call_id, idLength + 1);
+    return (char*)payload + idLength + 1;
+}
+
+void ToolRegistry::commitCall(int index) {
+    calls.commit(0, (uint32_t)index, micros());
+    if (threaded) {
+        wake();
+    }
+}
+
+void ToolRegistry::loop() {
+    if (!threaded) {
+        while (runNext()) {
+        }
+        return;
+    }
+
+    // A tool can't be stopped mid-call, so loop(), which outranks the
+    // worker, answers for it once the deadline passes
+    std::lock_guard<std::mutex> guard(inFlightLock);
+    if (!inFlight || inFlightAnswered) {
+        return;
+    }
+
+    Tool& tool = tools[inFlightTool];
+    uint32_t elapsedMs = (micros() - inFlightStartUs) / 1000;
+    if (elapsedMs < tool.timeoutMs) {
+        return;
+    }
+
+    inFlightAnswered = true;
+    tool.stats.timeouts++;
+    tool.latencyMs.record(elapsedMs);
+    Serial.printf("[TOOLS] '%s' timed out after %u ms\n", tool.name, (unsigned int)elapsedMs);
+    if (resultSink) {
+        resultSink(inFlightId, "Tool timed out", true);
+    }
+}
+
+uint32_t ToolRegistry::getMsUntilTimeout() {
+    if (!threaded) {
+        return UINT32_MAX;
+    }
+
+    std::lock_guard<std::mutex> guard(inFlightLock);
+    if (!inFlight) {
+        // A queued call is about to start on the worker; look again shortly
+        return calls.isEmpty() ? UINT32_MAX : 1;
+    }
+    if (inFlightAnswered) {
+        return UINT32_MAX;
+    }
+
+    uint32_t elapsedMs = (micros() - inFlightStartUs) / 1000;
+    uint32_t timeoutMs = tools[inFlightTool].timeoutMs;
+    return elapsedMs < timeoutMs ? timeoutMs - elapsedMs : 0;
+}
+
+size_t ToolRegistry::getToolCount() const {
+    return toolCount;
+}
+
+const char* ToolRegistry::getToolName(size_t index) const {
+    return tools[index].name;
+}
+
+const ToolStats& ToolRegistry::getStats(size_t index) const {
+    return tools[index].stats;
+}
+
+const LatencyHistogram& ToolRegistry::getLatency(size_t index) const {
+    return tools[index].latencyMs;
+}
+
+void ToolRegistry::resetStats() {
+    for (size_t i = 0; i < toolCount; i++) {
+        memset(&tools[i].stats, 0, sizeof(tools[i].stats));
+        tools[i].latencyMs.reset();
+    }
+}
+
+size_t ToolRegistry::format(size_t index, char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    const Tool& tool = tools[index];
+    int written = snprintf(out, size, "TOOL %s n=%lu p50=%lu p99=%lu max=%lu err=%lu timeout=%lu late=%lu",
+                           tool.name,
+                           (unsigned long)tool.stats.calls,
+                           (unsigned long)tool.latencyMs.getPercentile(50),
+                           (unsigned long)tool.latencyMs.getPercentile(99),
+                           (unsigned long)tool.latencyMs.getMax(),
+                           (unsigned long)tool.stats.errors,
+                           (unsigned long)tool.stats.timeouts,
+                           (unsigned long)tool.stats.late);
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+int ToolRegistry::findTool(const char* name) const {
+    for (size_t i = 0; i < toolCount; i++) {
+        if (strcmp(tools[i].name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void ToolRegistry::taskEntry(void* param) {
+    static_cast<ToolRegistry*>(param)->run();
+#ifdef ESP_PLATFORM
+    vTaskDelete(nullptr);
+#endif
+}
+
+void ToolRegistry::run() {
+    while (running) {
+        if (!runNext()) {
+            waitForCall();
+        }
+    }
+    stopped = true;
+}
+
+void ToolRegistry::wake() {
+#ifdef ESP_PLATFORM
+    if (taskHandle != nullptr) {
+        xTaskNotifyGive(taskHandle);
+    }
+#else
+    {
+        std::lock_guard<std::mutex> guard(wakeLock);
+        wakePending = true;
+    }
+    wakeup.notify_one();
+#endif
+}
+
+void ToolRegistry::waitForCall() {
+    // No timeout: an idle worker costs nothing until handleToolCall() or end()
+#ifdef ESP_PLATFORM
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#else
+    std::unique_lock<std::mutex> guard(wakeLock);
+    wakeup.wait(guard, [this]() { return wakePending; });
+    wakePending = false;
+#endif
+}
+
+bool ToolRegistry::runNext() {
+    QueuedMessage call;
+    if (!calls.front(call)) {
+        return false;
+    }
+
+    size_t index = call.arg;
+    Tool& tool = tools[index];
+    const char* toolCallId = (const char*)call.data;
+    const char* json = toolCallId + strlen(toolCallId) + 1;
+    tool.stats.calls++;
+
+    // Waited out its whole timeout behind a slower tool: don't start it
+    uint32_t waitedMs = (micros() - call.enqueuedUs) / 1000;
+    if (threaded && waitedMs >= tool.timeoutMs) {
+        tool.stats.timeouts++;
+        tool.latencyMs.record(waitedMs);
+        Serial.printf("[TOOLS] '%s' timed out in the queue after %u ms\n", tool.name, (unsigned int)waitedMs);
+        if (resultSink) {
+            resultSink(toolCallId, "Tool timed out", true);
+        }
+        calls.pop();
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(inFlightLock);
+        inFlight = true;
+        inFlightAnswered = false;
+        inFlightTool = index;
+        inFlightStartUs = call.enqueuedUs;
+        strncpy(inFlightId, toolCallId, sizeof(inFlightId) - 1);
+        inFlightId[sizeof(inFlightId) - 1] = '\0';
+    }
+
+    // The only parse of the parameters; the arena is empty again after it
+    bool ok;
+    result[0] = '\0';
+    {
+        JsonArenaScope scope(parametersArena);
+        JsonArenaAllocator allocator(parametersArena);
+        JsonDocument parameters(&allocator);
+        DeserializationError error = deserializeJson(parameters, json);
+        if (error) {
+            Serial.printf("[TOOLS] '%s' parameters not parsed: %s\n", tool.name, error.c_str());
+            snprintf(result, sizeof(result), "Invalid parameters: %s", error.c_str());
+            ok = false;
+        } else {
+            ok = tool.handler(parameters.as<JsonObjectConst>(), result, sizeof(result));
+        }
+    }
+    result[sizeof(result) - 1] = '\0';
+
+    {
+        std::lock_guard<std::mutex> guard(inFlightLock);
+        inFlight = false;
+        if (inFlightAnswered) {
+            tool.stats.late++;
+        } else {
+            finish(index, toolCallId, call.enqueuedUs, result, !ok);
+        }
+    }
+
+    calls.pop();
+    return true;
+}
+
+void ToolRegistry::finish(size_t index, const char* tool_call_id, uint32_t startUs, const char* text, bool is_error) {
+    Tool& tool = tools[index];
+    if (is_error) {
+        tool.stats.errors++;
+    }
+    tool.latencyMs.record((micros() - startUs) / 1000);
+
+    if (resultSink) {
+        resultSink(tool_call_id, text, is_error);
+    }
+}
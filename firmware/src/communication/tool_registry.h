@@ -0,0 +1,210 @@
+#ifndef TOOL_REGISTRY_H
+#define TOOL_REGISTRY_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include "message_queue.h"
+#include "json_arena.h"
+#include "../telemetry/latency_histogram.h"
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#include <condition_variable>
+#endif
+
+#ifndef TOOL_WORKER_ENABLED
+#define TOOL_WORKER_ENABLED 1               // 0 runs tools from loop()
+#endif
+
+#ifndef TOOL_WORKER_CORE
+#define TOOL_WORKER_CORE 1                  // Application core; the network task has core 0
+#endif
+
+#ifndef TOOL_WORKER_STACK_SIZE
+#define TOOL_WORKER_STACK_SIZE (8 * 1024)
+#endif
+
+#ifndef TOOL_WORKER_PRIORITY
+#define TOOL_WORKER_PRIORITY 0              // Below loop() (1): a busy tool can't starve it or its deadline check
+#endif
+
+#ifndef TOOL_MAX_TOOLS
+#define TOOL_MAX_TOOLS 16
+#endif
+
+#ifndef TOOL_QUEUE_SIZE
+#define TOOL_QUEUE_SIZE (16 * 1024)         // Pending calls: id + parameters JSON
+#endif
+
+#ifndef TOOL_JSON_ARENA_SIZE
+#define TOOL_JSON_ARENA_SIZE (4 * 1024)     // One call's parsed parameters
+#endif
+
+#ifndef TOOL_RESULT_MAX_SIZE
+#define TOOL_RESULT_MAX_SIZE 1024
+#endif
+
+#ifndef TOOL_DEFAULT_TIMEOUT_MS
+#define TOOL_DEFAULT_TIMEOUT_MS 5000
+#endif
+
+/**
+ * @brief Tool implementation, run on the worker task
+ *
+ * Runs concurrently with loop() (or from it when TOOL_WORKER_ENABLED is 0),
+ * so a handler may only use state that is safe from another task: atomics,
+ * thread-safe calls such as Speaker::setVolume() or NetworkTask sends, or a
+ * flag / EventLoop::post() that hands the work to loop().
+ * @param parameters The call's "parameters" object (may be null)
+ * @param result Buffer for the result text sent back to the agent
+ * @param result_size Size of the result buffer
+ * @return false to report the result as an error
+ */
+using ToolHandler = std::function<bool(JsonObjectConst parameters, char* result, size_t result_size)>;
+
+/**
+ * @brief Where results go, e.g. NetworkTask::sendToolResult (must be thread-safe)
+ */
+using ToolResultSink = std::function<bool(const char* tool_call_id, const char* result, bool is_error)>;
+
+/**
+ * @brief Per-tool counters
+ */
+struct ToolStats {
+    uint32_t calls;
+    uint32_t errors;
+    uint32_t timeouts;
+    uint32_t late;        // Results that arrived after the timeout reply and were dropped
+};
+
+/**
+ * @class ToolRegistry
+ * @brief Runs client tool calls by name on a worker task.
+ *
+ * handleToolCall() only queues the call, so a slow tool (sensor read,
+ * motor move) no longer stalls audio receive or playback. The worker runs
+ * below loop()'s priority and only gets the core while loop() waits. Each
+ * tool has a timeout counted from the moment the call arrived: if it
+ * expires, loop() sends the agent an error result straight away and the
+ * tool's own result is dropped when it finishes. Unknown tools are
+ * answered with an error.
+ *
+ * Latency (call received -> result posted) is recorded per tool.
+ */
+class ToolRegistry {
+public:
+    ToolRegistry();
+    ~ToolRegistry();
+
+    /**
+     * @brief Add a tool; call before begin()
+     * @param name Tool name as configured on the agent
+     * @param handler Implementation
+     * @param timeoutMs Time allowed from call to result
+     * @return false if the table is full or the name is taken
+     */
+    bool registerTool(const char* name, ToolHandler handler, uint32_t timeoutMs = TOOL_DEFAULT_TIMEOUT_MS);
+
+    /**
+     * @brief Allocate the call queue and start the worker
+     * @param sink Receives every result, from the worker task or loop()
+     * @param threaded false to run tools from loop() instead
+     * @return false if the queue couldn't be allocated
+     */
+    bool begin(ToolResultSink sink, bool threaded = TOOL_WORKER_ENABLED);
+
+    /**
+     * @brief Stop the worker (waits for a running tool to return)
+     */
+    void end();
+
+    /**
+     * @brief Queue a call; matches ToolCallCallback
+     */
+    void handleToolCall(const char* tool_name, const char* tool_call_id, JsonObjectConst parameters);
+
+    /**
+     * @brief Queue a call whose parameters are still JSON text, e.g. from
+     *        NetworkTask::onToolCallJson(); they are parsed once, on the worker
+     */
+    void handleToolCall(const char* tool_name, const char* tool_call_id, const char* parameters_json);
+
+    /**
+     * @brief Answer timed-out calls, or run queued calls when not threaded (call from loop())
+     */
+    void loop();
+
+    /**
+     * @brief Time until loop() must answer the running call, so the caller
+     *        can sleep until then
+     * @return UINT32_MAX if no call is waiting on a deadline
+     */
+    uint32_t getMsUntilTimeout();
+
+    size_t getToolCount() const;
+    const char* getToolName(size_t index) const;
+    const ToolStats& getStats(size_t index) const;
+    const LatencyHistogram& getLatency(size_t index) const;   // Milliseconds
+    void resetStats();
+
+    /**
+     * @brief Format one tool's statistics, e.g.
+     *        "TOOL wag_tail n=4 p50=310 p99=320 max=320 err=0 timeout=1 late=1"
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t format(size_t index, char* out, size_t size) const;
+
+private:
+    struct Tool {
+        char name[32];
+        ToolHandler handler;
+        uint32_t timeoutMs;
+        ToolStats stats;
+        LatencyHistogram latencyMs;
+    };
+
+    Tool tools[TOOL_MAX_TOOLS];
+    size_t toolCount;
+    MessageQueue calls;
+    ToolResultSink resultSink;
+    bool threaded;
+    std::atomic<bool> running;
+    std::atomic<bool> stopped;
+#ifdef ESP_PLATFORM
+    TaskHandle_t taskHandle;
+#else
+    std::thread worker;
+    std::mutex wakeLock;
+    std::condition_variable wakeup;
+    bool wakePending;
+#endif
+
+    // The call currently running, watched by loop() for its deadline
+    std::mutex inFlightLock;
+    bool inFlight;
+    bool inFlightAnswered;
+    size_t inFlightTool;
+    uint32_t inFlightStartUs;      // When the call arrived, micros()
+    char inFlightId[64];
+
+    JsonArena parametersArena;           // Worker only
+    char result[TOOL_RESULT_MAX_SIZE];   // Worker only
+
+    int findTool(const char* name) const;
+    static void taskEntry(void* param);
+    void run();
+    void wake();
+    void waitForCall();
+    char* reserveCall(const char* tool_name, const char* tool_call_id, size_t jsonLength, int& index);
+    void commitCall(int index);
+    bool runNext();
+    void finish(size_t index, const char* tool_call_id, uint32_t startUs, const char* text, bool is_error);
+};
+
+#endif
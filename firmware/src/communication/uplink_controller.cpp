@@ -0,0 +1,221 @@
+#include "uplink_controller.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* const MODE_NAMES[UPLINK_MODE_COUNT] = {"fast", "normal", "conserve", "gated"};
+
+UplinkController::UplinkController() :
+    mode(UPLINK_NORMAL),
+    reason("start"),
+    rttMs(0),
+    sendAverageMs(0),
+    backlogMs(0),
+    betterSinceMs(0),
+    better(false),
+    lastSpeechMs(0),
+    haveSpeech(false),
+    changes(0),
+    gated(0),
+    modeSinceMs(0),
+    statsStartMs(0),
+    started(false) {
+    memset(modeTimeMs, 0, sizeof(modeTimeMs));
+}
+
+void UplinkController::recordRssi(int8_t dbm) {
+    rssi.record(dbm);
+}
+
+void UplinkController::recordPing(uint32_t rttMs) {
+    this->rttMs = rttMs;
+}
+
+void UplinkController::recordSend(uint32_t sendMs) {
+    this->sendMs.record(sendMs);
+    sendAverageMs = sendAverageMs == 0 ? sendMs : sendAverageMs + ((int32_t)sendMs - (int32_t)sendAverageMs) / 4;
+}
+
+void UplinkController::setBacklog(uint32_t backlogMs) {
+    this->backlogMs = backlogMs;
+}
+
+bool UplinkController::update(uint32_t nowMs) {
+    if (!started) {
+        started = true;
+        modeSinceMs = nowMs;
+        statsStartMs = nowMs;
+    }
+
+    const char* why = "";
+    UplinkMode wanted = target(why);
+    if (wanted > mode) {
+        setMode(wanted, why, nowMs);
+        return true;
+    }
+    if (wanted == mode) {
+        better = false;
+        return false;
+    }
+
+    // Better signals: one step at a time, each after a quiet period
+    if (!better) {
+        better = true;
+        betterSinceMs = nowMs;
+        return false;
+    }
+    if (nowMs - betterSinceMs < UPLINK_RECOVERY_MS) {
+        return false;
+    }
+    setMode((UplinkMode)(mode - 1), "recovered", nowMs);
+    return true;
+}
+
+bool UplinkController::admit(const int16_t* samples, size_t count, uint32_t nowMs) {
+    if (samples != nullptr && count > 0) {
+        uint64_t sumSquares = 0;
+        for (size_t i = 0; i < count; i++) {
+            sumSquares += (int32_t)samples[i] * samples[i];
+        }
+        if (sumSquares / count >= (uint64_t)UPLINK_VAD_MIN_RMS * UPLINK_VAD_MIN_RMS) {
+            lastSpeechMs = nowMs;
+            haveSpeech = true;
+            return true;
+        }
+    }
+
+    if (mode != UPLINK_GATED || (haveSpeech && nowMs - lastSpeechMs <= UPLINK_VAD_HANGOVER_MS)) {
+        return true;
+    }
+    gated++;
+    return false;
+}
+
+UplinkMode UplinkController::getMode() const {
+    return mode;
+}
+
+uint32_t UplinkController::getChunkMs() const {
+    return chunkMs(mode);
+}
+
+const char* UplinkController::getReason() const {
+    return reason;
+}
+
+const char* UplinkController::modeName(UplinkMode mode) {
+    return mode < UPLINK_MODE_COUNT ? MODE_NAMES[mode] : "?";
+}
+
+uint32_t UplinkController::chunkMs(UplinkMode mode) {
+    switch (mode) {
+        case UPLINK_FAST:
+            return UPLINK_FAST_CHUNK_MS;
+        case UPLINK_NORMAL:
+            return UPLINK_NORMAL_CHUNK_MS;
+        default:
+            return UPLINK_CONSERVE_CHUNK_MS;
+    }
+}
+
+const LatencyHistogram& UplinkController::getSendTime() const {
+    return sendMs;
+}
+
+uint32_t UplinkController::getChangeCount() const {
+    return changes;
+}
+
+uint32_t UplinkController::getGatedCount() const {
+    return gated;
+}
+
+uint32_t UplinkController::getTimeInMode(UplinkMode mode, uint32_t nowMs) const {
+    if (mode >= UPLINK_MODE_COUNT) {
+        return 0;
+    }
+    uint64_t timeMs = modeTimeMs[mode];
+    if (started && mode == this->mode) {
+        timeMs += nowMs - modeSinceMs;
+    }
+    return (uint32_t)timeMs;
+}
+
+void UplinkController::resetStats(uint32_t nowMs) {
+    sendMs.reset();
+    changes = 0;
+    gated = 0;
+    memset(modeTimeMs, 0, sizeof(modeTimeMs));
+    modeSinceMs = nowMs;
+    statsStartMs = nowMs;
+}
+
+size_t UplinkController::format(char* out, size_t size, uint32_t nowMs) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size,
+                           "UPLINK mode=%s chunk=%lums reason=%s | send_ms p50=%lu p99=%lu backlog_ms=%lu rssi=%d rtt=%lu"
+                           " | changes=%lu gated=%lu |",
+                           modeName(mode), (unsigned long)getChunkMs(), reason,
+                           (unsigned long)sendMs.getPercentile(50), (unsigned long)sendMs.getPercentile(99),
+                           (unsigned long)backlogMs, (int)rssi.get(),
+                           (unsigned long)rttMs, (unsigned long)changes, (unsigned long)gated);
+    uint32_t totalMs = started ? nowMs - statsStartMs : 0;
+    for (size_t i = 0; i < UPLINK_MODE_COUNT && written >= 0 && (size_t)written < size; i++) {
+        uint32_t timeMs = getTimeInMode((UplinkMode)i, nowMs);
+        written += snprintf(out + written, size - written, " %s=%lu%%", MODE_NAMES[i],
+                            (unsigned long)(totalMs > 0 ? (uint64_t)timeMs * 100 / totalMs : 0));
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+UplinkMode UplinkController::target(const char*& why) const {
+    UplinkMode wanted = UPLINK_FAST;
+    why = "";
+
+    if (rssi.hasSample() && rssi.get() < UPLINK_RSSI_FAST_DBM) {
+        wanted = UPLINK_NORMAL;
+        why = "rssi";
+    } else if (rttMs > UPLINK_RTT_FAST_MS) {
+        wanted = UPLINK_NORMAL;
+        why = "rtt";
+    }
+    if (rssi.hasSample() && rssi.get() < UPLINK_RSSI_WEAK_DBM) {
+        wanted = UPLINK_CONSERVE;
+        why = "rssi";
+    }
+
+    // Not keeping up: one step below the current mode, at least
+    UplinkMode stepDown = mode < UPLINK_CONSERVE ? (UplinkMode)(mode + 1) : UPLINK_CONSERVE;
+    if (backlogMs > UPLINK_BACKLOG_HIGH_MS && stepDown > wanted) {
+        wanted = stepDown;
+        why = "backlog";
+    } else if (sendAverageMs > getChunkMs() && stepDown > wanted) {
+        wanted = stepDown;
+        why = "send";
+    }
+    if (backlogMs > UPLINK_BACKLOG_GATE_MS) {
+        wanted = UPLINK_GATED;
+        why = "backlog";
+    }
+
+    // Gated stays until the backlog has drained, whatever the other signals say
+    if (mode == UPLINK_GATED && backlogMs > UPLINK_BACKLOG_HIGH_MS) {
+        wanted = UPLINK_GATED;
+    }
+    return wanted;
+}
+
+void UplinkController::setMode(UplinkMode next, const char* why, uint32_t nowMs) {
+    modeTimeMs[mode] += nowMs - modeSinceMs;
+    modeSinceMs = nowMs;
+    mode = next;
+    reason = why;
+    better = false;
+    changes++;
+}
@@ -0,0 +1,157 @@
+#ifndef UPLINK_CONTROLLER_H
+#define UPLINK_CONTROLLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "link_monitor.h"
+#include "../telemetry/latency_histogram.h"
+
+#ifndef UPLINK_FAST_CHUNK_MS
+#define UPLINK_FAST_CHUNK_MS 100        // Strong link: the server hears speech sooner
+#endif
+
+#ifndef UPLINK_NORMAL_CHUNK_MS
+#define UPLINK_NORMAL_CHUNK_MS 250      // Same as the Python SDK
+#endif
+
+#ifndef UPLINK_CONSERVE_CHUNK_MS
+#define UPLINK_CONSERVE_CHUNK_MS 500    // Fewer messages, less JSON/TLS/TCP overhead per second of audio
+#endif
+
+#ifndef UPLINK_BACKLOG_HIGH_MS
+#define UPLINK_BACKLOG_HIGH_MS 500      // Audio queued but not yet written; above this, step down
+#endif
+
+#ifndef UPLINK_BACKLOG_GATE_MS
+#define UPLINK_BACKLOG_GATE_MS 1500     // Above this, only speech is sent
+#endif
+
+#ifndef UPLINK_RSSI_FAST_DBM
+#define UPLINK_RSSI_FAST_DBM -65        // Smoothed RSSI needed for fast mode
+#endif
+
+#ifndef UPLINK_RSSI_WEAK_DBM
+#define UPLINK_RSSI_WEAK_DBM -78        // Below this, conserve
+#endif
+
+#ifndef UPLINK_RTT_FAST_MS
+#define UPLINK_RTT_FAST_MS 300          // Ping RTT needed for fast mode
+#endif
+
+#ifndef UPLINK_RECOVERY_MS
+#define UPLINK_RECOVERY_MS 5000         // Signals must allow a better mode this long before each step up
+#endif
+
+#ifndef UPLINK_VAD_MIN_RMS
+#define UPLINK_VAD_MIN_RMS 600          // Chunks at least this loud count as speech when gated
+#endif
+
+#ifndef UPLINK_VAD_HANGOVER_MS
+#define UPLINK_VAD_HANGOVER_MS 1500     // Silence still sent after speech, so the server sees the turn end
+#endif
+
+// Ordered from most to least aggressive
+enum UplinkMode {
+    UPLINK_FAST,
+    UPLINK_NORMAL,
+    UPLINK_CONSERVE,
+    UPLINK_GATED,           // Conserve-sized chunks, silence beyond the hangover not sent
+    UPLINK_MODE_COUNT
+};
+
+/**
+ * @class UplinkController
+ * @brief Chooses the real-time uplink chunk size, and whether silence is
+ *        sent at all, from link quality and send backlog.
+ *
+ * Inputs are the smoothed RSSI, the server's ping RTT, how long each chunk
+ * took from capture to written, and how much audio is still queued. Any
+ * sign that the link can't keep up moves to a more conservative mode at
+ * once; stepping back up takes UPLINK_RECOVERY_MS of good signals per
+ * step, so a marginal link doesn't flap. In gated mode silent chunks are
+ * dropped once UPLINK_VAD_HANGOVER_MS has passed since the last speech,
+ * which bounds the backlog while keeping the trailing silence the server
+ * needs to end a turn.
+ *
+ * The audio format is fixed by the agent configuration, so the bitrate
+ * itself can't be lowered; the chunk size and gating are what adapt.
+ */
+class UplinkController {
+public:
+    UplinkController();
+
+    void recordRssi(int8_t dbm);
+    void recordPing(uint32_t rttMs);
+
+    /**
+     * @brief A chunk was written to the socket
+     * @param sendMs Capture (enqueue) to written
+     */
+    void recordSend(uint32_t sendMs);
+
+    /**
+     * @brief Audio queued for the uplink but not yet written
+     */
+    void setBacklog(uint32_t backlogMs);
+
+    /**
+     * @brief Re-evaluate the mode
+     * @return true if it changed; getReason() says why
+     */
+    bool update(uint32_t nowMs);
+
+    /**
+     * @brief Decide whether a chunk goes out; also tracks speech for gating
+     * @return false if the chunk should be dropped as silence
+     */
+    bool admit(const int16_t* samples, size_t count, uint32_t nowMs);
+
+    UplinkMode getMode() const;
+    uint32_t getChunkMs() const;
+    const char* getReason() const;      // Signal behind the last change
+    static const char* modeName(UplinkMode mode);
+    static uint32_t chunkMs(UplinkMode mode);
+
+    // Statistics
+    const LatencyHistogram& getSendTime() const;     // Milliseconds
+    uint32_t getChangeCount() const;
+    uint32_t getGatedCount() const;
+    uint32_t getTimeInMode(UplinkMode mode, uint32_t nowMs) const;
+    void resetStats(uint32_t nowMs);
+
+    /**
+     * @brief Current mode and why, the inputs behind it, and the share of
+     *        time spent in each mode since resetStats():
+     *        "UPLINK mode=normal chunk=250ms reason=rssi | send_ms p50=40 p99=300 backlog_ms=0 rssi=-70 rtt=120 |
+     *         changes=2 gated=0 | fast=10% normal=90% conserve=0% gated=0%"
+     * @return Length of the line in out
+     */
+    size_t format(char* out, size_t size, uint32_t nowMs) const;
+
+private:
+    UplinkMode mode;
+    const char* reason;
+
+    RssiAverage rssi;           // Smoothed like LinkMonitor's
+    uint32_t rttMs;
+    uint32_t sendAverageMs;     // Smoothed, 0 before the first send
+    uint32_t backlogMs;
+
+    uint32_t betterSinceMs;     // Signals have allowed a better mode since, while better is set
+    bool better;
+    uint32_t lastSpeechMs;
+    bool haveSpeech;
+
+    LatencyHistogram sendMs;
+    uint32_t changes;
+    uint32_t gated;
+    uint64_t modeTimeMs[UPLINK_MODE_COUNT];
+    uint32_t modeSinceMs;
+    uint32_t statsStartMs;
+    bool started;
+
+    UplinkMode target(const char*& why) const;
+    void setMode(UplinkMode next, const char* why, uint32_t nowMs);
+};
+
+#endif
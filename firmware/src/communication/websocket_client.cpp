@@ -1,56 +1,81 @@
 #include "websocket_client.h"
-#include "../config.h"
+#include "outbound_messages.h"
+#include "ca_bundle.h"
+#include "../system/mem_tracker.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
 
 // Speaker audio configuration
 // #define SPEAKER_BYTES_PER_SAMPLE 2  // 16-bit PCM audio = 2 bytes per sample
 // #define SPEAKER_SAMPLE_RATE 16000   // Set your speaker sample rate (e.g., 16000 Hz)
 
-// ElevenLabs WebSocket server certificate (root CA)
-const char* elevenlabs_ca_cert = \
-"-----BEGIN CERTIFICATE-----\n" \
-"MIIFazCCA1OgAwIBAgIRAIIQz7DSQONZRGPgu2OCiwAwDQYJKoZIhvcNAQELBQAw\n" \
-"TzELMAkGA1UEBhMCVVMxKTAnBgNVBAoTIEludGVybmV0IFNlY3VyaXR5IFJlc2Vh\n" \
-"cmNoIEdyb3VwMRUwEwYDVQQDEwxJU1JHIFJvb3QgWDEwHhcNMTUwNjA0MTEwNDM4\n" \
-"WhcNMzUwNjA0MTEwNDM4WjBPMQswCQYDVQQGEwJVUzEpMCcGA1UEChMgSW50ZXJu\n" \
-"ZXQgU2VjdXJpdHkgUmVzZWFyY2ggR3JvdXAxFTATBgNVBAMTDElTUkcgUm9vdCBY\n" \
-"MTCCAiIwDQYJKoZIhvcNAQEBBQADggIPADCCAgoCggIBAK3oJHP0FDfzm54rVygc\n" \
-"h77ct984kIxuPOZXoHj3dcKi/vVqbvYATyjb3miGbESTtrFj/RQSa78f0uoxmyF+\n" \
-"0TM8ukj13Xnfs7j/EvEhmkvBioZxaUpmZmyPfjxwv60pIgbz5MDmgK7iS4+3mX6U\n" \
-"A5/TR5d8mUgjU+g4rk8Kb4Mu0UlXjIB0ttov0DiNewNwIRt18jA8+o+u3dpjq+sW\n" \
-"T8KOEUt+zwvo/7V3LvSye0rgTBIlDHCNAymg4VMk7BPZ7hm/ELNKjD+Jo2FR3qyH\n" \
-"B5T0Y3HsLuJvW5iB4YlcNHlsdu87kGJ55tukmi8mxdAQ4Q7e2RCOFvu396j3x+UC\n" \
-"B5iPNgiV5+I3lg02dZ77DnKxHZu8A/lJBdiB3QW0KtZB6awBdpUKD9jf1b0SHzUv\n" \
-"KBds0pjBqAlkd25HN7rOrFleaJ1/ctaJxQZBKT5ZPt0m9STJEadao0xAH0ahmbWn\n" \
-"OlFuhjuefXKnEgV4We0+UXgVCwOPjdAvBbI+e0ocS3MFEvzG6uBQE3xDk3SzynTn\n" \
-"jh8BCNAw1FtxNrQHusEwMFxIt4I7mKZ9YIqioymCzLq9gwQbooMDQaHWBfEbwrbw\n" \
-"qHyGO0aoSCqI3Haadr8faqU9GY/rOPNk3sgrDQoo//fb4hVC1CLQJ13hef4Y53CI\n" \
-"rU7m2Ys6xt0nUW7/vGT1M0NPAgMBAAGjQjBAMA4GA1UdDwEB/wQEAwIBBjAPBgNV\n" \
-"HRMBAf8EBTADAQH/MB0GA1UdDgQWBBR5tFnme7bl5AFzgAiIyBpY9umbbjANBgkq\n" \
-"hkiG9w0BAQsFAAOCAgEAVR9YqbyyqFDQDLHYGmkgJykIrGF1XIpu+ILlaS/V9lZL\n" \
-"ubhzEFnTIZd+50xx+7LSYK05qAvqFyFWhfFQDlnrzuBZ6brJFe+GnY+EgPbk6ZGQ\n" \
-"3BebYhtF8GaV0nxvwuo77x/Py9auJ/GpsMiu/X1+mvoiBOv/2X/qkSsisRcOj/KK\n" \
-"NFtY2PwByVS5uCbMiogziUwthDyC3+6WVwW6LLv3xLfHTjuCvjHIInNzktHCgKQ5\n" \
-"ORAzI4JMPJ+GslWYHb4phowim57iaztXOoJwTdwJx4nLCgdNbOhdjsnvzqvHu7Ur\n" \
-"TkXWStAmzOVyyghqpZXjFaH3pO3JLF+l+/+sKAIuvtd7u+Nxe5AW0wdeRlN8NwdC\n" \
-"jNPElpzVmbUq4JUagEiuTDkHzsxHpFKVK7q4+63SM1N95R1NbdWhscdCb+ZAJzVc\n" \
-"oyi3B43njTOQ5yOf+1CceWxG1bQVs5ZufpsMljq4Ui0/1lvh+wjChP4kqKOJ2qxq\n" \
-"4RgqsahDYVvTH9w7jXbyLeiNdd8XM2w9U/t7y0Ff/9yi0GE44Za4rF2LN9d11TPA\n" \
-"mRGunUHBcnWEvgJBQl9nJEiU0Zsnvgc/ubhPgXRR4Xq37Z0j4r7g1SgEEzwxA57d\n" \
-"emyPxgcYxn/eR44/KJ4EBs+lVDR3veyJm+kXQ99b21/+jh5Xos1AnX5iItreGCc=\n" \
-"-----END CERTIFICATE-----\n";
+const char* elevenlabs_host = "api.elevenlabs.io";
+const uint16_t elevenlabs_port = 443;
 
 // Static instance for callback handling
 ElevenLabsClient* ElevenLabsClient::instance = nullptr;
 
+// Missing or non-string values read as ""
+static const char* textOf(JsonVariantConst value) {
+    const char* text = value.as<const char*>();
+    return text ? text : "";
+}
+
+void* JsonArenaAllocator::allocate(size_t size) {
+    return arena.isReady() ? arena.allocate(size) : memAlloc(MEM_TAG_NETWORK, size);
+}
+
+void JsonArenaAllocator::deallocate(void* ptr) {
+    if (arena.owns(ptr)) {
+        arena.deallocate(ptr);
+    } else {
+        memFree(ptr);
+    }
+}
+
+void* JsonArenaAllocator::reallocate(void* ptr, size_t new_size) {
+    if (arena.isReady() && (ptr == nullptr || arena.owns(ptr))) {
+        return arena.reallocate(ptr, new_size);
+    }
+    return memRealloc(MEM_TAG_NETWORK, ptr, new_size);
+}
+
 ElevenLabsClient::ElevenLabsClient() : 
+    webSocket(&sockets[0]),
+    standbySocket(&sockets[1]),
+    jsonAllocator(jsonArena),
+    serverHost(elevenlabs_host),
+    serverPort(elevenlabs_port),
+    serverSecure(true),
     connected(false),
     overrideAudio(true),
     streamingAudioEnabled(true),
+    binaryAudioRequested(false),
+    binaryAudioFrames(0),
+    binaryAudioRejected(0),
+    playbackSampleRate(0),
     lastReconnectAttempt(0),
     reconnectInterval(5000),
     reconnectAttempts(0),
     shouldReconnect(false),
+    networkAvailable(true),
     lastInterruptId(0),  // Initialize interrupt tracking
+    interruptSink(nullptr),
+    traceRecorder(nullptr),
+    reconnectTiming(),
+    connectionLostTime(0),
+    handshakeStartTime(0),
+    initStartTime(0),
+    awaitingInit(false),
+    hotStandbyEnabled(false),
+    standbyState(STANDBY_OFF),
+    standbyStartTime(0),
+    lastStandbyAttempt(0),
+    standbyHandshakeMs(0),
+    failoverCount(0),
+    lastRssiSample(0),
     audioCallback(nullptr),
     transcriptCallback(nullptr),
     agentResponseCallback(nullptr),
@@ -75,34 +100,56 @@ void ElevenLabsClient::begin(const char* agent_id) {
     
     Serial.println("Initializing ElevenLabs WebSocket connection...");
     
-    // Configure SSL client
-    wifiClientSecure.setCACert(elevenlabs_ca_cert);
-    wifiClientSecure.setTimeout(10000);
-    
-    // Direct connection to public agent endpoint
-    String wsUrl = "/v1/convai/conversation?agent_id=" + agentId;
-    Serial.println("Connecting to: api.elevenlabs.io" + wsUrl);
-    webSocket.beginSSL("api.elevenlabs.io", 443, wsUrl.c_str(), "", "https");
+    // Reset connection state
+    resetReconnectionState();
+    connectionLostTime = millis();
     
-    webSocket.onEvent(webSocketEvent);
+    // Reassembly buffer for fragmented messages, allocated once
+    if (!fragmentAssembler.begin()) {
+        Serial.printf("[WS_CLIENT] WARNING: Failed to allocate %u byte fragment buffer - fragmented messages will be dropped\n",
+                      (unsigned int)WS_FRAGMENT_BUFFER_SIZE);
+    }
     
-    // Configure heartbeat - more conservative settings to prevent disconnections
-    webSocket.enableHeartbeat(30000, 5000, 3);  // 30s ping interval, 5s timeout, 3 retries
+    // Arena for JSON documents; without it parsing falls back to the heap
+    if (!jsonArena.begin()) {
+        Serial.printf("[WS_CLIENT] WARNING: Failed to allocate %u byte JSON arena - using heap per message\n",
+                      (unsigned int)JSON_ARENA_SIZE);
+    }
     
-    // Set reconnect interval
-    webSocket.setReconnectInterval(5000);
+    // Direct connection to public agent endpoint
+    Serial.println(String("Connecting to: ") + serverHost + "/v1/convai/conversation?agent_id=" + agentId);
+    startConnection();
     
-    // Reset connection state
-    resetReconnectionState();
+    // Either socket can be the active one; events go where its role says
+    for (WebSocketsClient& socket : sockets) {
+        WebSocketsClient* self = &socket;
+        socket.onEvent([this, self](WStype_t type, uint8_t* payload, size_t length) {
+            if (self == webSocket) {
+                webSocketEvent(type, payload, length);
+            } else {
+                handleStandbyEvent(type, payload, length);
+            }
+        });
+        
+        // Configure heartbeat - more conservative settings to prevent disconnections
+        socket.enableHeartbeat(30000, 5000, 3);  // 30s ping interval, 5s timeout, 3 retries
+        
+        // Set reconnect interval
+        socket.setReconnectInterval(5000);
+    }
     
     Serial.println("WebSocket configured with SSL, attempting connection...");
 }
 
 void ElevenLabsClient::loop() {
-    webSocket.loop();
+    webSocket->loop();
+    if (standbyState != STANDBY_OFF) {
+        standbySocket->loop();
+    }
+    updateStandby();
     
     // Handle reconnection if needed
-    if (!connected && shouldReconnect) {
+    if (!connected && shouldReconnect && networkAvailable) {
         unsigned long currentTime = millis();
         if (currentTime - lastReconnectAttempt >= getReconnectDelay()) {
             Serial.println("Attempting to reconnect to ElevenLabs WebSocket...");
@@ -113,9 +160,10 @@ void ElevenLabsClient::loop() {
 }
 
 void ElevenLabsClient::disconnect() {
+    closeStandby("client disconnect");
     if (connected) {
         shouldReconnect = false;
-        webSocket.disconnect();
+        webSocket->disconnect();
         connected = false;
         Serial.println("WebSocket disconnected");
     }
@@ -125,26 +173,95 @@ bool ElevenLabsClient::isConnected() {
     return connected && (WiFi.status() == WL_CONNECTED);
 }
 
+void ElevenLabsClient::setNetworkAvailable(bool available) {
+    if (available == networkAvailable) {
+        return;
+    }
+    networkAvailable = available;
+    
+    if (!available) {
+        // The socket is dead; don't wait for TCP to notice
+        closeStandby("network lost");
+        if (connected) {
+            webSocket->disconnect();
+            if (connected) {
+                handleDisconnection();
+            }
+        }
+        Serial.println("[WS_CLIENT] Network down, reconnecting once it's back");
+        return;
+    }
+    
+    // Attempts failed while the network was down; start over at once
+    resetReconnectionState();
+    lastReconnectAttempt = millis() - getReconnectDelay();
+    Serial.println("[WS_CLIENT] Network back, reconnecting");
+}
+
 void ElevenLabsClient::reconnect() {
     if (!agentId.isEmpty() && WiFi.status() == WL_CONNECTED) {
         reconnectAttempts++;
         Serial.printf("WebSocket reconnection attempt #%d\n", reconnectAttempts);
         
         // Disconnect first if still connected
-        webSocket.disconnect();
-        delay(1000);
+        webSocket->disconnect();
         
-        // Reconfigure SSL and reconnect
-        wifiClientSecure.setCACert(elevenlabs_ca_cert);
-        
-        // Direct connection to public agent endpoint
-        String wsUrl = "/v1/convai/conversation?agent_id=" + agentId;
-        webSocket.beginSSL("api.elevenlabs.io", 443, wsUrl.c_str(), "", "https");
+        startConnection();
     } else {
         Serial.println("Cannot reconnect: WiFi not connected or agent ID missing");
     }
 }
 
+void ElevenLabsClient::startConnection() {
+    reconnectTiming = ReconnectTiming();
+    reconnectTiming.attempt = reconnectAttempts;
+    reconnectTiming.backoffMs = millis() - connectionLostTime;
+    awaitingInit = false;
+    
+    // The library resolves the host (lwIP keeps the address cached), parses
+    // the CA bundle and runs a full TLS handshake on every attempt. It makes
+    // a new WiFiClientSecure each time, and the framework's ssl_client has
+    // no hook to load a saved session or an already parsed chain, so all of
+    // it counts towards the handshake. Only the hot standby skips it.
+    handshakeStartTime = millis();
+    beginSocket(*webSocket);
+}
+
+void ElevenLabsClient::beginSocket(WebSocketsClient& socket) {
+    String wsUrl = "/v1/convai/conversation?agent_id=" + agentId;
+    if (binaryAudioRequested) {
+        wsUrl += "&audio_transport=binary";
+    }
+    if (serverSecure) {
+        socket.beginSslWithCA(serverHost.c_str(), serverPort, wsUrl.c_str(), elevenlabs_ca_bundle, "https");
+    } else {
+        socket.begin(serverHost.c_str(), serverPort, wsUrl.c_str(), "https");
+    }
+}
+
+template <typename Write>
+bool ElevenLabsClient::sendFixed(Write write) {
+    // Counting pass for the exact length, then write behind the header space
+    JsonWriter measure(nullptr, 0);
+    size_t length = write(measure).length();
+    
+    JsonArenaScope scope(jsonArena);
+    char* frame = outboundFrame;
+    if (length + 1 > WS_OUTBOUND_FRAME_SIZE) {
+        frame = (char*)jsonAllocator.allocate(WEBSOCKETS_MAX_HEADER_SIZE + length + 1);
+        if (!frame) {
+            Serial.printf("[WS_CLIENT] No memory to serialize %u byte message\n", (unsigned int)length);
+            return false;
+        }
+    }
+    
+    JsonWriter writer(frame + WEBSOCKETS_MAX_HEADER_SIZE, length + 1);
+    write(writer);
+    bool success = webSocket->sendTXT((uint8_t*)frame, length, true);
+    linkMonitor.recordSend(success, millis());
+    return success;
+}
+
 void ElevenLabsClient::sendAudio(const uint8_t* pcm_data, size_t size) {
     if (!connected) {
         handleError("Cannot send audio: WebSocket not connected");
@@ -172,25 +289,27 @@ void ElevenLabsClient::sendAudio(const uint8_t* pcm_data, size_t size) {
         size_t chunkSize = min(MAX_CHUNK_SIZE, size - offset);
         
         // Encode this chunk to base64
-        String base64Audio = base64Encode(pcm_data + offset, chunkSize);
+        JsonArenaScope scope(jsonArena);
+        size_t base64Size = ((chunkSize + 2) / 3) * 4 + 1;
+        char* base64Audio = (char*)jsonAllocator.allocate(base64Size);
+        size_t base64Length = base64Encode(pcm_data + offset, chunkSize, base64Audio, base64Size);
         
         // Validate base64 string is not empty
-        if (base64Audio.length() == 0) {
+        if (base64Length == 0) {
+            jsonAllocator.deallocate(base64Audio);
             handleError("Cannot send audio: Base64 encoding failed for chunk");
             return;
         }
         
-        JsonDocument doc;
-        doc["user_audio_chunk"] = base64Audio;
-        
-        String message;
-        serializeJson(doc, message);
+        JsonDocument doc(&jsonAllocator);
+        doc["user_audio_chunk"] = (const char*)base64Audio;
         
-        bool success = webSocket.sendTXT(message);
+        bool success = sendJson(doc);
+        jsonAllocator.deallocate(base64Audio);
         if (success) {
             chunkCount++;
             Serial.printf("Sent audio chunk %d: %d bytes PCM -> %d chars base64\n", 
-                         chunkCount, chunkSize, base64Audio.length());
+                         chunkCount, chunkSize, base64Length);
         } else {
             handleError("Failed to send audio chunk");
             return;
@@ -216,16 +335,12 @@ void ElevenLabsClient::sendText(const char* text) {
         return;
     }
     
-    JsonDocument doc;
-    doc["type"] = "user_message";
-    doc["text"] = text;
-    
-    String message;
-    serializeJson(doc, message);
-    
-    bool success = webSocket.sendTXT(message);
+    bool success = sendFixed([text](JsonWriter& writer) -> JsonWriter& {
+        return OutboundMessages::userMessage(writer, text);
+    });
     if (success) {
-        Serial.println("Sent text message: " + String(text));
+        Serial.print("Sent text message: ");
+        Serial.println(text);
     } else {
         handleError("Failed to send text message");
     }
@@ -237,13 +352,9 @@ void ElevenLabsClient::sendUserActivity() {
         return;
     }
     
-    JsonDocument doc;
-    doc["type"] = "user_activity";
-    
-    String message;
-    serializeJson(doc, message);
-    
-    webSocket.sendTXT(message);
+    sendFixed([](JsonWriter& writer) -> JsonWriter& {
+        return OutboundMessages::userActivity(writer);
+    });
 }
 
 void ElevenLabsClient::sendContextualUpdate(const char* text) {
@@ -252,14 +363,9 @@ void ElevenLabsClient::sendContextualUpdate(const char* text) {
         return;
     }
     
-    JsonDocument doc;
-    doc["type"] = "contextual_update";
-    doc["text"] = text;
-    
-    String message;
-    serializeJson(doc, message);
-    
-    webSocket.sendTXT(message);
+    sendFixed([text](JsonWriter& writer) -> JsonWriter& {
+        return OutboundMessages::contextualUpdate(writer, text);
+    });
 }
 
 void ElevenLabsClient::sendToolResult(const char* tool_call_id, const char* result, bool is_error) {
@@ -268,16 +374,9 @@ void ElevenLabsClient::sendToolResult(const char* tool_call_id, const char* resu
         return;
     }
     
-    JsonDocument doc;
-    doc["type"] = "client_tool_result";
-    doc["tool_call_id"] = tool_call_id;
-    doc["result"] = result;
-    doc["is_error"] = is_error;
-    
-    String message;
-    serializeJson(doc, message);
-    
-    webSocket.sendTXT(message);
+    sendFixed([=](JsonWriter& writer) -> JsonWriter& {
+        return OutboundMessages::toolResult(writer, tool_call_id, result, is_error);
+    });
 }
 
 void ElevenLabsClient::sendPong(uint32_t event_id) {
@@ -286,14 +385,9 @@ void ElevenLabsClient::sendPong(uint32_t event_id) {
         return;
     }
     
-    JsonDocument doc;
-    doc["type"] = "pong";
-    doc["event_id"] = event_id;
-    
-    String message;
-    serializeJson(doc, message);
-    
-    webSocket.sendTXT(message);
+    sendFixed([event_id](JsonWriter& writer) -> JsonWriter& {
+        return OutboundMessages::pong(writer, event_id);
+    });
     Serial.printf("Sent pong for event ID: %u\n", event_id);
 }
 
@@ -303,18 +397,11 @@ void ElevenLabsClient::sendInitialConnectionMessage() {
         return;
     }
     
-    JsonDocument doc;
-    doc["type"] = "conversation_initiation_client_data";
-    
     // Audio configuration - override default audio handling
-    if (overrideAudio) {
-        doc["conversation_config_override"]["override_agent_output_audio"] = true;
-    }
-    
-    String message;
-    serializeJson(doc, message);
-    
-    bool success = webSocket.sendTXT(message);
+    bool override_audio = overrideAudio;
+    bool success = sendFixed([override_audio](JsonWriter& writer) -> JsonWriter& {
+        return OutboundMessages::conversationInitiation(writer, override_audio);
+    });
     if (success) {
         Serial.println("Sent initial connection message");
     } else {
@@ -334,17 +421,23 @@ void ElevenLabsClient::webSocketEvent(WStype_t type, uint8_t* payload, size_t le
             case WStype_CONNECTED:
                 Serial.printf("WebSocket Connected to: %s\n", payload);
                 instance->connected = true;
+                instance->reconnectTiming.handshakeMs = millis() - instance->handshakeStartTime;
+                instance->initStartTime = millis();
+                instance->awaitingInit = true;
                 instance->resetReconnectionState();
                 instance->sendInitialConnectionMessage();
                 break;
                 
             case WStype_TEXT:
-                Serial.printf("Received text: %s\n", payload);
+                // Audio events run to tens of KB - log only the start
+                Serial.printf("Received text: %.40s%s\n", (char*)payload, length > 40 ? "..." : "");
+                instance->recordTrace(false, payload, length);
                 instance->handleWebSocketMessage(payload, length);
                 break;
                 
             case WStype_BIN:
-                Serial.printf("Received binary data: %u bytes\n", length);
+                instance->recordTrace(true, payload, length);
+                instance->handleBinaryMessage(payload, length);
                 break;
                 
             case WStype_ERROR:
@@ -356,7 +449,7 @@ void ElevenLabsClient::webSocketEvent(WStype_t type, uint8_t* payload, size_t le
             case WStype_FRAGMENT_BIN_START:
             case WStype_FRAGMENT:
             case WStype_FRAGMENT_FIN:
-                Serial.println("Received fragmented message");
+                instance->handleFragment(type, payload, length);
                 break;
                 
             case WStype_PING:
@@ -375,10 +468,15 @@ void ElevenLabsClient::webSocketEvent(WStype_t type, uint8_t* payload, size_t le
 }
 
 void ElevenLabsClient::handleWebSocketMessage(uint8_t* payload, size_t length) {
-    JsonDocument doc;
+    // The document and anything decoded from it live in the arena until the
+    // message has been handled; replies sent meanwhile nest their own scope
+    JsonArenaScope scope(jsonArena);
+    JsonDocument doc(&jsonAllocator);
     DeserializationError error = deserializeJson(doc, payload, length);
     
     if (error) {
+        Serial.printf("[WS_CLIENT] JSON parse failed: %s (%u bytes, arena %u/%u)\n", error.c_str(),
+                      (unsigned int)length, (unsigned int)jsonArena.used(), (unsigned int)jsonArena.capacity());
         handleError("Failed to parse JSON message");
         return;
     }
@@ -386,46 +484,151 @@ void ElevenLabsClient::handleWebSocketMessage(uint8_t* payload, size_t length) {
     processMessage(doc);
 }
 
+bool ElevenLabsClient::sendJson(const JsonDocument& doc) {
+    // Serialize behind WEBSOCKETS_MAX_HEADER_SIZE spare bytes so the
+    // WebSocket library builds the frame in place instead of copying it
+    size_t length = measureJson(doc);
+    size_t frameSize = WEBSOCKETS_MAX_HEADER_SIZE + length + 1;
+    uint8_t* frame = (uint8_t*)jsonAllocator.allocate(frameSize);
+    if (!frame) {
+        Serial.printf("[WS_CLIENT] No memory to serialize %u byte message\n", (unsigned int)length);
+        return false;
+    }
+    
+    serializeJson(doc, (char*)frame + WEBSOCKETS_MAX_HEADER_SIZE, length + 1);
+    bool success = webSocket->sendTXT(frame, length, true);
+    jsonAllocator.deallocate(frame);
+    linkMonitor.recordSend(success, millis());
+    return success;
+}
+
+void ElevenLabsClient::handleFragment(WStype_t type, uint8_t* payload, size_t length) {
+    switch (type) {
+        case WStype_FRAGMENT_TEXT_START:
+        case WStype_FRAGMENT_BIN_START:
+            if (!fragmentAssembler.start(payload, length, type == WStype_FRAGMENT_BIN_START)) {
+                Serial.printf("[WS_CLIENT] Dropping fragmented message (buffer: %u bytes)\n",
+                              (unsigned int)fragmentAssembler.capacity());
+            }
+            break;
+            
+        case WStype_FRAGMENT:
+            fragmentAssembler.append(payload, length);
+            break;
+            
+        case WStype_FRAGMENT_FIN:
+            if (!fragmentAssembler.finish(payload, length)) {
+                Serial.printf("[WS_CLIENT] Fragmented message dropped (%u dropped so far)\n",
+                              fragmentAssembler.getMessagesDropped());
+                break;
+            }
+            
+            recordTrace(fragmentAssembler.isBinary(), fragmentAssembler.data(), fragmentAssembler.length());
+            
+            if (fragmentAssembler.isBinary()) {
+                handleBinaryMessage(fragmentAssembler.data(), fragmentAssembler.length());
+            } else {
+                // Parse straight out of the reassembly buffer
+                handleWebSocketMessage(fragmentAssembler.data(), fragmentAssembler.length());
+            }
+            fragmentAssembler.reset();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+void ElevenLabsClient::handleBinaryMessage(const uint8_t* payload, size_t length) {
+    BinaryAudioFrame frame;
+    if (!parseBinaryAudioFrame(payload, length, frame)) {
+        Serial.printf("Received binary data: %u bytes (not an audio frame, dropped)\n", length);
+        return;
+    }
+    
+    // Same interruption rule as the JSON audio event
+    if (frame.eventId <= lastInterruptId) {
+        Serial.printf("[AUDIO] Skipping binary audio (Event ID: %u <= Last Interrupt: %u)\n",
+                      frame.eventId, lastInterruptId);
+        return;
+    }
+    
+    // The callback gets bare PCM; at another rate it would play at the wrong speed
+    uint32_t sampleRate = binaryAudioSampleRate(frame.format);
+    if (playbackSampleRate != 0 && sampleRate != playbackSampleRate) {
+        if (binaryAudioRejected++ == 0) {
+            Serial.printf("[AUDIO] Dropping binary audio: %u Hz frames, speaker runs at %u Hz\n",
+                          sampleRate, playbackSampleRate);
+        }
+        return;
+    }
+    
+    if (binaryAudioFrames++ == 0) {
+        Serial.printf("[AUDIO] Receiving binary audio frames (%u Hz PCM)\n", sampleRate);
+    }
+    
+    // PCM goes to the callback straight out of the receive buffer
+    if (audioCallback) {
+        audioCallback(frame.pcm, frame.length, frame.eventId);
+    }
+}
+
 void ElevenLabsClient::processMessage(const JsonDocument& doc) {
-    String type = doc["type"].as<String>();
+    // Strings are read in place from the arena-backed document
+    const char* type = textOf(doc["type"]);
     
-    if (type == "conversation_initiation_metadata") {
+    if (strcmp(type, "conversation_initiation_metadata") == 0) {
         // Handle conversation initiation
         if (doc["conversation_initiation_metadata_event"].is<JsonObject>()) {
-            conversationId = doc["conversation_initiation_metadata_event"]["conversation_id"].as<String>();
+            conversationId = textOf(doc["conversation_initiation_metadata_event"]["conversation_id"]);
+            
+            // A new conversation numbers its events from 1 again
+            lastInterruptId = 0;
             
-            Serial.println("Conversation initialized with ID: " + conversationId);
+            Serial.printf("Conversation initialized with ID: %s\n", conversationId.c_str());
+            
+            if (awaitingInit) {
+                awaitingInit = false;
+                reconnectTiming.initMs = millis() - initStartTime;
+                reconnectTiming.totalMs = millis() - connectionLostTime;
+                Serial.printf("[WS_CLIENT] Connect #%u%s: backoff=%ums handshake=%ums init=%ums total=%ums\n",
+                              reconnectTiming.attempt, reconnectTiming.failover ? " (failover)" : "",
+                              reconnectTiming.backoffMs, reconnectTiming.handshakeMs,
+                              reconnectTiming.initMs, reconnectTiming.totalMs);
+            }
             
             if (conversationInitCallback) {
                 conversationInitCallback(conversationId.c_str());
             }
         }
     }
-    else if (type == "user_transcript") {
+    else if (strcmp(type, "user_transcript") == 0) {
         // Handle user transcript
         if (doc["user_transcription_event"].is<JsonObject>()) {
-            String transcript = doc["user_transcription_event"]["user_transcript"].as<String>();
+            const char* transcript = textOf(doc["user_transcription_event"]["user_transcript"]);
             
-            Serial.println("User transcript: " + transcript);
+            Serial.print("User transcript: ");
+            Serial.println(transcript);
             
             if (transcriptCallback) {
-                transcriptCallback(transcript.c_str());
+                transcriptCallback(transcript);
             }
         }
     }
-    else if (type == "agent_response") {
+    else if (strcmp(type, "agent_response") == 0) {
         // Handle agent response
         if (doc["agent_response_event"].is<JsonObject>()) {
-            String response = doc["agent_response_event"]["agent_response"].as<String>();
+            const char* response = textOf(doc["agent_response_event"]["agent_response"]);
             
-            Serial.println("Agent response: " + response);
+            Serial.print("Agent response: ");
+            Serial.println(response);
             
             if (agentResponseCallback) {
-                agentResponseCallback(response.c_str());
+                agentResponseCallback(response);
             }
         }
     }
-    else if (type == "audio") {
+    else if (strcmp(type, "audio") == 0) {
         // Handle audio response - exact Python SDK implementation
         if (doc["audio_event"].is<JsonObject>()) {
             uint32_t event_id = doc["audio_event"]["event_id"].as<uint32_t>();
@@ -439,15 +642,16 @@ void ElevenLabsClient::processMessage(const JsonDocument& doc) {
             
             // Check if audio_base_64 field exists
             if (doc["audio_event"]["audio_base_64"].is<String>()) {
-                String audioBase64 = doc["audio_event"]["audio_base_64"].as<String>();
+                const char* audioBase64 = textOf(doc["audio_event"]["audio_base_64"]);
+                size_t base64Length = strlen(audioBase64);
                 
                 Serial.printf("[AUDIO] Processing audio chunk (Event ID: %u, %d chars)\n", 
-                              event_id, audioBase64.length());
+                              event_id, base64Length);
                 
                 // Decode base64 to PCM audio (like Python SDK)
-                size_t decodedSize = (audioBase64.length() * 3) / 4;  // Estimate decoded size
-                uint8_t* pcmData = new uint8_t[decodedSize];
-                size_t actualSize = base64Decode(audioBase64.c_str(), pcmData, decodedSize);
+                size_t decodedSize = (base64Length * 3) / 4;  // Estimate decoded size
+                uint8_t* pcmData = (uint8_t*)jsonAllocator.allocate(decodedSize);
+                size_t actualSize = pcmData ? base64Decode(audioBase64, pcmData, decodedSize) : 0;
                 
                 if (actualSize > 0) {
                     Serial.printf("[AUDIO] Decoded %d bytes PCM audio\n", actualSize);
@@ -460,19 +664,20 @@ void ElevenLabsClient::processMessage(const JsonDocument& doc) {
                     Serial.println("[AUDIO] Failed to decode base64 audio");
                 }
                 
-                delete[] pcmData;
+                jsonAllocator.deallocate(pcmData);
             } else {
                 Serial.printf("[AUDIO] Received audio event (Event ID: %u) but no audio data found\n", event_id);
             }
         }
     }
-    else if (type == "ping") {
+    else if (strcmp(type, "ping") == 0) {
         // Handle ping and send pong
         if (doc["ping_event"].is<JsonObject>()) {
             uint32_t event_id = doc["ping_event"]["event_id"].as<uint32_t>();
             uint32_t ping_ms = doc["ping_event"]["ping_ms"].as<uint32_t>();
             
             Serial.printf("Received ping: event_id=%u, ping_ms=%u\n", event_id, ping_ms);
+            linkMonitor.recordPing(ping_ms, millis());
             
             // Send pong response
             sendPong(event_id);
@@ -482,28 +687,22 @@ void ElevenLabsClient::processMessage(const JsonDocument& doc) {
             }
         }
     }
-    else if (type == "client_tool_call") {
+    else if (strcmp(type, "client_tool_call") == 0) {
         // Handle tool call
         if (doc["client_tool_call"].is<JsonObject>()) {
-            String tool_name = doc["client_tool_call"]["tool_name"].as<String>();
-            String tool_call_id = doc["client_tool_call"]["tool_call_id"].as<String>();
+            const char* tool_name = textOf(doc["client_tool_call"]["tool_name"]);
+            const char* tool_call_id = textOf(doc["client_tool_call"]["tool_call_id"]);
             
-            Serial.println("Tool call: " + tool_name + " (ID: " + tool_call_id + ")");
+            Serial.printf("Tool call: %s (ID: %s)\n", tool_name, tool_call_id);
             
             if (toolCallCallback) {
-                JsonDocument params_doc;
-                if (doc["client_tool_call"]["parameters"].is<JsonObject>()) {
-                    // Copy the parameters object to the new document
-                    JsonObjectConst parameters = doc["client_tool_call"]["parameters"].as<JsonObjectConst>();
-                    for (JsonPairConst kv : parameters) {
-                        params_doc[kv.key().c_str()] = kv.value();
-                    }
-                }
-                toolCallCallback(tool_name.c_str(), tool_call_id.c_str(), params_doc);
+                // Parameters are passed in place; the callback copies what it keeps
+                toolCallCallback(tool_name, tool_call_id,
+                                 doc["client_tool_call"]["parameters"].as<JsonObjectConst>());
             }
         }
     }
-    else if (type == "vad_score") {
+    else if (strcmp(type, "vad_score") == 0) {
         // Handle VAD score
         if (doc["vad_score_event"].is<JsonObject>()) {
             float vad_score = doc["vad_score_event"]["vad_score"].as<float>();
@@ -513,15 +712,16 @@ void ElevenLabsClient::processMessage(const JsonDocument& doc) {
             }
         }
     }
-    else if (type == "internal_tentative_agent_response") {
+    else if (strcmp(type, "internal_tentative_agent_response") == 0) {
         // Handle tentative agent response (internal)
         if (doc["tentative_agent_response_internal_event"].is<JsonObject>()) {
-            String tentative_response = doc["tentative_agent_response_internal_event"]["tentative_agent_response"].as<String>();
+            const char* tentative_response = textOf(doc["tentative_agent_response_internal_event"]["tentative_agent_response"]);
             
-            Serial.println("Tentative agent response: " + tentative_response);
+            Serial.print("Tentative agent response: ");
+            Serial.println(tentative_response);
         }
     }
-    else if (type == "interruption") {
+    else if (strcmp(type, "interruption") == 0) {
         // Handle interruption - exact Python SDK implementation
         if (doc["interruption_event"].is<JsonObject>()) {
             uint32_t event_id = doc["interruption_event"]["event_id"].as<uint32_t>();
@@ -529,43 +729,38 @@ void ElevenLabsClient::processMessage(const JsonDocument& doc) {
             
             Serial.printf("[INTERRUPTION] Conversation interrupted (Event ID: %u)\n", event_id);
             
+            // Drop already-queued stale speech before anything else runs
+            if (interruptSink) {
+                interruptSink->purgeUpToEvent(event_id);
+            }
+            
             if (interruptionCallback) {
                 interruptionCallback(event_id);
             }
         }
     }
-    else if (type == "agent_response_correction") {
+    else if (strcmp(type, "agent_response_correction") == 0) {
         // Handle agent response correction
         if (doc["agent_response_correction_event"].is<JsonObject>()) {
-            String corrected_response = doc["agent_response_correction_event"]["agent_response_correction"].as<String>();
+            const char* corrected_response = textOf(doc["agent_response_correction_event"]["agent_response_correction"]);
             
-            Serial.println("Agent response correction: " + corrected_response);
+            Serial.print("Agent response correction: ");
+            Serial.println(corrected_response);
             
             if (agentResponseCallback) {
-                agentResponseCallback(corrected_response.c_str());
-            }
-        }
-    }
-    else if (type == "interruption") {
-        // Handle interruption - exact Python SDK implementation
-        if (doc["interruption_event"].is<JsonObject>()) {
-            uint32_t event_id = doc["interruption_event"]["event_id"].as<uint32_t>();
-            lastInterruptId = event_id;  // Update last interrupt ID
-            
-            Serial.printf("[INTERRUPTION] Conversation interrupted (Event ID: %u)\n", event_id);
-            
-            if (interruptionCallback) {
-                interruptionCallback(event_id);
+                agentResponseCallback(corrected_response);
             }
         }
     }
     else {
-        Serial.println("Unknown message type: " + type);
+        Serial.print("Unknown message type: ");
+        Serial.println(type);
     }
 }
 
 void ElevenLabsClient::handleError(const char* error_message) {
-    Serial.println("ElevenLabs Client Error: " + String(error_message));
+    Serial.print("ElevenLabs Client Error: ");
+    Serial.println(error_message);
     
     if (errorCallback) {
         errorCallback(error_message);
@@ -573,15 +768,27 @@ void ElevenLabsClient::handleError(const char* error_message) {
 }
 
 void ElevenLabsClient::handleDisconnection() {
+    if (connected) {
+        connectionLostTime = millis();
+    }
+    
     connected = false;
+    awaitingInit = false;
     conversationId = "";
+    fragmentAssembler.reset();
+    binaryAudioFrames = 0;
+    binaryAudioRejected = 0;
     
-    Serial.println("WebSocket connection lost. Will attempt to reconnect...");
-    
-    // Call error callback to notify application
+    // The conversation is gone either way; the application restarts it
+    // on the next conversation_initiation_metadata
     if (errorCallback) {
         errorCallback("WebSocket connection lost");
     }
+    
+    if (promoteStandby()) {
+        return;
+    }
+    Serial.println("WebSocket connection lost. Will attempt to reconnect...");
 }
 
 void ElevenLabsClient::resetReconnectionState() {
@@ -596,6 +803,52 @@ unsigned long ElevenLabsClient::getReconnectDelay() {
     return min(delay, 60000UL);
 }
 
+const ReconnectTiming& ElevenLabsClient::getReconnectTiming() const {
+    return reconnectTiming;
+}
+
+const LinkMonitor& ElevenLabsClient::getLinkMonitor() const {
+    return linkMonitor;
+}
+
+uint32_t ElevenLabsClient::getFailoverCount() const {
+    return failoverCount;
+}
+
+const JsonArena& ElevenLabsClient::getJsonArena() const {
+    return jsonArena;
+}
+
+const FragmentAssembler& ElevenLabsClient::getFragmentAssembler() const {
+    return fragmentAssembler;
+}
+
+void ElevenLabsClient::attachTraceRecorder(ConversationTrace* trace) {
+    traceRecorder = trace;
+}
+
+void ElevenLabsClient::replayMessage(uint8_t* payload, size_t length, bool binary) {
+    // Replay runs without begin(), so set up the arena on first use
+    if (!jsonArena.isReady()) {
+        jsonArena.begin();
+    }
+
+    // Replayed messages must not be recorded again
+    ConversationTrace* recorder = traceRecorder;
+    traceRecorder = nullptr;
+    webSocketEvent(binary ? WStype_BIN : WStype_TEXT, payload, length);
+    traceRecorder = recorder;
+}
+
+void ElevenLabsClient::recordTrace(bool binary, const uint8_t* payload, size_t length) {
+    if (traceRecorder && traceRecorder->isRecording()) {
+        if (!traceRecorder->record(millis(), binary, payload, length)) {
+            Serial.printf("[WS_CLIENT] Trace buffer full after %u messages - recording stopped\n",
+                          traceRecorder->getRecordCount());
+        }
+    }
+}
+
 // Callback registration methods
 void ElevenLabsClient::onAudioData(AudioDataCallback callback) {
     audioCallback = callback;
@@ -637,11 +890,30 @@ void ElevenLabsClient::onInterruption(InterruptionCallback callback) {
     interruptionCallback = callback;
 }
 
+void ElevenLabsClient::attachInterruptSink(InterruptSink* sink) {
+    interruptSink = sink;
+}
+
 // Configuration methods
+void ElevenLabsClient::setServer(const char* host, uint16_t port, bool secure) {
+    // Lets a local mock server or relay stand in for api.elevenlabs.io
+    serverHost = host;
+    serverPort = port;
+    serverSecure = secure;
+}
+
 void ElevenLabsClient::setOverrideAudio(bool override) {
     overrideAudio = override;
 }
 
+void ElevenLabsClient::enableBinaryAudio(bool enable) {
+    binaryAudioRequested = enable;
+}
+
+void ElevenLabsClient::setPlaybackSampleRate(uint32_t hz) {
+    playbackSampleRate = hz;
+}
+
 void ElevenLabsClient::enableStreamingAudio(bool enable) {
     streamingAudioEnabled = enable;
     Serial.printf("[WS_CLIENT] Streaming audio %s\n", enable ? "enabled" : "disabled");
@@ -651,6 +923,139 @@ bool ElevenLabsClient::isStreamingAudioEnabled() {
     return streamingAudioEnabled;
 }
 
+void ElevenLabsClient::enableHotStandby(bool enable) {
+    hotStandbyEnabled = enable;
+    if (!enable) {
+        closeStandby("hot standby disabled");
+    }
+}
+
+bool ElevenLabsClient::isStandbyReady() const {
+    return standbyState == STANDBY_READY;
+}
+
+// Room for a second TLS session without starving the active one
+static bool hasStandbyBudget() {
+#ifdef ESP_PLATFORM
+    size_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    size_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (freeBytes < WS_STANDBY_MIN_FREE_HEAP || largestBlock < WS_STANDBY_MIN_FREE_BLOCK) {
+        Serial.printf("[STANDBY] Not enough internal RAM for a second TLS session (%u free, %u largest block)\n",
+                      (unsigned int)freeBytes, (unsigned int)largestBlock);
+        return false;
+    }
+#endif
+    return true;
+}
+
+void ElevenLabsClient::updateStandby() {
+    if (!hotStandbyEnabled) {
+        return;
+    }
+    
+    unsigned long now = millis();
+    if (now - lastRssiSample >= 1000 && WiFi.status() == WL_CONNECTED) {
+        linkMonitor.recordRssi(WiFi.RSSI(), now);
+        lastRssiSample = now;
+    }
+    
+    bool degraded = linkMonitor.isDegraded(now);
+    if (standbyState == STANDBY_OFF) {
+        if (connected && degraded && WiFi.status() == WL_CONNECTED &&
+            (lastStandbyAttempt == 0 || now - lastStandbyAttempt >= WS_STANDBY_RETRY_MS)) {
+            lastStandbyAttempt = now;
+            Serial.printf("[STANDBY] Link degraded (%s) - opening standby connection\n",
+                          LinkMonitor::signalName(linkMonitor.getLastSignal()));
+            openStandby();
+        }
+    } else if (connected && !degraded) {
+        closeStandby("link recovered");
+    }
+}
+
+void ElevenLabsClient::openStandby() {
+    if (!hasStandbyBudget()) {
+        return;
+    }
+    
+    standbyState = STANDBY_CONNECTING;
+    standbyStartTime = millis();
+    beginSocket(*standbySocket);
+}
+
+void ElevenLabsClient::closeStandby(const char* reason) {
+    if (standbyState == STANDBY_OFF) {
+        return;
+    }
+    
+    Serial.printf("[STANDBY] Closing standby connection: %s\n", reason);
+    standbyState = STANDBY_OFF;
+    standbySocket->disconnect();
+}
+
+void ElevenLabsClient::handleStandbyEvent(WStype_t type, uint8_t* payload, size_t length) {
+    switch (type) {
+        case WStype_CONNECTED:
+            standbyHandshakeMs = millis() - standbyStartTime;
+            standbyState = STANDBY_READY;
+            Serial.printf("[STANDBY] Ready after %ums\n", standbyHandshakeMs);
+            
+            // The active connection dropped while this one was connecting
+            if (!connected && shouldReconnect) {
+                WebSocketsClient* previous = webSocket;
+                if (promoteStandby()) {
+                    previous->disconnect();
+                }
+            }
+            break;
+            
+        case WStype_DISCONNECTED:
+            if (standbyState != STANDBY_OFF) {
+                Serial.println("[STANDBY] Standby connection closed by server");
+                standbyState = STANDBY_OFF;
+            }
+            break;
+            
+        case WStype_TEXT:
+        case WStype_BIN:
+            // Nothing is expected before the conversation is initiated
+            Serial.printf("[STANDBY] Ignoring %u byte message on standby connection\n", (unsigned int)length);
+            break;
+            
+        default:
+            break;
+    }
+}
+
+bool ElevenLabsClient::promoteStandby() {
+    if (standbyState != STANDBY_READY || !shouldReconnect) {
+        return false;
+    }
+    
+    // Swap roles; the old socket is no longer looped, so it stays down
+    WebSocketsClient* previous = webSocket;
+    webSocket = standbySocket;
+    standbySocket = previous;
+    standbyState = STANDBY_OFF;
+    failoverCount++;
+    
+    reconnectTiming = ReconnectTiming();
+    reconnectTiming.attempt = reconnectAttempts;
+    reconnectTiming.backoffMs = millis() - connectionLostTime;
+    reconnectTiming.handshakeMs = standbyHandshakeMs;
+    reconnectTiming.failover = true;
+    
+    Serial.printf("[STANDBY] Failover #%u: switching to standby connection\n", failoverCount);
+    connected = true;
+    initStartTime = millis();
+    awaitingInit = true;
+    resetReconnectionState();
+    linkMonitor.reset();
+    lastStandbyAttempt = 0;
+    sendInitialConnectionMessage();
+    return true;
+}
+
 // Real-time streaming methods (like Python SDK input_callback)
 void ElevenLabsClient::startRealtimeStreaming() {
     if (!connected) {
@@ -681,43 +1086,46 @@ void ElevenLabsClient::sendRealtimeAudioChunk(const uint8_t* pcm_data, size_t si
     }
     
     // Encode PCM data to base64 (like Python SDK)
-    String base64Audio = base64Encode(pcm_data, size);
-    if (base64Audio.length() == 0) {
+    JsonArenaScope scope(jsonArena);
+    size_t base64Size = ((size + 2) / 3) * 4 + 1;
+    char* base64Audio = (char*)jsonAllocator.allocate(base64Size);
+    if (base64Encode(pcm_data, size, base64Audio, base64Size) == 0) {
+        jsonAllocator.deallocate(base64Audio);
         return;
     }
     
     // Send as real-time chunk (same format as batch)
-    JsonDocument doc;
-    doc["user_audio_chunk"] = base64Audio;
+    JsonDocument doc(&jsonAllocator);
+    doc["user_audio_chunk"] = (const char*)base64Audio;
     
-    String message;
-    serializeJson(doc, message);
-    
-    webSocket.sendTXT(message);
+    sendJson(doc);
+    jsonAllocator.deallocate(base64Audio);
 }
 
 // Utility Functions
-String ElevenLabsClient::base64Encode(const uint8_t* data, size_t length) {
-    if (!data || length == 0) {
-        return "";  // Return empty string for invalid input
+size_t ElevenLabsClient::base64Encode(const uint8_t* data, size_t length, char* output, size_t output_size) {
+    // Needs room for the padded encoding plus a terminator
+    size_t encoded_length = ((length + 2) / 3) * 4;
+    if (!data || length == 0 || !output || output_size <= encoded_length) {
+        return 0;  // Nothing encoded for invalid input
     }
     
     const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    String encoded = "";
-    encoded.reserve((length * 4 / 3) + 4);  // Pre-allocate memory for efficiency
+    size_t out = 0;
     
     for (size_t i = 0; i < length; i += 3) {
         uint32_t b = (data[i] << 16);
         if (i + 1 < length) b |= (data[i + 1] << 8);
         if (i + 2 < length) b |= data[i + 2];
         
-        encoded += base64_chars[(b >> 18) & 0x3F];
-        encoded += base64_chars[(b >> 12) & 0x3F];
-        encoded += (i + 1 < length) ? base64_chars[(b >> 6) & 0x3F] : '=';
-        encoded += (i + 2 < length) ? base64_chars[b & 0x3F] : '=';
+        output[out++] = base64_chars[(b >> 18) & 0x3F];
+        output[out++] = base64_chars[(b >> 12) & 0x3F];
+        output[out++] = (i + 1 < length) ? base64_chars[(b >> 6) & 0x3F] : '=';
+        output[out++] = (i + 2 < length) ? base64_chars[b & 0x3F] : '=';
     }
+    output[out] = '\0';
     
-    return encoded;
+    return out;
 }
 
 size_t ElevenLabsClient::base64Decode(const char* base64_string, uint8_t* output_buffer, size_t max_output_size) {
@@ -732,7 +1140,12 @@ size_t ElevenLabsClient::base64Decode(const char* base64_string, uint8_t* output
         
         for (int j = 0; j < 4; j++) {
             char c = base64_string[i + j];
-            if (c == '=') break;
+            
+            // Padding still occupies its 6 bits
+            if (c == '=') {
+                b <<= 6;
+                continue;
+            }
             
             char* pos = strchr((char*)base64_chars, c);
             if (!pos) return 0;
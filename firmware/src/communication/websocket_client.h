@@ -5,20 +5,76 @@
 #include <functional>
 #include <WebSocketsClient.h>
 #include <ArduinoJson.h>
-#include <WiFiClientSecure.h>
+#include <WiFi.h>
+#include "binary_audio_frame.h"
+#include "conversation_trace.h"
+#include "fragment_assembler.h"
+#include "interrupt_sink.h"
+#include "json_arena.h"
+#include "json_writer.h"
+#include "link_monitor.h"
+
+#ifndef WS_OUTBOUND_FRAME_SIZE
+#define WS_OUTBOUND_FRAME_SIZE 512   // Reused for control messages; longer text goes to the arena
+#endif
+
+#ifndef WS_HOT_STANDBY_ENABLED
+#define WS_HOT_STANDBY_ENABLED 0               // 1 pre-opens a standby connection on a degraded link
+#endif
+
+#ifndef WS_STANDBY_MIN_FREE_HEAP
+#define WS_STANDBY_MIN_FREE_HEAP (64 * 1024)   // Internal RAM left over for a second TLS session
+#endif
+
+#ifndef WS_STANDBY_MIN_FREE_BLOCK
+#define WS_STANDBY_MIN_FREE_BLOCK (20 * 1024)  // mbedTLS record buffers need contiguous blocks
+#endif
+
+#ifndef WS_STANDBY_RETRY_MS
+#define WS_STANDBY_RETRY_MS 10000              // Between standby attempts while degraded
+#endif
 
 // Callback function types for handling server events
 using AudioDataCallback = std::function<void(const uint8_t* pcm_data, size_t size, uint32_t event_id)>;  // Raw PCM audio
 using TranscriptCallback = std::function<void(const char* transcript)>;
 using AgentResponseCallback = std::function<void(const char* response)>;
 using ConversationInitCallback = std::function<void(const char* conversation_id)>;
-using ToolCallCallback = std::function<void(const char* tool_name, const char* tool_call_id, const JsonDocument& parameters)>;
+using ToolCallCallback = std::function<void(const char* tool_name, const char* tool_call_id, JsonObjectConst parameters)>;  // Valid during the call only
 using ErrorCallback = std::function<void(const char* error_message)>;
 using VadScoreCallback = std::function<void(float vad_score)>;
 using PingCallback = std::function<void(uint32_t event_id, uint32_t ping_ms)>;
 using ConversationEndCallback = std::function<void()>;
 using InterruptionCallback = std::function<void(uint32_t event_id)>;
 
+// Per-phase timing of the most recent (re)connect, in milliseconds
+struct ReconnectTiming {
+    uint32_t attempt;      // 0 for the initial connect
+    uint32_t backoffMs;    // Connection lost until the attempt started
+    uint32_t handshakeMs;  // DNS + TCP + TLS + WebSocket upgrade
+    uint32_t initMs;       // Upgrade until conversation_initiation_metadata
+    uint32_t totalMs;      // Connection lost (or begin()) until initialized
+    bool failover;         // Switched to the hot standby; handshake already done
+};
+
+/**
+ * @class JsonArenaAllocator
+ * @brief Routes ArduinoJson's allocations into a JsonArena.
+ *
+ * Falls back to the heap only when the arena buffer itself couldn't be
+ * allocated; once the arena exists its capacity is a hard cap.
+ */
+class JsonArenaAllocator : public ArduinoJson::Allocator {
+public:
+    explicit JsonArenaAllocator(JsonArena& arena) : arena(arena) {}
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t new_size) override;
+
+private:
+    JsonArena& arena;
+};
+
 class ElevenLabsClient {
     
 public:
@@ -33,6 +89,13 @@ public:
     bool isConnected();
     void reconnect();
 
+    /**
+     * @brief Wi-Fi went down or came back. Down drops the connection at once
+     *        and holds off reconnect attempts; back reconnects without
+     *        waiting out the backoff built up during the outage.
+     */
+    void setNetworkAvailable(bool available);
+
     // Message sending methods  
     void sendAudio(const uint8_t* pcm_data, size_t size);  // Send raw PCM audio
     void sendText(const char* text);
@@ -53,10 +116,28 @@ public:
     void onConversationEnd(ConversationEndCallback callback);
     void onInterruption(InterruptionCallback callback);  // New interrupt callback
 
+    // Audio output purged directly on interruption, before callbacks run
+    void attachInterruptSink(InterruptSink* sink);
+
     // Configuration methods
+    void setServer(const char* host, uint16_t port, bool secure = true);  // Call before begin()
     void setOverrideAudio(bool override);
+    void enableBinaryAudio(bool enable);  // Ask a compatible relay for binary audio frames; call before begin()
+    void setPlaybackSampleRate(uint32_t hz);  // Binary frames at any other rate are dropped; 0 accepts all
     void enableStreamingAudio(bool enable);
     bool isStreamingAudioEnabled();
+    
+    /**
+     * @brief Keep a second, already-handshaked connection open while the
+     *        link looks degraded, and switch to it when the active one drops
+     *
+     * The standby only sends conversation_initiation_client_data once
+     * promoted, so the server sees a new conversation exactly as after a
+     * reconnect - minus DNS, TCP and TLS. Needs WS_STANDBY_MIN_FREE_HEAP of
+     * internal RAM for the second TLS session.
+     */
+    void enableHotStandby(bool enable);
+    bool isStandbyReady() const;
 
     // Real-time streaming methods (like Python SDK input_callback)
     void startRealtimeStreaming();
@@ -64,22 +145,70 @@ public:
     bool isRealtimeStreaming();
     void sendRealtimeAudioChunk(const uint8_t* pcm_data, size_t size);
 
+    // Connection diagnostics
+    const ReconnectTiming& getReconnectTiming() const;
+    const LinkMonitor& getLinkMonitor() const;
+    uint32_t getFailoverCount() const;
+    const JsonArena& getJsonArena() const;  // Per-message JSON memory (high-water mark, failures)
+    const FragmentAssembler& getFragmentAssembler() const;  // Reassembled/dropped message counts
+
+    // Trace capture and replay
+    void attachTraceRecorder(ConversationTrace* trace);  // Records every complete inbound message
+    void replayMessage(uint8_t* payload, size_t length, bool binary);  // Same path as a live frame
+
 private:
-    WebSocketsClient webSocket;
-    WiFiClientSecure wifiClientSecure;
+    WebSocketsClient sockets[2];
+    WebSocketsClient* webSocket;         // Active connection
+    WebSocketsClient* standbySocket;     // Hot standby, looped only while not STANDBY_OFF
+    FragmentAssembler fragmentAssembler;
+    JsonArena jsonArena;                 // Every JsonDocument and frame buffer, reclaimed per message
+    JsonArenaAllocator jsonAllocator;
+    char outboundFrame[WEBSOCKETS_MAX_HEADER_SIZE + WS_OUTBOUND_FRAME_SIZE];
     static ElevenLabsClient* instance;
 
     // Connection parameters
+    String serverHost;
+    uint16_t serverPort;
+    bool serverSecure;
     String agentId;
     String conversationId;
     bool connected;
     bool overrideAudio;
     bool streamingAudioEnabled;
+    bool binaryAudioRequested;
+    uint32_t binaryAudioFrames;
+    uint32_t binaryAudioRejected;     // Wrong sample rate, per connection
+    uint32_t playbackSampleRate;
     unsigned long lastReconnectAttempt;
     unsigned long reconnectInterval;
     int reconnectAttempts;
     bool shouldReconnect;
+    bool networkAvailable;
     uint32_t lastInterruptId;  // Track interruptions like Python SDK
+    InterruptSink* interruptSink;
+    ConversationTrace* traceRecorder;
+
+    // Reconnect phase timing
+    ReconnectTiming reconnectTiming;
+    unsigned long connectionLostTime;
+    unsigned long handshakeStartTime;
+    unsigned long initStartTime;
+    bool awaitingInit;
+    
+    // Hot standby
+    enum StandbyState {
+        STANDBY_OFF,
+        STANDBY_CONNECTING,
+        STANDBY_READY
+    };
+    bool hotStandbyEnabled;
+    StandbyState standbyState;
+    unsigned long standbyStartTime;
+    unsigned long lastStandbyAttempt;
+    uint32_t standbyHandshakeMs;
+    uint32_t failoverCount;
+    LinkMonitor linkMonitor;
+    unsigned long lastRssiSample;
 
     // Callbacks
     AudioDataCallback audioCallback;
@@ -96,14 +225,26 @@ private:
     // Internal methods
     static void webSocketEvent(WStype_t type, uint8_t* payload, size_t length);
     void handleWebSocketMessage(uint8_t* payload, size_t length);
+    void handleFragment(WStype_t type, uint8_t* payload, size_t length);
+    void handleBinaryMessage(const uint8_t* payload, size_t length);
+    void recordTrace(bool binary, const uint8_t* payload, size_t length);
+    void startConnection();
+    void beginSocket(WebSocketsClient& socket);
+    void handleStandbyEvent(WStype_t type, uint8_t* payload, size_t length);
+    void updateStandby();
+    void openStandby();
+    void closeStandby(const char* reason);
+    bool promoteStandby();
     void sendInitialConnectionMessage();
     void processMessage(const JsonDocument& doc);
+    bool sendJson(const JsonDocument& doc);
+    template <typename Write> bool sendFixed(Write write);
     void handleError(const char* error_message);
     void handleDisconnection();
     void resetReconnectionState();
     unsigned long getReconnectDelay();
     size_t base64Decode(const char* base64_string, uint8_t* output_buffer, size_t max_output_size);  // Base64 decoder
-    String base64Encode(const uint8_t* data, size_t length);  // Base64 encoder
+    size_t base64Encode(const uint8_t* data, size_t length, char* output, size_t output_size);  // Base64 encoder
 };
 
 #endif
\ No newline at end of file
@@ -1,32 +1,127 @@
 #include "wifi_manager.h"
 #include <Arduino.h>
+#include <Preferences.h>
+
+#define WIFI_CACHE_NAMESPACE "wifi"
+#define WIFI_CACHE_KEY "cache"
+#define WIFI_CACHE_VERSION 2
 
 bool WiFiManager::connect(const char* ssid, const char* password, unsigned long timeout_ms) {
+    if (!begin(ssid, password)) {
+        return false;
+    }
+    return waitForConnection(timeout_ms);
+}
+
+bool WiFiManager::begin(const char* ssid, const char* password) {
     Serial.print("Connecting to WiFi SSID: ");
     Serial.println(ssid);
 
-    // Disconnect any existing connection
-    WiFi.disconnect(true);
-    delay(1000);
-    
-    // Configure WiFi mode
+    this->ssid = ssid;
+    this->password = password;
+    registerEvents();
+    timing = {};
+    connectedMs = 0;
+    associatedMs = 0;
+    fastFailed = false;
+    cacheSaved = false;
+    beginMs = millis();
+    attemptMs = beginMs;
+
+    // The NVS cache replaces the driver's own copy of the config, which
+    // would otherwise be rewritten to flash on every begin()
+    WiFi.persistent(false);
     WiFi.mode(WIFI_STA);
+
+    fastAttempt = loadCache();
+    if (!fastAttempt) {
+        return startScanConnect();
+    }
+
+    // Directed connect: no scan
+    timing.cached = true;
+    Serial.printf("[WIFI] Trying cached AP %02X:%02X:%02X:%02X:%02X:%02X on channel %u\n",
+                  cache.bssid[0], cache.bssid[1], cache.bssid[2], cache.bssid[3], cache.bssid[4], cache.bssid[5],
+                  (unsigned int)cache.channel);
+    if (WiFi.begin(ssid, password, cache.channel, cache.bssid) == WL_CONNECT_FAILED) {
+        fastAttempt = false;
+        timing.fellBack = true;
+        return startScanConnect();
+    }
+    return true;
+}
+
+void WiFiManager::poll() {
+    if (connectedMs != 0) {
+        if (!cacheSaved) {
+            cacheSaved = true;
+            fastAttempt = false;
+            timing.associateMs = associatedMs >= attemptMs ? associatedMs - attemptMs : 0;
+            timing.ipMs = connectedMs >= associatedMs && associatedMs != 0 ? connectedMs - associatedMs : 0;
+            timing.totalMs = connectedMs - beginMs;
+            Serial.printf("[WIFI] Connected via %s in %lu ms (associate %lu ms, IP %lu ms)\n",
+                          !timing.cached ? "scan" : timing.fellBack ? "scan after cached AP failed" : "cached AP",
+                          timing.totalMs, timing.associateMs, timing.ipMs);
+            saveCache();
+        }
+        return;
+    }
+
+    // Gone, or not answering: the AP moved or the cache is stale
+    if (fastAttempt && (fastFailed || millis() - attemptMs > WIFI_FAST_CONNECT_TIMEOUT_MS)) {
+        Serial.printf("[WIFI] Cached AP %s, scanning\n", fastFailed ? "not found" : "did not answer");
+        timing.fellBack = true;
+        timing.fastMs = millis() - attemptMs;
+        clearCache();
+        WiFi.disconnect();
+        startScanConnect();
+    }
+}
+
+bool WiFiManager::startSupervisor(WiFiLinkCallback callback) {
+    if (supervisorTask != nullptr) {
+        return true;
+    }
+    linkCallback = callback;
     
-    // For WokWi, the channel (6) is sometimes needed.
-    // For physical hardware, this is usually not required.
-    WiFi.begin(ssid, password);
+    // Reconnects are the supervisor's, with its backoff, not the driver's
+    WiFi.setAutoReconnect(false);
+    supervisor.start(millis());
+    if (isConnected()) {
+        gotIpPending = true;
+    }
+    
+    if (xTaskCreatePinnedToCore(supervisorEntry, "wifi_sup", WIFI_SUPERVISOR_STACK_SIZE, this,
+                                WIFI_SUPERVISOR_PRIORITY, &supervisorTask, WIFI_SUPERVISOR_CORE) != pdPASS) {
+        supervisorTask = nullptr;
+        Serial.println("[WIFI] Failed to start supervisor task");
+        return false;
+    }
+    return true;
+}
 
+bool WiFiManager::isSupervised() const {
+    return supervisorTask != nullptr;
+}
+
+const WiFiSupervisor& WiFiManager::getSupervisor() const {
+    return supervisor;
+}
+
+bool WiFiManager::waitForConnection(unsigned long timeout_ms) {
     unsigned long startTime = millis();
-    while (WiFi.status() != WL_CONNECTED) {
+    while (WiFi.status() != WL_CONNECTED || connectedMs == 0) {
         // Check for the timeout
         if (millis() - startTime > timeout_ms) {
             Serial.println("\nConnection timed out!");
             WiFi.disconnect();
+            fastAttempt = false;
             return false;
         }
-        delay(250);
-        Serial.print(".");
+        poll();
+        delay(10);
     }
+    poll();
 
     Serial.println(" Connected!");
     Serial.print("IP Address: ");
@@ -40,4 +135,190 @@ bool WiFiManager::connect(const char* ssid, const char* password, unsigned long
 
 bool WiFiManager::isConnected() {
     return (WiFi.status()==WL_CONNECTED);
-}
\ No newline at end of file
+}
+
+unsigned long WiFiManager::getConnectedMs() const {
+    return connectedMs;
+}
+
+const WiFiConnectTiming& WiFiManager::getConnectTiming() const {
+    return timing;
+}
+
+void WiFiManager::clearCache() {
+    cacheValid = false;
+    Preferences preferences;
+    if (preferences.begin(WIFI_CACHE_NAMESPACE, false)) {
+        preferences.remove(WIFI_CACHE_KEY);
+        preferences.end();
+    }
+}
+
+size_t WiFiManager::format(char* out, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    const char* path = !timing.cached ? "scan" : timing.fellBack ? "fallback" : "cached";
+    int written;
+    if (!cacheSaved) {
+        written = snprintf(out, size, "WIFI connecting path=%s", path);
+    } else {
+        written = snprintf(out, size, "WIFI path=%s total=%lu assoc=%lu addr=%lu fast=%lu ch=%d rssi=%d",
+                           path, timing.totalMs, timing.associateMs, timing.ipMs, timing.fastMs,
+                           (int)WiFi.channel(), (int)WiFi.RSSI());
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+void WiFiManager::supervisorEntry(void* param) {
+    WiFiManager* manager = static_cast<WiFiManager*>(param);
+    for (;;) {
+        manager->supervise();
+        
+        // Woken by the station's events; otherwise when a retry or timeout is due.
+        // The cached-AP attempt is polled for its own, shorter timeout
+        uint32_t waitMs = manager->supervisor.getMsUntilNext(millis());
+        if (manager->fastAttempt && waitMs > 100) {
+            waitMs = 100;
+        }
+        ulTaskNotifyTake(pdTRUE, waitMs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(waitMs));
+    }
+}
+
+void WiFiManager::supervise() {
+    poll();
+    uint32_t now = millis();
+    
+    if (linkLostPending) {
+        linkLostPending = false;
+        bool wasUp = supervisor.isUp();
+        supervisor.onDisconnected(now);
+        if (wasUp) {
+            Serial.println("[WIFI] Link lost, reconnecting in the background");
+            if (linkCallback != nullptr) {
+                linkCallback(false);
+            }
+        }
+    }
+    
+    if (gotIpPending) {
+        gotIpPending = false;
+        if (!supervisor.isUp() && isConnected()) {
+            uint32_t outageMs = supervisor.getCurrentOutageMs(now);
+            supervisor.onConnected(now);
+            if (outageMs != 0) {
+                Serial.printf("[WIFI] Link back after %lu ms\n", (unsigned long)outageMs);
+            }
+            if (linkCallback != nullptr) {
+                linkCallback(true);
+            }
+        }
+    }
+    
+    WiFiAction action = supervisor.poll(now);
+    if (action == WIFI_ACTION_NONE) {
+        return;
+    }
+    if (action == WIFI_ACTION_RESCAN) {
+        Serial.printf("[WIFI] %lu attempts failed, dropping the cached AP\n", (unsigned long)supervisor.getFailures());
+        clearCache();
+    }
+    WiFi.disconnect();
+    begin(ssid, password);
+}
+
+void WiFiManager::notifySupervisor() {
+    if (supervisorTask != nullptr) {
+        xTaskNotifyGive(supervisorTask);
+    }
+}
+
+void WiFiManager::registerEvents() {
+    if (eventsRegistered) {
+        return;
+    }
+    eventsRegistered = true;
+
+    // Stamped in the Wi-Fi event task as they happen; poll() does the rest
+    WiFi.onEvent([this](arduino_event_id_t, arduino_event_info_t) {
+        associatedMs = millis();
+    }, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+
+    WiFi.onEvent([this](arduino_event_id_t, arduino_event_info_t) {
+        connectedMs = millis();
+        gotIpPending = true;
+        notifySupervisor();
+    }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+
+    WiFi.onEvent([this](arduino_event_id_t, arduino_event_info_t info) {
+        uint8_t reason = info.wifi_sta_disconnected.reason;
+        if (fastAttempt && reason == WIFI_REASON_NO_AP_FOUND) {
+            fastFailed = true;
+        }
+        // Our own WiFi.disconnect() before a new attempt isn't a loss, and a
+        // failed cached-AP attempt is poll()'s to handle
+        if (reason != WIFI_REASON_ASSOC_LEAVE && !fastAttempt) {
+            linkLostPending = true;
+            notifySupervisor();
+        }
+    }, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+}
+
+bool WiFiManager::loadCache() {
+    cacheValid = false;
+    Preferences preferences;
+    if (!preferences.begin(WIFI_CACHE_NAMESPACE, true)) {
+        return false;   // Nothing saved yet
+    }
+    if (preferences.getBytesLength(WIFI_CACHE_KEY) == sizeof(cache)) {
+        preferences.getBytes(WIFI_CACHE_KEY, &cache, sizeof(cache));
+        cacheValid = cache.version == WIFI_CACHE_VERSION && cache.channel >= 1 && cache.channel <= 14 &&
+                     strncmp(cache.ssid, ssid, sizeof(cache.ssid)) == 0;
+    }
+    preferences.end();
+    return cacheValid;
+}
+
+void WiFiManager::saveCache() {
+    CacheRecord record = {};
+    record.version = WIFI_CACHE_VERSION;
+    record.channel = (uint8_t)WiFi.channel();
+    uint8_t* bssid = WiFi.BSSID();
+    if (bssid != nullptr) {
+        memcpy(record.bssid, bssid, sizeof(record.bssid));
+    }
+    strncpy(record.ssid, ssid, sizeof(record.ssid) - 1);
+
+    // Only write when the AP or channel changed, to spare the flash
+    if (cacheValid && memcmp(&record, &cache, sizeof(record)) == 0) {
+        return;
+    }
+    Preferences preferences;
+    if (!preferences.begin(WIFI_CACHE_NAMESPACE, false) ||
+        preferences.putBytes(WIFI_CACHE_KEY, &record, sizeof(record)) != sizeof(record)) {
+        Serial.println("[WIFI] Failed to save the connection cache");
+    } else {
+        cache = record;
+        cacheValid = true;
+    }
+    preferences.end();
+}
+
+bool WiFiManager::startScanConnect() {
+    fastAttempt = false;
+    attemptMs = millis();
+    associatedMs = 0;
+
+    // For WokWi, the channel (6) is sometimes needed.
+    // For physical hardware, this is usually not required.
+    if (WiFi.begin(ssid, password) == WL_CONNECT_FAILED) {
+        Serial.println("Failed to start WiFi station");
+        return false;
+    }
+    return true;
+}
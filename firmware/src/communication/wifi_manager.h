@@ -2,6 +2,44 @@
 #define WIFI_MANAGER_H
 
 #include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "wifi_supervisor.h"
+
+#ifndef WIFI_CONNECT_TIMEOUT_MS
+#define WIFI_CONNECT_TIMEOUT_MS 10000
+#endif
+
+#ifndef WIFI_FAST_CONNECT_TIMEOUT_MS
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 3000   // Directed connect to the cached AP before scanning
+#endif
+
+#ifndef WIFI_SUPERVISOR_STACK_SIZE
+#define WIFI_SUPERVISOR_STACK_SIZE 4096
+#endif
+
+#ifndef WIFI_SUPERVISOR_PRIORITY
+#define WIFI_SUPERVISOR_PRIORITY 2          // Below the network task
+#endif
+
+#ifndef WIFI_SUPERVISOR_CORE
+#define WIFI_SUPERVISOR_CORE 0              // With the Wi-Fi stack, off the application core
+#endif
+
+// Called on the supervisor task when the link goes down or comes back
+typedef void (*WiFiLinkCallback)(bool up);
+
+/**
+ * @brief How the last connection was made and where its time went
+ */
+struct WiFiConnectTiming {
+    bool cached;                    // Tried the cached BSSID/channel first
+    bool fellBack;                  // ...and had to scan after all
+    unsigned long fastMs;           // Spent on the cached attempt before falling back
+    unsigned long associateMs;      // Attempt start to associated
+    unsigned long ipMs;             // Associated to IP address
+    unsigned long totalMs;          // begin() to IP address
+};
 
 /**
  * @class WiFiManager
@@ -9,6 +47,18 @@
  *
  * This class encapsulates all functionality related to connecting to a Wi-Fi
  * network, checking the connection status, and handling timeouts.
+ *
+ * The access point and channel of the last good connection are kept in
+ * NVS. The next begin() connects straight to that BSSID on that channel,
+ * skipping the scan; the address still comes from DHCP, since a cached
+ * lease may have run out. If the cached AP isn't reachable within
+ * WIFI_FAST_CONNECT_TIMEOUT_MS, the cache is dropped and a normal scan
+ * follows.
+ *
+ * After begin(), startSupervisor() hands the connection to a background
+ * task woken by the station's events. It drives the connect, and when the
+ * link drops it reconnects with backoff (see WiFiSupervisor) and reports
+ * the change through the link callback; nothing restarts the device.
  */
 class WiFiManager {
     public:
@@ -20,14 +70,112 @@ class WiFiManager {
         * @return true if the connection was successful, false otherwise.
         */
        //this is for wowki
-        bool connect(const char* ssid, const char* password, unsigned long timeout_ms = 10000);
+        bool connect(const char* ssid, const char* password, unsigned long timeout_ms = WIFI_CONNECT_TIMEOUT_MS);
         // bool connect(const char* ssid, const char* password);
 
+        /**
+        * @brief Starts associating and returns at once; the station connects
+        *        in the background while the caller does other setup.
+        * @param ssid The SSID of the Wi-Fi network; must stay valid until connected.
+        * @param password The password for the Wi-Fi network; likewise.
+        * @return false if the station could not be started.
+        */
+        bool begin(const char* ssid, const char* password);
+
+        /**
+        * @brief Advances a connection started by begin(): falls back to a scan
+        *        when the cached AP doesn't answer, and saves the cache once
+        *        connected. Call regularly until isConnected().
+        */
+        void poll();
+
+        /**
+        * @brief Run the connection from a background task from now on:
+        *        poll() and reconnects happen there. Call after begin().
+        * @param callback Told when the link goes down or comes back; runs on
+        *        the supervisor task, so it should only hand the news on.
+        * @return false if the task could not be created.
+        */
+        bool startSupervisor(WiFiLinkCallback callback);
+        bool isSupervised() const;
+
+        /**
+        * @brief Reconnect state and outage statistics
+        */
+        const WiFiSupervisor& getSupervisor() const;
+
+        /**
+        * @brief Waits for the connection started by begin().
+        * @param timeout_ms The maximum time to wait, in milliseconds.
+        * @return true once an IP address is assigned, false on timeout.
+        */
+        bool waitForConnection(unsigned long timeout_ms);
+
         /**
         * @brief Checks if the device is currently connected to Wi-Fi.
         * @return true if connected, false otherwise.
         */
         bool isConnected();
+
+        /**
+        * @brief millis() when the last IP address was assigned, 0 if none yet.
+        */
+        unsigned long getConnectedMs() const;
+
+        /**
+        * @brief Timings of the last connection; complete once connected.
+        */
+        const WiFiConnectTiming& getConnectTiming() const;
+
+        /**
+        * @brief Forget the cached access point.
+        */
+        void clearCache();
+
+        /**
+        * @brief Format the last connection as one line, e.g.
+        *        "WIFI path=cached total=450 assoc=290 addr=160 fast=0 ch=6 rssi=-58"
+        * @return Number of characters written (excluding the terminator)
+        */
+        size_t format(char* out, size_t size);
+
+    private:
+        // Stored as one NVS blob; a new version discards older records
+        struct CacheRecord {
+            uint8_t version;
+            uint8_t channel;
+            uint8_t bssid[6];
+            char ssid[33];
+        };
+
+        const char* ssid = nullptr;
+        const char* password = nullptr;
+        CacheRecord cache = {};
+        bool cacheValid = false;
+
+        bool eventsRegistered = false;
+        bool fastAttempt = false;
+        volatile bool fastFailed = false;
+        bool cacheSaved = false;
+        unsigned long beginMs = 0;
+        unsigned long attemptMs = 0;
+        volatile unsigned long associatedMs = 0;
+        volatile unsigned long connectedMs = 0;
+        WiFiConnectTiming timing = {};
+
+        WiFiSupervisor supervisor;
+        TaskHandle_t supervisorTask = nullptr;
+        WiFiLinkCallback linkCallback = nullptr;
+        volatile bool linkLostPending = false;
+        volatile bool gotIpPending = false;
+
+        static void supervisorEntry(void* param);
+        void supervise();
+        void notifySupervisor();
+        void registerEvents();
+        bool loadCache();
+        void saveCache();
+        bool startScanConnect();
 };
 
-#endif
\ No newline at end of file
+#endif
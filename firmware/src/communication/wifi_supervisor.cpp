@@ -0,0 +1,157 @@
+#include "wifi_supervisor.h"
+#include <stdio.h>
+
+WiFiSupervisor::WiFiSupervisor() :
+    state(WIFI_LINK_IDLE),
+    failures(0),
+    attemptStartMs(0),
+    nextAttemptMs(0),
+    outageStartMs(0),
+    inOutage(false),
+    outages(0),
+    attempts(0) {
+}
+
+void WiFiSupervisor::start(uint32_t nowMs) {
+    state = WIFI_LINK_CONNECTING;
+    attemptStartMs = nowMs;
+}
+
+void WiFiSupervisor::onConnected(uint32_t nowMs) {
+    if (inOutage) {
+        outageMs.record(nowMs - outageStartMs);
+        inOutage = false;
+    }
+    state = WIFI_LINK_UP;
+    failures = 0;
+}
+
+void WiFiSupervisor::onDisconnected(uint32_t nowMs) {
+    switch (state) {
+        case WIFI_LINK_UP:
+            // Lost: first retry soon, the AP is probably still there
+            outages++;
+            inOutage = true;
+            outageStartMs = nowMs;
+            failures = 0;
+            state = WIFI_LINK_BACKOFF;
+            nextAttemptMs = nowMs + WIFI_RECONNECT_MIN_MS;
+            break;
+
+        case WIFI_LINK_CONNECTING:
+            fail(nowMs);
+            break;
+
+        default:
+            // Repeats while already waiting
+            break;
+    }
+}
+
+WiFiAction WiFiSupervisor::poll(uint32_t nowMs) {
+    if (state == WIFI_LINK_CONNECTING && nowMs - attemptStartMs >= WIFI_ATTEMPT_TIMEOUT_MS) {
+        fail(nowMs);
+    }
+    if (state != WIFI_LINK_BACKOFF || (int32_t)(nowMs - nextAttemptMs) < 0) {
+        return WIFI_ACTION_NONE;
+    }
+
+    state = WIFI_LINK_CONNECTING;
+    attemptStartMs = nowMs;
+    attempts++;
+    return failures >= WIFI_RESCAN_AFTER ? WIFI_ACTION_RESCAN : WIFI_ACTION_RECONNECT;
+}
+
+uint32_t WiFiSupervisor::getMsUntilNext(uint32_t nowMs) const {
+    if (state == WIFI_LINK_BACKOFF) {
+        int32_t remaining = (int32_t)(nextAttemptMs - nowMs);
+        return remaining > 0 ? (uint32_t)remaining : 0;
+    }
+    if (state == WIFI_LINK_CONNECTING) {
+        uint32_t elapsed = nowMs - attemptStartMs;
+        return elapsed < WIFI_ATTEMPT_TIMEOUT_MS ? WIFI_ATTEMPT_TIMEOUT_MS - elapsed : 0;
+    }
+    return UINT32_MAX;
+}
+
+WiFiLinkState WiFiSupervisor::getState() const {
+    return state;
+}
+
+bool WiFiSupervisor::isUp() const {
+    return state == WIFI_LINK_UP;
+}
+
+uint32_t WiFiSupervisor::getFailures() const {
+    return failures;
+}
+
+const char* WiFiSupervisor::stateName(WiFiLinkState state) {
+    switch (state) {
+        case WIFI_LINK_IDLE:
+            return "idle";
+        case WIFI_LINK_CONNECTING:
+            return "connecting";
+        case WIFI_LINK_UP:
+            return "up";
+        case WIFI_LINK_BACKOFF:
+            return "backoff";
+    }
+    return "?";
+}
+
+uint32_t WiFiSupervisor::getOutageCount() const {
+    return outages;
+}
+
+uint32_t WiFiSupervisor::getAttemptCount() const {
+    return attempts;
+}
+
+const LatencyHistogram& WiFiSupervisor::getOutageTime() const {
+    return outageMs;
+}
+
+uint32_t WiFiSupervisor::getCurrentOutageMs(uint32_t nowMs) const {
+    return inOutage ? nowMs - outageStartMs : 0;
+}
+
+void WiFiSupervisor::resetStats() {
+    outages = 0;
+    attempts = 0;
+    outageMs.reset();
+}
+
+size_t WiFiSupervisor::format(char* out, size_t size, uint32_t nowMs) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "WIFISUP %s", stateName(state));
+    if (written >= 0 && (size_t)written < size && inOutage) {
+        written += snprintf(out + written, size - written, " down=%lums", (unsigned long)getCurrentOutageMs(nowMs));
+    }
+    if (written >= 0 && (size_t)written < size && state == WIFI_LINK_BACKOFF) {
+        written += snprintf(out + written, size - written, " failures=%lu next=%lums", (unsigned long)failures,
+                            (unsigned long)getMsUntilNext(nowMs));
+    }
+    if (written >= 0 && (size_t)written < size) {
+        written += snprintf(out + written, size - written, " outages=%lu attempts=%lu outage_ms p50=%lu p99=%lu max=%lu",
+                            (unsigned long)outages, (unsigned long)attempts,
+                            (unsigned long)outageMs.getPercentile(50), (unsigned long)outageMs.getPercentile(99),
+                            (unsigned long)outageMs.getMax());
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+void WiFiSupervisor::fail(uint32_t nowMs) {
+    failures++;
+    uint32_t shift = failures < 16 ? failures : 16;
+    uint64_t delayMs = (uint64_t)WIFI_RECONNECT_MIN_MS << shift;
+    state = WIFI_LINK_BACKOFF;
+    nextAttemptMs = nowMs + (delayMs < WIFI_RECONNECT_MAX_MS ? (uint32_t)delayMs : WIFI_RECONNECT_MAX_MS);
+}
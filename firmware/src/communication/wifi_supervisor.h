@@ -0,0 +1,114 @@
+#ifndef WIFI_SUPERVISOR_H
+#define WIFI_SUPERVISOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../telemetry/latency_histogram.h"
+
+#ifndef WIFI_RECONNECT_MIN_MS
+#define WIFI_RECONNECT_MIN_MS 500       // First retry after the link drops; doubles per failed attempt
+#endif
+
+#ifndef WIFI_RECONNECT_MAX_MS
+#define WIFI_RECONNECT_MAX_MS 30000
+#endif
+
+#ifndef WIFI_ATTEMPT_TIMEOUT_MS
+#define WIFI_ATTEMPT_TIMEOUT_MS 10000   // An attempt without an IP address by then has failed
+#endif
+
+#ifndef WIFI_RESCAN_AFTER
+#define WIFI_RESCAN_AFTER 3             // Failed attempts before the cached AP is dropped for a scan
+#endif
+
+enum WiFiLinkState {
+    WIFI_LINK_IDLE,         // Not started
+    WIFI_LINK_CONNECTING,   // Attempt in progress
+    WIFI_LINK_UP,
+    WIFI_LINK_BACKOFF       // Waiting before the next attempt
+};
+
+enum WiFiAction {
+    WIFI_ACTION_NONE,
+    WIFI_ACTION_RECONNECT,  // Connect again, cached AP first
+    WIFI_ACTION_RESCAN      // Forget the cached AP and scan
+};
+
+/**
+ * @class WiFiSupervisor
+ * @brief Decides when to reconnect Wi-Fi after the link drops or an attempt
+ *        fails, and keeps outage statistics.
+ *
+ * Driven by the station's connected and disconnected events; poll() says
+ * when the next attempt is due. Retries back off exponentially from
+ * WIFI_RECONNECT_MIN_MS to WIFI_RECONNECT_MAX_MS, and after
+ * WIFI_RESCAN_AFTER failures the cached AP is given up for a full scan.
+ * There is no give-up point: the device keeps running and keeps trying.
+ */
+class WiFiSupervisor {
+public:
+    WiFiSupervisor();
+
+    /**
+     * @brief The first connection attempt has been started
+     */
+    void start(uint32_t nowMs);
+
+    /**
+     * @brief An IP address was assigned
+     */
+    void onConnected(uint32_t nowMs);
+
+    /**
+     * @brief The station disconnected: the link dropped, or an attempt failed
+     */
+    void onDisconnected(uint32_t nowMs);
+
+    /**
+     * @brief Check for a due retry or a timed-out attempt
+     * @return What to start now; the attempt counts as started
+     */
+    WiFiAction poll(uint32_t nowMs);
+
+    /**
+     * @brief Time until poll() has something to do, UINT32_MAX if nothing is pending
+     */
+    uint32_t getMsUntilNext(uint32_t nowMs) const;
+
+    WiFiLinkState getState() const;
+    bool isUp() const;
+    uint32_t getFailures() const;               // Failed attempts in the current outage
+    static const char* stateName(WiFiLinkState state);
+
+    // Statistics
+    uint32_t getOutageCount() const;
+    uint32_t getAttemptCount() const;           // Retries started, all outages
+    const LatencyHistogram& getOutageTime() const;    // Milliseconds, link lost -> IP again
+    uint32_t getCurrentOutageMs(uint32_t nowMs) const;  // 0 while up
+    void resetStats();
+
+    /**
+     * @brief Link state and outage history; while down, also how long, how
+     *        many attempts failed and when the next is due:
+     *        "WIFISUP up outages=2 attempts=3 outage_ms p50=1200 p99=4100 max=4100"
+     *        "WIFISUP backoff down=5400ms failures=2 next=2000ms outages=3 attempts=5 outage_ms ..."
+     * @return Length of the line in out
+     */
+    size_t format(char* out, size_t size, uint32_t nowMs) const;
+
+private:
+    WiFiLinkState state;
+    uint32_t failures;
+    uint32_t attemptStartMs;
+    uint32_t nextAttemptMs;
+    uint32_t outageStartMs;
+    bool inOutage;
+
+    uint32_t outages;
+    uint32_t attempts;
+    LatencyHistogram outageMs;
+
+    void fail(uint32_t nowMs);
+};
+
+#endif
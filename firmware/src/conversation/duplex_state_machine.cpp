@@ -0,0 +1,176 @@
+#include "duplex_state_machine.h"
+#include <stdio.h>
+
+static const char* const SHORT_NAMES[DUPLEX_STATE_COUNT] = {"off", "listen", "speak", "barge", "recover"};
+
+DuplexStateMachine::DuplexStateMachine() :
+    state(DUPLEX_OFF),
+    enteredMs(0),
+    interruptedEventId(0),
+    transitionCallback(nullptr),
+    falseBargeIns(0) {
+}
+
+void DuplexStateMachine::start(uint32_t nowMs) {
+    interruptedEventId = 0;
+    enter(DUPLEX_LISTENING, nowMs);
+}
+
+void DuplexStateMachine::stop(uint32_t nowMs) {
+    enter(DUPLEX_OFF, nowMs);
+}
+
+bool DuplexStateMachine::onAgentAudio(uint32_t eventId, uint32_t nowMs) {
+    switch (state) {
+        case DUPLEX_OFF:
+            return true;
+
+        case DUPLEX_BARGE_IN:
+            // The user has the floor until the server answers the barge-in
+            return false;
+
+        case DUPLEX_LISTENING:
+        case DUPLEX_RECOVERING:
+            if (eventId <= interruptedEventId) {
+                return false;
+            }
+            enter(DUPLEX_AGENT_SPEAKING, nowMs);
+            return true;
+
+        case DUPLEX_AGENT_SPEAKING:
+            return eventId > interruptedEventId;
+    }
+    return false;
+}
+
+void DuplexStateMachine::onPlaybackDrained(uint32_t nowMs) {
+    if (state == DUPLEX_AGENT_SPEAKING) {
+        enter(DUPLEX_LISTENING, nowMs);
+    }
+}
+
+bool DuplexStateMachine::onLocalSpeech(uint32_t onsetMs, uint32_t nowMs) {
+    if (state != DUPLEX_AGENT_SPEAKING) {
+        return false;
+    }
+
+    cutLatencyMs.record(nowMs - onsetMs);
+    enter(DUPLEX_BARGE_IN, nowMs);
+    return true;
+}
+
+void DuplexStateMachine::onServerInterruption(uint32_t eventId, uint32_t nowMs) {
+    if (eventId > interruptedEventId) {
+        interruptedEventId = eventId;
+    }
+    if (state == DUPLEX_AGENT_SPEAKING || state == DUPLEX_BARGE_IN) {
+        enter(DUPLEX_RECOVERING, nowMs);
+    }
+}
+
+void DuplexStateMachine::update(uint32_t nowMs) {
+    uint32_t inStateMs = nowMs - enteredMs;
+    if (state == DUPLEX_BARGE_IN && inStateMs >= DUPLEX_BARGE_IN_TIMEOUT_MS) {
+        // Probably echo or noise: the server never heard an interruption
+        falseBargeIns++;
+        enter(DUPLEX_LISTENING, nowMs);
+    } else if (state == DUPLEX_RECOVERING && inStateMs >= DUPLEX_RECOVERY_MS) {
+        enter(DUPLEX_LISTENING, nowMs);
+    }
+}
+
+uint32_t DuplexStateMachine::getMsUntilTimeout(uint32_t nowMs) const {
+    uint32_t timeoutMs;
+    if (state == DUPLEX_BARGE_IN) {
+        timeoutMs = DUPLEX_BARGE_IN_TIMEOUT_MS;
+    } else if (state == DUPLEX_RECOVERING) {
+        timeoutMs = DUPLEX_RECOVERY_MS;
+    } else {
+        return UINT32_MAX;
+    }
+
+    uint32_t inStateMs = nowMs - enteredMs;
+    return inStateMs < timeoutMs ? timeoutMs - inStateMs : 0;
+}
+
+DuplexState DuplexStateMachine::getState() const {
+    return state;
+}
+
+const char* DuplexStateMachine::stateName(DuplexState state) {
+    switch (state) {
+        case DUPLEX_LISTENING:      return "LISTENING";
+        case DUPLEX_AGENT_SPEAKING: return "AGENT_SPEAKING";
+        case DUPLEX_BARGE_IN:       return "BARGE_IN";
+        case DUPLEX_RECOVERING:     return "RECOVERING";
+        default:                    return "OFF";
+    }
+}
+
+void DuplexStateMachine::onTransition(DuplexTransitionCallback callback) {
+    transitionCallback = callback;
+}
+
+const LatencyHistogram& DuplexStateMachine::getDwell(DuplexState state) const {
+    return dwellMs[state];
+}
+
+const LatencyHistogram& DuplexStateMachine::getCutLatency() const {
+    return cutLatencyMs;
+}
+
+uint32_t DuplexStateMachine::getFalseBargeIns() const {
+    return falseBargeIns;
+}
+
+void DuplexStateMachine::resetStats() {
+    for (size_t i = 0; i < DUPLEX_STATE_COUNT; i++) {
+        dwellMs[i].reset();
+    }
+    cutLatencyMs.reset();
+    falseBargeIns = 0;
+}
+
+size_t DuplexStateMachine::format(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "DUPLEX");
+    for (size_t i = DUPLEX_LISTENING; i < DUPLEX_STATE_COUNT && written >= 0 && (size_t)written < size; i++) {
+        written += snprintf(out + written, size - written, "%s %s n=%lu p50=%lu max=%lu",
+                            i == DUPLEX_LISTENING ? "" : " |", SHORT_NAMES[i],
+                            (unsigned long)dwellMs[i].getCount(),
+                            (unsigned long)dwellMs[i].getPercentile(50),
+                            (unsigned long)dwellMs[i].getMax());
+    }
+    if (written >= 0 && (size_t)written < size) {
+        written += snprintf(out + written, size - written, " | cut_ms p50=%lu max=%lu | false=%lu",
+                            (unsigned long)cutLatencyMs.getPercentile(50),
+                            (unsigned long)cutLatencyMs.getMax(),
+                            (unsigned long)falseBargeIns);
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+void DuplexStateMachine::enter(DuplexState next, uint32_t nowMs) {
+    if (next == state) {
+        return;
+    }
+
+    uint32_t dwell = nowMs - enteredMs;
+    if (state != DUPLEX_OFF) {
+        dwellMs[state].record(dwell);
+    }
+
+    DuplexState previous = state;
+    state = next;
+    enteredMs = nowMs;
+    if (transitionCallback) {
+        transitionCallback(previous, next, dwell);
+    }
+}
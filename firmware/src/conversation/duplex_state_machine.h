@@ -0,0 +1,119 @@
+#ifndef DUPLEX_STATE_MACHINE_H
+#define DUPLEX_STATE_MACHINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../telemetry/latency_histogram.h"
+
+#ifndef DUPLEX_BARGE_IN_TIMEOUT_MS
+#define DUPLEX_BARGE_IN_TIMEOUT_MS 1500     // No server interruption by then: false barge-in
+#endif
+
+#ifndef DUPLEX_RECOVERY_MS
+#define DUPLEX_RECOVERY_MS 5000             // Back to listening if no new response follows
+#endif
+
+enum DuplexState {
+    DUPLEX_OFF,
+    DUPLEX_LISTENING,         // Mic streaming, speaker idle
+    DUPLEX_AGENT_SPEAKING,    // Mic streaming, agent audio playing
+    DUPLEX_BARGE_IN,          // User talked over the agent; playback cut, agent audio dropped
+    DUPLEX_RECOVERING         // Server interrupted; stale audio dropped until the next response
+};
+
+#define DUPLEX_STATE_COUNT 5
+
+/**
+ * @brief Notified on every transition, with the time spent in the old state
+ */
+typedef void (*DuplexTransitionCallback)(DuplexState from, DuplexState to, uint32_t dwellMs);
+
+/**
+ * @class DuplexStateMachine
+ * @brief Turn-taking for real-time mode, where the microphone streams the
+ *        whole time and agent audio plays over it.
+ *
+ * Local barge-in (the user's voice detected while the agent speaks) enters
+ * BARGE_IN: the caller cuts playback at once and agent audio is dropped
+ * until the server confirms with an interruption event. The confirmation,
+ * or an interruption the server detected first, enters RECOVERING: audio
+ * for the interrupted event IDs is dropped and the next response's first
+ * chunk starts AGENT_SPEAKING again. A barge-in the server never confirms
+ * within DUPLEX_BARGE_IN_TIMEOUT_MS is counted as false and listening resumes.
+ *
+ * Dwell time per state and the speech-onset -> playback-cut latency are
+ * kept as histograms; the cut latency is what decides whether barge-in
+ * feels immediate.
+ */
+class DuplexStateMachine {
+public:
+    DuplexStateMachine();
+
+    void start(uint32_t nowMs);
+    void stop(uint32_t nowMs);
+
+    /**
+     * @brief An agent audio chunk arrived
+     * @return true if it should be played, false to drop it
+     */
+    bool onAgentAudio(uint32_t eventId, uint32_t nowMs);
+
+    /**
+     * @brief The speaker ran out of queued audio
+     */
+    void onPlaybackDrained(uint32_t nowMs);
+
+    /**
+     * @brief The barge-in detector heard the user
+     * @param onsetMs When the speech started
+     * @return true if playback must be cut now
+     */
+    bool onLocalSpeech(uint32_t onsetMs, uint32_t nowMs);
+
+    /**
+     * @brief The server sent an interruption event
+     */
+    void onServerInterruption(uint32_t eventId, uint32_t nowMs);
+
+    /**
+     * @brief Apply the barge-in and recovery timeouts
+     */
+    void update(uint32_t nowMs);
+
+    /**
+     * @return Time until update() has a timeout to apply, UINT32_MAX if none
+     */
+    uint32_t getMsUntilTimeout(uint32_t nowMs) const;
+
+    DuplexState getState() const;
+    static const char* stateName(DuplexState state);
+    void onTransition(DuplexTransitionCallback callback);
+
+    // Statistics
+    const LatencyHistogram& getDwell(DuplexState state) const;   // Milliseconds in each state
+    const LatencyHistogram& getCutLatency() const;               // Speech onset -> playback cut, ms
+    uint32_t getFalseBargeIns() const;
+    void resetStats();
+
+    /**
+     * @brief Dwell times per state in ms, cut latency and unconfirmed barge-ins:
+     *        "DUPLEX listen n=6 p50=2100 max=9000 | speak n=5 p50=3100 max=5200 | barge n=2 p50=240 max=310
+     *         | recover n=2 p50=900 max=1100 | cut_ms p50=70 max=82 | false=0"
+     * @return Length of the line, at most size - 1
+     */
+    size_t format(char* out, size_t size) const;
+
+private:
+    DuplexState state;
+    uint32_t enteredMs;
+    uint32_t interruptedEventId;      // Audio at or below this is stale
+    DuplexTransitionCallback transitionCallback;
+
+    LatencyHistogram dwellMs[DUPLEX_STATE_COUNT];
+    LatencyHistogram cutLatencyMs;
+    uint32_t falseBargeIns;
+
+    void enter(DuplexState next, uint32_t nowMs);
+};
+
+#endif
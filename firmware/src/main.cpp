@@ -3,14 +3,47 @@
 #include "config.h"
 #include "communication/wifi_manager.h"
 #include "communication/websocket_client.h"
+#include "communication/network_task.h"
+#include "communication/uplink_controller.h"
+#include "communication/tool_registry.h"
 #include "audio/microphone.h"
+#include "audio/barge_in_detector.h"
+#include "conversation/duplex_state_machine.h"
 #include "speaker/speaker.h"
+#include "telemetry/latency_telemetry.h"
+#include "telemetry/turn_tracer.h"
+#include "communication/conversation_trace.h"
+#include "system/event_loop.h"
+#include "system/timer_wheel.h"
+#include "system/loop_stall_detector.h"
+#include "system/command_shell.h"
+#include "system/power_manager.h"
+#include "system/boot_timeline.h"
+#include "system/mem_tracker.h"
+#include "system/memory_plan.h"
+#include "mbedtls/base64.h"
 
 // Global instances
 WiFiManager wifiManager;
 ElevenLabsClient elevenLabsClient;
+NetworkTask networkTask;  // Owns elevenLabsClient after initializeElevenLabs()
+ToolRegistry toolRegistry;
 Microphone microphone;
 Speaker speaker;
+LatencyTelemetry latencyTelemetry;
+TurnTracer turnTracer;  // Where each turn's time went, end of speech -> first sound
+ConversationTrace conversationTrace;
+EventLoop eventLoop;  // loop() sleeps here until a source posts or a timer is due
+DuplexStateMachine duplex;  // Turn-taking in real-time mode
+BargeInDetector bargeInDetector;
+TimerWheel timers;  // Deferred work for the state machine; nothing reachable from loop() may delay()
+LoopStallDetector loopStall;
+CommandShell shell;  // Serial commands, typed or framed by tools/shell_tool.py
+PowerManager power;  // CPU clock and sleep per conversation state
+BootTimeline boot;  // Per-phase boot timing, printed once connected
+UplinkController uplink;  // Real-time chunk size and silence gating from link quality
+MemoryPlan memoryPlan;  // Every audio buffer, allocated once at boot
+uint32_t lastUplinkCount = 0;
 
 // Conversation state management
 enum ConversationState {
@@ -22,6 +55,7 @@ enum ConversationState {
     PROCESSING_AUDIO,
     WAITING_FOR_RESPONSE,
     PLAYING_RESPONSE,
+    REALTIME_CONVERSATION,  // Mic and speaker both live; see duplex
     ERROR_STATE
 };
 
@@ -30,17 +64,88 @@ unsigned long stateTimer = 0;
 int countdownSeconds = 0;
 bool autoMode = false;  // Manual trigger vs auto conversation mode
 bool realtimeMode = false;  // Real-time streaming vs batch recording
+TimerId countdownTimer = 0;
+
+// Boot: Wi-Fi associates while the rest of setup() runs; the network
+// starts from loop() as soon as there is an IP
+#define ELEVENLABS_CONNECT_TIMEOUT_MS 15000
+#define CONNECT_POLL_MS 50
+TimerId connectTimer = 0;
+bool networkStarted = false;
+int bootWifiPhase = -1;
+int bootNetworkPhase = -1;
+
+// Set on the Wi-Fi supervisor task, handled in loop()
+std::atomic<bool> wifiLinkChanged(false);
+std::atomic<bool> wifiLinkUp(false);
+
+// Heap and per-subsystem memory lines, also part of the 'l' report
+#ifndef MEM_REPORT_INTERVAL_MS
+#define MEM_REPORT_INTERVAL_MS 60000
+#endif
+
+// 'dump' and 'turns' print base64 lines from a timer, a few per tick and only
+// while the serial TX buffer has room, so loop() never waits on the UART
+#ifndef DUMP_LINES_PER_TICK
+#define DUMP_LINES_PER_TICK 4
+#endif
+#define DUMP_TICK_MS 10
+#define DUMP_LINE_BYTES 48  // Encodes to 64 characters
+struct Base64Dump {
+    const char* tag;  // Line prefix; nullptr when no dump is running
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+};
+Base64Dump activeDump = {nullptr, nullptr, 0, 0};
+bool traceDumpPending = false;  // 'dump' asked while the network task still held the trace
+
+// Shell modes: which commands are available
+#define SHELL_MODE_MANUAL 0x01
+#define SHELL_MODE_REALTIME 0x02
+#define SHELL_MODE_ANY (SHELL_MODE_MANUAL | SHELL_MODE_REALTIME)
+uint32_t tracedUplinkMs = 0;
+uint32_t uplinkSpeechMs = 0;  // Last speech frame already counted by latencyTelemetry
+uint32_t tracedSpeakerSamples = 0;
+bool tracedSpeakerPlaying = false;
 
 // Function declarations
 void initializeHardware();
 void initializeElevenLabs();
+void handleConnecting();
+void onConnectTimeout();
+void printBootTimeline();
+void setupEventSources();
+void scheduleWakeups();
 void handleSerialInput();
+void setupShell();
+void setupPower();
+void setRealtimeMode(bool enabled);
+void startRealtimeMode();
+void stopRealtimeMode();
+void adjustVolume();
 void handleConversationFlow();
 void changeState(ConversationState newState);
 void startRecordingSequence();
 void handleCountdown();
+void scheduleNextRecording(uint32_t delayMs);
+void remindErrorState();
+void reportMemory();
 void processRecordedAudio();
 void setupElevenLabsCallbacks();
+void setupTools();
+void printLatencyTelemetry();
+void reportTelemetry(ShellEmit emit);
+void toggleTraceRecording();
+void dumpTrace();
+void stopTraceRecording(bool dump);
+void finishTraceStop();
+bool startDump(const char* tag, const uint8_t* data, size_t size, unsigned int count);
+void pumpDump();
+void traceUplink();
+void traceSpeaker();
+void onTurnTraced(const TurnRecord& record);
+void dumpTurns();
 
 // ElevenLabs event handlers
 void onConversationInit(const char* conversation_id);
@@ -49,14 +154,23 @@ void onAudioData(const uint8_t* pcm_data, size_t size, uint32_t event_id);  // C
 void onError(const char* error_message);
 void onTranscript(const char* transcript);
 void onInterruption(uint32_t event_id);  // New interrupt handler
+void onPing(uint32_t ping_ms);
 void handleAudioPlaybackError();
+void onWiFiLink(bool up);
+void handleWiFiLink();
 
 // Real-time streaming callback (like Python SDK input_callback)
 void onRealtimeAudioChunk(const int16_t* audioData, size_t samples);
+void adaptUplink(uint32_t now);
+void onMicFrame(const int16_t* samples, size_t count);
+void onDuplexTransition(DuplexState from, DuplexState to, uint32_t dwellMs);
 
 void setup() {
     Serial.begin(115200);
-    delay(1000);
+    // A USB console needs a moment to re-enumerate; a UART is ready at once
+    while (!Serial && millis() < 1000) {
+        delay(10);
+    }
     
     Serial.println("\n" + String("=").substring(0, 50));
     Serial.println(" PET ROBOT ASSISTANT - CONVERSATIONAL AI");
@@ -64,64 +178,205 @@ void setup() {
     Serial.println(" ElevenLabs Integration");
     Serial.println(String("=").substring(0, 50));
     
-    // Initialize all hardware components
+    // Initialize all hardware components while Wi-Fi associates; full
+    // clock until the first state change
+    setupPower();
     initializeHardware();
+    int phase = boot.begin("events", millis());
+    setupEventSources();
+    boot.end(phase, millis());
     
     // Setup ElevenLabs callbacks
+    phase = boot.begin("services", millis());
     setupElevenLabsCallbacks();
-    
-    // Initialize ElevenLabs connection
-    initializeElevenLabs();
+    setupTools();
+    setupShell();
+    timers.schedule(MEM_REPORT_INTERVAL_MS, reportMemory, millis());
+    boot.end(phase, millis());
     
     Serial.println("\n" + String("=").substring(0, 50));
-    Serial.println("READY FOR CONVERSATION!");
     Serial.println("Commands:");
     Serial.println("  'r' + Enter: Start single recording");
     Serial.println("  'a' + Enter: Toggle auto conversation mode");
     Serial.println("  's' + Enter: Stop current operation");
     Serial.println("  'v' + Enter: Adjust speaker volume");
     Serial.println("  't' + Enter: Toggle streaming audio mode");
+    Serial.println("  'l' + Enter: Print latency telemetry");
+    Serial.println("  'trace' + Enter: Start/stop recording inbound messages");
+    Serial.println("  'dump' + Enter: Print the recorded trace (tools/trace_tool.py)");
+    Serial.println("  'turns' + Enter: Print the per-turn latency records (tools/turn_tool.py)");
     Serial.println("  'realtime' + Enter: Toggle real-time streaming mode");
     Serial.println(String("=").substring(0, 50) + "\n");
     
-    changeState(WAITING_FOR_TRIGGER);
+    // The ElevenLabs connection starts from loop() once Wi-Fi has an IP
+    if (currentState != ERROR_STATE) {
+        changeState(CONNECTING);
+        connectTimer = timers.schedule(WIFI_CONNECT_TIMEOUT_MS, onConnectTimeout, millis());
+    }
 }
 
 void loop() {
-    // Handle WebSocket communication
-    if (elevenLabsClient.isConnected()) {
-        elevenLabsClient.loop();
+    // Sleep until there is something to do instead of polling every tick
+    scheduleWakeups();
+    if (eventLoop.wait() != 0) {
+        power.recordWake(eventLoop.getLastWakeUs());
     }
+    loopStall.begin(micros());
+    
+    // Deferred state machine work that is now due
+    timers.advance(millis());
+    loopStall.lap("timers", micros());
+    
+    // Deliver server events (and poll the client when it runs inline);
+    // uplink completions are traced first as they precede any answer
+    traceUplink();
+    handleWiFiLink();
+    networkTask.dispatch();
+    loopStall.lap("network", micros());
+    toolRegistry.loop();
+    loopStall.lap("tools", micros());
     
     // Handle audio systems
     microphone.loop();
+    loopStall.lap("microphone", micros());
     speaker.loop();
+    traceSpeaker();
+    loopStall.lap("speaker", micros());
     
     // Handle real-time streaming if enabled
     if (realtimeMode && microphone.isRealtimeStreaming()) {
         microphone.realtimeLoop();
+        loopStall.lap("realtime", micros());
     }
     
     // Handle serial commands
     handleSerialInput();
+    loopStall.lap("serial", micros());
     
     // Main conversation flow state machine
     handleConversationFlow();
+    loopStall.lap("state", micros());
+    
+    if (loopStall.end(micros())) {
+        Serial.printf("[LOOP] Stall: iteration took %lu ms (budget %u ms), slowest: %s %lu ms\n",
+                      (unsigned long)(loopStall.getLastUs() / 1000), (unsigned int)LOOP_STALL_BUDGET_MS,
+                      loopStall.getSlowestPhase(), (unsigned long)(loopStall.getSlowestPhaseUs() / 1000));
+    }
+}
+
+void setupEventSources() {
+    if (!eventLoop.begin()) {
+        Serial.println("Failed to create event loop");
+        changeState(ERROR_STATE);
+        return;
+    }
+    
+    // Server events: posted by the network task once they're queued
+    networkTask.onWake([]() {
+        eventLoop.post(EVENT_NETWORK);
+    });
+    
+    // An IP address lets the ElevenLabs connection start
+    WiFi.onEvent([](arduino_event_id_t, arduino_event_info_t) {
+        eventLoop.post(EVENT_NETWORK);
+    }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
     
-    yield();  // Allow background tasks to run without introducing latency
-    delay(1); // Add a small delay to prevent excessive CPU usage
+    // I2S DMA events: a forwarding task drains each driver's event queue
+    eventLoop.forwardQueue(microphone.getEventQueue(), sizeof(i2s_event_t), EVENT_MICROPHONE);
+    eventLoop.forwardQueue(speaker.getEventQueue(), sizeof(i2s_event_t), EVENT_SPEAKER);
+    
+    // Serial RX
+#if ARDUINO_USB_CDC_ON_BOOT && ARDUINO_USB_MODE
+    Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, [](void*, esp_event_base_t, int32_t, void*) {
+        eventLoop.post(EVENT_SERIAL);
+    });
+#else
+    Serial.onReceive([]() {
+        eventLoop.post(EVENT_SERIAL);
+    });
+#endif
+}
+
+void scheduleWakeups() {
+    // DMA events only matter while audio is moving; the rest are dropped
+    uint32_t interest = EVENT_NETWORK | EVENT_SERIAL | EVENT_TIMER;
+    if (microphone.isRecording() || microphone.isRealtimeStreaming()) {
+        interest |= EVENT_MICROPHONE;
+    }
+    if (speaker.isPlaying()) {
+        interest |= EVENT_SPEAKER;
+    }
+    eventLoop.setInterest(interest);
+    
+    // Sources that can't post get a timer instead
+    if (!networkTask.isThreaded()) {
+        eventLoop.setTimer(EVENT_LOOP_POLL_MS);
+    }
+    
+    uint32_t toolTimeoutMs = toolRegistry.getMsUntilTimeout();
+    if (toolTimeoutMs != UINT32_MAX) {
+        eventLoop.setTimer(toolTimeoutMs);
+    }
+    
+    // Stops the speaker's I2S channel once its DMA buffers have drained
+    uint32_t speakerIdleMs = speaker.getMsUntilIdle();
+    if (speakerIdleMs != UINT32_MAX) {
+        eventLoop.setTimer(speakerIdleMs);
+    }
+    
+    uint32_t duplexTimeoutMs = duplex.getMsUntilTimeout(millis());
+    if (duplexTimeoutMs != UINT32_MAX) {
+        eventLoop.setTimer(duplexTimeoutMs);
+    }
+    
+    uint32_t nextTimerMs = timers.getMsUntilNext(millis());
+    if (nextTimerMs != UINT32_MAX) {
+        eventLoop.setTimer(nextTimerMs);
+    }
+    
+    if (currentState == PROCESSING_AUDIO) {
+        eventLoop.setTimer(0);
+    }
+    
+    // Connection state isn't posted; check it often until ready
+    if (currentState == CONNECTING) {
+        eventLoop.setTimer(CONNECT_POLL_MS);
+    }
 }
 
 void initializeHardware() {
+    // Audio buffers first, while the heap is still in one piece
+    Serial.println("Planning audio memory...");
+    int phase = boot.begin("memory", millis());
+    bool ok = microphone.reserveMemory(memoryPlan, MIC_SAMPLE_RATE) &&
+              speaker.reserveMemory(memoryPlan, SPEAKER_SAMPLE_RATE) &&
+              memoryPlan.commit();
+    boot.end(phase, millis(), ok);
+    char line[256];
+    memoryPlan.format(line, sizeof(line));
+    Serial.printf("[MEM] %s\n", line);
+    if (!ok) {
+        Serial.println("Failed to allocate the audio memory plan!");
+        changeState(ERROR_STATE);
+        return;
+    }
+    
+    // Association runs in the Wi-Fi task; the audio drivers come up meanwhile
     Serial.println("Initializing WiFi...");
-    if (!wifiManager.connect(WIFI_SSID, WIFI_PASSWORD)) {
-        Serial.println("Failed to connect to WiFi. Restarting...");
-        ESP.restart();
+    bootWifiPhase = boot.begin("wifi", millis());
+    if (!wifiManager.begin(WIFI_SSID, WIFI_PASSWORD)) {
+        Serial.println("Failed to start WiFi, retrying in the background");
+    }
+    // Connects and reconnects from its own task from here on
+    if (!wifiManager.startSupervisor(onWiFiLink)) {
+        Serial.println("WiFi supervisor unavailable, polling from loop()");
     }
-    Serial.println("WiFi connected: " + WiFi.localIP().toString());
     
     Serial.println("Initializing microphone...");
-    if (!microphone.begin(MIC_SAMPLE_RATE)) {
+    phase = boot.begin("microphone", millis());
+    ok = microphone.begin(MIC_SAMPLE_RATE);
+    boot.end(phase, millis(), ok);
+    if (!ok) {
         Serial.println("Failed to initialize microphone!");
         changeState(ERROR_STATE);
         return;
@@ -129,155 +384,348 @@ void initializeHardware() {
     Serial.println("Microphone initialized");
     
     Serial.println("Initializing speaker...");
-    if (!speaker.begin(SPEAKER_SAMPLE_RATE)) {
+    phase = boot.begin("speaker", millis());
+    ok = speaker.begin(SPEAKER_SAMPLE_RATE);
+    boot.end(phase, millis(), ok);
+    if (!ok) {
         Serial.println("Failed to initialize speaker!");
         changeState(ERROR_STATE);
         return;
     }
     Serial.println("Speaker initialized");
     speaker.setVolume(0.7f);  // Set default volume to 70%
+    
+    // From here on the audio path allocates nothing; a late allocation shows
+    // in the report (and aborts with MEM_STRICT_STEADY_STATE)
+    memTracker.seal(MEM_TAG_MICROPHONE);
+    memTracker.seal(MEM_TAG_SPEAKER);
 }
 
 void setupElevenLabsCallbacks() {
-    elevenLabsClient.onConversationInit(onConversationInit);
-    elevenLabsClient.onAgentResponse(onAgentResponse);
-    elevenLabsClient.onAudioData(onAudioData);
-    elevenLabsClient.onError(onError);
-    elevenLabsClient.onTranscript(onTranscript);
-    elevenLabsClient.onInterruption(onInterruption);  // Add interrupt callback
+    networkTask.onConversationInit(onConversationInit);
+    networkTask.onAgentResponse(onAgentResponse);
+    networkTask.onAudioData(onAudioData);
+    networkTask.onError(onError);
+    networkTask.onTranscript(onTranscript);
+    networkTask.onInterruption(onInterruption);  // Add interrupt callback
+    networkTask.onPing([](uint32_t event_id, uint32_t ping_ms) {
+        onPing(ping_ms);
+    });
+    
+    // Client tools run on the tool worker, never in the receive path
+    networkTask.onToolCallJson([](const char* tool_name, const char* tool_call_id, const char* parameters_json) {
+        toolRegistry.handleToolCall(tool_name, tool_call_id, parameters_json);
+    });
+    
+    // Interruptions purge stale chunks from the speaker queue before the
+    // interruption callback runs (the speaker is only touched from loop())
+    networkTask.attachInterruptSink(&speaker);
+    
+    turnTracer.onTurn(onTurnTraced);
+    
+    // Real-time turn-taking: barge-in is detected on every microphone read
+    duplex.onTransition(onDuplexTransition);
+    microphone.setFrameCallback(onMicFrame);
     
     // Enable streaming audio for better responsiveness
     elevenLabsClient.enableStreamingAudio(true);
+    elevenLabsClient.enableHotStandby(WS_HOT_STANDBY_ENABLED);
+    elevenLabsClient.setPlaybackSampleRate(SPEAKER_SAMPLE_RATE);
+}
+
+void setupTools() {
+    // Names must match the client tools configured on the agent
+    // Handlers run on the tool worker, beside loop(): the speaker gain is
+    // atomic and the status calls only read
+    toolRegistry.registerTool("set_volume", [](JsonObjectConst parameters, char* result, size_t result_size) {
+        int percent = parameters["volume"] | -1;
+        if (percent < 0 || percent > 100) {
+            snprintf(result, result_size, "volume must be 0-100");
+            return false;
+        }
+        speaker.setVolume(percent / 100.0f);
+        snprintf(result, result_size, "Volume set to %d%%", percent);
+        return true;
+    }, 1000);
+    
+    toolRegistry.registerTool("get_device_status", [](JsonObjectConst parameters, char* result, size_t result_size) {
+        snprintf(result, result_size, "uptime %lu s, wifi %d dBm, free heap %u B, volume %d%%",
+                 millis() / 1000, (int)WiFi.RSSI(), (unsigned int)ESP.getFreeHeap(),
+                 (int)(speaker.getVolume() * 100));
+        return true;
+    }, 1000);
+    
+    // Results go back through the network task's outbound queue
+    if (!toolRegistry.begin([](const char* tool_call_id, const char* result, bool is_error) {
+            return networkTask.sendToolResult(tool_call_id, result, is_error);
+        })) {
+        Serial.println("Failed to start tool worker");
+    }
 }
 
 void initializeElevenLabs() {
     Serial.println("Connecting to ElevenLabs...");
-    changeState(CONNECTING);
+    networkStarted = true;
+    bootNetworkPhase = boot.begin("network", millis());
     
     // Initialize WebSocket connection for public agent
     elevenLabsClient.begin(ELEVEN_LABS_AGENT_ID);
     
-    // Wait for connection with timeout
-    unsigned long connectionStart = millis();
-    bool connected = false;
+    // Socket I/O, TLS and parsing move to the network task from here on.
+    // A push-to-talk recording is queued as one message, so it must fit
+    networkTask.reserveOutbound((size_t)MIC_MAX_RECORDING_SECONDS * MIC_SAMPLE_RATE * sizeof(int16_t));
+    if (!networkTask.begin(elevenLabsClient)) {
+        Serial.println("Failed to start network task");
+        boot.end(bootNetworkPhase, millis(), false);
+        timers.cancel(connectTimer);
+        changeState(ERROR_STATE);
+        return;
+    }
     
-    while (millis() - connectionStart < 15000) {  // 15 second timeout
-        elevenLabsClient.loop();
-        
-        if (elevenLabsClient.isConnected()) {
-            connected = true;
-            break;
+    // handleConnecting() sees the connection; this reports a slow one
+    timers.cancel(connectTimer);
+    connectTimer = timers.schedule(ELEVENLABS_CONNECT_TIMEOUT_MS, onConnectTimeout, millis());
+}
+
+void handleConnecting() {
+    if (!networkStarted) {
+        if (!wifiManager.isSupervised()) {
+            wifiManager.poll();
+        }
+        if (wifiManager.isConnected()) {
+            // Stamped by the Wi-Fi event, which may be a little earlier
+            unsigned long connectedMs = wifiManager.getConnectedMs();
+            boot.end(bootWifiPhase, connectedMs != 0 ? connectedMs : millis());
+            Serial.println("WiFi connected: " + WiFi.localIP().toString());
+            initializeElevenLabs();
         }
-        delay(100);
+        return;
     }
     
-    if (connected) {
+    if (networkTask.isConnected()) {
+        timers.cancel(connectTimer);
+        boot.end(bootNetworkPhase, millis());
+        boot.markReady(millis());
         Serial.println("ElevenLabs connected successfully");
-    } else {
-        Serial.println("Failed to connect to ElevenLabs");
-        changeState(ERROR_STATE);
+        printBootTimeline();
+        Serial.println("READY FOR CONVERSATION!");
+        changeState(WAITING_FOR_TRIGGER);
+    }
+}
+
+void onConnectTimeout() {
+    if (currentState != CONNECTING) {
+        return;
+    }
+    if (!networkStarted) {
+        // The supervisor keeps retrying; the network starts whenever it connects
+        Serial.println("WiFi not connected yet, still retrying in the background");
+        return;
+    }
+    // The client keeps reconnecting; handleConnecting() finishes the boot
+    // whenever it gets through, so just say so now and then
+    Serial.printf("ElevenLabs not connected after %u s, still retrying\n",
+                  (unsigned int)(ELEVENLABS_CONNECT_TIMEOUT_MS / 1000));
+    connectTimer = timers.schedule(ELEVENLABS_CONNECT_TIMEOUT_MS, onConnectTimeout, millis());
+}
+
+void printBootTimeline() {
+    char line[128];
+    for (size_t i = 0; i < boot.getPhaseCount(); i++) {
+        boot.formatPhase(i, line, sizeof(line));
+        Serial.printf("[BOOT] %s\n", line);
+    }
+    if (boot.isReady()) {
+        Serial.printf("[BOOT] Ready in %lu ms\n", (unsigned long)boot.getReadyMs());
     }
 }
 
 void handleSerialInput() {
-    if (Serial.available()) {
-        String input = Serial.readStringUntil('\n');
-        input.trim();
-        input.toLowerCase();
-        
-        // If in real-time mode, only allow stopping or volume changes
-        if (realtimeMode) {
-            if (input == "realtime" || input == "s") {
-                Serial.println("[REALTIME] Stopping real-time mode...");
-                realtimeMode = false;
-                microphone.stopRealtimeStreaming();
-                elevenLabsClient.stopRealtimeStreaming();
-                changeState(WAITING_FOR_TRIGGER);
-                Serial.println("[REALTIME] ✓ Stopped - back to manual mode");
-            } else if (input == "v") {
-                float currentVolume = speaker.getVolume();
-                float newVolume = (currentVolume >= 1.0f) ? 0.3f : currentVolume + 0.2f;
-                speaker.setVolume(newVolume);
-                Serial.printf("Speaker volume: %.1f%%\n", newVolume * 100);
-            } else if (input.length() > 0) {
-                Serial.println("[REALTIME] In real-time mode. Use 'realtime' or 's' to stop.");
-            }
-            return; // Don't process other commands while in real-time mode
+    // Only what has already arrived: a partial line waits in the shell
+    uint8_t buffer[64];
+    size_t budget = SHELL_BYTES_PER_LOOP;
+    int available;
+    while (budget > 0 && (available = Serial.available()) > 0) {
+        size_t count = min(min((size_t)available, sizeof(buffer)), budget);
+        count = Serial.read(buffer, count);
+        if (count == 0) {
+            break;
         }
-        
-        // Normal command processing when not in real-time mode
-        if (input == "r") {
-            if (currentState == WAITING_FOR_TRIGGER) {
-                Serial.println("Starting recording sequence...");
-                startRecordingSequence();
-            } else {
-                Serial.println("Can't start recording in current state");
-            }
+        shell.feed(buffer, count, millis());
+        budget -= count;
+    }
+    
+    // A burst bigger than the budget carries on next iteration
+    if (budget == 0 && Serial.available() > 0) {
+        eventLoop.post(EVENT_SERIAL);
+    }
+}
+
+void setupShell() {
+    shell.setWriter([](const uint8_t* data, size_t size) -> size_t {
+        return Serial.write(data, size);
+    });
+    shell.setMetricsProvider(reportTelemetry);
+    shell.onFallback([](const char* line) {
+        if (realtimeMode) {
+            Serial.println("[REALTIME] In real-time mode. Use 'realtime' or 's' to stop.");
+        } else {
+            Serial.printf("Unknown command: %s\n", line);
         }
-        else if (input == "a") {
-            autoMode = !autoMode;
-            Serial.println("Auto conversation mode: " + String(autoMode ? "ON" : "OFF"));
-            
-            if (autoMode && currentState == WAITING_FOR_TRIGGER) {
-                Serial.println("Starting auto conversation...");
-                startRecordingSequence();
-            }
+    });
+    
+    shell.registerCommand("r", [](const char*) {
+        if (currentState == WAITING_FOR_TRIGGER) {
+            Serial.println("Starting recording sequence...");
+            startRecordingSequence();
+        } else {
+            Serial.println("Can't start recording in current state");
         }
-        else if (input == "s") {
-            Serial.println("Stopping current operation...");
-            speaker.stop();
-            microphone.clearBuffer();
-            changeState(WAITING_FOR_TRIGGER);
+    }, SHELL_MODE_MANUAL);
+    
+    shell.registerCommand("a", [](const char*) {
+        autoMode = !autoMode;
+        Serial.println("Auto conversation mode: " + String(autoMode ? "ON" : "OFF"));
+        
+        if (autoMode && currentState == WAITING_FOR_TRIGGER) {
+            Serial.println("Starting auto conversation...");
+            startRecordingSequence();
         }
-        else if (input == "v") {
-            float currentVolume = speaker.getVolume();
-            float newVolume = (currentVolume >= 1.0f) ? 0.3f : currentVolume + 0.2f;
-            speaker.setVolume(newVolume);
-            Serial.printf("Speaker volume: %.1f%%\n", newVolume * 100);
+    }, SHELL_MODE_MANUAL);
+    
+    shell.registerCommand("s", [](const char*) {
+        if (realtimeMode) {
+            stopRealtimeMode();
+            return;
         }
-        else if (input == "t") {
-            bool currentMode = elevenLabsClient.isStreamingAudioEnabled();
-            elevenLabsClient.enableStreamingAudio(!currentMode);
-            Serial.println("Streaming audio mode: " + String(!currentMode ? "ON" : "OFF"));
+        if (currentState == CONNECTING) {
+            Serial.println("Still connecting; nothing to stop");
+            return;
         }
-        else if (input == "realtime") {
-            realtimeMode = true;
-            Serial.println("\n[REALTIME] Mode: ENABLED");
-            
-            if (currentState == WAITING_FOR_TRIGGER) {
-                Serial.println("[REALTIME] Starting real-time conversation mode...");
-                elevenLabsClient.startRealtimeStreaming();
-                if (microphone.startRealtimeStreaming(onRealtimeAudioChunk)) {
-                    Serial.println("[REALTIME] ✓ Active - speak continuously for real-time conversation!");
-                    Serial.println("[REALTIME] Audio will be sent in 250ms chunks");
-                } else {
-                    Serial.println("[REALTIME] ✗ Failed to start streaming");
-                    realtimeMode = false;
-                }
-            } else {
-                Serial.println("[REALTIME] ✗ Cannot start - not in waiting state");
-                realtimeMode = false;
-            }
+        Serial.println("Stopping current operation...");
+        timers.cancel(countdownTimer);
+        speaker.stop();
+        microphone.clearBuffer();
+        changeState(WAITING_FOR_TRIGGER);
+    }, SHELL_MODE_ANY);
+    
+    shell.registerCommand("v", [](const char*) {
+        adjustVolume();
+    }, SHELL_MODE_ANY);
+    
+    shell.registerCommand("t", [](const char*) {
+        bool currentMode = networkTask.isStreamingAudioEnabled();
+        networkTask.enableStreamingAudio(!currentMode);
+        Serial.println("Streaming audio mode: " + String(!currentMode ? "ON" : "OFF"));
+    }, SHELL_MODE_MANUAL);
+    
+    shell.registerCommand("l", [](const char*) {
+        printLatencyTelemetry();
+    }, SHELL_MODE_ANY);
+    
+    shell.registerCommand("trace", [](const char*) {
+        toggleTraceRecording();
+    }, SHELL_MODE_ANY);
+    
+    shell.registerCommand("dump", [](const char*) {
+        dumpTrace();
+    }, SHELL_MODE_ANY);
+    
+    shell.registerCommand("turns", [](const char*) {
+        dumpTurns();
+    }, SHELL_MODE_ANY);
+    
+    shell.registerCommand("realtime", [](const char*) {
+        if (realtimeMode) {
+            stopRealtimeMode();
+        } else {
+            startRealtimeMode();
         }
-        else if (input.length() > 0) {
-            Serial.println("Unknown command: " + input);
+    }, SHELL_MODE_ANY);
+}
+
+void setupPower() {
+    // Waiting states trade wake latency for power; anything on the path
+    // from speech to playback runs at full clock with the radio awake
+    power.setProfile(IDLE, "idle", {80, true, true});
+    power.setProfile(CONNECTING, "connecting", {240, false, false});
+    power.setProfile(WAITING_FOR_TRIGGER, "waiting", {80, true, true});
+    power.setProfile(COUNTDOWN, "countdown", {80, false, true});
+    power.setProfile(RECORDING, "recording", {160, false, false});
+    power.setProfile(PROCESSING_AUDIO, "processing", {240, false, false});
+    power.setProfile(WAITING_FOR_RESPONSE, "response", {240, false, false});
+    power.setProfile(PLAYING_RESPONSE, "playing", {240, false, false});
+    power.setProfile(REALTIME_CONVERSATION, "realtime", {240, false, false});
+    power.setProfile(ERROR_STATE, "error", {80, true, true});
+    power.setApplier(applyPowerProfile);
+}
+
+void setRealtimeMode(bool enabled) {
+    realtimeMode = enabled;
+    shell.setMode(enabled ? SHELL_MODE_REALTIME : SHELL_MODE_MANUAL);
+}
+
+void startRealtimeMode() {
+    setRealtimeMode(true);
+    Serial.println("\n[REALTIME] Mode: ENABLED");
+    
+    if (currentState == WAITING_FOR_TRIGGER) {
+        Serial.println("[REALTIME] Starting real-time conversation mode...");
+        networkTask.startRealtimeStreaming();
+        // The link was probably the same last session, so keep its mode
+        microphone.setRealtimeChunkMs(uplink.getChunkMs());
+        if (microphone.startRealtimeStreaming(onRealtimeAudioChunk)) {
+            duplex.start(millis());
+            changeState(REALTIME_CONVERSATION);
+            Serial.println("[REALTIME] ✓ Active - speak continuously for real-time conversation!");
+            Serial.printf("[REALTIME] Audio will be sent in %lums chunks, adapted to the link\n",
+                          (unsigned long)uplink.getChunkMs());
+        } else {
+            Serial.println("[REALTIME] ✗ Failed to start streaming");
+            setRealtimeMode(false);
         }
+    } else {
+        Serial.println("[REALTIME] ✗ Cannot start - not in waiting state");
+        setRealtimeMode(false);
     }
 }
 
+void stopRealtimeMode() {
+    Serial.println("[REALTIME] Stopping real-time mode...");
+    setRealtimeMode(false);
+    microphone.stopRealtimeStreaming();
+    networkTask.stopRealtimeStreaming();
+    duplex.stop(millis());
+    speaker.stop();
+    changeState(WAITING_FOR_TRIGGER);
+    Serial.println("[REALTIME] ✓ Stopped - back to manual mode");
+}
+
+void adjustVolume() {
+    float currentVolume = speaker.getVolume();
+    float newVolume = (currentVolume >= 1.0f) ? 0.3f : currentVolume + 0.2f;
+    speaker.setVolume(newVolume);
+    Serial.printf("Speaker volume: %.1f%%\n", newVolume * 100);
+}
+
 void handleConversationFlow() {
     switch (currentState) {
+        case CONNECTING:
+            handleConnecting();
+            break;
+            
         case WAITING_FOR_TRIGGER:
             // Idle state - waiting for user input
             break;
             
         case COUNTDOWN:
-            handleCountdown();
+            // Ticked by countdownTimer
             break;
             
         case RECORDING:
             if (microphone.isRecordingComplete()) {
                 Serial.println("Recording complete!");
+                turnTracer.mark(TURN_MIC_CAPTURE, millis());
                 changeState(PROCESSING_AUDIO);
             }
             break;
@@ -295,25 +743,25 @@ void handleConversationFlow() {
             if (!speaker.isPlaying()) {
                 Serial.println("[RESPONSE] ✓ Response playback complete!");
                 
-                if (realtimeMode) {
-                    // In real-time mode, just continue streaming - no state changes
-                    Serial.println("[REALTIME] Continuing real-time conversation...");
-                    // Stay in PLAYING_RESPONSE or go back to a listening state
-                    // But don't restart recording sequences
-                } else if (autoMode) {
+                if (autoMode) {
                     Serial.println("Auto mode: Starting next recording cycle...");
-                    delay(1000);  // Brief pause before next recording
-                    startRecordingSequence();
+                    scheduleNextRecording(1000);  // Brief pause before next recording
                 } else {
                     changeState(WAITING_FOR_TRIGGER);
                 }
             }
             break;
             
+        case REALTIME_CONVERSATION:
+            // The mic never stops; the duplex state machine decides what plays
+            duplex.update(millis());
+            if (!speaker.isPlaying() && speaker.getQueuedChunks() == 0) {
+                duplex.onPlaybackDrained(millis());
+            }
+            break;
+            
         case ERROR_STATE:
-            // Error state - system halted
-            Serial.println("System in error state. Reset required.");
-            delay(5000);
+            // Error state - system halted; remindErrorState() repeats the message
             break;
             
         default:
@@ -325,6 +773,11 @@ void changeState(ConversationState newState) {
     if (currentState != newState) {
         currentState = newState;
         stateTimer = millis();
+        power.enter(newState, stateTimer);
+        
+        if (newState == ERROR_STATE) {
+            timers.schedule(0, remindErrorState, millis());
+        }
         
         // Optional: Print state changes for debugging
         // Serial.printf("[STATE] Changed to: %d\n", (int)newState);
@@ -335,24 +788,69 @@ void startRecordingSequence() {
     Serial.println("Starting 3-second countdown...");
     countdownSeconds = 3;
     changeState(COUNTDOWN);
+    timers.cancel(countdownTimer);
+    countdownTimer = timers.schedule(1000, handleCountdown, millis());
 }
 
 void handleCountdown() {
-    if (millis() - stateTimer >= 1000) {  // Every second
-        Serial.printf("Recording in: %d\n", countdownSeconds);
-        countdownSeconds--;
-        stateTimer = millis();
-        
-        if (countdownSeconds <= 0) {
-            Serial.println("RECORDING NOW!");
-            if (microphone.startRecording(3)) {  // 3-second recording
-                changeState(RECORDING);
-            } else {
-                Serial.println("Failed to start recording!");
-                changeState(ERROR_STATE);
-            }
+    // Every second while in COUNTDOWN
+    if (currentState != COUNTDOWN) {
+        return;
+    }
+    
+    Serial.printf("Recording in: %d\n", countdownSeconds);
+    countdownSeconds--;
+    
+    if (countdownSeconds > 0) {
+        countdownTimer = timers.schedule(1000, handleCountdown, millis());
+        return;
+    }
+    
+    Serial.println("RECORDING NOW!");
+    if (microphone.startRecording(3)) {  // 3-second recording
+        changeState(RECORDING);
+    } else {
+        Serial.println("Failed to start recording!");
+        changeState(ERROR_STATE);
+    }
+}
+
+void scheduleNextRecording(uint32_t delayMs) {
+    // Waits in WAITING_FOR_TRIGGER, so 'r', 'a' or 's' meanwhile take over
+    changeState(WAITING_FOR_TRIGGER);
+    timers.schedule(delayMs, []() {
+        if (autoMode && currentState == WAITING_FOR_TRIGGER) {
+            startRecordingSequence();
+        }
+    }, millis());
+}
+
+void remindErrorState() {
+    if (currentState != ERROR_STATE) {
+        return;
+    }
+    Serial.println("System in error state. Reset required.");
+    timers.schedule(5000, remindErrorState, millis());
+}
+
+void reportMemory() {
+    char line[256];
+    memTracker.formatHeap(line, sizeof(line));
+    Serial.printf("[MEM] %s\n", line);
+    for (size_t i = 0; i < MEM_TAG_COUNT; i++) {
+        memTracker.formatTag((MemTag)i, line, sizeof(line));
+        Serial.printf("[MEM] %s\n", line);
+    }
+    
+    // Plenty free but no block big enough is the failure that shows up hours later
+    for (size_t i = 0; i < MEM_REGION_COUNT; i++) {
+        uint32_t fragmentation = memTracker.getFragmentation((MemRegion)i);
+        if (fragmentation > MEM_FRAGMENTATION_WARN_PCT) {
+            Serial.printf("[MEM] Warning: %s heap %u%% fragmented\n",
+                          MemTracker::regionName((MemRegion)i), (unsigned int)fragmentation);
         }
     }
+    timers.schedule(MEM_REPORT_INTERVAL_MS, reportMemory, millis());
 }
 
 void processRecordedAudio() {
@@ -373,7 +871,13 @@ void processRecordedAudio() {
         Serial.printf("Sending audio (%d bytes PCM) to ElevenLabs...\n", audioSize);
         
         // Send raw PCM audio to ElevenLabs (Python SDK style)
-        elevenLabsClient.sendAudio((const uint8_t*)pcmData, audioSize);
+        if (!networkTask.sendAudio((const uint8_t*)pcmData, audioSize)) {
+            Serial.println("Outbound queue full - audio dropped");
+            microphone.clearBuffer();
+            changeState(WAITING_FOR_TRIGGER);
+            return;
+        }
+        latencyTelemetry.markUplinkChunk(millis());
         
         // Clear microphone buffer
         microphone.clearBuffer();
@@ -391,6 +895,9 @@ void onConversationInit(const char* conversation_id) {
 }
 
 void onAgentResponse(const char* response) {
+    latencyTelemetry.markAgentResponse(millis());
+    turnTracer.mark(TURN_AGENT_RESPONSE, millis());
+    
     Serial.println("\n" + String("=").substring(0, 50));
     Serial.println("[AGENT RESPONSE] Text received:");
     Serial.println(response);
@@ -401,20 +908,31 @@ void onAgentResponse(const char* response) {
 }
 
 void onAudioData(const uint8_t* pcm_data, size_t size, uint32_t event_id) {
+    latencyTelemetry.markAudio(millis());
+    
+    // After a barge-in the rest of the interrupted response is dropped
+    if (realtimeMode && !duplex.onAgentAudio(event_id, millis())) {
+        Serial.printf("[DUPLEX] Dropped audio chunk (Event: %u) in %s\n",
+                      event_id, DuplexStateMachine::stateName(duplex.getState()));
+        return;
+    }
+    turnTracer.mark(TURN_FIRST_AUDIO, millis());
+    
     Serial.printf("[RESPONSE] Received audio chunk (Event: %u, %d bytes PCM)\n", event_id, size);
     
-    // In Python SDK style: immediately output audio to speaker (audio_interface.output)
-    // No complex chunking logic needed - just play the PCM data directly
-    if (speaker.isPlaying()) {
-        // If speaker is busy, this could be handled by queuing or interrupting
-        Serial.println("[RESPONSE] Speaker busy - implementing proper audio interface...");
+    // Queue the chunk behind any audio still playing (audio_interface.output).
+    // Chunks keep their event ID so an interruption can purge them.
+    if (!speaker.isStreaming() && !speaker.startStreamingAudio()) {
+        Serial.println("[RESPONSE] ✗ Failed to start streaming playback!");
+        handleAudioPlaybackError();
+        return;
     }
     
-    // Convert PCM data to format expected by speaker and play immediately
-    // This mimics the Python SDK's audio_interface.output(audio) behavior
-    if (speaker.playPCMAudio(pcm_data, size)) {
-        Serial.printf("[RESPONSE] ✓ Playing audio chunk (Event: %u, %d bytes)\n", event_id, size);
-        changeState(PLAYING_RESPONSE);
+    if (speaker.addRawAudioChunk((const int16_t*)pcm_data, size, event_id)) {
+        Serial.printf("[RESPONSE] ✓ Queued audio chunk (Event: %u, %d bytes)\n", event_id, size);
+        if (!realtimeMode) {
+            changeState(PLAYING_RESPONSE);
+        }
     } else {
         Serial.println("[RESPONSE] ✗ Failed to play PCM audio chunk!");
         handleAudioPlaybackError();
@@ -422,39 +940,78 @@ void onAudioData(const uint8_t* pcm_data, size_t size, uint32_t event_id) {
 }
 
 void onTranscript(const char* transcript) {
+    turnTracer.mark(TURN_USER_TRANSCRIPT, millis());
     Serial.println("[TRANSCRIPT] User: " + String(transcript));
 }
 
 void onInterruption(uint32_t event_id) {
-    Serial.printf("[INTERRUPT] Conversation interrupted (Event ID: %u) - stopping audio playback\n", event_id);
-    
-    // Immediately stop audio playback (like Python SDK's audio_interface.interrupt())
-    speaker.stop();
+    // Stale chunks (event ID <= this one) were already purged from the speaker
+    // queue by the client, like the Python SDK's audio_interface.interrupt()
+    Serial.printf("[INTERRUPT] Conversation interrupted (Event ID: %u) - stale audio purged, %d chunks queued\n",
+                  event_id, speaker.getQueuedChunks());
     
-    // Clear any audio buffers/queues
-    speaker.clearBuffer();
+    // Real-time mode keeps streaming; the duplex state machine recovers
+    if (realtimeMode) {
+        duplex.onServerInterruption(event_id, millis());
+        return;
+    }
     
     // Return to waiting for trigger state
     changeState(WAITING_FOR_TRIGGER);
 }
 
+void onPing(uint32_t ping_ms) {
+    latencyTelemetry.recordPing(ping_ms);
+    uplink.recordPing(ping_ms);
+}
+
+// On the Wi-Fi supervisor task: hand the news to loop()
+void onWiFiLink(bool up) {
+    wifiLinkUp = up;
+    wifiLinkChanged = true;
+    eventLoop.post(EVENT_NETWORK);
+}
+
+void handleWiFiLink() {
+    if (!wifiLinkChanged.exchange(false)) {
+        return;
+    }
+    bool up = wifiLinkUp;
+    if (networkStarted) {
+        networkTask.setNetworkAvailable(up);
+    }
+    if (!up && (microphone.isRecording() || microphone.isRealtimeStreaming())) {
+        // Capture carries on; chunks are dropped until the server is back
+        Serial.println("[WIFI] Link lost mid-conversation, audio capture continues");
+    }
+}
+
 void onError(const char* error_message) {
     Serial.println("[ERROR] ElevenLabs Error: " + String(error_message));
     
     // Attempt to recover from errors
     if (currentState == WAITING_FOR_RESPONSE) {
         Serial.println("[ERROR] Attempting to recover...");
-        delay(2000);
-        changeState(WAITING_FOR_TRIGGER);
+        timers.schedule(2000, []() {
+            // A response that arrived meanwhile wins
+            if (currentState == WAITING_FOR_RESPONSE) {
+                changeState(WAITING_FOR_TRIGGER);
+            }
+        }, millis());
     }
 }
 
 void handleAudioPlaybackError() {
+    if (realtimeMode) {
+        // Keep the conversation going; the next response may play
+        Serial.println("[DUPLEX] Audio failed, still listening");
+        return;
+    }
+    
     if (autoMode) {
         // Continue conversation even if audio fails
         Serial.println("Audio failed in auto mode, continuing conversation...");
-        delay(2000);
-        startRecordingSequence();
+        scheduleNextRecording(2000);
     } else {
         Serial.println("Audio failed, returning to trigger wait");
         changeState(WAITING_FOR_TRIGGER);
@@ -463,17 +1020,281 @@ void handleAudioPlaybackError() {
 
 // Real-time streaming callback (like Python SDK input_callback)
 void onRealtimeAudioChunk(const int16_t* audioData, size_t samples) {
-    if (!realtimeMode || !elevenLabsClient.isConnected()) {
+    if (!realtimeMode || !networkTask.isConnected()) {
         return;
     }
+    uint32_t now = millis();
+    turnTracer.mark(TURN_MIC_CAPTURE, now);
+    adaptUplink(now);
+    if (!uplink.admit(audioData, samples, now)) {
+        return;  // Silence while the link is backed up
+    }
     
     // Convert samples to bytes for transmission
     size_t audioSize = samples * sizeof(int16_t);
     const uint8_t* pcmBytes = reinterpret_cast<const uint8_t*>(audioData);
     
     // Send real-time audio chunk (like Python SDK input_callback)
-    elevenLabsClient.sendRealtimeAudioChunk(pcmBytes, audioSize);
+    if (!networkTask.sendRealtimeAudioChunk(pcmBytes, audioSize)) {
+        Serial.println("[REALTIME] Outbound queue full - chunk dropped");
+        return;
+    }
+    // Only chunks carrying speech restart the response timer, so it runs
+    // from the chunk that ended the user's speech, not the latest one
+    if (bargeInDetector.getLastSpeechMs() != uplinkSpeechMs) {
+        uplinkSpeechMs = bargeInDetector.getLastSpeechMs();
+        latencyTelemetry.markUplinkChunk(millis());
+    }
     
     // Debug output for real-time streaming
     Serial.printf("[REALTIME] Sent chunk: %d samples (%d bytes) to ElevenLabs\n", samples, audioSize);
-}
\ No newline at end of file
+}
+
+// Once per chunk: feed the link signals in and apply any new chunk size
+void adaptUplink(uint32_t now) {
+    uplink.recordRssi((int8_t)WiFi.RSSI());
+    uint32_t count = networkTask.getUplinkCount();
+    if (count != lastUplinkCount) {
+        lastUplinkCount = count;
+        uplink.recordSend(networkTask.getLastUplinkUs() / 1000);
+    }
+    uplink.setBacklog(networkTask.getOutboundBacklog() * 1000 / (MIC_SAMPLE_RATE * sizeof(int16_t)));
+    
+    if (uplink.update(now)) {
+        microphone.setRealtimeChunkMs(uplink.getChunkMs());
+        Serial.printf("[UPLINK] %s (%lums chunks), reason: %s\n", UplinkController::modeName(uplink.getMode()),
+                      (unsigned long)uplink.getChunkMs(), uplink.getReason());
+    }
+}
+
+// Every microphone read (~16 ms) while streaming, for barge-in detection
+void onMicFrame(const int16_t* samples, size_t count) {
+    uint32_t now = millis();
+    if (!bargeInDetector.processFrame(samples, count, now)) {
+        return;
+    }
+    
+    if (duplex.onLocalSpeech(bargeInDetector.getOnsetMs(), now)) {
+        // Dropping the queue zeroes the DMA buffers: silent within one buffer
+        size_t dropped = speaker.purgeUpToEvent(UINT32_MAX);
+        networkTask.sendUserActivity();
+        Serial.printf("[DUPLEX] Barge-in: playback cut %u ms after speech onset, %u chunks dropped\n",
+                      (unsigned int)(now - bargeInDetector.getOnsetMs()), (unsigned int)dropped);
+    }
+}
+
+void onDuplexTransition(DuplexState from, DuplexState to, uint32_t dwellMs) {
+    Serial.printf("[DUPLEX] %s -> %s after %u ms\n", DuplexStateMachine::stateName(from),
+                  DuplexStateMachine::stateName(to), (unsigned int)dwellMs);
+    
+    // The speaker's echo becomes the new floor before barge-in can trigger
+    if (to == DUPLEX_AGENT_SPEAKING) {
+        bargeInDetector.arm(millis());
+    }
+}
+
+void printLatencyTelemetry() {
+    reportTelemetry([](const char* line) {
+        Serial.println(line);
+    });
+}
+
+void reportTelemetry(ShellEmit emit) {
+    char line[256];
+    latencyTelemetry.format(line, sizeof(line));
+    emit(line);
+    turnTracer.flush(millis());
+    turnTracer.format(line, sizeof(line));
+    emit(line);
+    networkTask.format(line, sizeof(line));
+    emit(line);
+    eventLoop.format(line, sizeof(line));
+    emit(line);
+    duplex.format(line, sizeof(line));
+    emit(line);
+    timers.format(line, sizeof(line));
+    emit(line);
+    loopStall.format(line, sizeof(line));
+    emit(line);
+    microphone.getAudioGraph().format(line, sizeof(line));
+    emit(line);
+    speaker.getAudioGraph().format(line, sizeof(line));
+    emit(line);
+    shell.format(line, sizeof(line));
+    emit(line);
+    power.format(line, sizeof(line), millis());
+    emit(line);
+    boot.format(line, sizeof(line));
+    emit(line);
+    wifiManager.format(line, sizeof(line));
+    emit(line);
+    wifiManager.getSupervisor().format(line, sizeof(line), millis());
+    emit(line);
+    uplink.format(line, sizeof(line), millis());
+    emit(line);
+    memoryPlan.format(line, sizeof(line));
+    emit(line);
+    memTracker.formatHeap(line, sizeof(line));
+    emit(line);
+    for (size_t i = 0; i < MEM_TAG_COUNT; i++) {
+        memTracker.formatTag((MemTag)i, line, sizeof(line));
+        emit(line);
+    }
+    for (size_t i = 0; i < toolRegistry.getToolCount(); i++) {
+        toolRegistry.format(i, line, sizeof(line));
+        emit(line);
+    }
+}
+
+void traceUplink() {
+    uint32_t sentMs = networkTask.getLastAudioSentMs();
+    if (sentMs != tracedUplinkMs) {
+        tracedUplinkMs = sentMs;
+        turnTracer.mark(TURN_UPLINK_SENT, sentMs);
+    }
+}
+
+void traceSpeaker() {
+    // Any write counts: after an underrun it cancels the provisional end
+    uint32_t samples = speaker.getSamplesWritten();
+    if (samples != tracedSpeakerSamples) {
+        tracedSpeakerSamples = samples;
+        turnTracer.mark(TURN_FIRST_SAMPLE, millis());
+    }
+    
+    bool playing = speaker.isPlaying();
+    if (tracedSpeakerPlaying && !playing) {
+        turnTracer.mark(TURN_PLAYBACK_END, millis());
+    }
+    tracedSpeakerPlaying = playing;
+    turnTracer.flush(millis());
+}
+
+void onTurnTraced(const TurnRecord& record) {
+    char line[160];
+    TurnTracer::formatTurn(record, line, sizeof(line));
+    Serial.printf("[TURN] %s\n", line);
+}
+
+void toggleTraceRecording() {
+    if (activeDump.tag != nullptr) {
+        Serial.println("[TRACE] Dump in progress");
+        return;
+    }
+    if (networkTask.isTracing()) {
+        stopTraceRecording(false);
+        return;
+    }
+    if (!networkTask.isTraceReleased()) {
+        Serial.println("[TRACE] Still stopping");
+        return;
+    }
+    
+    // Buffer is allocated on first use so it costs nothing when unused
+    if (!conversationTrace.begin(TRACE_BUFFER_SIZE)) {
+        Serial.printf("[TRACE] ✗ Failed to allocate %u byte trace buffer\n", (unsigned int)TRACE_BUFFER_SIZE);
+        return;
+    }
+    
+    // From here the network task owns the trace until it is released
+    if (!networkTask.startTrace(&conversationTrace)) {
+        Serial.println("[TRACE] ✗ Network queue full - try again");
+        return;
+    }
+    Serial.printf("[TRACE] Recording inbound messages (%u KB buffer)\n", (unsigned int)(TRACE_BUFFER_SIZE / 1024));
+}
+
+// The network task records into the trace; it is only read here once released
+void stopTraceRecording(bool dump) {
+    traceDumpPending = traceDumpPending || dump;
+    networkTask.stopTrace();  // Retried by finishTraceStop() if the queue is full
+    timers.schedule(0, finishTraceStop, millis());
+}
+
+void finishTraceStop() {
+    if (networkTask.isTracing()) {
+        networkTask.stopTrace();
+    }
+    if (!networkTask.isTraceReleased()) {
+        timers.schedule(DUMP_TICK_MS, finishTraceStop, millis());
+        return;
+    }
+    
+    Serial.printf("[TRACE] Stopped: %u messages, %u bytes\n",
+                  conversationTrace.getRecordCount(), (unsigned int)conversationTrace.size());
+    if (traceDumpPending) {
+        traceDumpPending = false;
+        dumpTrace();
+    }
+}
+
+void dumpTrace() {
+    if (networkTask.isTracing()) {
+        stopTraceRecording(true);
+        return;
+    }
+    if (!networkTask.isTraceReleased()) {
+        traceDumpPending = true;  // finishTraceStop() is on its way
+        return;
+    }
+    if (conversationTrace.size() == 0) {
+        Serial.println("[TRACE] Nothing recorded - use 'trace' first");
+        return;
+    }
+    
+    // Base64 lines, same idea as the audio dumps read by base64_to_wav.py
+    startDump("TRACE", conversationTrace.data(), conversationTrace.size(), conversationTrace.getRecordCount());
+}
+
+void dumpTurns() {
+    turnTracer.flush(millis());
+    if (turnTracer.getTurnCount() == 0) {
+        Serial.println("[TURN] No completed turns yet");
+        return;
+    }
+    
+    // Same base64 line framing as dumpTrace(); the buffer must outlive the dump
+    static uint8_t data[TURN_EXPORT_HEADER_SIZE + TURN_TRACE_CAPACITY * TURN_EXPORT_RECORD_SIZE];
+    if (activeDump.tag != nullptr) {
+        Serial.println("[TURN] Dump in progress");
+        return;
+    }
+    size_t size = turnTracer.exportBinary(data, sizeof(data));
+    startDump("TURNS", data, size, (unsigned int)turnTracer.getTurnCount());
+}
+
+// Prints "<tag>_BEGIN <size> <count>"; pumpDump() sends the rest
+bool startDump(const char* tag, const uint8_t* data, size_t size, unsigned int count) {
+    if (activeDump.tag != nullptr) {
+        Serial.printf("[DUMP] %s dump still running\n", activeDump.tag);
+        return false;
+    }
+    
+    activeDump = {tag, data, size, 0};
+    Serial.printf("%s_BEGIN %u %u\n", tag, (unsigned int)size, count);
+    timers.schedule(0, pumpDump, millis());
+    return true;
+}
+
+void pumpDump() {
+    unsigned char line[72];
+    for (int i = 0; i < DUMP_LINES_PER_TICK && activeDump.offset < activeDump.size; i++) {
+        // Prefix + 64 characters + newline; wait for the UART rather than block on it
+        if (Serial.availableForWrite() < (int)sizeof(line) + 8) {
+            break;
+        }
+        size_t chunk = min((size_t)DUMP_LINE_BYTES, activeDump.size - activeDump.offset);
+        size_t written = 0;
+        mbedtls_base64_encode(line, sizeof(line), &written, activeDump.data + activeDump.offset, chunk);
+        line[written] = '\0';
+        Serial.printf("%s:%s\n", activeDump.tag, (const char*)line);
+        activeDump.offset += chunk;
+    }
+    
+    if (activeDump.offset < activeDump.size) {
+        timers.schedule(DUMP_TICK_MS, pumpDump, millis());
+        return;
+    }
+    Serial.printf("%s_END\n", activeDump.tag);
+    activeDump.tag = nullptr;
+}
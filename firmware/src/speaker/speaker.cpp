@@ -1,25 +1,45 @@
 #include "speaker.h"
 #include "../config.h"
 #include "mbedtls/base64.h"
-#include <queue>
 
 Speaker::Speaker() : 
     sampleRate(SPEAKER_SAMPLE_RATE),
     bitsPerSample(16),
     bufferLen(1024),
-    volume(0.7f),  // Default to 70% volume
+    memoryPlan(nullptr),
+    poolRegion(-1),
+    stagingRegion(-1),
     audioBuffer(nullptr),
     audioBufferSize(0),
     audioSamples(0),
     playbackPosition(0),
     stereoBuffer(nullptr),
     stereoBufferSize(0),
+    playbackSource(*this),
+    volumeFilter("volume", 0.7f),  // Default to 70% volume
+    stereoFilter("stereo"),
+    i2sOutput(*this),
+    playbackGraph("speaker"),
+    slotSamples(0),
+    queueHead(0),
+    queueCount(0),
+    playingQueuedChunk(false),
     streamingMode(false),
     streamingFinished(false),
     expectedEventId(1),
     initialized(false),
     playing(false),
-    playbackStartTime(0) {
+    outputRunning(false),
+    lastWriteMs(0),
+    playbackStartTime(0),
+    eventQueue(nullptr),
+    dmaFull(false),
+    samplesWritten(0) {
+    playbackGraph.setSource(&playbackSource);
+    playbackGraph.addFilter(&volumeFilter);
+    playbackGraph.addFilter(&stereoFilter);
+    playbackGraph.addSink(&i2sOutput);
+    playbackGraph.setClock([]() -> uint32_t { return ESP.getCycleCount(); });
 }
 
 Speaker::~Speaker() {
@@ -33,11 +53,23 @@ Speaker::~Speaker() {
         Serial.println("[SPEAKER] I2S driver uninstalled in destructor");
     }
     
-    freeAudioBuffer();
-    freeStereoBuffer();
+    // The buffers belong to the memory plan
     clearAudioQueue();
 }
 
+bool Speaker::reserveMemory(MemoryPlan& plan, uint32_t sampleRate, int bufferLen) {
+    // The chunk pool, and one stereo frame worked on in place in internal RAM
+    size_t slotBytes = (size_t)sampleRate * SPEAKER_SLOT_MS / 1000 * sizeof(int16_t);
+    poolRegion = plan.add("speaker_pool", SPEAKER_QUEUE_DEPTH * slotBytes, MEM_PSRAM);
+    stagingRegion = plan.add("speaker_staging", bufferLen * 2 * sizeof(int16_t), MEM_INTERNAL);
+    if (poolRegion < 0 || stagingRegion < 0) {
+        Serial.println("[SPEAKER] ERROR: No room in the memory plan");
+        return false;
+    }
+    memoryPlan = &plan;
+    return true;
+}
+
 bool Speaker::begin(uint32_t sampleRate, uint8_t bitsPerSample, int bufferLen) {
     if (initialized) {
         Serial.println("[SPEAKER] Already initialized");
@@ -74,16 +106,19 @@ bool Speaker::begin(uint32_t sampleRate, uint8_t bitsPerSample, int bufferLen) {
         return false;
     }
 
-    // Allocate stereo buffer for mono-to-stereo conversion
-    // Size it for the maximum chunk size (bufferLen samples * 2 for stereo)
-    if (!allocateStereoBuffer(bufferLen * 2)) {
-        Serial.println("[SPEAKER] ERROR: Failed to allocate stereo buffer");
+    // Stereo buffer and chunk slots come from the memory plan and are
+    // reused for the lifetime of the speaker
+    if (!attachPlannedBuffers()) {
+        Serial.println("[SPEAKER] ERROR: No planned buffers; reserveMemory() and commit the plan before begin()");
         i2s_stop(I2S_PORT);
         i2s_driver_uninstall(I2S_PORT);
         return false;
     }
 
+    // Idle until there is something to play
     initialized = true;
+    outputRunning = true;
+    setOutput(false);
     Serial.println("[SPEAKER] I2S speaker initialized successfully");
     return true;
 }
@@ -111,33 +146,15 @@ bool Speaker::playBase64Audio(const String& base64AudioData) {
 
     Serial.printf("[SPEAKER] Decoding base64 audio: %d characters\n", base64AudioData.length());
 
-    // Decode base64 audio data
-    size_t decodedSize = 0;
-    int16_t* decodedAudio = decodeBase64Audio(base64AudioData, decodedSize);
-    
-    if (decodedAudio == nullptr || decodedSize == 0) {
+    // Decoded into the chunk pool and played as a one-off stream
+    if (!startStreamingAudio() || !addAudioChunk(base64AudioData)) {
         Serial.println("[SPEAKER] ERROR: Failed to decode base64 audio");
+        stop();
         return false;
     }
+    finishStreaming();
 
-    // Store audio data for playback
-    freeAudioBuffer();  // Free any existing buffer
-    audioBuffer = decodedAudio;
-    audioBufferSize = decodedSize;
-    audioSamples = decodedSize / sizeof(int16_t);
-    playbackPosition = 0;
-
-    // Apply volume adjustment
-    applyVolume(audioBuffer, audioSamples);
-
-    Serial.printf("[SPEAKER] Audio ready for playback: %d samples, %d bytes\n", audioSamples, audioBufferSize);
-    Serial.printf("[SPEAKER] Duration: %.2f seconds\n", (float)audioSamples / sampleRate);
-
-    // Start playback
-    playing = true;
-    playbackStartTime = millis();
-
-    Serial.println("[SPEAKER] Audio playback started");
+    Serial.printf("[SPEAKER] Audio ready for playback: %d chunks\n", queueCount);
     return true;
 }
 
@@ -147,7 +164,7 @@ bool Speaker::playRawAudio(const int16_t* audioData, size_t audioSize) {
         return false;
     }
 
-    if (playing) {
+    if (playing || streamingMode) {
         Serial.println("[SPEAKER] WARNING: Already playing audio, stopping current playback");
         stop();
     }
@@ -161,33 +178,15 @@ bool Speaker::playRawAudio(const int16_t* audioData, size_t audioSize) {
         return false;
     }
 
-    // Allocate and copy audio data
-    freeAudioBuffer();
-    audioBuffer = (int16_t*)malloc(audioSize);
-    if (audioBuffer == nullptr) {
-        #ifdef ESP_PLATFORM
-        Serial.printf("[SPEAKER] ERROR: Failed to allocate audio buffer. Requested size: %u bytes, Free heap: %u bytes\n", (unsigned int)audioSize, (unsigned int)ESP.getFreeHeap());
-        #else
-        Serial.printf("[SPEAKER] ERROR: Failed to allocate audio buffer. Requested size: %u bytes\n", (unsigned int)audioSize);
-        #endif
+    // Copied into the chunk pool and played as a one-off stream
+    if (!startStreamingAudio() || !addRawAudioChunk(audioData, audioSize)) {
+        Serial.printf("[SPEAKER] ERROR: %u bytes of audio don't fit in the chunk pool\n", (unsigned int)audioSize);
+        stop();
         return false;
     }
+    finishStreaming();
 
-    memcpy(audioBuffer, audioData, audioSize);
-    audioBufferSize = audioSize;
-    audioSamples = audioSize / sizeof(int16_t);
-    playbackPosition = 0;
-
-    // Apply volume adjustment
-    applyVolume(audioBuffer, audioSamples);
-
-    Serial.printf("[SPEAKER] Raw audio ready for playback: %d samples, %d bytes\n", audioSamples, audioBufferSize);
-
-    // Start playback
-    playing = true;
-    playbackStartTime = millis();
-
-    Serial.println("[SPEAKER] Raw audio playback started");
+    Serial.printf("[SPEAKER] Raw audio ready for playback: %d samples, %d bytes\n", audioSize / sizeof(int16_t), audioSize);
     return true;
 }
 
@@ -229,31 +228,47 @@ bool Speaker::addAudioChunk(const String& base64AudioData, uint32_t eventId) {
         return true; // Not an error, just skip
     }
     
-    // Decode the base64 audio chunk
-    size_t decodedSize = 0;
-    int16_t* decodedAudio = decodeBase64Audio(base64AudioData, decodedSize);
-    
-    if (decodedAudio == nullptr || decodedSize == 0) {
-        Serial.println("[SPEAKER] ERROR: Failed to decode audio chunk");
+    // Size the decode without allocating
+    size_t requiredLen = 0;
+    int result = mbedtls_base64_decode(NULL, 0, &requiredLen,
+                                      (const unsigned char*)base64AudioData.c_str(), base64AudioData.length());
+    if (result != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL) {
+        Serial.println("[SPEAKER] ERROR: Invalid base64 data");
         return false;
     }
     
-    size_t samples = decodedSize / sizeof(int16_t);
-    
-    // Apply volume adjustment
-    applyVolume(decodedAudio, samples);
+    // Decode straight into pooled slots, whole base64 groups at a time
+    size_t pieceBytes = slotSamples * sizeof(int16_t) / 6 * 6;
+    size_t pieceChars = pieceBytes / 3 * 4;
+    size_t pieces = pieceBytes > 0 ? (requiredLen + pieceBytes - 1) / pieceBytes : 0;
+    if (pieces == 0 || slotsFor(pieces * slotSamples) == 0) {
+        return false;
+    }
     
-    // Create audio chunk and add to queue
-    AudioChunk* chunk = new AudioChunk(decodedAudio, samples, eventId);
-    audioQueue.push(chunk);
+    const unsigned char* text = (const unsigned char*)base64AudioData.c_str();
+    size_t length = base64AudioData.length();
+    size_t filled = 0;
+    for (size_t position = 0; position < length; position += pieceChars) {
+        AudioChunk* chunk = acquireChunkSlot(filled);
+        size_t decodedSize = 0;
+        result = mbedtls_base64_decode((unsigned char*)chunk->data, chunk->capacity * sizeof(int16_t), &decodedSize,
+                                      text + position, min(pieceChars, length - position));
+        if (result != 0 || decodedSize == 0) {
+            // Nothing is queued yet, so the filled slots are simply reused
+            Serial.println("[SPEAKER] ERROR: Failed to decode audio chunk");
+            return false;
+        }
+        
+        chunk->samples = decodedSize / sizeof(int16_t);
+        chunk->eventId = eventId;
+        filled++;
+    }
     
-    Serial.printf("[SPEAKER] Added audio chunk: %d samples, event ID: %u, queue size: %d\n", 
-                  samples, eventId, audioQueue.size());
+    // Queue the chunk only once all of it decoded
+    commitChunkSlots(filled);
     
-    // Start playback if not already playing and we have chunks
-    if (!playing && !audioQueue.empty()) {
-        startStreamingPlayback();
-    }
+    Serial.printf("[SPEAKER] Added audio chunk: %d bytes in %d slots, event ID: %u, queue size: %d\n", 
+                  requiredLen, pieces, eventId, queueCount);
     
     return true;
 }
@@ -270,38 +285,62 @@ bool Speaker::addRawAudioChunk(const int16_t* audioData, size_t audioSize, uint3
     }
     
     size_t samples = audioSize / sizeof(int16_t);
-    
-    // Allocate and copy audio data
-    int16_t* chunkData = (int16_t*)malloc(audioSize);
-    if (chunkData == nullptr) {
-        Serial.printf("[SPEAKER] ERROR: Failed to allocate memory for audio chunk: %d bytes\n", audioSize);
+    size_t slots = slotsFor(samples);
+    if (slots == 0) {
         return false;
     }
     
-    memcpy(chunkData, audioData, audioSize);
+    // Copy into pooled slots; the pieces share the event ID, so an
+    // interruption purges them together
+    for (size_t offset = 0; offset < samples; ) {
+        AudioChunk* chunk = acquireChunkSlot();
+        size_t count = min(chunk->capacity, samples - offset);
+        memcpy(chunk->data, audioData + offset, count * sizeof(int16_t));
+        chunk->samples = count;
+        chunk->eventId = eventId;
+        commitChunkSlots(1);
+        offset += count;
+    }
+    
+    Serial.printf("[SPEAKER] Added raw audio chunk: %d samples in %d slots, event ID: %u, queue size: %d\n", 
+                  samples, slots, eventId, queueCount);
+    
+    return true;
+}
+
+size_t Speaker::purgeUpToEvent(uint32_t eventId) {
+    size_t purged = 0;
     
-    // Apply volume adjustment
-    applyVolume(chunkData, samples);
+    bool cutPlayback = false;
     
-    // Create audio chunk and add to queue
-    AudioChunk* chunk = new AudioChunk(chunkData, samples, eventId);
-    audioQueue.push(chunk);
+    // Event IDs increase monotonically, so stale chunks sit at the head
+    while (queueCount > 0 && chunkPool[queueHead].eventId <= eventId) {
+        cutPlayback |= playingQueuedChunk;
+        releaseHeadChunk();
+        purged++;
+    }
     
-    Serial.printf("[SPEAKER] Added raw audio chunk: %d samples, event ID: %u, queue size: %d\n", 
-                  samples, eventId, audioQueue.size());
+    if (cutPlayback && initialized) {
+        // Flush the stale samples already handed to DMA
+        i2sOutput.discard();
+        i2s_zero_dma_buffer(I2S_PORT);
+    }
     
-    // Start playback if not already playing and we have chunks
-    if (!playing && !audioQueue.empty()) {
-        startStreamingPlayback();
+    if (purged > 0) {
+        Serial.printf("[SPEAKER] Purged %d chunks up to event ID %u, %d remaining\n", purged, eventId, queueCount);
     }
     
-    return true;
+    return purged;
+}
+
+size_t Speaker::getQueuedChunks() {
+    return queueCount;
 }
 
 void Speaker::finishStreaming() {
     if (streamingMode) {
         streamingFinished = true;
-        Serial.printf("[SPEAKER] Streaming finished, %d chunks remaining in queue\n", audioQueue.size());
+        Serial.printf("[SPEAKER] Streaming finished, %d chunks remaining in queue\n", queueCount);
     }
 }
 
@@ -317,12 +356,11 @@ void Speaker::stop() {
     if (playing) {
         playing = false;
         playbackPosition = 0;
+        i2sOutput.discard();
         
-        // Stop I2S transmission without uninstalling driver
-        if (initialized) {
-            i2s_stop(I2S_PORT);
-            i2s_start(I2S_PORT);  // Restart to clear any pending data
-        }
+        // Stop I2S transmission without uninstalling driver; the next
+        // playback starts it again on cleared buffers
+        setOutput(false);
         
         Serial.println("[SPEAKER] Audio playback stopped");
     }
@@ -340,26 +378,42 @@ void Speaker::stop() {
 }
 
 void Speaker::setVolume(float volume) {
-    this->volume = constrain(volume, 0.0f, 1.0f);
-    Serial.printf("[SPEAKER] Volume set to: %.2f\n", this->volume);
+    // Applied as each frame is played, so it takes effect on queued audio too
+    volumeFilter.setGain(constrain(volume, 0.0f, 1.0f));
+    Serial.printf("[SPEAKER] Volume set to: %.2f\n", volumeFilter.getGain());
 }
 
 float Speaker::getVolume() {
-    return volume;
+    return volumeFilter.getGain();
 }
 
 void Speaker::loop() {
-    if (playing && initialized) {
+    // Writes don't block: fill every free DMA buffer, then wait for the
+    // driver's next I2S_EVENT_TX_DONE
+    dmaFull = false;
+    for (int i = 0; i < SPEAKER_DMA_BUF_COUNT && playing && initialized && !dmaFull; i++) {
+        // The rest of the last frame goes out before anything new is read
+        if (i2sOutput.hasPending()) {
+            i2sOutput.flush();
+            continue;
+        }
+        
         if (streamingMode) {
             // Handle streaming audio playback
             if (!processStreamingAudio()) {
-                // Streaming playback completed
                 playing = false;
-                streamingMode = false;
-                streamingFinished = false;
-                clearAudioQueue();
                 unsigned long playbackDuration = millis() - playbackStartTime;
-                Serial.printf("[SPEAKER] Streaming playback completed in %lu ms\n", playbackDuration);
+                
+                if (streamingFinished) {
+                    // Streaming playback completed
+                    streamingMode = false;
+                    streamingFinished = false;
+                    clearAudioQueue();
+                    Serial.printf("[SPEAKER] Streaming playback completed in %lu ms\n", playbackDuration);
+                } else {
+                    // Queue ran dry - stay in streaming mode, next chunk restarts playback
+                    Serial.printf("[SPEAKER] Streaming queue drained after %lu ms, waiting for chunks\n", playbackDuration);
+                }
             }
         } else {
             // Handle regular audio playback
@@ -371,24 +425,50 @@ void Speaker::loop() {
             }
         }
     }
+    
+    if (getMsUntilIdle() == 0) {
+        setOutput(false);
+    }
 }
 
 void Speaker::clearBuffer() {
     if (playing) {
         stop();
     }
-    freeAudioBuffer();
     clearAudioQueue();
     playbackPosition = 0;
     Serial.println("[SPEAKER] Audio buffer and queue cleared");
 }
 
+QueueHandle_t Speaker::getEventQueue() const {
+    return eventQueue;
+}
+
+uint32_t Speaker::getSamplesWritten() const {
+    return samplesWritten;
+}
+
+uint32_t Speaker::getMsUntilIdle() const {
+    if (playing || !outputRunning) {
+        return UINT32_MAX;
+    }
+
+    // Every DMA buffer still holds audio until it has been sent once
+    uint32_t drainMs = (uint32_t)((uint64_t)SPEAKER_DMA_BUF_COUNT * bufferLen * 1000 / sampleRate) + 1;
+    uint32_t elapsedMs = millis() - lastWriteMs;
+    return elapsedMs < drainMs ? drainMs - elapsedMs : 0;
+}
+
 void Speaker::getPlaybackStats(size_t& totalSamples, size_t& currentPosition, uint32_t& sampleRate) {
     totalSamples = this->audioSamples;
     currentPosition = this->playbackPosition;
     sampleRate = this->sampleRate;
 }
 
+const AudioGraph& Speaker::getAudioGraph() const {
+    return playbackGraph;
+}
+
 bool Speaker::installI2S() {
     const i2s_config_t i2s_config = {
         .mode = i2s_mode_t(I2S_MODE_MASTER | I2S_MODE_TX),
@@ -397,12 +477,14 @@ bool Speaker::installI2S() {
         .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,  // Better DAC compatibility
         .communication_format = i2s_comm_format_t(I2S_COMM_FORMAT_STAND_I2S),
         .intr_alloc_flags = 0,
-        .dma_buf_count = 6,
+        .dma_buf_count = SPEAKER_DMA_BUF_COUNT,
         .dma_buf_len = bufferLen,
         .use_apll = false
     };
 
-    esp_err_t err = i2s_driver_install(I2S_PORT, &i2s_config, 0, NULL);
+    // The driver posts I2S_EVENT_TX_DONE each time a DMA buffer is sent,
+    // which is when there is room to write again
+    esp_err_t err = i2s_driver_install(I2S_PORT, &i2s_config, SPEAKER_EVENT_QUEUE_LENGTH, &eventQueue);
     if (err != ESP_OK) {
         Serial.printf("[SPEAKER] ERROR: I2S driver install failed: %s\n", esp_err_to_name(err));
         return false;
@@ -433,165 +515,219 @@ bool Speaker::playbackChunk() {
         return false;  // Playback complete
     }
 
-    // Calculate how many samples to write in this chunk
-    size_t monoSamplesToWrite = min((size_t)bufferLen, audioSamples - playbackPosition);
-    
-    // Since we're using I2S_CHANNEL_FMT_RIGHT_LEFT, we need to duplicate mono samples to stereo
-    // Use pre-allocated stereo buffer to avoid memory fragmentation
-    size_t stereoSamples = monoSamplesToWrite * 2;
-    
-    // Ensure our pre-allocated buffer is large enough
-    if (stereoBuffer == nullptr || stereoSamples * sizeof(int16_t) > stereoBufferSize) {
+    // Read the next bufferLen samples into the stereo buffer, scale and
+    // widen them there, and hand the frame to I2S
+    size_t startPosition = playbackPosition;
+    if (!playbackGraph.run()) {
         Serial.println("[SPEAKER] ERROR: Stereo buffer too small or not allocated");
         return false;
     }
-    
-    // Duplicate mono samples to stereo (L and R channels get same data)
-    for (size_t i = 0; i < monoSamplesToWrite; i++) {
-        stereoBuffer[i * 2] = audioBuffer[playbackPosition + i];     // Left channel
-        stereoBuffer[i * 2 + 1] = audioBuffer[playbackPosition + i]; // Right channel
+    if (i2sOutput.hasFailed()) {
+        return false;
     }
     
-    size_t bytesToWrite = stereoSamples * sizeof(int16_t);
-    size_t bytesWritten = 0;
-    esp_err_t result = i2s_write(I2S_PORT, 
-                                stereoBuffer, 
-                                bytesToWrite, 
-                                &bytesWritten, 
-                                portMAX_DELAY);
-    
-    if (result == ESP_OK && bytesWritten > 0) {
-        size_t stereoSamplesWritten = bytesWritten / sizeof(int16_t);
-        size_t monoSamplesWritten = stereoSamplesWritten / 2;  // Convert back to mono count
-        playbackPosition += monoSamplesWritten;
-
-        // Progress indicator (every second)
-        if ((playbackPosition % sampleRate) < monoSamplesWritten) {
-            float secondsPlayed = (float)playbackPosition / sampleRate;
-            float totalSeconds = (float)audioSamples / sampleRate;
-            Serial.printf("[SPEAKER] Playing: %.1f/%.1f seconds\n", secondsPlayed, totalSeconds);
-        }
+    // Progress indicator (every second)
+    size_t monoSamplesRead = playbackPosition - startPosition;
+    if ((playbackPosition % sampleRate) < monoSamplesRead) {
+        float secondsPlayed = (float)playbackPosition / sampleRate;
+        float totalSeconds = (float)audioSamples / sampleRate;
+        Serial.printf("[SPEAKER] Playing: %.1f/%.1f seconds\n", secondsPlayed, totalSeconds);
+    }
 
-        // Check if playback is complete
-        if (playbackPosition >= audioSamples) {
-            Serial.println("[SPEAKER] Audio playback finished");
-            return false;
-        }
-    } else {
-        Serial.printf("[SPEAKER] ERROR: I2S write failed: %s\n", esp_err_to_name(result));
-        return false;
+    // Check if playback is complete; a remainder waiting for DMA keeps it going
+    if (playbackPosition >= audioSamples) {
+        Serial.println("[SPEAKER] Audio playback finished");
+        return i2sOutput.hasPending();
     }
 
     return true;  // Continue playback
 }
 
-int16_t* Speaker::decodeBase64Audio(const String& base64Data, size_t& decodedSize) {
-    // Calculate required buffer size for base64 decoding
-    size_t requiredLen = 0;
-    int result = mbedtls_base64_decode(NULL, 0, &requiredLen, 
-                                      (const unsigned char*)base64Data.c_str(), base64Data.length());
-    
-    if (result != MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL) {
-        Serial.println("[SPEAKER] ERROR: Invalid base64 data");
-        decodedSize = 0;
-        return nullptr;
+Speaker::PlaybackSource::PlaybackSource(Speaker& speaker) :
+    AudioSource("buffer"),
+    speaker(speaker) {
+}
+
+bool Speaker::PlaybackSource::read(AudioFrame& frame) {
+    if (speaker.audioBuffer == nullptr || speaker.playbackPosition >= speaker.audioSamples) {
+        return false;
     }
     
-    // Allocate buffer for decoded data
-    uint8_t* decodedBytes = (uint8_t*)malloc(requiredLen);
-    if (decodedBytes == nullptr) {
-        Serial.println("[SPEAKER] ERROR: Failed to allocate decode buffer");
-        decodedSize = 0;
-        return nullptr;
-    }
+    // Leave room for the stereo filter to double the frame in place
+    size_t samples = min((size_t)speaker.bufferLen, speaker.audioSamples - speaker.playbackPosition);
+    samples = min(samples, frame.capacity / 2);
+    memcpy(frame.samples, speaker.audioBuffer + speaker.playbackPosition, samples * sizeof(int16_t));
+    frame.count = samples;
+    frame.channels = 1;
+    speaker.playbackPosition += samples;
+    return samples > 0;
+}
 
-    // Perform base64 decoding
-    result = mbedtls_base64_decode(decodedBytes, requiredLen, &decodedSize,
-                                  (const unsigned char*)base64Data.c_str(), base64Data.length());
-    
-    if (result != 0) {
-        Serial.println("[SPEAKER] ERROR: Base64 decode failed");
-        free(decodedBytes);
-        decodedSize = 0;
-        return nullptr;
+Speaker::I2SOutput::I2SOutput(Speaker& speaker) :
+    AudioSink("i2s_out"),
+    speaker(speaker),
+    pending(nullptr),
+    pendingBytes(0),
+    pendingChannels(1),
+    failed(false) {
+}
+
+void Speaker::I2SOutput::consume(const AudioFrame& frame) {
+    failed = false;
+    write((const uint8_t*)frame.samples, frame.count * sizeof(int16_t), frame.channels);
+}
+
+bool Speaker::I2SOutput::hasPending() const {
+    return pendingBytes > 0;
+}
+
+void Speaker::I2SOutput::flush() {
+    if (pendingBytes > 0) {
+        write(pending, pendingBytes, pendingChannels);
     }
+}
 
-    Serial.printf("[SPEAKER] Base64 decode successful: %d bytes\n", decodedSize);
-    
-    // Return as int16_t pointer (PCM audio data)
-    return (int16_t*)decodedBytes;
+void Speaker::I2SOutput::discard() {
+    pending = nullptr;
+    pendingBytes = 0;
 }
 
-void Speaker::applyVolume(int16_t* samples, size_t sampleCount) {
-    if (volume == 1.0f) {
-        return;  // No volume adjustment needed
+bool Speaker::I2SOutput::hasFailed() const {
+    return failed;
+}
+
+void Speaker::I2SOutput::write(const uint8_t* data, size_t bytes, uint8_t channels) {
+    size_t bytesWritten = 0;
+    esp_err_t result = i2s_write(I2S_PORT, data, bytes, &bytesWritten, 0);
+    if (result != ESP_OK) {
+        Serial.printf("[SPEAKER] ERROR: I2S write failed: %s\n", esp_err_to_name(result));
+        failed = true;
+        discard();
+        return;
+    }
+    
+    speaker.samplesWritten += bytesWritten / (sizeof(int16_t) * channels);
+    speaker.lastWriteMs = millis();
+    if (bytesWritten < bytes) {
+        // DMA buffers are full; the rest goes out after the next TX_DONE
+        pending = data + bytesWritten;
+        pendingBytes = bytes - bytesWritten;
+        pendingChannels = channels;
+        speaker.dmaFull = true;
+    } else {
+        discard();
     }
+}
 
-    for (size_t i = 0; i < sampleCount; i++) {
-        int32_t adjustedSample = (int32_t)(samples[i] * volume);
-        
-        // Clamp to int16_t range
-        if (adjustedSample > INT16_MAX) {
-            adjustedSample = INT16_MAX;
-        } else if (adjustedSample < INT16_MIN) {
-            adjustedSample = INT16_MIN;
-        }
-        
-        samples[i] = (int16_t)adjustedSample;
+bool Speaker::attachPlannedBuffers() {
+    if (memoryPlan == nullptr) {
+        return false;
+    }
+    
+    stereoBuffer = (int16_t*)memoryPlan->get(stagingRegion);
+    stereoBufferSize = memoryPlan->getSize(stagingRegion);
+    int16_t* pool = (int16_t*)memoryPlan->get(poolRegion);
+    slotSamples = memoryPlan->getSize(poolRegion) / sizeof(int16_t) / SPEAKER_QUEUE_DEPTH;
+    if (stereoBuffer == nullptr || stereoBufferSize < (size_t)bufferLen * 2 * sizeof(int16_t) ||
+        pool == nullptr || slotSamples == 0) {
+        stereoBuffer = nullptr;
+        stereoBufferSize = 0;
+        return false;
+    }
+    playbackGraph.setBuffer(stereoBuffer, stereoBufferSize / sizeof(int16_t));
+    
+    for (size_t i = 0; i < SPEAKER_QUEUE_DEPTH; i++) {
+        chunkPool[i].data = pool + i * slotSamples;
+        chunkPool[i].capacity = slotSamples;
+        chunkPool[i].samples = 0;
     }
+    return true;
 }
 
-void Speaker::freeAudioBuffer() {
-    if (audioBuffer != nullptr) {
-        free(audioBuffer);
+void Speaker::clearAudioQueue() {
+    if (playingQueuedChunk) {
         audioBuffer = nullptr;
         audioBufferSize = 0;
         audioSamples = 0;
+        playingQueuedChunk = false;
     }
+    
+    // Slots keep their buffers for reuse
+    queueHead = 0;
+    queueCount = 0;
 }
 
-bool Speaker::allocateStereoBuffer(size_t maxStereoSamples) {
-    if (stereoBuffer != nullptr) {
-        return true; // Already allocated
+size_t Speaker::slotsFor(size_t samples) {
+    if (slotSamples == 0) {
+        Serial.println("[SPEAKER] ERROR: Chunk pool not attached");
+        return 0;
     }
     
-    stereoBufferSize = maxStereoSamples * sizeof(int16_t);
-    stereoBuffer = (int16_t*)malloc(stereoBufferSize);
-    if (stereoBuffer == nullptr) {
-        Serial.print("Failed to allocate stereo buffer. Requested size: ");
-        Serial.print(stereoBufferSize);
-        Serial.print(" bytes. Available memory: ");
-        Serial.print(ESP.getFreeHeap());
-        Serial.println(" bytes.");
-        stereoBufferSize = 0;
-        return false;
+    size_t slots = (samples + slotSamples - 1) / slotSamples;
+    if (queueCount + slots > SPEAKER_QUEUE_DEPTH) {
+        Serial.printf("[SPEAKER] ERROR: Chunk queue full (%d of %d slots used, %d needed)\n", queueCount,
+                      SPEAKER_QUEUE_DEPTH, slots);
+        return 0;
     }
+    return slots;
+}
+
+AudioChunk* Speaker::acquireChunkSlot(size_t ahead) {
+    if (queueCount + ahead >= SPEAKER_QUEUE_DEPTH) {
+        return nullptr;
+    }
+    return &chunkPool[(queueHead + queueCount + ahead) % SPEAKER_QUEUE_DEPTH];
+}
+
+void Speaker::commitChunkSlots(size_t count) {
+    queueCount += count;
     
-    return true;
+    // Start playback if not already playing
+    if (!playing) {
+        startStreamingPlayback();
+    }
 }
 
-void Speaker::freeStereoBuffer() {
-    if (stereoBuffer != nullptr) {
-        free(stereoBuffer);
-        stereoBuffer = nullptr;
-        stereoBufferSize = 0;
+void Speaker::releaseHeadChunk() {
+    if (queueCount == 0) {
+        return;
+    }
+    
+    if (playingQueuedChunk) {
+        audioBuffer = nullptr;
+        audioBufferSize = 0;
+        audioSamples = 0;
+        playbackPosition = 0;
+        playingQueuedChunk = false;
     }
+    
+    chunkPool[queueHead].samples = 0;
+    queueHead = (queueHead + 1) % SPEAKER_QUEUE_DEPTH;
+    queueCount--;
 }
 
-void Speaker::clearAudioQueue() {
-    while (!audioQueue.empty()) {
-        AudioChunk* chunk = audioQueue.front();
-        audioQueue.pop();
-        delete chunk;
+void Speaker::setOutput(bool on) {
+    if (!initialized || on == outputRunning) {
+        return;
     }
+
+    if (!on) {
+        i2s_stop(I2S_PORT);
+        i2s_zero_dma_buffer(I2S_PORT);
+    } else if (i2s_start(I2S_PORT) != ESP_OK) {
+        Serial.println("[SPEAKER] ERROR: Failed to start I2S");
+        return;
+    }
+    outputRunning = on;
 }
 
 void Speaker::startStreamingPlayback() {
-    if (audioQueue.empty()) {
+    if (queueCount == 0) {
         Serial.println("[SPEAKER] WARNING: No audio chunks to play");
         return;
     }
     
+    setOutput(true);
     playing = true;
     playbackStartTime = millis();
     Serial.println("[SPEAKER] Started streaming playback");
@@ -599,39 +735,32 @@ void Speaker::startStreamingPlayback() {
 
 bool Speaker::processStreamingAudio() {
     // If current chunk is finished, move to next chunk
-    if (audioBuffer == nullptr || playbackPosition >= audioSamples) {
-        // Free current chunk
-        freeAudioBuffer();
+    if (!playingQueuedChunk || playbackPosition >= audioSamples) {
+        // Return the finished chunk's slot to the pool
+        if (playingQueuedChunk) {
+            releaseHeadChunk();
+        }
         
-        // Get next chunk from queue
-        if (!audioQueue.empty()) {
-            AudioChunk* chunk = audioQueue.front();
-            audioQueue.pop();
-            
-            // Set up for playback
-            audioBuffer = chunk->data;
-            audioSamples = chunk->samples;
-            audioBufferSize = chunk->samples * sizeof(int16_t);
-            playbackPosition = 0;
-            
-            Serial.printf("[SPEAKER] Playing chunk: %d samples, event ID: %u, %d chunks remaining\n", 
-                          chunk->samples, chunk->eventId, audioQueue.size());
-            
-            // Don't delete chunk data as we're using it, just delete the container
-            chunk->data = nullptr; // Prevent destructor from freeing the data
-            delete chunk;
-        } else if (streamingFinished) {
-            // No more chunks and streaming is finished
+        if (queueCount == 0) {
+            // Nothing left to play (streamingFinished decides what happens next)
             return false;
-        } else {
-            // No chunks available but streaming not finished, keep waiting
-            return true;
         }
+        
+        // Play the next chunk straight out of its slot
+        AudioChunk& chunk = chunkPool[queueHead];
+        audioBuffer = chunk.data;
+        audioSamples = chunk.samples;
+        audioBufferSize = chunk.samples * sizeof(int16_t);
+        playbackPosition = 0;
+        playingQueuedChunk = true;
+        
+        Serial.printf("[SPEAKER] Playing chunk: %d samples, event ID: %u, %d chunks remaining\n", 
+                      chunk.samples, chunk.eventId, queueCount - 1);
     }
     
-    // Play current chunk
-    if (audioBuffer != nullptr && playbackPosition < audioSamples) {
-        return playbackChunk();
+    // Play current chunk - reaching its end is not the end of the stream
+    if (!playbackChunk() && playbackPosition < audioSamples) {
+        return false;  // I2S write failed
     }
     
     return true;
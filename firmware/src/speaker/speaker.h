@@ -3,24 +3,30 @@
 
 #include <driver/i2s.h>
 #include <Arduino.h>
-#include <queue>
+#include "../communication/interrupt_sink.h"
+#include "../audio/audio_graph.h"
+#include "../system/memory_plan.h"
 
-// Audio chunk structure for streaming
+#ifndef SPEAKER_QUEUE_DEPTH
+#define SPEAKER_QUEUE_DEPTH 32  // Streaming chunks that can be queued at once
+#endif
+
+#ifndef SPEAKER_SLOT_MS
+#define SPEAKER_SLOT_MS 500     // Audio per pool slot; a longer chunk takes several slots
+#endif
+
+#define SPEAKER_DMA_BUF_COUNT 6
+#define SPEAKER_EVENT_QUEUE_LENGTH 8  // I2S driver events (one per DMA buffer sent)
+
+// Audio chunk slot in the streaming pool. The sample buffer is the slot's
+// fixed share of the planned speaker pool, reused for every chunk that lands in it.
 struct AudioChunk {
     int16_t* data;
-    size_t samples;
+    size_t capacity;   // Samples the buffer can hold
+    size_t samples;    // Samples currently stored
     uint32_t eventId;  // For tracking ElevenLabs event order
     
-    AudioChunk() : data(nullptr), samples(0), eventId(0) {}
-    AudioChunk(int16_t* audioData, size_t sampleCount, uint32_t id = 0) 
-        : data(audioData), samples(sampleCount), eventId(id) {}
-    
-    ~AudioChunk() {
-        if (data) {
-            free(data);
-            data = nullptr;
-        }
-    }
+    AudioChunk() : data(nullptr), capacity(0), samples(0), eventId(0) {}
 };
 
 /**
@@ -31,7 +37,7 @@ struct AudioChunk {
  * an I2S DAC/amplifier, managing audio buffers, and handling real-time playback.
  * Optimized for ElevenLabs Conversational AI audio responses.
  */
-class Speaker {
+class Speaker : public InterruptSink {
 public:
     /**
      * @brief Constructor - initializes speaker with default settings
@@ -44,7 +50,18 @@ public:
     ~Speaker();
 
     /**
-     * @brief Initialize the I2S speaker with specified parameters
+     * @brief Reserve the chunk pool and DMA staging buffer in the boot-time
+     *        memory plan; call before the plan is committed
+     * @param plan Plan to add the regions to
+     * @param sampleRate Sample rate begin() will be called with
+     * @param bufferLen DMA buffer length begin() will be called with
+     * @return true if the regions were added
+     */
+    bool reserveMemory(MemoryPlan& plan, uint32_t sampleRate = 24000, int bufferLen = 1024);
+
+    /**
+     * @brief Initialize the I2S speaker with specified parameters; the
+     *        memory plan must be committed by now
      * @param sampleRate Sample rate for playback (default from config.h: 24000Hz)
      * @param bitsPerSample Bits per sample (16-bit)
      * @param bufferLen DMA buffer length for playback
@@ -53,14 +70,15 @@ public:
     bool begin(uint32_t sampleRate = 24000, uint8_t bitsPerSample = 16, int bufferLen = 1024);
 
     /**
-     * @brief Play audio data from base64 encoded string (ElevenLabs format)
+     * @brief Play audio data from base64 encoded string (ElevenLabs format).
+     *        Played from the chunk pool, so it must fit in it
      * @param base64AudioData Base64 encoded PCM audio data
      * @return true if playback started successfully, false otherwise
      */
     bool playBase64Audio(const String& base64AudioData);
 
     /**
-     * @brief Play raw PCM audio data
+     * @brief Play raw PCM audio data; copied into the chunk pool, so it must fit in it
      * @param audioData Pointer to PCM audio samples
      * @param audioSize Size of audio data in bytes
      * @return true if playback started successfully, false otherwise
@@ -82,7 +100,8 @@ public:
     bool startStreamingAudio();
 
     /**
-     * @brief Add an audio chunk for streaming playback
+     * @brief Add an audio chunk for streaming playback; one longer than
+     *        SPEAKER_SLOT_MS is decoded across several slots
      * @param base64AudioData Base64 encoded PCM audio chunk
      * @param eventId ElevenLabs event ID for ordering
      * @return true if chunk added successfully, false otherwise
@@ -90,7 +109,8 @@ public:
     bool addAudioChunk(const String& base64AudioData, uint32_t eventId = 0);
 
     /**
-     * @brief Add raw audio chunk for streaming playback
+     * @brief Add raw audio chunk for streaming playback; one longer than
+     *        SPEAKER_SLOT_MS is split across several slots
      * @param audioData Pointer to PCM audio samples
      * @param audioSize Size of audio data in bytes
      * @param eventId ElevenLabs event ID for ordering
@@ -98,6 +118,24 @@ public:
      */
     bool addRawAudioChunk(const int16_t* audioData, size_t audioSize, uint32_t eventId = 0);
 
+    /**
+     * @brief Drop queued streaming chunks with an event ID at or below the threshold
+     *
+     * Event IDs arrive in increasing order, so only the k stale chunks at the
+     * head of the queue are touched. Their slots go back to the pool. If the
+     * chunk being played is stale, output is cut at the current DMA buffer.
+     *
+     * @param eventId Interruption event ID
+     * @return Number of chunks dropped (including the one playing, if any)
+     */
+    size_t purgeUpToEvent(uint32_t eventId) override;
+
+    /**
+     * @brief Get number of streaming chunks queued (including the one playing)
+     * @return Queued chunk count
+     */
+    size_t getQueuedChunks();
+
     /**
      * @brief Finish streaming mode and play remaining chunks
      */
@@ -121,7 +159,7 @@ public:
     void stop();
 
     /**
-     * @brief Set audio volume (0.0 to 1.0)
+     * @brief Set audio volume (0.0 to 1.0); safe from any task
      * @param volume Volume level (0.0 = mute, 1.0 = full volume)
      */
     void setVolume(float volume);
@@ -134,10 +172,30 @@ public:
 
     /**
      * @brief Main loop function for audio playback management
-     * Call this repeatedly in the main loop when playing audio
+     * Call this repeatedly in the main loop when playing audio. Never blocks:
+     * it fills the free DMA buffers and returns.
      */
     void loop();
 
+    /**
+     * @brief I2S driver event queue; an I2S_EVENT_TX_DONE means loop() can write again
+     * @return Queue handle, or nullptr before begin()
+     */
+    QueueHandle_t getEventQueue() const;
+
+    /**
+     * @brief Mono samples handed to the I2S driver since begin(); a change
+     *        means audio reached the DMA buffers
+     */
+    uint32_t getSamplesWritten() const;
+
+    /**
+     * @brief Time until loop() stops the idle I2S channel, once the last
+     *        samples have left the DMA buffers
+     * @return Milliseconds, 0 if due now, UINT32_MAX while playing or stopped
+     */
+    uint32_t getMsUntilIdle() const;
+
     /**
      * @brief Clear any queued audio and reset playback state
      */
@@ -151,7 +209,48 @@ public:
      */
     void getPlaybackStats(size_t& totalSamples, size_t& currentPosition, uint32_t& sampleRate);
 
+    /**
+     * @brief Playback graph (buffer -> volume -> stereo -> I2S), for its
+     *        per-node cycle statistics
+     */
+    const AudioGraph& getAudioGraph() const;
+
 private:
+    /**
+     * @brief Graph source: the next bufferLen samples of the buffer being played
+     */
+    class PlaybackSource : public AudioSource {
+    public:
+        explicit PlaybackSource(Speaker& speaker);
+        bool read(AudioFrame& frame) override;
+
+    private:
+        Speaker& speaker;
+    };
+
+    /**
+     * @brief Graph sink: non-blocking I2S write. What the DMA buffers can't
+     *        take stays in the frame and goes out first on the next loop()
+     */
+    class I2SOutput : public AudioSink {
+    public:
+        explicit I2SOutput(Speaker& speaker);
+        void consume(const AudioFrame& frame) override;
+        bool hasPending() const;
+        void flush();
+        void discard();
+        bool hasFailed() const;
+
+    private:
+        Speaker& speaker;
+        const uint8_t* pending;
+        size_t pendingBytes;
+        uint8_t pendingChannels;
+        bool failed;
+
+        void write(const uint8_t* data, size_t bytes, uint8_t channels);
+    };
+
     // I2S pin configuration for audio output
     static const int I2S_WS_PIN = 45;   // LRC (Left/Right Clock)
     static const int I2S_SD_PIN = 48;   // DIN (Data Input)
@@ -162,20 +261,36 @@ private:
     uint32_t sampleRate;
     uint8_t bitsPerSample;
     int bufferLen;
-    float volume;
     
-    // Audio buffers
+    // Memory plan regions
+    MemoryPlan* memoryPlan;
+    int poolRegion;
+    int stagingRegion;
+    
+    // Audio buffers; audioBuffer is the slot being played
     int16_t* audioBuffer;
     size_t audioBufferSize;
     size_t audioSamples;
     size_t playbackPosition;
     
-    // Stereo conversion buffer (pre-allocated to avoid fragmentation)
+    // Stereo conversion buffer (DMA staging, from the plan); each frame is
+    // read, scaled and widened in place here
     int16_t* stereoBuffer;
     size_t stereoBufferSize;
     
-    // Streaming audio support
-    std::queue<AudioChunk*> audioQueue;
+    // Playback graph
+    PlaybackSource playbackSource;
+    GainFilter volumeFilter;
+    MonoToStereoFilter stereoFilter;
+    I2SOutput i2sOutput;
+    AudioGraph playbackGraph;
+    
+    // Streaming audio support - fixed ring of reusable chunk slots
+    AudioChunk chunkPool[SPEAKER_QUEUE_DEPTH];
+    size_t slotSamples;
+    size_t queueHead;
+    size_t queueCount;
+    bool playingQueuedChunk;  // audioBuffer points into chunkPool[queueHead]
     bool streamingMode;
     bool streamingFinished;
     uint32_t expectedEventId;  // For ensuring proper chunk ordering
@@ -183,7 +298,12 @@ private:
     // State management
     bool initialized;
     bool playing;
+    bool outputRunning;     // I2S channel running; stopped soon after playback ends
+    uint32_t lastWriteMs;
     unsigned long playbackStartTime;
+    QueueHandle_t eventQueue;
+    bool dmaFull;  // Last write didn't fit; wait for TX_DONE
+    uint32_t samplesWritten;
 
     /**
      * @brief Install and configure I2S driver for output
@@ -204,58 +324,48 @@ private:
     bool playbackChunk();
 
     /**
-     * @brief Decode base64 audio data to PCM samples
-     * @param base64Data Base64 encoded audio string
-     * @param decodedSize Reference to store decoded data size
-     * @return Pointer to decoded PCM data
-     * 
-     * @warning MEMORY OWNERSHIP: The returned pointer is allocated with malloc()
-     *          and MUST be freed by the caller using free(). Failure to do so
-     *          will result in memory leaks.
-     * 
-     * @note The caller is responsible for:
-     *       1. Checking if the returned pointer is not nullptr
-     *       2. Using the data before freeing it
-     *       3. Calling free() on the returned pointer when done
-     * 
-     * @example
-     *   size_t size;
-     *   int16_t* data = decodeBase64Audio(base64String, size);
-     *   if (data != nullptr) {
-     *       // Use the data...
-     *       free(data);  // Must free when done
-     *   }
+     * @brief Take the stereo buffer and carve the chunk slots out of the plan
+     * @return true if both regions are there and big enough
      */
-    int16_t* decodeBase64Audio(const String& base64Data, size_t& decodedSize);
+    bool attachPlannedBuffers();
 
     /**
-     * @brief Apply volume adjustment to audio samples
-     * @param samples Pointer to audio samples
-     * @param sampleCount Number of samples to process
+     * @brief Clear all queued audio chunks (slots keep their buffers)
      */
-    void applyVolume(int16_t* samples, size_t sampleCount);
+    void clearAudioQueue();
 
     /**
-     * @brief Free allocated audio buffer
+     * @brief Check that the queue has room for a chunk of this many samples
+     * @return Number of slots it takes, or 0 if it doesn't fit
      */
-    void freeAudioBuffer();
+    size_t slotsFor(size_t samples);
 
     /**
-     * @brief Allocate stereo conversion buffer
-     * @param maxStereoSamples Maximum number of stereo samples the buffer should hold
-     * @return true if allocation successful, false otherwise
+     * @brief Reserve a free slot in the chunk pool; check slotsFor() first
+     * @param ahead Free slots to skip, for filling several before committing them
+     * @return Pointer to the slot, or nullptr if the queue is full
      */
-    bool allocateStereoBuffer(size_t maxStereoSamples);
+    AudioChunk* acquireChunkSlot(size_t ahead = 0);
 
     /**
-     * @brief Free stereo conversion buffer
+     * @brief Queue the next count slots filled through acquireChunkSlot() and
+     * start playback if idle
      */
-    void freeStereoBuffer();
+    void commitChunkSlots(size_t count);
 
     /**
-     * @brief Clear all queued audio chunks
+     * @brief Return the slot at the head of the queue to the pool
      */
-    void clearAudioQueue();
+    void releaseHeadChunk();
+
+    /**
+     * @brief Start or stop the I2S channel. A running channel holds the
+     *        driver's PM lock and raises a DMA event per buffer, so it
+     *        only runs while there is audio to send
+     * @param on true to start; false also zeroes the DMA buffers so a
+     *        restart doesn't replay stale samples
+     */
+    void setOutput(bool on);
 
     /**
      * @brief Start streaming playback from queue
@@ -0,0 +1,122 @@
+#include "boot_timeline.h"
+#include <stdio.h>
+
+BootTimeline::BootTimeline() :
+    phaseCount(0),
+    readyMs(0),
+    ready(false) {
+}
+
+int BootTimeline::begin(const char* name, uint32_t nowMs) {
+    if (phaseCount >= BOOT_MAX_PHASES) {
+        return -1;
+    }
+    phases[phaseCount] = {name, nowMs, nowMs, false, true};
+    return (int)phaseCount++;
+}
+
+void BootTimeline::end(int phase, uint32_t nowMs, bool ok) {
+    if (phase < 0 || (size_t)phase >= phaseCount || phases[phase].ended) {
+        return;
+    }
+    phases[phase].endMs = nowMs;
+    phases[phase].ended = true;
+    phases[phase].ok = ok;
+}
+
+void BootTimeline::markReady(uint32_t nowMs) {
+    if (!ready) {
+        readyMs = nowMs;
+        ready = true;
+    }
+}
+
+bool BootTimeline::isReady() const {
+    return ready;
+}
+
+uint32_t BootTimeline::getReadyMs() const {
+    return readyMs;
+}
+
+size_t BootTimeline::getPhaseCount() const {
+    return phaseCount;
+}
+
+uint32_t BootTimeline::getPhaseMs(size_t index) const {
+    if (index >= phaseCount || !phases[index].ended) {
+        return 0;
+    }
+    return phases[index].endMs - phases[index].startMs;
+}
+
+size_t BootTimeline::formatPhase(size_t index, char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+    if (index >= phaseCount) {
+        out[0] = '\0';
+        return 0;
+    }
+
+    const Phase& phase = phases[index];
+    int written;
+    if (!phase.ended) {
+        written = snprintf(out, size, "%-12s %5lu -> running", phase.name, (unsigned long)phase.startMs);
+    } else {
+        written = snprintf(out, size, "%-12s %5lu -> %5lu ms %5lu ms", phase.name, (unsigned long)phase.startMs,
+                           (unsigned long)phase.endMs, (unsigned long)(phase.endMs - phase.startMs));
+    }
+
+    // Bar over [0, ready]; a phase still running or ending after ready is cut at the edge
+    uint32_t spanMs = ready ? readyMs : 0;
+    if (phase.ended && phase.endMs > spanMs) {
+        spanMs = phase.endMs;
+    }
+    if (spanMs > 0 && written >= 0 && (size_t)written + BOOT_TIMELINE_WIDTH + 3 < size) {
+        uint32_t endMs = phase.ended ? phase.endMs : spanMs;
+        size_t from = (size_t)((uint64_t)phase.startMs * BOOT_TIMELINE_WIDTH / spanMs);
+        size_t to = (size_t)((uint64_t)endMs * BOOT_TIMELINE_WIDTH / spanMs);
+        if (to == from && to < BOOT_TIMELINE_WIDTH) {
+            to++;   // Short phases still get one column
+        }
+        out[written++] = ' ';
+        out[written++] = '|';
+        for (size_t column = 0; column < BOOT_TIMELINE_WIDTH; column++) {
+            out[written++] = (column >= from && column < to) ? '#' : ' ';
+        }
+        out[written++] = '|';
+        out[written] = '\0';
+    }
+    if (!phase.ok && written >= 0 && (size_t)written < size) {
+        written += snprintf(out + written, size - written, " FAILED");
+    }
+
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+size_t BootTimeline::format(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = ready ? snprintf(out, size, "BOOT ready=%lums |", (unsigned long)readyMs)
+                        : snprintf(out, size, "BOOT ready=- |");
+    for (size_t i = 0; i < phaseCount && written >= 0 && (size_t)written < size; i++) {
+        if (phases[i].ended) {
+            written += snprintf(out + written, size - written, " %s=%lu%s", phases[i].name,
+                                (unsigned long)getPhaseMs(i), phases[i].ok ? "" : "!");
+        } else {
+            written += snprintf(out + written, size - written, " %s=-", phases[i].name);
+        }
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
@@ -0,0 +1,81 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef BOOT_MAX_PHASES
+#define BOOT_MAX_PHASES 12
+#endif
+
+#ifndef BOOT_TIMELINE_WIDTH
+#define BOOT_TIMELINE_WIDTH 40          // Columns of the bar drawn for each phase
+#endif
+
+/**
+ * @class BootTimeline
+ * @brief Records when each boot phase started and ended, so overlapping
+ *        phases and the time to ready can be read off one printout.
+ *
+ * Phases may overlap: Wi-Fi association runs while the audio drivers come
+ * up, so each phase keeps its own start and end rather than being a lap of
+ * the previous one. Times are milliseconds since reset.
+ */
+class BootTimeline {
+public:
+    BootTimeline();
+
+    /**
+     * @brief Start a phase
+     * @param name Must outlive the timeline
+     * @return Phase id for end(), -1 if BOOT_MAX_PHASES are in use
+     */
+    int begin(const char* name, uint32_t nowMs);
+
+    /**
+     * @brief End a phase; ignored for an invalid or already ended id
+     */
+    void end(int phase, uint32_t nowMs, bool ok = true);
+
+    /**
+     * @brief Record the time the device became ready; only the first call counts
+     */
+    void markReady(uint32_t nowMs);
+
+    bool isReady() const;
+    uint32_t getReadyMs() const;
+
+    size_t getPhaseCount() const;
+    uint32_t getPhaseMs(size_t index) const;     // Duration, 0 while running
+
+    /**
+     * @brief Format one phase with a bar scaled to the time to ready, e.g.
+     *        "wifi            40 ->  2390 ms  2350 ms |#################       |"
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t formatPhase(size_t index, char* out, size_t size) const;
+
+    /**
+     * @brief The line printed once the device is ready: time to ready, then
+     *        each phase's duration in begin() order, e.g.
+     *        "BOOT ready=2900ms | wifi=2350 microphone=35 speaker=60 network=480"
+     * @return Length of the line in out
+     */
+    size_t format(char* out, size_t size) const;
+
+private:
+    struct Phase {
+        const char* name;
+        uint32_t startMs;
+        uint32_t endMs;
+        bool ended;
+        bool ok;
+    };
+
+    Phase phases[BOOT_MAX_PHASES];
+    size_t phaseCount;
+    uint32_t readyMs;
+    bool ready;
+};
+
+#endif
@@ -0,0 +1,309 @@
+#include "command_shell.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+CommandShell* CommandShell::replying = nullptr;
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static bool equalsIgnoreCase(const char* a, const char* b) {
+    while (*a && *b) {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) {
+            return false;
+        }
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+CommandShell::CommandShell() :
+    commandCount(0),
+    mode(1),
+    fallback(nullptr),
+    writer(nullptr),
+    metricsProvider(nullptr),
+    lineLength(0),
+    lineOverflow(false),
+    rxState(RX_TEXT),
+    frameLength(0),
+    frameExpected(0),
+    lastByteMs(0),
+    replySeq(0) {
+    resetStats();
+}
+
+bool CommandShell::registerCommand(const char* name, ShellHandler handler, uint8_t modes) {
+    if (name == nullptr || handler == nullptr || commandCount >= SHELL_MAX_COMMANDS) {
+        return false;
+    }
+    commands[commandCount].name = name;
+    commands[commandCount].handler = handler;
+    commands[commandCount].modes = modes;
+    commandCount++;
+    return true;
+}
+
+void CommandShell::setMode(uint8_t mode) {
+    this->mode = mode;
+}
+
+uint8_t CommandShell::getMode() const {
+    return mode;
+}
+
+void CommandShell::onFallback(ShellFallback fallback) {
+    this->fallback = fallback;
+}
+
+void CommandShell::setWriter(ShellWriter writer) {
+    this->writer = writer;
+}
+
+void CommandShell::setMetricsProvider(ShellMetricsProvider provider) {
+    metricsProvider = provider;
+}
+
+void CommandShell::feed(const uint8_t* data, size_t size, uint32_t nowMs) {
+    for (size_t i = 0; i < size; i++) {
+        // The sender went away mid-frame; what follows is text again
+        if (rxState != RX_TEXT && (int32_t)(nowMs - lastByteMs) > SHELL_FRAME_TIMEOUT_MS) {
+            badFrames++;
+            rxState = RX_TEXT;
+        }
+        lastByteMs = nowMs;
+
+        if (rxState == RX_TEXT) {
+            feedText(data[i]);
+        } else {
+            feedFrame(data[i]);
+        }
+    }
+}
+
+uint8_t CommandShell::execute(char* text) {
+    // Trim in place
+    while (isSpace(*text)) {
+        text++;
+    }
+    size_t length = strlen(text);
+    while (length > 0 && isSpace(text[length - 1])) {
+        text[--length] = '\0';
+    }
+    if (length == 0) {
+        return SHELL_STATUS_OK;
+    }
+
+    // The name ends at the first space; the rest are the arguments
+    char* args = text;
+    while (*args && !isSpace(*args)) {
+        args++;
+    }
+    char* nameEnd = args;
+    char separator = *nameEnd;
+    if (*args) {
+        *args++ = '\0';
+        while (isSpace(*args)) {
+            args++;
+        }
+    }
+
+    for (size_t i = 0; i < commandCount; i++) {
+        if ((commands[i].modes & mode) && equalsIgnoreCase(commands[i].name, text)) {
+            commands[i].handler(args);
+            return SHELL_STATUS_OK;
+        }
+    }
+
+    *nameEnd = separator;
+    if (fallback != nullptr) {
+        fallback(text);
+    }
+    return SHELL_STATUS_UNKNOWN;
+}
+
+bool CommandShell::sendFrame(uint8_t type, uint8_t seq, const uint8_t* payload, size_t length) {
+    if (writer == nullptr || length > SHELL_FRAME_MAX_PAYLOAD) {
+        return false;
+    }
+
+    // One write, so log output from other tasks can't land inside the frame
+    uint8_t out[SHELL_FRAME_OVERHEAD + SHELL_FRAME_MAX_PAYLOAD];
+    out[0] = SHELL_FRAME_SYNC;
+    out[1] = type;
+    out[2] = seq;
+    out[3] = (uint8_t)length;
+    out[4] = (uint8_t)(length >> 8);
+    if (length > 0) {
+        memcpy(out + SHELL_FRAME_HEADER_SIZE, payload, length);
+    }
+    uint16_t crc = crc16(out + 1, SHELL_FRAME_HEADER_SIZE - 1 + length);
+    out[SHELL_FRAME_HEADER_SIZE + length] = (uint8_t)crc;
+    out[SHELL_FRAME_HEADER_SIZE + length + 1] = (uint8_t)(crc >> 8);
+
+    size_t total = SHELL_FRAME_OVERHEAD + length;
+    return writer(out, total) == total;
+}
+
+uint32_t CommandShell::getLineCount() const {
+    return lines;
+}
+
+uint32_t CommandShell::getFrameCount() const {
+    return frames;
+}
+
+uint32_t CommandShell::getBadFrameCount() const {
+    return badFrames;
+}
+
+uint32_t CommandShell::getOverflowCount() const {
+    return overflows;
+}
+
+void CommandShell::resetStats() {
+    lines = 0;
+    frames = 0;
+    badFrames = 0;
+    overflows = 0;
+}
+
+size_t CommandShell::format(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "SHELL lines=%lu frames=%lu bad=%lu overflow=%lu",
+                           (unsigned long)lines, (unsigned long)frames,
+                           (unsigned long)badFrames, (unsigned long)overflows);
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+uint16_t CommandShell::crc16(const uint8_t* data, size_t size, uint16_t crc) {
+    for (size_t i = 0; i < size; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void CommandShell::feedText(uint8_t byte) {
+    if (byte == '\n' || byte == '\r') {
+        endLine();
+    } else if (byte == SHELL_FRAME_SYNC && lineLength == 0 && !lineOverflow) {
+        rxState = RX_HEADER;
+        frameLength = 0;
+    } else if (byte == '\b' || byte == 0x7F) {
+        if (lineLength > 0) {
+            lineLength--;
+        }
+    } else if (lineLength < SHELL_LINE_MAX) {
+        line[lineLength++] = (char)byte;
+    } else {
+        lineOverflow = true;
+    }
+}
+
+void CommandShell::feedFrame(uint8_t byte) {
+    frame[frameLength++] = byte;
+
+    if (rxState == RX_HEADER) {
+        if (frameLength < SHELL_FRAME_HEADER_SIZE - 1) {
+            return;
+        }
+        size_t payloadLength = frame[2] | ((size_t)frame[3] << 8);
+        if (payloadLength > SHELL_FRAME_MAX_PAYLOAD) {
+            badFrames++;
+            rxState = RX_TEXT;
+            return;
+        }
+        frameExpected = SHELL_FRAME_OVERHEAD - 1 + payloadLength;
+        rxState = RX_BODY;
+        return;
+    }
+
+    if (frameLength < frameExpected) {
+        return;
+    }
+    rxState = RX_TEXT;
+
+    size_t covered = frameExpected - 2;
+    uint16_t crc = frame[covered] | ((uint16_t)frame[covered + 1] << 8);
+    if (crc != crc16(frame, covered)) {
+        badFrames++;
+        return;
+    }
+    frames++;
+    handleFrame();
+}
+
+void CommandShell::endLine() {
+    if (lineOverflow) {
+        overflows++;
+    } else if (lineLength > 0) {
+        line[lineLength] = '\0';
+        lines++;
+        execute(line);
+    }
+    lineLength = 0;
+    lineOverflow = false;
+}
+
+void CommandShell::handleFrame() {
+    uint8_t type = frame[0];
+    uint8_t seq = frame[1];
+    const uint8_t* payload = frame + SHELL_FRAME_HEADER_SIZE - 1;
+    size_t length = frameExpected - SHELL_FRAME_OVERHEAD + 1;
+    uint8_t status = SHELL_STATUS_BAD_REQUEST;
+
+    switch (type) {
+        case SHELL_FRAME_PING:
+            sendFrame(SHELL_FRAME_PING | SHELL_FRAME_REPLY, seq, payload, length);
+            return;
+
+        case SHELL_FRAME_COMMAND:
+            if (length <= SHELL_LINE_MAX) {
+                char text[SHELL_LINE_MAX + 1];
+                memcpy(text, payload, length);
+                text[length] = '\0';
+                status = execute(text);
+            }
+            sendFrame(SHELL_FRAME_COMMAND | SHELL_FRAME_REPLY, seq, &status, 1);
+            return;
+
+        case SHELL_FRAME_METRICS:
+            if (metricsProvider != nullptr) {
+                replying = this;
+                replySeq = seq;
+                metricsProvider(emitMetricsLine);
+                replying = nullptr;
+            }
+            // An empty reply ends the dump
+            sendFrame(SHELL_FRAME_METRICS | SHELL_FRAME_REPLY, seq, nullptr, 0);
+            return;
+
+        default:
+            sendFrame(type | SHELL_FRAME_REPLY, seq, &status, 1);
+            return;
+    }
+}
+
+void CommandShell::emitMetricsLine(const char* text) {
+    if (replying == nullptr) {
+        return;
+    }
+    size_t length = strlen(text);
+    if (length > SHELL_FRAME_MAX_PAYLOAD) {
+        length = SHELL_FRAME_MAX_PAYLOAD;
+    }
+    replying->sendFrame(SHELL_FRAME_METRICS | SHELL_FRAME_REPLY, replying->replySeq, (const uint8_t*)text, length);
+}
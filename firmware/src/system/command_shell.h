@@ -0,0 +1,194 @@
+#ifndef COMMAND_SHELL_H
+#define COMMAND_SHELL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SHELL_LINE_MAX
+#define SHELL_LINE_MAX 64               // Longer lines are dropped whole, never run truncated
+#endif
+
+#ifndef SHELL_MAX_COMMANDS
+#define SHELL_MAX_COMMANDS 16
+#endif
+
+#ifndef SHELL_FRAME_MAX_PAYLOAD
+#define SHELL_FRAME_MAX_PAYLOAD 256     // Request and reply frames; one telemetry line fits
+#endif
+
+#ifndef SHELL_BYTES_PER_LOOP
+#define SHELL_BYTES_PER_LOOP 256        // Read per loop() iteration; a burst is spread over several
+#endif
+
+#ifndef SHELL_FRAME_TIMEOUT_MS
+#define SHELL_FRAME_TIMEOUT_MS 500      // A frame that stalls this long is abandoned
+#endif
+
+/*
+ * Binary control frame, for host tools (tools/shell_tool.py). Integers
+ * are little-endian:
+ *
+ *   uint8  sync     SHELL_FRAME_SYNC
+ *   uint8  type     SHELL_FRAME_* (replies set SHELL_FRAME_REPLY)
+ *   uint8  seq      Copied into the reply
+ *   uint16 length   Payload bytes, at most SHELL_FRAME_MAX_PAYLOAD
+ *   payload
+ *   uint16 crc      CRC-16/CCITT-FALSE of type, seq, length and payload
+ *
+ * The sync byte is not ASCII and is only recognised at the start of a
+ * line, so frames and typed commands share the port. Replies go out
+ * between log lines; the host skips whatever doesn't check out as a frame.
+ *
+ *   PING     -> reply echoes the payload
+ *   COMMAND  payload is a command line -> reply is one status byte
+ *   METRICS  -> one reply per telemetry line, then an empty reply
+ */
+#define SHELL_FRAME_SYNC 0xA5
+#define SHELL_FRAME_HEADER_SIZE 5
+#define SHELL_FRAME_OVERHEAD (SHELL_FRAME_HEADER_SIZE + 2)
+
+#define SHELL_FRAME_PING 0x01
+#define SHELL_FRAME_COMMAND 0x02
+#define SHELL_FRAME_METRICS 0x03
+#define SHELL_FRAME_REPLY 0x80
+
+// COMMAND reply status
+#define SHELL_STATUS_OK 0
+#define SHELL_STATUS_UNKNOWN 1          // No command by that name in the current mode
+#define SHELL_STATUS_BAD_REQUEST 2      // Unknown frame type, or the line is too long
+
+/**
+ * @brief Runs a command; args is the rest of the line after the name,
+ *        trimmed (empty if none)
+ */
+typedef void (*ShellHandler)(const char* args);
+
+/**
+ * @brief Receives the whole line when no command matches
+ */
+typedef void (*ShellFallback)(const char* line);
+
+/**
+ * @brief Writes bytes to the port; must not block for long
+ */
+typedef size_t (*ShellWriter)(const uint8_t* data, size_t size);
+
+typedef void (*ShellEmit)(const char* line);
+
+/**
+ * @brief Reports telemetry by calling emit once per line
+ */
+typedef void (*ShellMetricsProvider)(ShellEmit emit);
+
+/**
+ * @class CommandShell
+ * @brief Incremental serial command reader with a command table and a
+ *        framed binary control channel.
+ *
+ * feed() takes whatever bytes have arrived and never waits for the rest
+ * of a line, so a slow or partial line can't stall the main loop. Lines
+ * collect in a fixed buffer and names are matched case-insensitively
+ * without allocating. Each command lists the modes it runs in; in any
+ * other mode its line goes to the fallback.
+ */
+class CommandShell {
+public:
+    CommandShell();
+
+    /**
+     * @brief Add a command
+     * @param modes Bitmask of the modes the command runs in
+     * @return false if the table is full
+     */
+    bool registerCommand(const char* name, ShellHandler handler, uint8_t modes);
+
+    void setMode(uint8_t mode);
+    uint8_t getMode() const;
+
+    void onFallback(ShellFallback fallback);
+    void setWriter(ShellWriter writer);
+    void setMetricsProvider(ShellMetricsProvider provider);
+
+    /**
+     * @brief Process received bytes, running any command they complete
+     */
+    void feed(const uint8_t* data, size_t size, uint32_t nowMs);
+
+    /**
+     * @brief Run a command line as if it had been typed
+     * @return SHELL_STATUS_OK or SHELL_STATUS_UNKNOWN (after the fallback)
+     */
+    uint8_t execute(char* line);
+
+    /**
+     * @brief Write a frame through the writer
+     * @return false without a writer or if the payload is too large
+     */
+    bool sendFrame(uint8_t type, uint8_t seq, const uint8_t* payload, size_t length);
+
+    // Statistics
+    uint32_t getLineCount() const;
+    uint32_t getFrameCount() const;        // Valid frames received
+    uint32_t getBadFrameCount() const;     // CRC, length or timeout
+    uint32_t getOverflowCount() const;     // Lines dropped as too long
+    void resetStats();
+
+    /**
+     * @brief Counters for the 'l' report: "SHELL lines=12 frames=40 bad=0 overflow=0".
+     *        bad counts frames that failed the length or CRC check or stalled
+     *        mid-way; overflow counts lines longer than SHELL_LINE_MAX
+     * @return Length of the line in out
+     */
+    size_t format(char* out, size_t size) const;
+
+    static uint16_t crc16(const uint8_t* data, size_t size, uint16_t crc = 0xFFFF);
+
+private:
+    struct Command {
+        const char* name;
+        ShellHandler handler;
+        uint8_t modes;
+    };
+
+    enum RxState {
+        RX_TEXT,
+        RX_HEADER,      // Type, seq and length
+        RX_BODY         // Payload and CRC
+    };
+
+    Command commands[SHELL_MAX_COMMANDS];
+    size_t commandCount;
+    uint8_t mode;
+    ShellFallback fallback;
+    ShellWriter writer;
+    ShellMetricsProvider metricsProvider;
+
+    // Text lines
+    char line[SHELL_LINE_MAX + 1];
+    size_t lineLength;
+    bool lineOverflow;
+
+    // Binary frames
+    RxState rxState;
+    uint8_t frame[SHELL_FRAME_OVERHEAD - 1 + SHELL_FRAME_MAX_PAYLOAD];   // Everything after the sync byte
+    size_t frameLength;
+    size_t frameExpected;
+    uint32_t lastByteMs;
+
+    uint32_t lines;
+    uint32_t frames;
+    uint32_t badFrames;
+    uint32_t overflows;
+
+    // Target of the METRICS emit callback while it runs
+    static CommandShell* replying;
+    uint8_t replySeq;
+
+    void feedText(uint8_t byte);
+    void feedFrame(uint8_t byte);
+    void endLine();
+    void handleFrame();
+    static void emitMetricsLine(const char* text);
+};
+
+#endif
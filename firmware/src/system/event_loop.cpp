@@ -0,0 +1,243 @@
+#include "event_loop.h"
+#include <string.h>
+
+#ifndef ESP_PLATFORM
+#include <chrono>
+#endif
+
+#define EVENT_LOOP_MAX_ITEM_SIZE 32     // i2s_event_t is 8 bytes
+
+static const char* const SOURCE_NAMES[EVENT_SOURCE_COUNT] = {"net", "mic", "spk", "serial", "timer"};
+
+EventLoop::EventLoop() :
+    pending(0),
+    firstPostUs(0),
+    interest(0xFFFFFFFF),
+    timerArmed(false),
+    timerDeadlineUs(0),
+#ifdef ESP_PLATFORM
+    wakeSemaphore(nullptr),
+    queueCount(0),
+#endif
+    lastWakeUs(0),
+    blockedUs(0),
+    elapsedUs(0),
+    lastWaitEndUs(0) {
+    memset(wakeCounts, 0, sizeof(wakeCounts));
+}
+
+bool EventLoop::begin() {
+#ifdef ESP_PLATFORM
+    if (wakeSemaphore == nullptr) {
+        wakeSemaphore = xSemaphoreCreateBinary();
+        if (wakeSemaphore == nullptr) {
+            Serial.println("[EVENT] Failed to create the wake semaphore");
+            return false;
+        }
+    }
+#endif
+    resetStats();
+    return true;
+}
+
+void EventLoop::post(uint32_t events) {
+    pending.fetch_or(events);
+    markPosted();
+#ifdef ESP_PLATFORM
+    if (wakeSemaphore != nullptr) {
+        xSemaphoreGive(wakeSemaphore);
+    }
+#else
+    // Taking the lock orders this post after a waiter's last check
+    { std::lock_guard<std::mutex> guard(lock); }
+    wakeup.notify_one();
+#endif
+}
+
+#ifdef ESP_PLATFORM
+void IRAM_ATTR EventLoop::postFromISR(uint32_t events) {
+    pending.fetch_or(events);
+    markPosted();
+    BaseType_t woken = pdFALSE;
+    if (wakeSemaphore != nullptr) {
+        xSemaphoreGiveFromISR(wakeSemaphore, &woken);
+    }
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+bool EventLoop::forwardQueue(QueueHandle_t queue, size_t itemSize, uint32_t events) {
+    if (wakeSemaphore == nullptr || queue == nullptr || queueCount >= EVENT_LOOP_MAX_QUEUES ||
+        itemSize > EVENT_LOOP_MAX_ITEM_SIZE) {
+        Serial.println("[EVENT] Cannot forward queue");
+        return false;
+    }
+
+    ForwardedQueue& forwarded = queues[queueCount];
+    forwarded = {this, queue, itemSize, events};
+    if (xTaskCreate(forwardEntry, "event_fwd", EVENT_LOOP_FORWARD_STACK_SIZE, &forwarded,
+                    EVENT_LOOP_FORWARD_PRIORITY, nullptr) != pdPASS) {
+        Serial.println("[EVENT] Failed to create forwarding task");
+        return false;
+    }
+    queueCount++;
+    return true;
+}
+
+void EventLoop::forwardEntry(void* param) {
+    ForwardedQueue* forwarded = static_cast<ForwardedQueue*>(param);
+    uint8_t item[EVENT_LOOP_MAX_ITEM_SIZE];
+    while (true) {
+        if (xQueueReceive(forwarded->queue, item, portMAX_DELAY) == pdTRUE) {
+            forwarded->loop->post(forwarded->events);
+        }
+    }
+}
+#endif
+
+void EventLoop::setInterest(uint32_t events) {
+    interest = events;
+}
+
+void EventLoop::setTimer(uint32_t delayMs) {
+    uint32_t deadlineUs = micros() + delayMs * 1000;
+    if (!timerArmed || (int32_t)(deadlineUs - timerDeadlineUs) < 0) {
+        timerDeadlineUs = deadlineUs;
+        timerArmed = true;
+    }
+}
+
+uint32_t EventLoop::wait(uint32_t maxWaitMs) {
+    if (maxWaitMs > EVENT_LOOP_MAX_SLEEP_MS) {
+        maxWaitMs = EVENT_LOOP_MAX_SLEEP_MS;
+    }
+
+    uint32_t startUs = micros();
+    uint32_t events = 0;
+    while (true) {
+        uint32_t nowUs = micros();
+        events = collect(nowUs);
+        uint32_t waitedUs = nowUs - startUs;
+        if (events != 0 || waitedUs >= maxWaitMs * 1000) {
+            break;
+        }
+
+        uint32_t timeoutUs = maxWaitMs * 1000 - waitedUs;
+        if (timerArmed) {
+            uint32_t untilTimerUs = timerDeadlineUs - nowUs;   // Not yet due, see collect()
+            if (untilTimerUs < timeoutUs) {
+                timeoutUs = untilTimerUs;
+            }
+        }
+
+        block(timeoutUs);
+        blockedUs += micros() - nowUs;
+    }
+
+    uint32_t endUs = micros();
+    if (lastWaitEndUs != 0) {
+        elapsedUs += endUs - lastWaitEndUs;
+    }
+    lastWaitEndUs = endUs;
+    return events;
+}
+
+uint32_t EventLoop::collect(uint32_t nowUs) {
+    uint32_t lateUs = 0;
+    bool timerFired = false;
+    if (timerArmed && (int32_t)(nowUs - timerDeadlineUs) >= 0) {
+        timerArmed = false;
+        timerFired = true;
+        lateUs = nowUs - timerDeadlineUs;
+    }
+
+    uint32_t posted = pending.exchange(0);
+    uint32_t postedUs = firstPostUs.exchange(0);
+    uint32_t events = (posted & interest) | (timerFired ? EVENT_TIMER : 0);
+    if (events == 0) {
+        return 0;
+    }
+
+    // One sample per wake: how long the oldest post (else the timer) waited
+    lastWakeUs = 0;
+    if ((posted & interest) != 0 && postedUs != 0) {
+        lastWakeUs = nowUs - postedUs;
+        wakeLatencyUs.record(lastWakeUs);
+    } else if (timerFired) {
+        lastWakeUs = lateUs;
+        wakeLatencyUs.record(lastWakeUs);
+    }
+
+    for (size_t i = 0; i < EVENT_SOURCE_COUNT; i++) {
+        if (events & (1u << i)) {
+            wakeCounts[i]++;
+        }
+    }
+    return events;
+}
+
+void EventLoop::block(uint32_t timeoutUs) {
+#ifdef ESP_PLATFORM
+    // Round up so a timer isn't reached a tick early and spun on
+    const uint32_t tickUs = portTICK_PERIOD_MS * 1000;
+    TickType_t ticks = (timeoutUs + tickUs - 1) / tickUs;
+    xSemaphoreTake(wakeSemaphore, ticks);
+#else
+    std::unique_lock<std::mutex> guard(lock);
+    if (pending.load() == 0) {
+        wakeup.wait_for(guard, std::chrono::microseconds(timeoutUs));
+    }
+#endif
+}
+
+void EventLoop::markPosted() {
+    uint32_t expected = 0;
+    firstPostUs.compare_exchange_strong(expected, micros() | 1);
+}
+
+const LatencyHistogram& EventLoop::getWakeLatency() const {
+    return wakeLatencyUs;
+}
+
+uint32_t EventLoop::getLastWakeUs() const {
+    return lastWakeUs;
+}
+
+uint32_t EventLoop::getWakeCount(size_t source) const {
+    return source < EVENT_SOURCE_COUNT ? wakeCounts[source] : 0;
+}
+
+uint32_t EventLoop::getIdlePercent() const {
+    return elapsedUs > 0 ? (uint32_t)(blockedUs * 100 / elapsedUs) : 0;
+}
+
+void EventLoop::resetStats() {
+    wakeLatencyUs.reset();
+    memset(wakeCounts, 0, sizeof(wakeCounts));
+    blockedUs = 0;
+    elapsedUs = 0;
+    lastWaitEndUs = micros();
+}
+
+size_t EventLoop::format(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "EVENT wake_us n=%lu p50=%lu p99=%lu max=%lu | idle %lu%% |",
+                           (unsigned long)wakeLatencyUs.getCount(),
+                           (unsigned long)wakeLatencyUs.getPercentile(50),
+                           (unsigned long)wakeLatencyUs.getPercentile(99),
+                           (unsigned long)wakeLatencyUs.getMax(),
+                           (unsigned long)getIdlePercent());
+    for (size_t i = 0; i < EVENT_SOURCE_COUNT && written >= 0 && (size_t)written < size; i++) {
+        written += snprintf(out + written, size - written, " %s=%lu", SOURCE_NAMES[i],
+                            (unsigned long)wakeCounts[i]);
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
@@ -0,0 +1,168 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "../telemetry/latency_histogram.h"
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#ifndef EVENT_LOOP_MAX_SLEEP_MS
+#define EVENT_LOOP_MAX_SLEEP_MS 1000        // Longest wait without any event or timer
+#endif
+
+#ifndef EVENT_LOOP_POLL_MS
+#define EVENT_LOOP_POLL_MS 1                // Timer for sources that can't post (client polled inline)
+#endif
+
+#ifndef EVENT_LOOP_MAX_QUEUES
+#define EVENT_LOOP_MAX_QUEUES 4
+#endif
+
+#ifndef EVENT_LOOP_FORWARD_STACK_SIZE
+#define EVENT_LOOP_FORWARD_STACK_SIZE 2048  // Per forwarded queue: receive one item, post()
+#endif
+
+#ifndef EVENT_LOOP_FORWARD_PRIORITY
+#define EVENT_LOOP_FORWARD_PRIORITY 3       // Above loop() and the tool worker
+#endif
+
+// Event sources, combined as bits
+enum AppEvent : uint32_t {
+    EVENT_NETWORK = 1 << 0,     // Server events queued by the network task
+    EVENT_MICROPHONE = 1 << 1,  // I2S RX DMA buffer filled
+    EVENT_SPEAKER = 1 << 2,     // I2S TX DMA buffer drained
+    EVENT_SERIAL = 1 << 3,      // Serial RX
+    EVENT_TIMER = 1 << 4        // Deadline set with setTimer()
+};
+
+#define EVENT_SOURCE_COUNT 5
+
+/**
+ * @class EventLoop
+ * @brief Sleeps the application task until something needs handling.
+ *
+ * Replaces polling with delay(1): producers post event bits (from any task,
+ * or an ISR), and a small task per forwarded I2S driver event queue posts
+ * for each item, so wait() returns as soon as there is work and otherwise
+ * blocks until the next timer. Events outside the interest mask are
+ * consumed without waking the caller, e.g. microphone DMA events while
+ * nothing is recording.
+ *
+ * Records wake-to-handle latency (post, or timer deadline, to wait()
+ * returning) and the share of time spent blocked in wait() as idle time.
+ */
+class EventLoop {
+public:
+    EventLoop();
+
+    /**
+     * @brief Create the wait primitives; call from the task that will wait()
+     * @return false if they couldn't be allocated
+     */
+    bool begin();
+
+    /**
+     * @brief Wake the loop with these events (thread-safe)
+     */
+    void post(uint32_t events);
+
+#ifdef ESP_PLATFORM
+    /**
+     * @brief Wake the loop from an interrupt handler
+     */
+    void postFromISR(uint32_t events);
+
+    /**
+     * @brief Post these events for every item that arrives on a queue the
+     *        loop doesn't own, e.g. the event queue from i2s_driver_install()
+     *
+     * A forwarding task drains the queue. The I2S driver discards its oldest
+     * event when the queue is full, which a queue set can't follow, so the
+     * queue is never added to one.
+     * @param queue Queue to drain; nothing else may receive from it
+     * @param itemSize Size of one item
+     * @return false if EVENT_LOOP_MAX_QUEUES are forwarded or the task couldn't start
+     */
+    bool forwardQueue(QueueHandle_t queue, size_t itemSize, uint32_t events);
+#endif
+
+    /**
+     * @brief Events that wake wait(); others are dropped (default: all)
+     */
+    void setInterest(uint32_t events);
+
+    /**
+     * @brief Post EVENT_TIMER after delayMs; the earliest pending timer wins
+     *        (call from the waiting task)
+     */
+    void setTimer(uint32_t delayMs);
+
+    /**
+     * @brief Block until an event of interest or the timer
+     * @param maxWaitMs Upper bound on the wait (EVENT_LOOP_MAX_SLEEP_MS also applies)
+     * @return Events that were pending, 0 on timeout
+     */
+    uint32_t wait(uint32_t maxWaitMs = EVENT_LOOP_MAX_SLEEP_MS);
+
+    // Statistics
+    const LatencyHistogram& getWakeLatency() const;   // Microseconds
+    uint32_t getLastWakeUs() const;                   // Sample recorded by the last wait()
+    uint32_t getWakeCount(size_t source) const;       // Per bit position
+    uint32_t getIdlePercent() const;                  // Since resetStats()
+    void resetStats();
+
+    /**
+     * @brief Format loop statistics as one line, e.g.
+     *        "EVENT wake_us n=812 p50=45 p99=900 max=4100 | idle 96% | net=640 mic=0 spk=120 serial=2 timer=50"
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t format(char* out, size_t size) const;
+
+private:
+    std::atomic<uint32_t> pending;
+    std::atomic<uint32_t> firstPostUs;   // Oldest unhandled post, 0 if none
+    uint32_t interest;
+
+    bool timerArmed;
+    uint32_t timerDeadlineUs;
+
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t wakeSemaphore;
+
+    struct ForwardedQueue {
+        EventLoop* loop;
+        QueueHandle_t queue;
+        size_t itemSize;
+        uint32_t events;
+    };
+    ForwardedQueue queues[EVENT_LOOP_MAX_QUEUES];
+    size_t queueCount;
+
+    static void forwardEntry(void* param);
+#else
+    std::mutex lock;
+    std::condition_variable wakeup;
+#endif
+
+    LatencyHistogram wakeLatencyUs;
+    uint32_t lastWakeUs;
+    uint32_t wakeCounts[EVENT_SOURCE_COUNT];
+    uint64_t blockedUs;
+    uint64_t elapsedUs;
+    uint32_t lastWaitEndUs;
+
+    uint32_t collect(uint32_t nowUs);
+    void block(uint32_t timeoutUs);
+    void markPosted();
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "loop_stall_detector.h"
+#include <stdio.h>
+
+LoopStallDetector::LoopStallDetector() :
+    startUs(0),
+    lapUs(0),
+    lastUs(0),
+    slowestPhase(""),
+    slowestPhaseUs(0),
+    stalls(0) {
+}
+
+void LoopStallDetector::begin(uint32_t nowUs) {
+    startUs = nowUs;
+    lapUs = nowUs;
+    slowestPhase = "";
+    slowestPhaseUs = 0;
+}
+
+void LoopStallDetector::lap(const char* name, uint32_t nowUs) {
+    uint32_t phaseUs = nowUs - lapUs;
+    if (phaseUs >= slowestPhaseUs) {
+        slowestPhase = name;
+        slowestPhaseUs = phaseUs;
+    }
+    lapUs = nowUs;
+}
+
+bool LoopStallDetector::end(uint32_t nowUs) {
+    lastUs = nowUs - startUs;
+    iterationUs.record(lastUs);
+    if (lastUs > (uint32_t)LOOP_STALL_BUDGET_MS * 1000) {
+        stalls++;
+        return true;
+    }
+    return false;
+}
+
+uint32_t LoopStallDetector::getLastUs() const {
+    return lastUs;
+}
+
+const char* LoopStallDetector::getSlowestPhase() const {
+    return slowestPhase;
+}
+
+uint32_t LoopStallDetector::getSlowestPhaseUs() const {
+    return slowestPhaseUs;
+}
+
+const LatencyHistogram& LoopStallDetector::getIterationTime() const {
+    return iterationUs;
+}
+
+uint32_t LoopStallDetector::getStallCount() const {
+    return stalls;
+}
+
+void LoopStallDetector::resetStats() {
+    iterationUs.reset();
+    stalls = 0;
+}
+
+size_t LoopStallDetector::format(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "LOOP work_us n=%lu p50=%lu p99=%lu max=%lu | stalls=%lu (budget %u ms)",
+                           (unsigned long)iterationUs.getCount(),
+                           (unsigned long)iterationUs.getPercentile(50),
+                           (unsigned long)iterationUs.getPercentile(99),
+                           (unsigned long)iterationUs.getMax(),
+                           (unsigned long)stalls,
+                           (unsigned int)LOOP_STALL_BUDGET_MS);
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
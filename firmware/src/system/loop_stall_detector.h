@@ -0,0 +1,65 @@
+#ifndef LOOP_STALL_DETECTOR_H
+#define LOOP_STALL_DETECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../telemetry/latency_histogram.h"
+
+#ifndef LOOP_STALL_BUDGET_MS
+#define LOOP_STALL_BUDGET_MS 20         // Just over one 16 ms microphone DMA read
+#endif
+
+/**
+ * @class LoopStallDetector
+ * @brief Times the work done in each main loop iteration and flags the
+ *        ones over LOOP_STALL_BUDGET_MS.
+ *
+ * begin() is called once the loop wakes and end() when its handlers are
+ * done, so time asleep in the event loop doesn't count. lap() splits the
+ * iteration into named phases; a stall reports the slowest one, which is
+ * usually the handler that blocked. All times are in microseconds.
+ */
+class LoopStallDetector {
+public:
+    LoopStallDetector();
+
+    void begin(uint32_t nowUs);
+
+    /**
+     * @brief End the phase called name, which ran since the last lap() or begin()
+     */
+    void lap(const char* name, uint32_t nowUs);
+
+    /**
+     * @return true if the iteration went over budget
+     */
+    bool end(uint32_t nowUs);
+
+    uint32_t getLastUs() const;               // Last iteration
+    const char* getSlowestPhase() const;      // Of the last iteration, "" if no laps
+    uint32_t getSlowestPhaseUs() const;
+
+    // Statistics
+    const LatencyHistogram& getIterationTime() const;   // Microseconds
+    uint32_t getStallCount() const;
+    void resetStats();
+
+    /**
+     * @brief Format the statistics as one line, e.g.
+     *        "LOOP work_us n=5120 p50=180 p99=2900 max=24000 | stalls=1 (budget 20 ms)"
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t format(char* out, size_t size) const;
+
+private:
+    uint32_t startUs;
+    uint32_t lapUs;
+    uint32_t lastUs;
+    const char* slowestPhase;
+    uint32_t slowestPhaseUs;
+
+    LatencyHistogram iterationUs;
+    uint32_t stalls;
+};
+
+#endif
@@ -0,0 +1,288 @@
+#include "mem_tracker.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#include <soc/soc_memory_layout.h>
+#endif
+
+// Precedes every tracked block, so memFree() knows what to uncount. 8 bytes
+// keeps the payload as aligned as the heap's own blocks
+struct MemHeader {
+    uint32_t size;
+    uint16_t magic;
+    uint8_t tag;
+    uint8_t region;
+};
+
+#define MEM_HEADER_MAGIC 0xA110
+static_assert(sizeof(MemHeader) == 8, "MemHeader must stay 8 bytes");
+
+static const char* const TAG_NAMES[MEM_TAG_COUNT] = {"mic", "speaker", "net", "plan"};
+static const char* const REGION_NAMES[MEM_REGION_COUNT] = {"int", "psram"};
+
+#ifdef ESP_PLATFORM
+static bool espHeapProbe(MemRegion region, MemHeapInfo& info) {
+    uint32_t caps = region == MEM_PSRAM ? MALLOC_CAP_SPIRAM : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (heap_caps_get_total_size(caps) == 0) {
+        return false;
+    }
+    info.freeBytes = heap_caps_get_free_size(caps);
+    info.minFreeBytes = heap_caps_get_minimum_free_size(caps);
+    info.largestBlock = heap_caps_get_largest_free_block(caps);
+    return true;
+}
+#endif
+
+MemTracker memTracker;
+
+MemTracker::MemTracker() :
+#ifdef ESP_PLATFORM
+    heapProbe(espHeapProbe) {
+#else
+    heapProbe(nullptr) {
+#endif
+    memset(stats, 0, sizeof(stats));
+    memset(sealed, 0, sizeof(sealed));
+}
+
+void MemTracker::recordAlloc(MemTag tag, MemRegion region, size_t size) {
+    if (tag >= MEM_TAG_COUNT || region >= MEM_REGION_COUNT) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    MemTagStats& tagStats = stats[tag];
+    tagStats.allocations++;
+    tagStats.liveBytes[region] += size;
+    if (tagStats.liveBytes[region] > tagStats.peakBytes[region]) {
+        tagStats.peakBytes[region] = tagStats.liveBytes[region];
+    }
+    if (sealed[tag]) {
+        tagStats.lateAllocations++;
+#if MEM_STRICT_STEADY_STATE
+        printf("[MEM] %s allocated %lu bytes after its buffers were sealed\n", TAG_NAMES[tag], (unsigned long)size);
+        abort();
+#endif
+    }
+}
+
+void MemTracker::recordFree(MemTag tag, MemRegion region, size_t size) {
+    if (tag >= MEM_TAG_COUNT || region >= MEM_REGION_COUNT) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    MemTagStats& tagStats = stats[tag];
+    tagStats.frees++;
+    tagStats.liveBytes[region] -= size < tagStats.liveBytes[region] ? size : tagStats.liveBytes[region];
+}
+
+void MemTracker::recordFailure(MemTag tag, MemRegion region, size_t size) {
+    if (tag >= MEM_TAG_COUNT) {
+        return;
+    }
+    // What was left when it failed tells fragmentation from exhaustion
+    MemHeapInfo info = {};
+    getHeapInfo(region, info);
+
+    std::lock_guard<std::mutex> guard(lock);
+    MemTagStats& tagStats = stats[tag];
+    tagStats.failures++;
+    tagStats.lastFailedSize = size;
+    tagStats.largestBlockAtFailure = info.largestBlock;
+}
+
+void MemTracker::seal(MemTag tag) {
+    if (tag < MEM_TAG_COUNT) {
+        std::lock_guard<std::mutex> guard(lock);
+        sealed[tag] = true;
+    }
+}
+
+bool MemTracker::isSealed(MemTag tag) const {
+    if (tag >= MEM_TAG_COUNT) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    return sealed[tag];
+}
+
+MemTagStats MemTracker::getStats(MemTag tag) const {
+    MemTagStats copy = {};
+    if (tag < MEM_TAG_COUNT) {
+        std::lock_guard<std::mutex> guard(lock);
+        copy = stats[tag];
+    }
+    return copy;
+}
+
+const char* MemTracker::tagName(MemTag tag) {
+    return tag < MEM_TAG_COUNT ? TAG_NAMES[tag] : "?";
+}
+
+const char* MemTracker::regionName(MemRegion region) {
+    return region < MEM_REGION_COUNT ? REGION_NAMES[region] : "?";
+}
+
+void MemTracker::setHeapProbe(MemHeapProbe probe) {
+    heapProbe = probe;
+}
+
+bool MemTracker::getHeapInfo(MemRegion region, MemHeapInfo& info) const {
+    info = {};
+    return heapProbe != nullptr && region < MEM_REGION_COUNT && heapProbe(region, info);
+}
+
+uint32_t MemTracker::getFragmentation(MemRegion region) const {
+    MemHeapInfo info;
+    if (!getHeapInfo(region, info) || info.freeBytes == 0) {
+        return 0;
+    }
+    size_t largest = info.largestBlock < info.freeBytes ? info.largestBlock : info.freeBytes;
+    return (uint32_t)(100 - (uint64_t)largest * 100 / info.freeBytes);
+}
+
+void MemTracker::resetStats() {
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t i = 0; i < MEM_TAG_COUNT; i++) {
+        MemTagStats& tagStats = stats[i];
+        for (size_t region = 0; region < MEM_REGION_COUNT; region++) {
+            tagStats.peakBytes[region] = tagStats.liveBytes[region];
+        }
+        tagStats.allocations = 0;
+        tagStats.frees = 0;
+        tagStats.failures = 0;
+        tagStats.lastFailedSize = 0;
+        tagStats.largestBlockAtFailure = 0;
+        tagStats.lateAllocations = 0;
+    }
+}
+
+size_t MemTracker::formatHeap(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "HEAP");
+    for (size_t i = 0; i < MEM_REGION_COUNT && written >= 0 && (size_t)written < size; i++) {
+        MemHeapInfo info;
+        if (!getHeapInfo((MemRegion)i, info)) {
+            continue;
+        }
+        written += snprintf(out + written, size - written, "%s %s free=%lu min=%lu largest=%lu frag=%lu%%",
+                            written > 4 ? " |" : "", REGION_NAMES[i], (unsigned long)info.freeBytes,
+                            (unsigned long)info.minFreeBytes, (unsigned long)info.largestBlock,
+                            (unsigned long)getFragmentation((MemRegion)i));
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+size_t MemTracker::formatTag(MemTag tag, char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    MemTagStats tagStats = getStats(tag);
+    int written = snprintf(out, size, "MEM %s int=%lu/%lu psram=%lu/%lu allocs=%lu frees=%lu fails=%lu",
+                           tagName(tag), (unsigned long)tagStats.liveBytes[MEM_INTERNAL],
+                           (unsigned long)tagStats.peakBytes[MEM_INTERNAL], (unsigned long)tagStats.liveBytes[MEM_PSRAM],
+                           (unsigned long)tagStats.peakBytes[MEM_PSRAM], (unsigned long)tagStats.allocations,
+                           (unsigned long)tagStats.frees, (unsigned long)tagStats.failures);
+    if (tagStats.failures > 0 && written >= 0 && (size_t)written < size) {
+        written += snprintf(out + written, size - written, " last_fail=%lu largest=%lu",
+                            (unsigned long)tagStats.lastFailedSize, (unsigned long)tagStats.largestBlockAtFailure);
+    }
+    if (tagStats.lateAllocations > 0 && written >= 0 && (size_t)written < size) {
+        written += snprintf(out + written, size - written, " late=%lu", (unsigned long)tagStats.lateAllocations);
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+static MemRegion regionOf(void* block, MemRegion requested) {
+#ifdef ESP_PLATFORM
+    (void)requested;
+    return esp_ptr_external_ram(block) ? MEM_PSRAM : MEM_INTERNAL;
+#else
+    (void)block;
+    return requested;
+#endif
+}
+
+static void* track(void* block, MemTag tag, size_t size, MemRegion requested) {
+    if (block == nullptr) {
+        memTracker.recordFailure(tag, requested, size);
+        return nullptr;
+    }
+    MemHeader* header = (MemHeader*)block;
+    header->size = (uint32_t)size;
+    header->magic = MEM_HEADER_MAGIC;
+    header->tag = (uint8_t)tag;
+    header->region = (uint8_t)regionOf(block, requested);
+    memTracker.recordAlloc(tag, (MemRegion)header->region, size);
+    return header + 1;
+}
+
+void* memAlloc(MemTag tag, size_t size) {
+    return track(malloc(sizeof(MemHeader) + size), tag, size, MEM_INTERNAL);
+}
+
+void* memAllocPsram(MemTag tag, size_t size) {
+#ifdef ESP_PLATFORM
+    void* block = heap_caps_malloc(sizeof(MemHeader) + size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+    void* block = malloc(sizeof(MemHeader) + size);
+#endif
+    return track(block, tag, size, MEM_PSRAM);
+}
+
+void* memAllocInternal(MemTag tag, size_t size) {
+#ifdef ESP_PLATFORM
+    void* block = heap_caps_malloc(sizeof(MemHeader) + size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+    void* block = malloc(sizeof(MemHeader) + size);
+#endif
+    return track(block, tag, size, MEM_INTERNAL);
+}
+
+void* memRealloc(MemTag tag, void* ptr, size_t size) {
+    if (ptr == nullptr) {
+        return memAlloc(tag, size);
+    }
+    MemHeader* header = (MemHeader*)ptr - 1;
+    if (header->magic != MEM_HEADER_MAGIC) {
+        return realloc(ptr, size);  // Not ours; leave it uncounted
+    }
+
+    MemHeader old = *header;
+    void* block = realloc(header, sizeof(MemHeader) + size);
+    if (block == nullptr) {
+        // The old block is still valid and still counted
+        memTracker.recordFailure(tag, (MemRegion)old.region, size);
+        return nullptr;
+    }
+    memTracker.recordFree((MemTag)old.tag, (MemRegion)old.region, old.size);
+    return track(block, tag, size, (MemRegion)old.region);
+}
+
+void memFree(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    MemHeader* header = (MemHeader*)ptr - 1;
+    if (header->magic != MEM_HEADER_MAGIC) {
+        free(ptr);  // Not ours
+        return;
+    }
+    memTracker.recordFree((MemTag)header->tag, (MemRegion)header->region, header->size);
+    header->magic = 0;
+    free(header);
+}
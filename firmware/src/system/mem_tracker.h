@@ -0,0 +1,145 @@
+#ifndef MEM_TRACKER_H
+#define MEM_TRACKER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+
+#ifndef MEM_FRAGMENTATION_WARN_PCT
+#define MEM_FRAGMENTATION_WARN_PCT 60   // Free memory not in the largest block, above which the report warns
+#endif
+
+#ifndef MEM_STRICT_STEADY_STATE
+#define MEM_STRICT_STEADY_STATE 0       // 1: abort on an allocation by a sealed tag (debug builds)
+#endif
+
+// Who asked for the memory
+enum MemTag {
+    MEM_TAG_MICROPHONE,
+    MEM_TAG_SPEAKER,
+    MEM_TAG_NETWORK,        // ElevenLabsClient and the queues around it
+    MEM_TAG_PLAN,           // The boot-time memory plan's arenas
+    MEM_TAG_COUNT
+};
+
+// Where it ended up
+enum MemRegion {
+    MEM_INTERNAL,
+    MEM_PSRAM,
+    MEM_REGION_COUNT
+};
+
+struct MemTagStats {
+    size_t liveBytes[MEM_REGION_COUNT];
+    size_t peakBytes[MEM_REGION_COUNT];
+    uint32_t allocations;
+    uint32_t frees;
+    uint32_t failures;
+    size_t lastFailedSize;          // Request that failed last
+    size_t largestBlockAtFailure;   // Largest free block in its region at the time
+    uint32_t lateAllocations;       // Allocations after seal()
+};
+
+struct MemHeapInfo {
+    size_t freeBytes;
+    size_t minFreeBytes;            // Low watermark since boot
+    size_t largestBlock;
+};
+
+// Fills in one region's heap figures; false if the region doesn't exist
+typedef bool (*MemHeapProbe)(MemRegion region, MemHeapInfo& info);
+
+/**
+ * @class MemTracker
+ * @brief Per-subsystem accounting of the buffers allocated through
+ *        memAlloc() and friends, plus heap watermarks and fragmentation.
+ *
+ * Each tag keeps live and peak bytes per region, so a failed allocation
+ * can be put next to who is holding what. The heap figures come from a
+ * probe (heap_caps on the device), so the accounting itself has no
+ * platform dependencies. Safe to use from any task.
+ */
+class MemTracker {
+public:
+    MemTracker();
+
+    void recordAlloc(MemTag tag, MemRegion region, size_t size);
+    void recordFree(MemTag tag, MemRegion region, size_t size);
+    void recordFailure(MemTag tag, MemRegion region, size_t size);
+
+    /**
+     * @brief Declare a tag's buffers all allocated: from here on each
+     *        allocation it makes counts as late, and aborts when
+     *        MEM_STRICT_STEADY_STATE is set
+     */
+    void seal(MemTag tag);
+    bool isSealed(MemTag tag) const;
+
+    MemTagStats getStats(MemTag tag) const;
+    static const char* tagName(MemTag tag);
+    static const char* regionName(MemRegion region);
+
+    void setHeapProbe(MemHeapProbe probe);
+    bool getHeapInfo(MemRegion region, MemHeapInfo& info) const;
+
+    /**
+     * @brief Share of a region's free memory outside its largest block, 0-100
+     */
+    uint32_t getFragmentation(MemRegion region) const;
+
+    /**
+     * @brief Clear the counters and peaks; live bytes are kept
+     */
+    void resetStats();
+
+    /**
+     * @brief Format the heap figures as one line, e.g.
+     *        "HEAP int free=180000 min=150000 largest=110000 frag=38% | psram free=7800000 min=7500000 largest=7700000 frag=1%"
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t formatHeap(char* out, size_t size) const;
+
+    /**
+     * @brief Format one tag as one line, live/peak bytes per region, e.g.
+     *        "MEM speaker int=8192/16384 psram=0/0 allocs=12 frees=10 fails=1 last_fail=65536 largest=40000"
+     *        with " late=N" appended once a sealed tag has allocated
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t formatTag(MemTag tag, char* out, size_t size) const;
+
+private:
+    mutable std::mutex lock;
+    MemTagStats stats[MEM_TAG_COUNT];
+    bool sealed[MEM_TAG_COUNT];
+    MemHeapProbe heapProbe;
+};
+
+extern MemTracker memTracker;
+
+/**
+ * @brief malloc() counted against a tag; may land in PSRAM like malloc()
+ */
+void* memAlloc(MemTag tag, size_t size);
+
+/**
+ * @brief Like memAlloc(), but PSRAM only (plain malloc() off the device)
+ */
+void* memAllocPsram(MemTag tag, size_t size);
+
+/**
+ * @brief Like memAlloc(), but internal RAM only, e.g. for buffers the CPU
+ *        works through every frame
+ */
+void* memAllocInternal(MemTag tag, size_t size);
+
+/**
+ * @brief realloc() for memory from memAlloc() or memAllocPsram(); nullptr allocates
+ */
+void* memRealloc(MemTag tag, void* ptr, size_t size);
+
+/**
+ * @brief free() for memory from the functions above; nullptr is ignored
+ */
+void memFree(void* ptr);
+
+#endif
@@ -0,0 +1,107 @@
+#include "memory_plan.h"
+#include <stdio.h>
+#include <string.h>
+
+MemoryPlan::MemoryPlan() :
+    regionCount(0),
+    committed(false) {
+    memset(regions, 0, sizeof(regions));
+    memset(totals, 0, sizeof(totals));
+    memset(arenas, 0, sizeof(arenas));
+}
+
+MemoryPlan::~MemoryPlan() {
+    release();
+}
+
+size_t MemoryPlan::alignUp(size_t bytes) {
+    return (bytes + MEM_PLAN_ALIGN - 1) & ~(size_t)(MEM_PLAN_ALIGN - 1);
+}
+
+int MemoryPlan::add(const char* name, size_t bytes, MemRegion region) {
+    if (committed || regionCount >= MEM_PLAN_MAX_REGIONS || region >= MEM_REGION_COUNT) {
+        return -1;
+    }
+
+    Region& entry = regions[regionCount];
+    entry.name = name;
+    entry.bytes = bytes;
+    entry.offset = totals[region];
+    entry.region = region;
+    totals[region] += alignUp(bytes);
+    return (int)regionCount++;
+}
+
+bool MemoryPlan::commit() {
+    if (committed) {
+        return true;
+    }
+
+    for (size_t i = 0; i < MEM_REGION_COUNT; i++) {
+        if (totals[i] == 0) {
+            continue;
+        }
+        // memAlloc() blocks are 8-byte aligned; ask for the slack to reach MEM_PLAN_ALIGN
+        size_t bytes = totals[i] + MEM_PLAN_ALIGN;
+        arenas[i] = (uint8_t*)(i == MEM_PSRAM ? memAllocPsram(MEM_TAG_PLAN, bytes)
+                                              : memAllocInternal(MEM_TAG_PLAN, bytes));
+        if (arenas[i] == nullptr) {
+            release();
+            return false;
+        }
+    }
+
+    committed = true;
+    return true;
+}
+
+void MemoryPlan::release() {
+    for (size_t i = 0; i < MEM_REGION_COUNT; i++) {
+        memFree(arenas[i]);
+        arenas[i] = nullptr;
+    }
+    committed = false;
+}
+
+bool MemoryPlan::isCommitted() const {
+    return committed;
+}
+
+void* MemoryPlan::get(int id) const {
+    if (!committed || id < 0 || (size_t)id >= regionCount) {
+        return nullptr;
+    }
+    const Region& entry = regions[id];
+    uintptr_t base = alignUp((uintptr_t)arenas[entry.region]);
+    return (void*)(base + entry.offset);
+}
+
+size_t MemoryPlan::getSize(int id) const {
+    return id >= 0 && (size_t)id < regionCount ? regions[id].bytes : 0;
+}
+
+size_t MemoryPlan::getRegionCount() const {
+    return regionCount;
+}
+
+size_t MemoryPlan::getTotal(MemRegion region) const {
+    return region < MEM_REGION_COUNT ? totals[region] : 0;
+}
+
+size_t MemoryPlan::format(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "PLAN int=%lu psram=%lu%s", (unsigned long)totals[MEM_INTERNAL],
+                           (unsigned long)totals[MEM_PSRAM], committed ? "" : " (not committed)");
+    for (size_t i = 0; i < regionCount && written >= 0 && (size_t)written < size; i++) {
+        written += snprintf(out + written, size - written, "%s %s=%lu@%s", i == 0 ? " |" : "", regions[i].name,
+                            (unsigned long)regions[i].bytes, MemTracker::regionName(regions[i].region));
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
@@ -0,0 +1,82 @@
+#ifndef MEMORY_PLAN_H
+#define MEMORY_PLAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mem_tracker.h"
+
+#ifndef MEM_PLAN_MAX_REGIONS
+#define MEM_PLAN_MAX_REGIONS 8
+#endif
+
+#ifndef MEM_PLAN_ALIGN
+#define MEM_PLAN_ALIGN 16   // Region start alignment; a cache line on the S3
+#endif
+
+/**
+ * @class MemoryPlan
+ * @brief Lays out long-lived buffers at boot and allocates them as one
+ *        arena per memory type.
+ *
+ * Each subsystem adds its regions - sized from its configuration - before
+ * commit(). commit() then makes at most one allocation per MemRegion and
+ * carves it up, so the buffers neither fragment the heap nor depend on a
+ * large free block turning up mid-conversation. Nothing is added or freed
+ * after that until release().
+ */
+class MemoryPlan {
+public:
+    MemoryPlan();
+    ~MemoryPlan();
+
+    /**
+     * @brief Reserve a region; only before commit()
+     * @param name Static label for the report
+     * @param bytes Region size
+     * @param region Internal RAM or PSRAM
+     * @return Region id for get(), or -1 if the plan is full or committed
+     */
+    int add(const char* name, size_t bytes, MemRegion region);
+
+    /**
+     * @brief Allocate the arenas and place every region
+     * @return false if an arena could not be allocated; nothing stays allocated
+     */
+    bool commit();
+
+    /**
+     * @brief Free the arenas; regions are kept, so commit() can run again
+     */
+    void release();
+
+    bool isCommitted() const;
+    void* get(int id) const;        // nullptr before commit() or for a bad id
+    size_t getSize(int id) const;
+    size_t getRegionCount() const;
+    size_t getTotal(MemRegion region) const;   // Arena size, alignment included
+
+    /**
+     * @brief Format the plan as one line, e.g.
+     *        "PLAN int=6144 psram=869376 | mic_record=320000@psram uplink=16000@psram ..."
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t format(char* out, size_t size) const;
+
+private:
+    struct Region {
+        const char* name;
+        size_t bytes;
+        size_t offset;
+        MemRegion region;
+    };
+
+    Region regions[MEM_PLAN_MAX_REGIONS];
+    size_t regionCount;
+    size_t totals[MEM_REGION_COUNT];
+    uint8_t* arenas[MEM_REGION_COUNT];
+    bool committed;
+
+    static size_t alignUp(size_t bytes);
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "power_manager.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_idf_version.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/uart.h>
+
+#define POWER_UART_WAKE_THRESHOLD 3     // Edges on RX that wake the chip from light sleep
+#endif
+
+static bool sameProfile(const PowerProfile& a, const PowerProfile& b) {
+    return a.cpuMhz == b.cpuMhz && a.lightSleep == b.lightSleep && a.modemSleep == b.modemSleep;
+}
+
+PowerManager::PowerManager() :
+    applier(nullptr),
+    state(0),
+    enteredMs(0),
+    active{0, false, false},
+    applied(false),
+    switches(0),
+    failures(0),
+    statsStartMs(0) {
+    for (size_t i = 0; i < POWER_MAX_STATES; i++) {
+        states[i].name = "";
+        states[i].profile = {0, false, false};
+        states[i].configured = false;
+        states[i].timeMs = 0;
+    }
+}
+
+bool PowerManager::setProfile(uint8_t state, const char* name, const PowerProfile& profile) {
+    if (state >= POWER_MAX_STATES) {
+        return false;
+    }
+    states[state].name = name != nullptr ? name : "";
+    states[state].profile = profile;
+    states[state].configured = true;
+    return true;
+}
+
+void PowerManager::setApplier(PowerApplier applier) {
+    this->applier = applier;
+}
+
+void PowerManager::enter(uint8_t newState, uint32_t nowMs) {
+    if (newState >= POWER_MAX_STATES) {
+        return;
+    }
+    if (applied) {
+        states[state].timeMs += nowMs - enteredMs;
+    } else {
+        statsStartMs = nowMs;
+    }
+    state = newState;
+    enteredMs = nowMs;
+
+    // States without a profile keep whatever is in effect
+    if (states[newState].configured && (!applied || !sameProfile(active, states[newState].profile))) {
+        apply(states[newState].profile);
+    }
+    applied = true;
+}
+
+void PowerManager::recordWake(uint32_t latencyUs) {
+    states[state].wakeUs.record(latencyUs);
+}
+
+uint8_t PowerManager::getState() const {
+    return state;
+}
+
+const PowerProfile& PowerManager::getActiveProfile() const {
+    return active;
+}
+
+uint32_t PowerManager::getTimeInState(uint8_t state, uint32_t nowMs) const {
+    if (state >= POWER_MAX_STATES) {
+        return 0;
+    }
+    uint64_t timeMs = states[state].timeMs;
+    if (applied && state == this->state) {
+        timeMs += nowMs - enteredMs;
+    }
+    return (uint32_t)timeMs;
+}
+
+const LatencyHistogram& PowerManager::getWakeLatency(uint8_t state) const {
+    return states[state < POWER_MAX_STATES ? state : 0].wakeUs;
+}
+
+uint32_t PowerManager::getSwitchCount() const {
+    return switches;
+}
+
+uint32_t PowerManager::getFailureCount() const {
+    return failures;
+}
+
+void PowerManager::resetStats(uint32_t nowMs) {
+    for (size_t i = 0; i < POWER_MAX_STATES; i++) {
+        states[i].timeMs = 0;
+        states[i].wakeUs.reset();
+    }
+    enteredMs = nowMs;
+    statsStartMs = nowMs;
+    switches = 0;
+    failures = 0;
+}
+
+size_t PowerManager::format(char* out, size_t size, uint32_t nowMs) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    const char* sleep = active.lightSleep ? (active.modemSleep ? "light,modem" : "light")
+                                          : (active.modemSleep ? "modem" : "none");
+    int written = snprintf(out, size, "POWER %uMHz sleep=%s switches=%lu", (unsigned int)active.cpuMhz,
+                           sleep, (unsigned long)switches);
+    if (failures > 0 && written >= 0 && (size_t)written < size) {
+        written += snprintf(out + written, size - written, " failed=%lu", (unsigned long)failures);
+    }
+
+    uint32_t totalMs = nowMs - statsStartMs;
+    bool first = true;
+    for (size_t i = 0; i < POWER_MAX_STATES && written >= 0 && (size_t)written < size; i++) {
+        uint32_t timeMs = getTimeInState((uint8_t)i, nowMs);
+        if (timeMs == 0 && states[i].wakeUs.getCount() == 0) {
+            continue;
+        }
+        written += snprintf(out + written, size - written, "%s%s %lu%% %lu/%lu", first ? " | " : ", ",
+                            states[i].name, (unsigned long)(totalMs > 0 ? (uint64_t)timeMs * 100 / totalMs : 0),
+                            (unsigned long)states[i].wakeUs.getPercentile(50),
+                            (unsigned long)states[i].wakeUs.getPercentile(99));
+        first = false;
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+void PowerManager::apply(const PowerProfile& profile) {
+    active = profile;
+#if !POWER_LIGHT_SLEEP
+    active.lightSleep = false;
+#endif
+    switches++;
+    if (applier != nullptr && !applier(active)) {
+        failures++;
+    }
+}
+
+#ifdef ESP_PLATFORM
+bool applyPowerProfile(const PowerProfile& profile) {
+    static bool pmUnavailable = false;
+    bool ok = true;
+
+    bool lightSleep = profile.lightSleep;
+#if ARDUINO_USB_CDC_ON_BOOT && ARDUINO_USB_MODE
+    lightSleep = false;     // USB Serial/JTAG drops while the chip sleeps
+#endif
+
+    if (!pmUnavailable) {
+        // With power management built in, it owns the clock: no locks held
+        // (I2S stopped, loop blocked) lets the idle task light-sleep
+#if ESP_IDF_VERSION_MAJOR >= 5
+        esp_pm_config_t config = {};
+#else
+        esp_pm_config_esp32s3_t config = {};
+#endif
+        config.max_freq_mhz = profile.cpuMhz;
+        config.min_freq_mhz = profile.cpuMhz;
+        config.light_sleep_enable = lightSleep;
+        esp_err_t err = esp_pm_configure(&config);
+        if (err == ESP_ERR_NOT_SUPPORTED) {
+            Serial.println("[POWER] Power management not built in: clock only, no light sleep");
+            pmUnavailable = true;
+        } else if (err != ESP_OK) {
+            Serial.printf("[POWER] esp_pm_configure failed: %s\n", esp_err_to_name(err));
+            ok = false;
+        }
+    }
+    if (pmUnavailable && !setCpuFrequencyMhz(profile.cpuMhz)) {
+        Serial.printf("[POWER] Cannot set CPU to %u MHz\n", (unsigned int)profile.cpuMhz);
+        ok = false;
+    }
+
+#if !(ARDUINO_USB_CDC_ON_BOOT && ARDUINO_USB_MODE)
+    if (lightSleep && !pmUnavailable) {
+        static bool uartWakeEnabled = false;
+        if (!uartWakeEnabled) {
+            uart_set_wakeup_threshold(UART_NUM_0, POWER_UART_WAKE_THRESHOLD);
+            uartWakeEnabled = esp_sleep_enable_uart_wakeup(UART_NUM_0) == ESP_OK;
+        }
+    }
+#endif
+
+    // Stored by the Wi-Fi library and applied again when the station starts
+    wifi_ps_type_t powerSave = profile.modemSleep ? WIFI_PS_MIN_MODEM : WIFI_PS_NONE;
+    WiFi.setSleep(powerSave);
+    if (WiFi.getSleep() != powerSave) {
+        ok = false;
+    }
+    return ok;
+}
+#endif
@@ -0,0 +1,123 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../telemetry/latency_histogram.h"
+
+#ifndef POWER_MAX_STATES
+#define POWER_MAX_STATES 12
+#endif
+
+#ifndef POWER_LIGHT_SLEEP
+#define POWER_LIGHT_SLEEP 1             // 0 keeps the chip out of light sleep in every state
+#endif
+
+/**
+ * @brief What a state may trade for power
+ */
+struct PowerProfile {
+    uint16_t cpuMhz;        // 80, 160 or 240; all keep the APB clock at 80 MHz
+    bool lightSleep;        // Light-sleep the chip while the loop waits for events
+    bool modemSleep;        // Wi-Fi power save; inbound packets wait for the next DTIM beacon
+};
+
+/**
+ * @brief Puts a profile into effect
+ * @return false if part of it couldn't be applied
+ */
+typedef bool (*PowerApplier)(const PowerProfile& profile);
+
+/**
+ * @class PowerManager
+ * @brief Applies a power profile per conversation state and records what
+ *        it costs in wake latency.
+ *
+ * Each state gets a CPU clock and whether light sleep and Wi-Fi modem
+ * sleep are allowed. enter() applies the new state's profile when it
+ * differs from the one in effect, so the clock goes up as soon as a
+ * conversation starts. recordWake() takes the event loop's wake latency
+ * for the current state, and time in each state is accumulated, so the
+ * latency cost of each profile can be read against the time it saves.
+ *
+ * The applier does the hardware work (applyPowerProfile() on the ESP32);
+ * timestamps are passed in, so the class itself has no platform
+ * dependencies.
+ */
+class PowerManager {
+public:
+    PowerManager();
+
+    /**
+     * @brief Set the profile for a state
+     * @param name Short name for format(); must outlive the manager
+     * @return false if state >= POWER_MAX_STATES
+     */
+    bool setProfile(uint8_t state, const char* name, const PowerProfile& profile);
+
+    void setApplier(PowerApplier applier);
+
+    /**
+     * @brief Switch to a state, applying its profile if it changed
+     */
+    void enter(uint8_t state, uint32_t nowMs);
+
+    /**
+     * @brief Record a wake latency against the current state
+     */
+    void recordWake(uint32_t latencyUs);
+
+    uint8_t getState() const;
+    const PowerProfile& getActiveProfile() const;
+
+    // Statistics
+    uint32_t getTimeInState(uint8_t state, uint32_t nowMs) const;    // Milliseconds
+    const LatencyHistogram& getWakeLatency(uint8_t state) const;     // Microseconds
+    uint32_t getSwitchCount() const;       // Profiles applied
+    uint32_t getFailureCount() const;      // Applier returned false
+    void resetStats(uint32_t nowMs);
+
+    /**
+     * @brief Format the statistics as one line, listing visited states as
+     *        share of time and wake latency p50/p99, e.g.
+     *        "POWER 80MHz sleep=light,modem switches=14 | waiting 95% 120/900, recording 2% 40/80"
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t format(char* out, size_t size, uint32_t nowMs) const;
+
+private:
+    struct StateInfo {
+        const char* name;
+        PowerProfile profile;
+        bool configured;
+        uint64_t timeMs;
+        LatencyHistogram wakeUs;
+    };
+
+    StateInfo states[POWER_MAX_STATES];
+    PowerApplier applier;
+    uint8_t state;
+    uint32_t enteredMs;
+    PowerProfile active;
+    bool applied;
+    uint32_t switches;
+    uint32_t failures;
+    uint32_t statsStartMs;
+
+    void apply(const PowerProfile& profile);
+};
+
+#ifdef ESP_PLATFORM
+/**
+ * @brief Apply a profile to the ESP32: CPU clock, automatic light sleep
+ *        (when the IDF power management is built in) and Wi-Fi power save
+ *
+ * Light sleep is skipped while the console is on USB Serial/JTAG, which
+ * would disconnect; on a UART console a few received bytes wake the chip
+ * (those bytes are lost). Running I2S drivers hold a power management
+ * lock, so audio keeps the chip awake by itself.
+ */
+bool applyPowerProfile(const PowerProfile& profile);
+#endif
+
+#endif
@@ -0,0 +1,209 @@
+#include "timer_wheel.h"
+#include <stdio.h>
+
+TimerWheel::TimerWheel() {
+    for (size_t i = 0; i < TIMER_WHEEL_MAX_TIMERS; i++) {
+        timers[i].generation = 0;
+    }
+    reset();
+}
+
+TimerId TimerWheel::schedule(uint32_t delayMs, TimerCallback callback, uint32_t nowMs) {
+    if (callback == nullptr) {
+        return 0;
+    }
+    sync(nowMs);
+
+    size_t index = 0;
+    while (index < TIMER_WHEEL_MAX_TIMERS && timers[index].active) {
+        index++;
+    }
+    if (index == TIMER_WHEEL_MAX_TIMERS) {
+        overflows++;
+        return 0;
+    }
+
+    // First tick at or after the deadline, never one advance() already passed
+    uint32_t sinceTickMs = (int32_t)(nowMs - tickStartMs) > 0 ? nowMs - tickStartMs : 0;
+    uint32_t dueTick = currentTick + (sinceTickMs + delayMs + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+    if (dueTick == currentTick) {
+        dueTick++;
+    }
+
+    Timer& timer = timers[index];
+    timer.callback = callback;
+    timer.dueTick = dueTick;
+    timer.generation++;
+    timer.next = -1;
+    timer.active = true;
+
+    // Append, so timers due on the same tick run in the order they were set
+    int8_t* link = &slots[dueTick % TIMER_WHEEL_SLOTS];
+    while (*link >= 0) {
+        link = &timers[*link].next;
+    }
+    *link = (int8_t)index;
+
+    return ((uint32_t)timer.generation << 8) | (uint32_t)(index + 1);
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    if (!isPending(id)) {
+        return false;
+    }
+    unlink((id & 0xFF) - 1);
+    return true;
+}
+
+bool TimerWheel::isPending(TimerId id) const {
+    size_t index = (id & 0xFF) - 1;
+    return id != 0 && index < TIMER_WHEEL_MAX_TIMERS && timers[index].active &&
+           timers[index].generation == (uint16_t)(id >> 8);
+}
+
+size_t TimerWheel::advance(uint32_t nowMs) {
+    sync(nowMs);
+    uint32_t elapsedTicks = (nowMs - tickStartMs) / TIMER_WHEEL_TICK_MS;
+    if (elapsedTicks == 0) {
+        return 0;
+    }
+
+    // Timers set by the callbacks below land after targetTick
+    uint32_t firstTick = currentTick + 1;
+    uint32_t targetTick = currentTick + elapsedTicks;
+    currentTick = targetTick;
+    tickStartMs += elapsedTicks * TIMER_WHEEL_TICK_MS;
+
+    // A gap of a full revolution or more visits every slot once
+    uint32_t ticks = elapsedTicks < TIMER_WHEEL_SLOTS ? elapsedTicks : TIMER_WHEEL_SLOTS;
+
+    size_t ran = 0;
+    for (uint32_t tick = firstTick; tick != firstTick + ticks; tick++) {
+        size_t slot = tick % TIMER_WHEEL_SLOTS;
+        int index;
+        // Rescan after each callback: it may have cancelled the next timer
+        while ((index = findDue(slot, targetTick)) >= 0) {
+            Timer& timer = timers[index];
+            TimerCallback callback = timer.callback;
+            int32_t lateMs = (int32_t)(nowMs - dueMs(timer.dueTick));
+            latenessMs.record(lateMs > 0 ? (uint32_t)lateMs : 0);
+            unlink(index);
+            fired++;
+            ran++;
+            callback();
+        }
+    }
+    return ran;
+}
+
+uint32_t TimerWheel::getMsUntilNext(uint32_t nowMs) const {
+    uint32_t best = UINT32_MAX;
+    for (size_t i = 0; i < TIMER_WHEEL_MAX_TIMERS; i++) {
+        if (!timers[i].active) {
+            continue;
+        }
+        int32_t remaining = (int32_t)(dueMs(timers[i].dueTick) - nowMs);
+        if (remaining <= 0) {
+            return 0;
+        }
+        if ((uint32_t)remaining < best) {
+            best = (uint32_t)remaining;
+        }
+    }
+    return best;
+}
+
+size_t TimerWheel::getPendingCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < TIMER_WHEEL_MAX_TIMERS; i++) {
+        if (timers[i].active) {
+            count++;
+        }
+    }
+    return count;
+}
+
+const LatencyHistogram& TimerWheel::getLateness() const {
+    return latenessMs;
+}
+
+uint32_t TimerWheel::getFiredCount() const {
+    return fired;
+}
+
+uint32_t TimerWheel::getOverflowCount() const {
+    return overflows;
+}
+
+void TimerWheel::resetStats() {
+    latenessMs.reset();
+    fired = 0;
+    overflows = 0;
+}
+
+size_t TimerWheel::format(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "TIMERS pending=%u fired=%lu late_ms p50=%lu max=%lu | full=%lu",
+                           (unsigned int)getPendingCount(),
+                           (unsigned long)fired,
+                           (unsigned long)latenessMs.getPercentile(50),
+                           (unsigned long)latenessMs.getMax(),
+                           (unsigned long)overflows);
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+void TimerWheel::reset() {
+    // Generations survive, so handles from before the reset stay invalid
+    for (size_t i = 0; i < TIMER_WHEEL_MAX_TIMERS; i++) {
+        timers[i].callback = nullptr;
+        timers[i].active = false;
+        timers[i].next = -1;
+    }
+    for (size_t i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        slots[i] = -1;
+    }
+    currentTick = 0;
+    tickStartMs = 0;
+    started = false;
+    resetStats();
+}
+
+void TimerWheel::sync(uint32_t nowMs) {
+    if (!started) {
+        tickStartMs = nowMs;
+        started = true;
+    }
+}
+
+uint32_t TimerWheel::dueMs(uint32_t tick) const {
+    return tickStartMs + (tick - currentTick) * TIMER_WHEEL_TICK_MS;
+}
+
+void TimerWheel::unlink(size_t index) {
+    int8_t* link = &slots[timers[index].dueTick % TIMER_WHEEL_SLOTS];
+    while (*link >= 0) {
+        if ((size_t)*link == index) {
+            *link = timers[index].next;
+            break;
+        }
+        link = &timers[*link].next;
+    }
+    timers[index].active = false;
+    timers[index].next = -1;
+}
+
+int TimerWheel::findDue(size_t slot, uint32_t tick) const {
+    for (int index = slots[slot]; index >= 0; index = timers[index].next) {
+        if ((int32_t)(tick - timers[index].dueTick) >= 0) {
+            return index;
+        }
+    }
+    return -1;
+}
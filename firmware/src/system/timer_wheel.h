@@ -0,0 +1,111 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../telemetry/latency_histogram.h"
+
+#ifndef TIMER_WHEEL_TICK_MS
+#define TIMER_WHEEL_TICK_MS 10          // Resolution; timers fire on the first tick at or after their deadline
+#endif
+
+#ifndef TIMER_WHEEL_SLOTS
+#define TIMER_WHEEL_SLOTS 64            // One revolution is 640 ms; longer timers wait for their round
+#endif
+
+#ifndef TIMER_WHEEL_MAX_TIMERS
+#define TIMER_WHEEL_MAX_TIMERS 16
+#endif
+
+typedef void (*TimerCallback)();
+
+// Handle returned by schedule(); 0 is never a valid timer
+typedef uint32_t TimerId;
+
+/**
+ * @class TimerWheel
+ * @brief Deferred callbacks for the main loop, so handlers never delay().
+ *
+ * A hashed timing wheel: each timer hangs off the slot of its deadline tick
+ * and advance() only visits the slots of the ticks that have passed, so the
+ * cost does not grow with how far ahead timers are set. Timers live in a
+ * fixed pool and callbacks run from advance(), on the caller's task; they
+ * may schedule or cancel timers, including themselves.
+ *
+ * Lateness past the deadline is recorded per callback. Much more than one
+ * tick of it means loop() was held up by something else.
+ */
+class TimerWheel {
+public:
+    TimerWheel();
+
+    /**
+     * @brief Run callback once, delayMs from now
+     * @return Handle for cancel(), 0 if the pool is full
+     */
+    TimerId schedule(uint32_t delayMs, TimerCallback callback, uint32_t nowMs);
+
+    /**
+     * @return true if the timer was pending; false if it already ran or was cancelled
+     */
+    bool cancel(TimerId id);
+
+    bool isPending(TimerId id) const;
+
+    /**
+     * @brief Run every callback whose deadline has passed
+     * @return Number of callbacks run
+     */
+    size_t advance(uint32_t nowMs);
+
+    /**
+     * @return Time until the next deadline, 0 if one is due, UINT32_MAX if none
+     */
+    uint32_t getMsUntilNext(uint32_t nowMs) const;
+
+    size_t getPendingCount() const;
+
+    // Statistics
+    const LatencyHistogram& getLateness() const;   // Deadline -> callback, ms
+    uint32_t getFiredCount() const;
+    uint32_t getOverflowCount() const;            // schedule() calls refused
+    void resetStats();
+
+    /**
+     * @brief Summary for the 'l' report: "TIMERS pending=2 fired=41 late_ms p50=1 max=12 | full=0",
+     *        where full counts the schedule() calls refused for want of a free timer
+     * @return Length of the line in out
+     */
+    size_t format(char* out, size_t size) const;
+
+    /**
+     * @brief Cancel every timer and clear the statistics
+     */
+    void reset();
+
+private:
+    struct Timer {
+        TimerCallback callback;
+        uint32_t dueTick;
+        uint16_t generation;
+        int8_t next;                 // Next timer in the same slot, -1 at the end
+        bool active;
+    };
+
+    Timer timers[TIMER_WHEEL_MAX_TIMERS];
+    int8_t slots[TIMER_WHEEL_SLOTS];  // First timer of each slot, -1 if empty
+    uint32_t currentTick;             // Last tick advance() has processed
+    uint32_t tickStartMs;             // When currentTick began; ticks count from the first call, so millis() wrap is harmless
+    bool started;
+
+    LatencyHistogram latenessMs;
+    uint32_t fired;
+    uint32_t overflows;
+
+    void sync(uint32_t nowMs);
+    uint32_t dueMs(uint32_t tick) const;
+    void unlink(size_t index);
+    int findDue(size_t slot, uint32_t tick) const;
+};
+
+#endif
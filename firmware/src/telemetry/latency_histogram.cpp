@@ -0,0 +1,106 @@
+#include "latency_histogram.h"
+#include <string.h>
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::record(uint32_t valueMs) {
+    buckets[bucketIndex(valueMs)]++;
+    samples++;
+    sum += valueMs;
+
+    if (samples == 1 || valueMs < minValue) {
+        minValue = valueMs;
+    }
+    if (valueMs > maxValue) {
+        maxValue = valueMs;
+    }
+}
+
+void LatencyHistogram::reset() {
+    memset(buckets, 0, sizeof(buckets));
+    samples = 0;
+    minValue = 0;
+    maxValue = 0;
+    sum = 0;
+}
+
+uint32_t LatencyHistogram::getPercentile(float percentile) const {
+    if (samples == 0) {
+        return 0;
+    }
+
+    if (percentile <= 0.0f) {
+        return minValue;
+    }
+    if (percentile >= 100.0f) {
+        return maxValue;
+    }
+
+    // Rank of the sample we're looking for (1-based, rounded up)
+    uint32_t rank = (uint32_t)((percentile / 100.0f) * samples);
+    if ((float)rank < (percentile / 100.0f) * samples) {
+        rank++;
+    }
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint32_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            if (i == BUCKET_COUNT - 1) {
+                return maxValue;  // Overflow bucket has no upper bound
+            }
+            uint32_t value = bucketUpperBound(i);
+            if (value > maxValue) value = maxValue;
+            if (value < minValue) value = minValue;
+            return value;
+        }
+    }
+
+    return maxValue;
+}
+
+uint32_t LatencyHistogram::getCount() const {
+    return samples;
+}
+
+uint32_t LatencyHistogram::getMin() const {
+    return minValue;
+}
+
+uint32_t LatencyHistogram::getMax() const {
+    return maxValue;
+}
+
+uint32_t LatencyHistogram::getMean() const {
+    return samples ? (uint32_t)(sum / samples) : 0;
+}
+
+size_t LatencyHistogram::bucketIndex(uint32_t valueMs) {
+    if (valueMs < LINEAR_BUCKETS) {
+        return valueMs;
+    }
+
+    uint32_t exponent = 31 - __builtin_clz(valueMs);  // >= 4
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+
+    uint32_t sub = (valueMs >> (exponent - 3)) & (SUB_BUCKETS - 1);
+    return LINEAR_BUCKETS + (exponent - 4) * SUB_BUCKETS + sub;
+}
+
+uint32_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < LINEAR_BUCKETS) {
+        return (uint32_t)index;
+    }
+
+    uint32_t exponent = (uint32_t)((index - LINEAR_BUCKETS) / SUB_BUCKETS) + 4;
+    uint32_t sub = (uint32_t)((index - LINEAR_BUCKETS) % SUB_BUCKETS);
+    uint32_t width = 1UL << (exponent - 3);
+    return (1UL << exponent) + (sub + 1) * width - 1;
+}
@@ -0,0 +1,59 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @class LatencyHistogram
+ * @brief Fixed-size streaming histogram of millisecond latencies.
+ *
+ * Values below 16 ms get their own bucket; above that every power of two
+ * is split into 8 sub-buckets, so percentiles are within 12.5% of the true
+ * value up to ~17 minutes. Recording is O(1) and never allocates.
+ */
+class LatencyHistogram {
+public:
+    static const uint8_t LINEAR_BUCKETS = 16;
+    static const uint8_t SUB_BUCKETS = 8;
+    static const uint8_t MAX_EXPONENT = 19;   // Values >= 2^20 ms are clamped
+    static const size_t BUCKET_COUNT = LINEAR_BUCKETS + (MAX_EXPONENT - 3) * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    /**
+     * @brief Record one latency sample
+     * @param valueMs Latency in milliseconds
+     */
+    void record(uint32_t valueMs);
+
+    /**
+     * @brief Discard all samples
+     */
+    void reset();
+
+    /**
+     * @brief Estimate a percentile
+     * @param percentile Percentile to query (0-100)
+     * @return Upper bound of the bucket holding the percentile, clamped to
+     *         the observed min/max; 0 if no samples were recorded
+     */
+    uint32_t getPercentile(float percentile) const;
+
+    uint32_t getCount() const;
+    uint32_t getMin() const;
+    uint32_t getMax() const;
+    uint32_t getMean() const;
+
+private:
+    uint32_t buckets[BUCKET_COUNT];
+    uint32_t samples;
+    uint32_t minValue;
+    uint32_t maxValue;
+    uint64_t sum;
+
+    static size_t bucketIndex(uint32_t valueMs);
+    static uint32_t bucketUpperBound(size_t index);
+};
+
+#endif
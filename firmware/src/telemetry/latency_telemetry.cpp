@@ -0,0 +1,87 @@
+#include "latency_telemetry.h"
+#include <stdio.h>
+
+LatencyTelemetry::LatencyTelemetry() :
+    lastUplinkMs(0),
+    responsePending(false),
+    audioPending(false) {
+}
+
+void LatencyTelemetry::recordPing(uint32_t pingMs) {
+    // The first ping of a session carries no measurement
+    if (pingMs > 0) {
+        pingRtt.record(pingMs);
+    }
+}
+
+void LatencyTelemetry::markUplinkChunk(uint32_t nowMs) {
+    lastUplinkMs = nowMs;
+    responsePending = true;
+    audioPending = true;
+}
+
+void LatencyTelemetry::markAgentResponse(uint32_t nowMs) {
+    if (responsePending) {
+        uplinkToResponse.record(nowMs - lastUplinkMs);
+        responsePending = false;
+    }
+}
+
+void LatencyTelemetry::markAudio(uint32_t nowMs) {
+    if (audioPending) {
+        uplinkToAudio.record(nowMs - lastUplinkMs);
+        audioPending = false;
+    }
+}
+
+void LatencyTelemetry::reset() {
+    pingRtt.reset();
+    uplinkToResponse.reset();
+    uplinkToAudio.reset();
+    responsePending = false;
+    audioPending = false;
+}
+
+size_t LatencyTelemetry::format(char* out, size_t size) const {
+    if (out == nullptr || size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "LAT ");
+    size_t used = (written > 0 && (size_t)written < size) ? (size_t)written : size - 1;
+
+    used += formatSeries(out + used, used < size ? size - used : 0, "ping", pingRtt);
+    used += formatSeries(out + used, used < size ? size - used : 0, " | resp", uplinkToResponse);
+    used += formatSeries(out + used, used < size ? size - used : 0, " | audio", uplinkToAudio);
+
+    return used < size ? used : size - 1;
+}
+
+const LatencyHistogram& LatencyTelemetry::getPingHistogram() const {
+    return pingRtt;
+}
+
+const LatencyHistogram& LatencyTelemetry::getResponseHistogram() const {
+    return uplinkToResponse;
+}
+
+const LatencyHistogram& LatencyTelemetry::getAudioHistogram() const {
+    return uplinkToAudio;
+}
+
+size_t LatencyTelemetry::formatSeries(char* out, size_t size, const char* name, const LatencyHistogram& histogram) {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "%s n=%lu p50=%lu p90=%lu p99=%lu max=%lu", name,
+                           (unsigned long)histogram.getCount(),
+                           (unsigned long)histogram.getPercentile(50),
+                           (unsigned long)histogram.getPercentile(90),
+                           (unsigned long)histogram.getPercentile(99),
+                           (unsigned long)histogram.getMax());
+    if (written < 0) {
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
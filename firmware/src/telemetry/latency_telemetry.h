@@ -0,0 +1,80 @@
+#ifndef LATENCY_TELEMETRY_H
+#define LATENCY_TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "latency_histogram.h"
+
+/**
+ * @class LatencyTelemetry
+ * @brief Collects conversation round-trip latencies as streaming histograms.
+ *
+ * Tracks three series:
+ *  - ping:  RTT reported by the server in ping_event.ping_ms
+ *  - resp:  end of the user's audio -> first agent_response of the turn
+ *  - audio: end of the user's audio -> first audio event of the turn
+ *
+ * A turn is armed by markUplinkChunk() and closed by the first response
+ * (or audio) that follows it. The caller marks the recording upload in
+ * push-to-talk mode and, in real-time mode, only chunks that carry speech,
+ * so silence streamed after the user stops doesn't restart the clock.
+ */
+class LatencyTelemetry {
+public:
+    LatencyTelemetry();
+
+    /**
+     * @brief Record a server-reported ping RTT
+     * @param pingMs RTT in milliseconds (0 means "not measured yet" and is ignored)
+     */
+    void recordPing(uint32_t pingMs);
+
+    /**
+     * @brief Mark that an uplink audio chunk holding the user's speech was sent
+     * @param nowMs Current time in milliseconds
+     */
+    void markUplinkChunk(uint32_t nowMs);
+
+    /**
+     * @brief Mark an agent_response event
+     * @param nowMs Current time in milliseconds
+     */
+    void markAgentResponse(uint32_t nowMs);
+
+    /**
+     * @brief Mark an audio event
+     * @param nowMs Current time in milliseconds
+     */
+    void markAudio(uint32_t nowMs);
+
+    /**
+     * @brief Discard all samples
+     */
+    void reset();
+
+    /**
+     * @brief Format all series as one compact line, e.g.
+     *        "LAT ping n=12 p50=85 p90=120 p99=180 max=190 | resp n=3 ... | audio n=3 ..."
+     * @param out Output buffer
+     * @param size Output buffer size in bytes
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t format(char* out, size_t size) const;
+
+    const LatencyHistogram& getPingHistogram() const;
+    const LatencyHistogram& getResponseHistogram() const;
+    const LatencyHistogram& getAudioHistogram() const;
+
+private:
+    LatencyHistogram pingRtt;
+    LatencyHistogram uplinkToResponse;
+    LatencyHistogram uplinkToAudio;
+
+    uint32_t lastUplinkMs;
+    bool responsePending;
+    bool audioPending;
+
+    static size_t formatSeries(char* out, size_t size, const char* name, const LatencyHistogram& histogram);
+};
+
+#endif
@@ -0,0 +1,285 @@
+#include "turn_tracer.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* const STAGE_NAMES[TURN_STAGE_COUNT] = {"uplink", "stt", "llm", "tts", "buffer", "play"};
+
+static void writeU16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void writeU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// Nearest-rank percentile of values[0..count), sorting them in place
+static int32_t percentile(int32_t* values, size_t count, uint32_t percent) {
+    for (size_t i = 1; i < count; i++) {
+        int32_t value = values[i];
+        size_t j = i;
+        while (j > 0 && values[j - 1] > value) {
+            values[j] = values[j - 1];
+            j--;
+        }
+        values[j] = value;
+    }
+    size_t rank = (percent * count + 99) / 100;
+    return values[rank > 0 ? rank - 1 : 0];
+}
+
+TurnTracer::TurnTracer() :
+    turnCallback(nullptr) {
+    reset();
+}
+
+void TurnTracer::mark(TurnPoint point, uint32_t nowMs) {
+    // Anything but more playback after a settled end starts the next turn
+    if (point != TURN_FIRST_SAMPLE && point != TURN_PLAYBACK_END && hasSettled(nowMs)) {
+        commit();
+    }
+
+    uint8_t bit = (uint8_t)(1u << point);
+    switch (point) {
+        case TURN_MIC_CAPTURE:
+        case TURN_UPLINK_SENT:
+            // Latest wins; once the server has answered they belong to the next turn
+            if (agentSide) {
+                pendingTimes[point] = nowMs;
+                pendingSeen |= bit;
+            } else {
+                set(point, nowMs);
+            }
+            break;
+
+        case TURN_USER_TRANSCRIPT:
+            // The user spoke again before this turn settled, e.g. a barge-in
+            if (agentSide) {
+                commit();
+            }
+            set(point, nowMs);
+            agentSide = true;
+            break;
+
+        case TURN_AGENT_RESPONSE:
+        case TURN_FIRST_AUDIO:
+            if (!(seen & bit)) {
+                set(point, nowMs);
+            }
+            agentSide = true;
+            break;
+
+        case TURN_FIRST_SAMPLE:
+            if (!(seen & bit)) {
+                set(point, nowMs);
+            } else {
+                // Playback resumed: the drain was an underrun, not the end
+                seen &= (uint8_t)~(1u << TURN_PLAYBACK_END);
+            }
+            agentSide = true;
+            break;
+
+        case TURN_PLAYBACK_END:
+            if (seen & (1u << TURN_FIRST_SAMPLE)) {
+                set(point, nowMs);
+            }
+            break;
+    }
+}
+
+void TurnTracer::flush(uint32_t nowMs) {
+    if (hasSettled(nowMs)) {
+        commit();
+    }
+}
+
+void TurnTracer::onTurn(TurnCallback callback) {
+    turnCallback = callback;
+}
+
+size_t TurnTracer::getTurnCount() const {
+    return count;
+}
+
+const TurnRecord& TurnTracer::getTurn(size_t index) const {
+    return records[(head + index) % TURN_TRACE_CAPACITY];
+}
+
+uint32_t TurnTracer::getCompletedTurns() const {
+    return completedTurns;
+}
+
+const char* TurnTracer::stageName(size_t stage) {
+    return stage < TURN_STAGE_COUNT ? STAGE_NAMES[stage] : "?";
+}
+
+int32_t TurnTracer::getStageMs(const TurnRecord& record, size_t stage) {
+    if (stage >= TURN_STAGE_COUNT || record.offsetMs[stage] == TURN_NOT_SEEN ||
+        record.offsetMs[stage + 1] == TURN_NOT_SEEN) {
+        return -1;
+    }
+    int32_t ms = (int32_t)record.offsetMs[stage + 1] - (int32_t)record.offsetMs[stage];
+    return ms >= 0 ? ms : -1;
+}
+
+int32_t TurnTracer::getFirstSoundMs(const TurnRecord& record) {
+    if (record.offsetMs[TURN_MIC_CAPTURE] == TURN_NOT_SEEN || record.offsetMs[TURN_FIRST_SAMPLE] == TURN_NOT_SEEN) {
+        return -1;
+    }
+    int32_t ms = (int32_t)record.offsetMs[TURN_FIRST_SAMPLE] - (int32_t)record.offsetMs[TURN_MIC_CAPTURE];
+    return ms >= 0 ? ms : -1;
+}
+
+void TurnTracer::reset() {
+    memset(times, 0, sizeof(times));
+    seen = 0;
+    memset(pendingTimes, 0, sizeof(pendingTimes));
+    pendingSeen = 0;
+    agentSide = false;
+    head = 0;
+    count = 0;
+    completedTurns = 0;
+}
+
+size_t TurnTracer::format(char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "TURNS n=%u", (unsigned int)count);
+    int32_t values[TURN_TRACE_CAPACITY];
+    for (size_t stage = 0; stage <= TURN_STAGE_COUNT && written >= 0 && (size_t)written < size; stage++) {
+        // The last column is the end-to-end figure
+        size_t samples = 0;
+        for (size_t i = 0; i < count; i++) {
+            const TurnRecord& record = getTurn(i);
+            int32_t ms = stage < TURN_STAGE_COUNT ? getStageMs(record, stage) : getFirstSoundMs(record);
+            if (ms >= 0) {
+                values[samples++] = ms;
+            }
+        }
+
+        const char* name = stage < TURN_STAGE_COUNT ? STAGE_NAMES[stage] : "first_sound";
+        if (samples == 0) {
+            written += snprintf(out + written, size - written, " | %s -", name);
+        } else {
+            int32_t p50 = percentile(values, samples, 50);
+            int32_t p95 = percentile(values, samples, 95);
+            written += snprintf(out + written, size - written, " | %s p50=%ld p95=%ld", name, (long)p50, (long)p95);
+        }
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+size_t TurnTracer::formatTurn(const TurnRecord& record, char* out, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    int written = snprintf(out, size, "TURN %lu", (unsigned long)record.turn);
+    for (size_t stage = 0; stage < TURN_STAGE_COUNT && written >= 0 && (size_t)written < size; stage++) {
+        int32_t ms = getStageMs(record, stage);
+        if (ms >= 0) {
+            written += snprintf(out + written, size - written, " %s=%ld", STAGE_NAMES[stage], (long)ms);
+        } else {
+            written += snprintf(out + written, size - written, " %s=-", STAGE_NAMES[stage]);
+        }
+    }
+    if (written >= 0 && (size_t)written < size) {
+        int32_t ms = getFirstSoundMs(record);
+        if (ms >= 0) {
+            written += snprintf(out + written, size - written, " | first_sound=%ld", (long)ms);
+        } else {
+            written += snprintf(out + written, size - written, " | first_sound=-");
+        }
+    }
+    if (written < 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return (size_t)written < size ? (size_t)written : size - 1;
+}
+
+size_t TurnTracer::getExportSize() const {
+    return TURN_EXPORT_HEADER_SIZE + count * TURN_EXPORT_RECORD_SIZE;
+}
+
+size_t TurnTracer::exportBinary(uint8_t* out, size_t size) const {
+    size_t needed = getExportSize();
+    if (out == nullptr || size < needed) {
+        return 0;
+    }
+
+    memcpy(out, TURN_EXPORT_MAGIC, 4);
+    out[4] = TURN_EXPORT_VERSION;
+    out[5] = TURN_POINT_COUNT;
+    writeU16(out + 6, (uint16_t)count);
+
+    uint8_t* p = out + TURN_EXPORT_HEADER_SIZE;
+    for (size_t i = 0; i < count; i++) {
+        const TurnRecord& record = getTurn(i);
+        writeU32(p, record.turn);
+        writeU32(p + 4, record.startMs);
+        for (size_t point = 0; point < TURN_POINT_COUNT; point++) {
+            writeU16(p + 8 + 2 * point, record.offsetMs[point]);
+        }
+        p += TURN_EXPORT_RECORD_SIZE;
+    }
+    return needed;
+}
+
+void TurnTracer::set(TurnPoint point, uint32_t nowMs) {
+    times[point] = nowMs;
+    seen |= (uint8_t)(1u << point);
+}
+
+void TurnTracer::commit() {
+    if (seen != 0) {
+        // Offsets are from the earliest point, whatever order they came in
+        uint32_t startMs = 0;
+        bool first = true;
+        for (size_t point = 0; point < TURN_POINT_COUNT; point++) {
+            if ((seen & (1u << point)) && (first || (int32_t)(times[point] - startMs) < 0)) {
+                startMs = times[point];
+                first = false;
+            }
+        }
+
+        TurnRecord& record = records[(head + count) % TURN_TRACE_CAPACITY];
+        if (count < TURN_TRACE_CAPACITY) {
+            count++;
+        } else {
+            head = (head + 1) % TURN_TRACE_CAPACITY;
+        }
+
+        record.turn = ++completedTurns;
+        record.startMs = startMs;
+        for (size_t point = 0; point < TURN_POINT_COUNT; point++) {
+            uint32_t offset = times[point] - startMs;
+            record.offsetMs[point] = !(seen & (1u << point)) ? TURN_NOT_SEEN
+                                     : offset < TURN_NOT_SEEN ? (uint16_t)offset
+                                     : (uint16_t)(TURN_NOT_SEEN - 1);
+        }
+
+        if (turnCallback) {
+            turnCallback(record);
+        }
+    }
+
+    // User-side points seen while the server answered start the next turn
+    seen = pendingSeen;
+    times[TURN_MIC_CAPTURE] = pendingTimes[TURN_MIC_CAPTURE];
+    times[TURN_UPLINK_SENT] = pendingTimes[TURN_UPLINK_SENT];
+    pendingSeen = 0;
+    agentSide = false;
+}
+
+bool TurnTracer::hasSettled(uint32_t nowMs) const {
+    return (seen & (1u << TURN_PLAYBACK_END)) && (int32_t)(nowMs - times[TURN_PLAYBACK_END]) >= TURN_SETTLE_MS;
+}
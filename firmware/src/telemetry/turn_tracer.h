@@ -0,0 +1,147 @@
+#ifndef TURN_TRACER_H
+#define TURN_TRACER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TURN_TRACE_CAPACITY
+#define TURN_TRACE_CAPACITY 32          // Most recent turns kept; the summary covers these
+#endif
+
+#ifndef TURN_SETTLE_MS
+#define TURN_SETTLE_MS 1000             // Playback drained this long ends the turn (not a queue underrun)
+#endif
+
+// Trace points of one turn, in the order they normally happen
+enum TurnPoint {
+    TURN_MIC_CAPTURE,       // Last microphone chunk captured before the user's turn ended
+    TURN_UPLINK_SENT,       // ...and finished sending
+    TURN_USER_TRANSCRIPT,
+    TURN_AGENT_RESPONSE,
+    TURN_FIRST_AUDIO,       // First audio event received
+    TURN_FIRST_SAMPLE,      // First sample written to I2S
+    TURN_PLAYBACK_END
+};
+
+#define TURN_POINT_COUNT 7
+#define TURN_STAGE_COUNT (TURN_POINT_COUNT - 1)   // Between consecutive points
+#define TURN_NOT_SEEN 0xFFFF
+
+/*
+ * Export layout (all integers little-endian):
+ *
+ *   header       "TURN" | uint8 version | uint8 point count | uint16 record count
+ *   each record  uint32 turn | uint32 start_ms | uint16 offset_ms[point count]
+ *
+ * Offsets are from start_ms, the earliest point of the turn, in TurnPoint
+ * order; TURN_NOT_SEEN marks a point the turn didn't reach. Records are
+ * oldest first.
+ */
+#define TURN_EXPORT_MAGIC "TURN"
+#define TURN_EXPORT_VERSION 1
+#define TURN_EXPORT_HEADER_SIZE 8
+#define TURN_EXPORT_RECORD_SIZE (8 + 2 * TURN_POINT_COUNT)
+
+struct TurnRecord {
+    uint32_t turn;
+    uint32_t startMs;
+    uint16_t offsetMs[TURN_POINT_COUNT];
+};
+
+/**
+ * @brief Notified when a turn is complete
+ */
+typedef void (*TurnCallback)(const TurnRecord& record);
+
+/**
+ * @class TurnTracer
+ * @brief Stitches trace points into one record per conversation turn, to
+ *        show where the time from end of speech to first sound goes.
+ *
+ * Microphone and uplink points keep the latest timestamp until the server
+ * answers, so in real-time mode they land on the last chunk before the
+ * user's turn ended. Agent-side points keep the first. A turn is complete
+ * once playback has been drained for TURN_SETTLE_MS, or when the next
+ * user transcript arrives (e.g. after a barge-in).
+ *
+ * The last TURN_TRACE_CAPACITY turns are kept in a ring, for the rolling
+ * summary and the binary export read by tools/turn_tool.py.
+ */
+class TurnTracer {
+public:
+    TurnTracer();
+
+    /**
+     * @brief Record a trace point
+     */
+    void mark(TurnPoint point, uint32_t nowMs);
+
+    /**
+     * @brief Complete the current turn if its playback has ended
+     *        (call before reading the summary)
+     */
+    void flush(uint32_t nowMs);
+
+    void onTurn(TurnCallback callback);
+
+    size_t getTurnCount() const;                        // Turns held, up to TURN_TRACE_CAPACITY
+    const TurnRecord& getTurn(size_t index) const;      // 0 is the oldest
+    uint32_t getCompletedTurns() const;                 // Since reset()
+    static const char* stageName(size_t stage);         // Stage i runs from point i to point i + 1
+
+    /**
+     * @return Stage duration in ms, or -1 if the turn lacks either end
+     */
+    static int32_t getStageMs(const TurnRecord& record, size_t stage);
+
+    /**
+     * @return Microphone capture -> first sample written, or -1
+     */
+    static int32_t getFirstSoundMs(const TurnRecord& record);
+
+    void reset();
+
+    /**
+     * @brief Format per-stage p50/p95 over the turns held, e.g.
+     *        "TURNS n=8 | uplink p50=12 p95=30 | stt p50=640 p95=900 | llm ... | first_sound p50=1750 p95=2400"
+     * @return Number of characters written (excluding the terminator)
+     */
+    size_t format(char* out, size_t size) const;
+
+    /**
+     * @brief Format one turn's breakdown, e.g.
+     *        "TURN 8 uplink=12 stt=640 llm=820 tts=280 buffer=9 play=4100 | first_sound=1761"
+     * @return Number of characters written (excluding the terminator)
+     */
+    static size_t formatTurn(const TurnRecord& record, char* out, size_t size);
+
+    /**
+     * @return Bytes exportBinary() needs for the turns held
+     */
+    size_t getExportSize() const;
+
+    /**
+     * @brief Write the turns held in the export layout
+     * @return Bytes written, 0 if size is less than getExportSize()
+     */
+    size_t exportBinary(uint8_t* out, size_t size) const;
+
+private:
+    uint32_t times[TURN_POINT_COUNT];
+    uint8_t seen;                       // Bit per TurnPoint
+    uint32_t pendingTimes[2];           // Microphone and uplink points for the next turn
+    uint8_t pendingSeen;
+    bool agentSide;                     // The server has answered; user-side points go to pending
+
+    TurnRecord records[TURN_TRACE_CAPACITY];
+    size_t head;                        // Oldest record
+    size_t count;
+    uint32_t completedTurns;
+    TurnCallback turnCallback;
+
+    void set(TurnPoint point, uint32_t nowMs);
+    void commit();
+    bool hasSettled(uint32_t nowMs) const;
+};
+
+#endif
@@ -0,0 +1,325 @@
+#include <unity.h>
+#include <string.h>
+#include "audio/audio_graph.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Hands out a ramp 1, 2, 3... up to a fixed frame size
+class RampSource : public AudioSource {
+public:
+    RampSource() : AudioSource("ramp"), next(1), frameSize(4), lastBuffer(nullptr), empty(false) {}
+
+    bool read(AudioFrame& frame) override {
+        lastBuffer = frame.samples;
+        if (empty) {
+            return false;
+        }
+        size_t count = frameSize < frame.capacity ? frameSize : frame.capacity;
+        for (size_t i = 0; i < count; i++) {
+            frame.samples[i] = next++;
+        }
+        frame.count = count;
+        frame.channels = 1;
+        return true;
+    }
+
+    int16_t next;
+    size_t frameSize;
+    int16_t* lastBuffer;
+    bool empty;
+};
+
+// Drops every frame while closed
+class GateFilter : public AudioFilter {
+public:
+    GateFilter() : AudioFilter("gate"), open(true) {}
+
+    bool process(AudioFrame&) override {
+        return open;
+    }
+
+    bool open;
+};
+
+static uint32_t fakeCycles;
+static uint32_t tickClock() {
+    fakeCycles += 10;
+    return fakeCycles;
+}
+
+static int16_t blocks[4][8];
+static size_t blockCount;
+static size_t tapped;
+static const int16_t* tappedSamples;
+
+static void onBlock(const int16_t* samples, size_t count) {
+    if (blockCount < 4) {
+        memcpy(blocks[blockCount], samples, count * sizeof(int16_t));
+    }
+    blockCount++;
+}
+
+static void onTap(const int16_t* samples, size_t count) {
+    tappedSamples = samples;
+    tapped += count;
+}
+
+void setUp(void) {
+    fakeCycles = 0;
+    blockCount = 0;
+    tapped = 0;
+    tappedSamples = nullptr;
+    memset(blocks, 0, sizeof(blocks));
+}
+
+void tearDown(void) {
+}
+
+void test_source_reads_straight_into_the_sink_block() {
+    int16_t scratch[16];
+    int16_t block[10];
+    RampSource source;
+    BlockSink recorder("recorder");
+    AudioGraph graph("test");
+    graph.setSource(&source);
+    graph.addSink(&recorder);
+    graph.setBuffer(scratch, 16);
+    recorder.setBlock(block, 10);
+
+    TEST_ASSERT_TRUE(graph.run());
+    TEST_ASSERT_EQUAL_PTR(block, source.lastBuffer);
+    TEST_ASSERT_TRUE(graph.run());
+    TEST_ASSERT_EQUAL_PTR(block + 4, source.lastBuffer);
+
+    // The last read is cut to what the block still has room for
+    TEST_ASSERT_TRUE(graph.run());
+    TEST_ASSERT_EQUAL(10, recorder.getFill());
+    TEST_ASSERT_TRUE(recorder.isFull());
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT16(i + 1, block[i]);
+    }
+
+    // A full block offers nothing, so the graph falls back to its buffer
+    TEST_ASSERT_TRUE(graph.run());
+    TEST_ASSERT_EQUAL_PTR(scratch, source.lastBuffer);
+    TEST_ASSERT_EQUAL(10, recorder.getFill());
+}
+
+void test_block_callback_delivers_whole_blocks() {
+    int16_t scratch[16];
+    int16_t block[6];
+    RampSource source;
+    BlockSink chunker("chunker");
+    AudioGraph graph("test");
+    graph.setSource(&source);
+    graph.addSink(&chunker);
+    graph.setBuffer(scratch, 16);
+    chunker.setBlock(block, 6);
+    chunker.setCallback(onBlock);
+
+    // Reads stop at the block boundary: 4, 2, 4, 2
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(graph.run());
+    }
+    TEST_ASSERT_EQUAL(2, blockCount);
+    TEST_ASSERT_EQUAL(0, chunker.getFill());
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_INT16(i + 1, blocks[0][i]);
+        TEST_ASSERT_EQUAL_INT16(i + 7, blocks[1][i]);
+    }
+}
+
+void test_resize_keeps_collected_samples() {
+    int16_t scratch[16];
+    int16_t block[8];
+    RampSource source;
+    BlockSink chunker("chunker");
+    AudioGraph graph("test");
+    graph.setSource(&source);
+    graph.addSink(&chunker);
+    graph.setBuffer(scratch, 16);
+    chunker.setBlock(block, 8);
+    chunker.setCallback(onBlock);
+
+    // Shrunk below the 4 samples collected: they go out as they are
+    TEST_ASSERT_TRUE(graph.run());
+    chunker.resize(2);
+    TEST_ASSERT_EQUAL(1, blockCount);
+    TEST_ASSERT_EQUAL(0, chunker.getFill());
+    TEST_ASSERT_EQUAL_INT16(4, blocks[0][3]);
+
+    // Reads now stop at the new length
+    TEST_ASSERT_TRUE(graph.run());
+    TEST_ASSERT_EQUAL(2, blockCount);
+    TEST_ASSERT_EQUAL_INT16(5, blocks[1][0]);
+    TEST_ASSERT_EQUAL_INT16(6, blocks[1][1]);
+
+    // Never beyond the storage
+    chunker.resize(100);
+    TEST_ASSERT_EQUAL(8, chunker.getBlockSize());
+}
+
+void test_fan_out_shares_one_frame_and_copies_only_into_other_blocks() {
+    int16_t scratch[16];
+    int16_t first[8];
+    int16_t second[8];
+    RampSource source;
+    CallbackSink tap("tap");
+    BlockSink a("a");
+    BlockSink b("b");
+    AudioGraph graph("test");
+    graph.setSource(&source);
+    graph.addSink(&tap);
+    graph.addSink(&a);
+    graph.addSink(&b);
+    graph.setBuffer(scratch, 16);
+    tap.setCallback(onTap);
+    a.setBlock(first, 8);
+    b.setBlock(second, 8);
+
+    TEST_ASSERT_TRUE(graph.run());
+    // The tap offers no storage, so the frame lives in the first block
+    TEST_ASSERT_EQUAL_PTR(first, tappedSamples);
+    TEST_ASSERT_EQUAL(4, tapped);
+    TEST_ASSERT_EQUAL(4, a.getFill());
+    TEST_ASSERT_EQUAL(4, b.getFill());
+    TEST_ASSERT_EQUAL_INT16(4, second[3]);
+
+    // Detaching a sink keeps the others in order
+    TEST_ASSERT_TRUE(graph.removeSink(&a));
+    TEST_ASSERT_FALSE(graph.removeSink(&a));
+    TEST_ASSERT_TRUE(graph.run());
+    TEST_ASSERT_EQUAL_PTR(second + 4, tappedSamples);
+    TEST_ASSERT_EQUAL(8, b.getFill());
+}
+
+void test_gain_clamps_and_stereo_widens_in_place() {
+    int16_t buffer[8];
+    RampSource source;
+    GainFilter gain("gain", 1000.0f);
+    MonoToStereoFilter stereo("stereo");
+    CallbackSink tap("tap");
+    AudioGraph graph("test");
+    graph.setSource(&source);
+    graph.addFilter(&gain);
+    graph.addFilter(&stereo);
+    graph.addSink(&tap);
+    graph.setBuffer(buffer, 8);
+    tap.setCallback(onTap);
+
+    source.next = 30;
+    TEST_ASSERT_TRUE(graph.run());
+    TEST_ASSERT_EQUAL(8, tapped);
+    TEST_ASSERT_EQUAL_PTR(buffer, tappedSamples);
+    TEST_ASSERT_EQUAL_INT16(30000, buffer[0]);
+    TEST_ASSERT_EQUAL_INT16(30000, buffer[1]);
+    TEST_ASSERT_EQUAL_INT16(32000, buffer[4]);
+    TEST_ASSERT_EQUAL_INT16(32000, buffer[5]);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, buffer[6]);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, buffer[7]);
+
+    // No room to double the frame: dropped rather than overrun
+    source.frameSize = 8;
+    TEST_ASSERT_FALSE(graph.run());
+    TEST_ASSERT_EQUAL(1, graph.getDropped());
+    TEST_ASSERT_EQUAL(8, tapped);
+}
+
+void test_dropped_frames_do_not_advance_the_block() {
+    int16_t block[8];
+    RampSource source;
+    GateFilter gate;
+    BlockSink recorder("recorder");
+    AudioGraph graph("test");
+    graph.setSource(&source);
+    graph.addFilter(&gate);
+    graph.addSink(&recorder);
+    recorder.setBlock(block, 8);
+
+    gate.open = false;
+    TEST_ASSERT_FALSE(graph.run());
+    TEST_ASSERT_EQUAL(0, recorder.getFill());
+    gate.open = true;
+    TEST_ASSERT_TRUE(graph.run());
+    TEST_ASSERT_EQUAL(4, recorder.getFill());
+    TEST_ASSERT_EQUAL_INT16(5, block[0]);
+
+    // Nothing read: nothing counted
+    source.empty = true;
+    TEST_ASSERT_FALSE(graph.run());
+    TEST_ASSERT_EQUAL(1, graph.getFrames());
+    TEST_ASSERT_EQUAL(1, graph.getDropped());
+}
+
+void test_no_storage_means_no_read() {
+    RampSource source;
+    BlockSink recorder("recorder");
+    AudioGraph graph("test");
+    graph.setSource(&source);
+    graph.addSink(&recorder);
+
+    TEST_ASSERT_FALSE(graph.run());
+    TEST_ASSERT_NULL(source.lastBuffer);
+}
+
+void test_cycles_are_accounted_per_node() {
+    int16_t buffer[8];
+    char line[160];
+    RampSource source;
+    GainFilter gain("gain", 2.0f);
+    CallbackSink tap("tap");
+    BlockSink unused("unused");
+    AudioGraph graph("mic");
+    graph.setSource(&source);
+    graph.addFilter(&gain);
+    graph.addSink(&tap);
+    graph.setBuffer(buffer, 8);
+    graph.setClock(tickClock);
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(graph.run());
+    }
+    // Each clock read advances 10 cycles, one read per node boundary
+    TEST_ASSERT_EQUAL_UINT32(3, source.getFrames());
+    TEST_ASSERT_EQUAL_UINT32(10, source.getAverageCycles());
+    TEST_ASSERT_EQUAL_UINT32(10, gain.getAverageCycles());
+    TEST_ASSERT_EQUAL_UINT32(10, tap.getMaxCycles());
+
+    graph.addSink(&unused);
+    graph.format(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("AUDIO mic frames=3 drop=0 | ramp=10/10 gain=10/10 tap=10/10 unused=-", line);
+
+    graph.resetStats();
+    TEST_ASSERT_EQUAL_UINT32(0, gain.getFrames());
+    TEST_ASSERT_EQUAL_UINT32(0, graph.getFrames());
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_source_reads_straight_into_the_sink_block);
+    RUN_TEST(test_block_callback_delivers_whole_blocks);
+    RUN_TEST(test_resize_keeps_collected_samples);
+    RUN_TEST(test_fan_out_shares_one_frame_and_copies_only_into_other_blocks);
+    RUN_TEST(test_gain_clamps_and_stereo_widens_in_place);
+    RUN_TEST(test_dropped_frames_do_not_advance_the_block);
+    RUN_TEST(test_no_storage_means_no_read);
+    RUN_TEST(test_cycles_are_accounted_per_node);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,121 @@
+#include <unity.h>
+#include <math.h>
+#include "audio/barge_in_detector.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static const size_t FRAME = 256;        // One DMA read at 16 kHz
+static const uint32_t FRAME_MS = 16;
+
+static BargeInDetector detector;
+static int16_t frame[FRAME];
+static uint32_t nowMs;
+
+static void fill(int amplitude) {
+    for (size_t i = 0; i < FRAME; i++) {
+        frame[i] = (int16_t)(amplitude * sin(2.0 * M_PI * 300.0 * i / 16000.0));
+    }
+}
+
+// Feeds frames of one amplitude; returns the 1-based frame that triggered, 0 if none
+static int feed(int amplitude, int frames) {
+    fill(amplitude);
+    int triggeredAt = 0;
+    for (int i = 0; i < frames; i++) {
+        nowMs += FRAME_MS;
+        if (detector.processFrame(frame, FRAME, nowMs) && triggeredAt == 0) {
+            triggeredAt = i + 1;
+        }
+    }
+    return triggeredAt;
+}
+
+void setUp(void) {
+    detector.reset();
+    nowMs = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_quiet_room_never_triggers() {
+    TEST_ASSERT_EQUAL(0, feed(200, 200));
+}
+
+void test_speech_triggers_after_hold_frames() {
+    feed(200, 50);
+    uint32_t burstStartMs = nowMs + FRAME_MS;
+    TEST_ASSERT_EQUAL(BARGE_IN_HOLD_FRAMES, feed(8000, 20));
+    TEST_ASSERT_EQUAL_UINT32(burstStartMs, detector.getOnsetMs());
+}
+
+void test_short_click_is_ignored() {
+    feed(200, 50);
+    TEST_ASSERT_EQUAL(0, feed(8000, BARGE_IN_HOLD_FRAMES - 1));
+    TEST_ASSERT_EQUAL(0, feed(200, 10));
+}
+
+void test_one_trigger_per_burst() {
+    feed(200, 50);
+    TEST_ASSERT_TRUE(feed(8000, 10) > 0);
+    TEST_ASSERT_EQUAL(0, feed(8000, 10));
+    feed(200, 5);
+    TEST_ASSERT_TRUE(feed(8000, 10) > 0);
+}
+
+void test_last_speech_stops_at_silence() {
+    feed(200, 50);
+    TEST_ASSERT_EQUAL_UINT32(0, detector.getLastSpeechMs());
+    feed(8000, BARGE_IN_HOLD_FRAMES - 1);
+    TEST_ASSERT_EQUAL_UINT32(0, detector.getLastSpeechMs());  // Not held yet
+    feed(8000, 10);
+    uint32_t endOfSpeechMs = nowMs;
+    TEST_ASSERT_EQUAL_UINT32(endOfSpeechMs, detector.getLastSpeechMs());
+    feed(200, 30);
+    TEST_ASSERT_EQUAL_UINT32(endOfSpeechMs, detector.getLastSpeechMs());
+}
+
+void test_echo_is_learned_during_grace() {
+    feed(200, 50);
+    detector.arm(nowMs);
+    // Agent audio coming back through the microphone
+    TEST_ASSERT_EQUAL(0, feed(3000, 60));
+    TEST_ASSERT_TRUE(detector.getFloorRms() > 1500);
+
+    // The user talking over it is much louder still
+    TEST_ASSERT_TRUE(feed(16000, 10) > 0);
+}
+
+void test_echo_without_grace_would_trigger() {
+    feed(200, 50);
+    TEST_ASSERT_TRUE(feed(3000, 10) > 0);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_quiet_room_never_triggers);
+    RUN_TEST(test_speech_triggers_after_hold_frames);
+    RUN_TEST(test_short_click_is_ignored);
+    RUN_TEST(test_one_trigger_per_burst);
+    RUN_TEST(test_last_speech_stops_at_silence);
+    RUN_TEST(test_echo_is_learned_during_grace);
+    RUN_TEST(test_echo_without_grace_would_trigger);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
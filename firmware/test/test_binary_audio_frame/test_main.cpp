@@ -0,0 +1,88 @@
+#include <unity.h>
+#include <string.h>
+#include "communication/binary_audio_frame.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+uint8_t frame[BINARY_AUDIO_HEADER_SIZE + 8];
+
+void setUp(void) {
+    writeBinaryAudioHeader(frame, BINARY_AUDIO_FORMAT_PCM_16000, 0x01020304, 8);
+    for (int i = 0; i < 8; i++) {
+        frame[BINARY_AUDIO_HEADER_SIZE + i] = (uint8_t)i;
+    }
+}
+
+void tearDown(void) {
+    // Nothing to clean up
+}
+
+void test_header_layout_is_little_endian() {
+    const uint8_t expected[BINARY_AUDIO_HEADER_SIZE] = {
+        1, BINARY_AUDIO_FORMAT_PCM_16000, 0, 0,
+        0x04, 0x03, 0x02, 0x01,
+        8, 0, 0, 0
+    };
+    TEST_ASSERT_EQUAL_MEMORY(expected, frame, BINARY_AUDIO_HEADER_SIZE);
+}
+
+void test_parse_points_into_frame() {
+    BinaryAudioFrame parsed;
+    TEST_ASSERT_TRUE(parseBinaryAudioFrame(frame, sizeof(frame), parsed));
+    TEST_ASSERT_EQUAL_UINT32(0x01020304, parsed.eventId);
+    TEST_ASSERT_EQUAL_UINT8(BINARY_AUDIO_FORMAT_PCM_16000, parsed.format);
+    TEST_ASSERT_EQUAL(8, parsed.length);
+    TEST_ASSERT_TRUE(parsed.pcm == frame + BINARY_AUDIO_HEADER_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(16000, binaryAudioSampleRate(parsed.format));
+}
+
+void test_rejects_length_mismatch() {
+    BinaryAudioFrame parsed;
+    TEST_ASSERT_FALSE(parseBinaryAudioFrame(frame, sizeof(frame) - 1, parsed));
+    TEST_ASSERT_FALSE(parseBinaryAudioFrame(frame, BINARY_AUDIO_HEADER_SIZE - 1, parsed));
+}
+
+void test_rejects_unknown_version_and_format() {
+    BinaryAudioFrame parsed;
+
+    frame[0] = 2;
+    TEST_ASSERT_FALSE(parseBinaryAudioFrame(frame, sizeof(frame), parsed));
+
+    frame[0] = BINARY_AUDIO_VERSION;
+    frame[1] = 0;
+    TEST_ASSERT_FALSE(parseBinaryAudioFrame(frame, sizeof(frame), parsed));
+}
+
+void test_empty_payload_is_valid() {
+    BinaryAudioFrame parsed;
+    writeBinaryAudioHeader(frame, BINARY_AUDIO_FORMAT_PCM_24000, 7, 0);
+    TEST_ASSERT_TRUE(parseBinaryAudioFrame(frame, BINARY_AUDIO_HEADER_SIZE, parsed));
+    TEST_ASSERT_EQUAL(0, parsed.length);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_header_layout_is_little_endian);
+    RUN_TEST(test_parse_points_into_frame);
+    RUN_TEST(test_rejects_length_mismatch);
+    RUN_TEST(test_rejects_unknown_version_and_format);
+    RUN_TEST(test_empty_payload_is_valid);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,114 @@
+#include <unity.h>
+#include <string.h>
+#include "system/boot_timeline.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static BootTimeline* timeline;
+
+void setUp(void) {
+    static BootTimeline instance;
+    instance = BootTimeline();
+    timeline = &instance;
+}
+
+void tearDown(void) {
+}
+
+void test_overlapping_phases_keep_their_own_times() {
+    int wifi = timeline->begin("wifi", 100);
+    int mic = timeline->begin("microphone", 110);
+    timeline->end(mic, 150);
+    timeline->end(wifi, 2100);
+
+    TEST_ASSERT_EQUAL(2, timeline->getPhaseCount());
+    TEST_ASSERT_EQUAL_UINT32(2000, timeline->getPhaseMs(0));
+    TEST_ASSERT_EQUAL_UINT32(40, timeline->getPhaseMs(1));
+
+    // Ending twice keeps the first end
+    timeline->end(mic, 900);
+    TEST_ASSERT_EQUAL_UINT32(40, timeline->getPhaseMs(1));
+}
+
+void test_running_phase_and_invalid_ids() {
+    int phase = timeline->begin("network", 0);
+    TEST_ASSERT_EQUAL_UINT32(0, timeline->getPhaseMs(phase));
+    timeline->end(-1, 10);
+    timeline->end(5, 10);
+    TEST_ASSERT_EQUAL_UINT32(0, timeline->getPhaseMs(phase));
+
+    for (int i = 1; i < BOOT_MAX_PHASES; i++) {
+        TEST_ASSERT_EQUAL_INT(i, timeline->begin("x", 0));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, timeline->begin("overflow", 0));
+}
+
+void test_ready_recorded_once() {
+    TEST_ASSERT_FALSE(timeline->isReady());
+    timeline->markReady(3000);
+    timeline->markReady(5000);
+    TEST_ASSERT_TRUE(timeline->isReady());
+    TEST_ASSERT_EQUAL_UINT32(3000, timeline->getReadyMs());
+}
+
+void test_format_phase_bar() {
+    int wifi = timeline->begin("wifi", 0);
+    int speaker = timeline->begin("speaker", 1000);
+    timeline->end(speaker, 1010, false);
+    timeline->end(wifi, 2000);
+    timeline->markReady(4000);
+
+    char line[128];
+    timeline->formatPhase(0, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("wifi             0 ->  2000 ms  2000 ms |####################                    |", line);
+
+    // A short phase still shows one column
+    timeline->formatPhase(1, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("speaker       1000 ->  1010 ms    10 ms |          #                             | FAILED", line);
+
+    // Too small for the bar: the text alone
+    char small[48];
+    timeline->formatPhase(0, small, sizeof(small));
+    TEST_ASSERT_EQUAL_STRING("wifi             0 ->  2000 ms  2000 ms", small);
+}
+
+void test_format_summary() {
+    char line[96];
+    int wifi = timeline->begin("wifi", 0);
+    int network = timeline->begin("network", 2000);
+    timeline->end(wifi, 1900);
+    timeline->format(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("BOOT ready=- | wifi=1900 network=-", line);
+
+    timeline->end(network, 2500, false);
+    timeline->markReady(2500);
+    timeline->format(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("BOOT ready=2500ms | wifi=1900 network=500!", line);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_overlapping_phases_keep_their_own_times);
+    RUN_TEST(test_running_phase_and_invalid_ids);
+    RUN_TEST(test_ready_recorded_once);
+    RUN_TEST(test_format_phase_bar);
+    RUN_TEST(test_format_summary);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,245 @@
+#include <unity.h>
+#include <string.h>
+#include "system/command_shell.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+#define MODE_NORMAL 1
+#define MODE_REALTIME 2
+
+static CommandShell* shell;
+static int stopCount;
+static char lastArgs[SHELL_LINE_MAX + 1];
+static char lastFallback[SHELL_LINE_MAX + 1];
+static int fallbackCount;
+
+// Everything the shell wrote
+static uint8_t written[1024];
+static size_t writtenLength;
+
+static void onStop(const char* args) {
+    stopCount++;
+    strncpy(lastArgs, args, sizeof(lastArgs) - 1);
+}
+
+static void onFallback(const char* line) {
+    fallbackCount++;
+    strncpy(lastFallback, line, sizeof(lastFallback) - 1);
+}
+
+static size_t capture(const uint8_t* data, size_t size) {
+    memcpy(written + writtenLength, data, size);
+    writtenLength += size;
+    return size;
+}
+
+static void reportMetrics(ShellEmit emit) {
+    emit("LAT a=1");
+    emit("LOOP b=2");
+}
+
+static void feedText(const char* text, uint32_t nowMs = 0) {
+    shell->feed((const uint8_t*)text, strlen(text), nowMs);
+}
+
+static size_t buildFrame(uint8_t* out, uint8_t type, uint8_t seq, const char* payload) {
+    size_t length = payload ? strlen(payload) : 0;
+    out[0] = SHELL_FRAME_SYNC;
+    out[1] = type;
+    out[2] = seq;
+    out[3] = (uint8_t)length;
+    out[4] = (uint8_t)(length >> 8);
+    memcpy(out + 5, payload, length);
+    uint16_t crc = CommandShell::crc16(out + 1, 4 + length);
+    out[5 + length] = (uint8_t)crc;
+    out[6 + length] = (uint8_t)(crc >> 8);
+    return 7 + length;
+}
+
+// Checks the frame at offset and moves offset past it
+static void expectFrame(size_t& offset, uint8_t type, uint8_t seq, const void* payload, size_t length) {
+    TEST_ASSERT_EQUAL_UINT8(SHELL_FRAME_SYNC, written[offset]);
+    TEST_ASSERT_EQUAL_UINT8(type, written[offset + 1]);
+    TEST_ASSERT_EQUAL_UINT8(seq, written[offset + 2]);
+    TEST_ASSERT_EQUAL(length, written[offset + 3] | (written[offset + 4] << 8));
+    if (length > 0) {
+        TEST_ASSERT_EQUAL_MEMORY(payload, written + offset + 5, length);
+    }
+    uint16_t crc = CommandShell::crc16(written + offset + 1, 4 + length);
+    TEST_ASSERT_EQUAL_UINT16(crc, written[offset + 5 + length] | (written[offset + 6 + length] << 8));
+    offset += 7 + length;
+}
+
+void setUp(void) {
+    static CommandShell instance;
+    instance = CommandShell();
+    shell = &instance;
+    shell->registerCommand("s", onStop, MODE_NORMAL | MODE_REALTIME);
+    shell->registerCommand("realtime", onStop, MODE_NORMAL);
+    shell->onFallback(onFallback);
+    shell->setWriter(capture);
+    shell->setMetricsProvider(reportMetrics);
+    stopCount = 0;
+    fallbackCount = 0;
+    memset(lastArgs, 0, sizeof(lastArgs));
+    memset(lastFallback, 0, sizeof(lastFallback));
+    writtenLength = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_crc16_check_value() {
+    TEST_ASSERT_EQUAL_UINT16(0x29B1, CommandShell::crc16((const uint8_t*)"123456789", 9));
+}
+
+void test_partial_line_waits_for_its_end() {
+    feedText("  S");
+    TEST_ASSERT_EQUAL_INT(0, stopCount);
+    feedText("  now please \r\n");
+    TEST_ASSERT_EQUAL_INT(1, stopCount);
+    TEST_ASSERT_EQUAL_STRING("now please", lastArgs);
+
+    // The \n after \r is an empty line, not a second command
+    TEST_ASSERT_EQUAL_UINT32(1, shell->getLineCount());
+    TEST_ASSERT_EQUAL_INT(0, fallbackCount);
+}
+
+void test_mode_limits_commands() {
+    shell->setMode(MODE_REALTIME);
+    feedText("REALTIME extra\n");
+    TEST_ASSERT_EQUAL_INT(0, stopCount);
+    TEST_ASSERT_EQUAL_INT(1, fallbackCount);
+    TEST_ASSERT_EQUAL_STRING("REALTIME extra", lastFallback);
+
+    feedText("s\n");
+    TEST_ASSERT_EQUAL_INT(1, stopCount);
+}
+
+void test_backspace_and_overlong_lines() {
+    feedText("sx\b\n");
+    TEST_ASSERT_EQUAL_INT(1, stopCount);
+
+    char longLine[SHELL_LINE_MAX + 10];
+    memset(longLine, 's', sizeof(longLine) - 1);
+    longLine[sizeof(longLine) - 1] = '\0';
+    feedText(longLine);
+    feedText("\n");
+    TEST_ASSERT_EQUAL_INT(1, stopCount);
+    TEST_ASSERT_EQUAL_INT(0, fallbackCount);
+    TEST_ASSERT_EQUAL_UINT32(1, shell->getOverflowCount());
+
+    // The next line is unaffected
+    feedText("s\n");
+    TEST_ASSERT_EQUAL_INT(2, stopCount);
+}
+
+void test_ping_frame_between_text_lines() {
+    uint8_t frame[64];
+    size_t length = buildFrame(frame, SHELL_FRAME_PING, 7, "hello");
+    feedText("s\n");
+    shell->feed(frame, length, 0);
+    feedText("s\n");
+
+    TEST_ASSERT_EQUAL_INT(2, stopCount);
+    TEST_ASSERT_EQUAL_UINT32(1, shell->getFrameCount());
+    size_t offset = 0;
+    expectFrame(offset, SHELL_FRAME_PING | SHELL_FRAME_REPLY, 7, "hello", 5);
+    TEST_ASSERT_EQUAL(writtenLength, offset);
+}
+
+void test_command_frame_replies_with_status() {
+    uint8_t frame[64];
+    size_t length = buildFrame(frame, SHELL_FRAME_COMMAND, 1, "s 5");
+    length += buildFrame(frame + length, SHELL_FRAME_COMMAND, 2, "nope");
+
+    // Byte by byte, as a slow port would deliver it
+    for (size_t i = 0; i < length; i++) {
+        shell->feed(frame + i, 1, i);
+    }
+
+    TEST_ASSERT_EQUAL_INT(1, stopCount);
+    TEST_ASSERT_EQUAL_STRING("5", lastArgs);
+    TEST_ASSERT_EQUAL_INT(1, fallbackCount);
+    uint8_t ok = SHELL_STATUS_OK;
+    uint8_t unknown = SHELL_STATUS_UNKNOWN;
+    size_t offset = 0;
+    expectFrame(offset, SHELL_FRAME_COMMAND | SHELL_FRAME_REPLY, 1, &ok, 1);
+    expectFrame(offset, SHELL_FRAME_COMMAND | SHELL_FRAME_REPLY, 2, &unknown, 1);
+    TEST_ASSERT_EQUAL(writtenLength, offset);
+}
+
+void test_metrics_frame_streams_one_reply_per_line() {
+    uint8_t frame[16];
+    size_t length = buildFrame(frame, SHELL_FRAME_METRICS, 9, nullptr);
+    shell->feed(frame, length, 0);
+
+    size_t offset = 0;
+    expectFrame(offset, SHELL_FRAME_METRICS | SHELL_FRAME_REPLY, 9, "LAT a=1", 7);
+    expectFrame(offset, SHELL_FRAME_METRICS | SHELL_FRAME_REPLY, 9, "LOOP b=2", 8);
+    expectFrame(offset, SHELL_FRAME_METRICS | SHELL_FRAME_REPLY, 9, nullptr, 0);
+    TEST_ASSERT_EQUAL(writtenLength, offset);
+}
+
+void test_corrupt_and_stalled_frames_are_dropped() {
+    uint8_t frame[64];
+    size_t length = buildFrame(frame, SHELL_FRAME_COMMAND, 1, "s");
+    frame[length - 1] ^= 0xFF;
+    shell->feed(frame, length, 0);
+    TEST_ASSERT_EQUAL_INT(0, stopCount);
+    TEST_ASSERT_EQUAL_UINT32(1, shell->getBadFrameCount());
+    TEST_ASSERT_EQUAL(0, writtenLength);
+
+    // Half a frame, then typing resumes much later
+    length = buildFrame(frame, SHELL_FRAME_COMMAND, 2, "s");
+    shell->feed(frame, 3, 1000);
+    feedText("s\n", 1000 + SHELL_FRAME_TIMEOUT_MS + 1);
+    TEST_ASSERT_EQUAL_INT(1, stopCount);
+    TEST_ASSERT_EQUAL_UINT32(2, shell->getBadFrameCount());
+
+    // Oversized length field
+    frame[3] = 0xFF;
+    frame[4] = 0xFF;
+    shell->feed(frame, 5, 2000);
+    feedText("s\n", 2000);
+    TEST_ASSERT_EQUAL_INT(2, stopCount);
+    TEST_ASSERT_EQUAL_UINT32(3, shell->getBadFrameCount());
+}
+
+void test_format() {
+    char line[96];
+    feedText("s\nbogus\n");
+    shell->format(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("SHELL lines=2 frames=0 bad=0 overflow=0", line);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc16_check_value);
+    RUN_TEST(test_partial_line_waits_for_its_end);
+    RUN_TEST(test_mode_limits_commands);
+    RUN_TEST(test_backspace_and_overlong_lines);
+    RUN_TEST(test_ping_frame_between_text_lines);
+    RUN_TEST(test_command_frame_replies_with_status);
+    RUN_TEST(test_metrics_frame_streams_one_reply_per_line);
+    RUN_TEST(test_corrupt_and_stalled_frames_are_dropped);
+    RUN_TEST(test_format);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
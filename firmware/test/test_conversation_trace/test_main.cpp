@@ -0,0 +1,117 @@
+#include <unity.h>
+#include <string.h>
+#include "communication/conversation_trace.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+ConversationTrace trace;
+
+void setUp(void) {
+    trace.begin(256);
+    trace.start(1000);
+}
+
+void tearDown(void) {
+    trace.end();
+}
+
+void test_empty_trace_has_valid_header() {
+    TEST_ASSERT_EQUAL(TRACE_HEADER_SIZE, trace.size());
+    TEST_ASSERT_EQUAL_MEMORY(TRACE_MAGIC, trace.data(), 8);
+
+    TraceReader reader;
+    TraceRecord record;
+    TEST_ASSERT_TRUE(reader.open(trace.data(), trace.size()));
+    TEST_ASSERT_FALSE(reader.next(record));
+}
+
+void test_records_round_trip() {
+    const char* text = "{\"type\":\"ping\"}";
+    const uint8_t binary[3] = { 0x01, 0x00, 0xFF };
+
+    TEST_ASSERT_TRUE(trace.record(1010, false, (const uint8_t*)text, strlen(text)));
+    TEST_ASSERT_TRUE(trace.record(1250, true, binary, sizeof(binary)));
+    TEST_ASSERT_EQUAL_UINT32(2, trace.getRecordCount());
+
+    TraceReader reader;
+    TraceRecord record;
+    TEST_ASSERT_TRUE(reader.open(trace.data(), trace.size()));
+
+    TEST_ASSERT_TRUE(reader.next(record));
+    TEST_ASSERT_EQUAL_UINT32(10, record.timestampMs);
+    TEST_ASSERT_FALSE(record.binary);
+    TEST_ASSERT_EQUAL_UINT32(strlen(text), record.length);
+    TEST_ASSERT_EQUAL_MEMORY(text, record.data, record.length);
+
+    TEST_ASSERT_TRUE(reader.next(record));
+    TEST_ASSERT_EQUAL_UINT32(250, record.timestampMs);
+    TEST_ASSERT_TRUE(record.binary);
+    TEST_ASSERT_EQUAL_MEMORY(binary, record.data, sizeof(binary));
+
+    TEST_ASSERT_FALSE(reader.next(record));
+
+    reader.rewind();
+    TEST_ASSERT_TRUE(reader.next(record));
+    TEST_ASSERT_EQUAL_UINT32(10, record.timestampMs);
+}
+
+void test_full_buffer_stops_recording() {
+    uint8_t payload[100];
+    memset(payload, 'x', sizeof(payload));
+
+    TEST_ASSERT_TRUE(trace.record(1000, false, payload, sizeof(payload)));
+    TEST_ASSERT_TRUE(trace.record(1000, false, payload, sizeof(payload)));
+    TEST_ASSERT_FALSE(trace.record(1000, false, payload, sizeof(payload)));
+
+    TEST_ASSERT_TRUE(trace.isTruncated());
+    TEST_ASSERT_FALSE(trace.isRecording());
+    TEST_ASSERT_EQUAL_UINT32(2, trace.getRecordCount());
+    TEST_ASSERT_TRUE(trace.size() <= trace.capacity());
+}
+
+void test_stopped_trace_ignores_records() {
+    trace.stop();
+    TEST_ASSERT_FALSE(trace.record(1001, false, (const uint8_t*)"{}", 2));
+    TEST_ASSERT_EQUAL(TRACE_HEADER_SIZE, trace.size());
+}
+
+void test_reader_rejects_bad_input() {
+    TraceReader reader;
+    uint8_t garbage[TRACE_HEADER_SIZE];
+    memset(garbage, 0, sizeof(garbage));
+    TEST_ASSERT_FALSE(reader.open(garbage, sizeof(garbage)));
+    TEST_ASSERT_FALSE(reader.open(trace.data(), 4));
+
+    // A record cut off mid-payload is not returned
+    trace.record(1000, false, (const uint8_t*)"{\"type\":\"audio\"}", 16);
+    TraceRecord record;
+    TEST_ASSERT_TRUE(reader.open(trace.data(), trace.size() - 1));
+    TEST_ASSERT_FALSE(reader.next(record));
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_trace_has_valid_header);
+    RUN_TEST(test_records_round_trip);
+    RUN_TEST(test_full_buffer_stops_recording);
+    RUN_TEST(test_stopped_trace_ignores_records);
+    RUN_TEST(test_reader_rejects_bad_input);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,136 @@
+#include <unity.h>
+#include "conversation/duplex_state_machine.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static DuplexStateMachine duplex;
+static int transitions;
+static DuplexState lastFrom;
+static DuplexState lastTo;
+static uint32_t lastDwellMs;
+
+static void recordTransition(DuplexState from, DuplexState to, uint32_t dwellMs) {
+    transitions++;
+    lastFrom = from;
+    lastTo = to;
+    lastDwellMs = dwellMs;
+}
+
+void setUp(void) {
+    duplex = DuplexStateMachine();
+    transitions = 0;
+    duplex.onTransition(recordTransition);
+    duplex.start(0);
+}
+
+void tearDown(void) {
+}
+
+void test_agent_audio_starts_and_drain_ends_speaking() {
+    TEST_ASSERT_EQUAL(DUPLEX_LISTENING, duplex.getState());
+    TEST_ASSERT_TRUE(duplex.onAgentAudio(1, 1000));
+    TEST_ASSERT_EQUAL(DUPLEX_AGENT_SPEAKING, duplex.getState());
+    TEST_ASSERT_TRUE(duplex.onAgentAudio(1, 1100));
+
+    duplex.onPlaybackDrained(3000);
+    TEST_ASSERT_EQUAL(DUPLEX_LISTENING, duplex.getState());
+    TEST_ASSERT_EQUAL(DUPLEX_AGENT_SPEAKING, lastFrom);
+    TEST_ASSERT_EQUAL_UINT32(2000, lastDwellMs);
+    TEST_ASSERT_EQUAL_UINT32(1, duplex.getDwell(DUPLEX_AGENT_SPEAKING).getCount());
+}
+
+void test_local_speech_only_barges_in_while_agent_speaks() {
+    TEST_ASSERT_FALSE(duplex.onLocalSpeech(400, 500));
+    TEST_ASSERT_EQUAL(DUPLEX_LISTENING, duplex.getState());
+
+    duplex.onAgentAudio(1, 1000);
+    TEST_ASSERT_TRUE(duplex.onLocalSpeech(1930, 2000));
+    TEST_ASSERT_EQUAL(DUPLEX_BARGE_IN, duplex.getState());
+    TEST_ASSERT_EQUAL_UINT32(70, duplex.getCutLatency().getMax());
+
+    // Rest of the interrupted response is not played
+    TEST_ASSERT_FALSE(duplex.onAgentAudio(1, 2050));
+    TEST_ASSERT_FALSE(duplex.onAgentAudio(2, 2100));
+}
+
+void test_server_interruption_drops_stale_audio_until_next_response() {
+    duplex.onAgentAudio(3, 1000);
+    duplex.onLocalSpeech(1900, 2000);
+    duplex.onServerInterruption(3, 2300);
+    TEST_ASSERT_EQUAL(DUPLEX_RECOVERING, duplex.getState());
+    TEST_ASSERT_EQUAL_UINT32(300, lastDwellMs);
+
+    TEST_ASSERT_FALSE(duplex.onAgentAudio(3, 2400));
+    TEST_ASSERT_TRUE(duplex.onAgentAudio(4, 3000));
+    TEST_ASSERT_EQUAL(DUPLEX_AGENT_SPEAKING, duplex.getState());
+}
+
+void test_interruption_detected_by_server_first() {
+    duplex.onAgentAudio(5, 1000);
+    duplex.onServerInterruption(5, 1500);
+    TEST_ASSERT_EQUAL(DUPLEX_RECOVERING, duplex.getState());
+    TEST_ASSERT_FALSE(duplex.onAgentAudio(5, 1600));
+}
+
+void test_unconfirmed_barge_in_times_out_as_false() {
+    duplex.onAgentAudio(1, 1000);
+    duplex.onLocalSpeech(1900, 2000);
+    TEST_ASSERT_EQUAL_UINT32(DUPLEX_BARGE_IN_TIMEOUT_MS, duplex.getMsUntilTimeout(2000));
+
+    duplex.update(2000 + DUPLEX_BARGE_IN_TIMEOUT_MS - 1);
+    TEST_ASSERT_EQUAL(DUPLEX_BARGE_IN, duplex.getState());
+    duplex.update(2000 + DUPLEX_BARGE_IN_TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(DUPLEX_LISTENING, duplex.getState());
+    TEST_ASSERT_EQUAL_UINT32(1, duplex.getFalseBargeIns());
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, duplex.getMsUntilTimeout(5000));
+}
+
+void test_recovery_without_response_returns_to_listening() {
+    duplex.onAgentAudio(1, 1000);
+    duplex.onServerInterruption(1, 1200);
+    duplex.update(1200 + DUPLEX_RECOVERY_MS);
+    TEST_ASSERT_EQUAL(DUPLEX_LISTENING, duplex.getState());
+    TEST_ASSERT_EQUAL_UINT32(0, duplex.getFalseBargeIns());
+}
+
+void test_format_lists_every_state() {
+    duplex.onAgentAudio(1, 1000);
+    duplex.onLocalSpeech(1900, 2000);
+    duplex.onServerInterruption(1, 2200);
+
+    char line[256];
+    size_t length = duplex.format(line, sizeof(line));
+    TEST_ASSERT_TRUE(length > 0);
+    TEST_ASSERT_EQUAL_STRING(
+        "DUPLEX listen n=1 p50=1000 max=1000 | speak n=1 p50=1000 max=1000 | barge n=1 p50=200 max=200"
+        " | recover n=0 p50=0 max=0 | cut_ms p50=100 max=100 | false=0", line);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_agent_audio_starts_and_drain_ends_speaking);
+    RUN_TEST(test_local_speech_only_barges_in_while_agent_speaks);
+    RUN_TEST(test_server_interruption_drops_stale_audio_until_next_response);
+    RUN_TEST(test_interruption_detected_by_server_first);
+    RUN_TEST(test_unconfirmed_barge_in_times_out_as_false);
+    RUN_TEST(test_recovery_without_response_returns_to_listening);
+    RUN_TEST(test_format_lists_every_state);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,157 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "communication/fragment_assembler.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+static unsigned long nowMicros() { return micros(); }
+#else
+#include <chrono>
+static unsigned long nowMicros() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static const size_t TEST_CAPACITY = 64 * 1024;
+
+FragmentAssembler assembler;
+
+// Build an agent audio message the way the server sends it
+static std::string makeAudioMessage(size_t base64Chars, uint32_t eventId) {
+    std::string audio(base64Chars, 'A');
+    return "{\"type\":\"audio\",\"audio_event\":{\"audio_base_64\":\"" + audio +
+           "\",\"event_id\":" + std::to_string(eventId) + "}}";
+}
+
+// Feed a message as START / FRAGMENT... / FIN frames of fragmentSize bytes
+static bool feedFragmented(const std::string& message, size_t fragmentSize) {
+    const uint8_t* data = (const uint8_t*)message.data();
+    size_t remaining = message.size();
+    size_t first = remaining > fragmentSize ? fragmentSize : remaining;
+
+    assembler.start(data, first, false);
+    data += first;
+    remaining -= first;
+
+    while (remaining > fragmentSize) {
+        assembler.append(data, fragmentSize);
+        data += fragmentSize;
+        remaining -= fragmentSize;
+    }
+    return assembler.finish(data, remaining);
+}
+
+void setUp(void) {
+    assembler.end();
+    TEST_ASSERT_TRUE(assembler.begin(TEST_CAPACITY));
+}
+
+void tearDown(void) {
+    assembler.end();
+}
+
+void test_reassembles_fragmented_text_message() {
+    std::string message = makeAudioMessage(10000, 42);
+
+    TEST_ASSERT_TRUE(feedFragmented(message, 1460));
+    TEST_ASSERT_FALSE(assembler.isBinary());
+    TEST_ASSERT_EQUAL(message.size(), assembler.length());
+    TEST_ASSERT_EQUAL_MEMORY(message.data(), assembler.data(), message.size());
+    TEST_ASSERT_EQUAL_UINT8(0, assembler.data()[assembler.length()]);
+    TEST_ASSERT_EQUAL_UINT32(1, assembler.getMessagesAssembled());
+}
+
+void test_reuses_buffer_across_messages() {
+    uint8_t* buffer = assembler.data();
+
+    for (uint32_t i = 0; i < 10; i++) {
+        std::string message = makeAudioMessage(2000 + i * 500, i);
+        TEST_ASSERT_TRUE(feedFragmented(message, 512));
+        TEST_ASSERT_EQUAL_MEMORY(message.data(), assembler.data(), message.size());
+        assembler.reset();
+    }
+
+    TEST_ASSERT_TRUE(buffer == assembler.data());
+    TEST_ASSERT_EQUAL_UINT32(10, assembler.getMessagesAssembled());
+}
+
+void test_drops_oversized_message_and_recovers() {
+    std::string oversized = makeAudioMessage(TEST_CAPACITY, 1);
+    TEST_ASSERT_FALSE(feedFragmented(oversized, 4096));
+    TEST_ASSERT_EQUAL_UINT32(1, assembler.getMessagesDropped());
+    TEST_ASSERT_EQUAL_UINT32(0, assembler.getMessagesAssembled());
+
+    std::string next = makeAudioMessage(1000, 2);
+    TEST_ASSERT_TRUE(feedFragmented(next, 4096));
+    TEST_ASSERT_EQUAL_MEMORY(next.data(), assembler.data(), next.size());
+}
+
+void test_ignores_continuation_without_start() {
+    const uint8_t fragment[] = "orphan";
+    TEST_ASSERT_FALSE(assembler.append(fragment, sizeof(fragment)));
+    TEST_ASSERT_FALSE(assembler.finish(fragment, sizeof(fragment)));
+    TEST_ASSERT_EQUAL_UINT32(0, assembler.getMessagesAssembled());
+}
+
+void test_unfinished_message_counts_as_dropped() {
+    const uint8_t fragment[] = "{\"type\":";
+    assembler.start(fragment, sizeof(fragment) - 1, false);
+
+    std::string message = makeAudioMessage(100, 3);
+    TEST_ASSERT_TRUE(feedFragmented(message, 64));
+    TEST_ASSERT_EQUAL_UINT32(1, assembler.getMessagesDropped());
+    TEST_ASSERT_EQUAL_MEMORY(message.data(), assembler.data(), message.size());
+}
+
+void test_reassembly_throughput() {
+    // ~24 KB frames, typical for a chunk of agent speech
+    std::string message = makeAudioMessage(24000, 7);
+    const int iterations = 500;
+
+    unsigned long start = nowMicros();
+    for (int i = 0; i < iterations; i++) {
+        feedFragmented(message, 1460);
+        assembler.reset();
+    }
+    unsigned long elapsed = nowMicros() - start;
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(iterations, assembler.getMessagesAssembled());
+
+    char report[128];
+    snprintf(report, sizeof(report), "Reassembly: %.0f msgs/s, %.1f MB/s (%u fragments)",
+             iterations * 1e6 / elapsed, (double)assembler.getBytesAssembled() / elapsed,
+             assembler.getFragmentsReceived());
+    TEST_MESSAGE(report);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_reassembles_fragmented_text_message);
+    RUN_TEST(test_reuses_buffer_across_messages);
+    RUN_TEST(test_drops_oversized_message_and_recovers);
+    RUN_TEST(test_ignores_continuation_without_start);
+    RUN_TEST(test_unfinished_message_counts_as_dropped);
+    RUN_TEST(test_reassembly_throughput);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,128 @@
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include "communication/json_arena.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static const size_t TEST_CAPACITY = 4096;
+
+JsonArena arena;
+
+void setUp(void) {
+    arena.end();
+    TEST_ASSERT_TRUE(arena.begin(TEST_CAPACITY));
+}
+
+void tearDown(void) {
+    arena.end();
+}
+
+void test_allocations_are_aligned_and_owned() {
+    void* a = arena.allocate(3);
+    void* b = arena.allocate(17);
+
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)a % 8);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)b % 8);
+    TEST_ASSERT_TRUE(arena.owns(a));
+    TEST_ASSERT_TRUE(arena.owns(b));
+    TEST_ASSERT_FALSE(arena.owns(&arena));
+}
+
+void test_hard_cap_fails_instead_of_growing() {
+    TEST_ASSERT_NULL(arena.allocate(TEST_CAPACITY));
+    TEST_ASSERT_EQUAL(1, arena.getFailures());
+
+    // Smaller requests still fit afterwards
+    TEST_ASSERT_NOT_NULL(arena.allocate(TEST_CAPACITY / 2));
+}
+
+void test_last_block_grows_in_place() {
+    char* text = (char*)arena.allocate(8);
+    memcpy(text, "abcdefg", 8);
+
+    char* grown = (char*)arena.reallocate(text, 1024);
+    TEST_ASSERT_EQUAL_PTR(text, grown);
+    TEST_ASSERT_EQUAL_STRING("abcdefg", grown);
+
+    // Shrinking gives the tail back
+    size_t before = arena.used();
+    TEST_ASSERT_EQUAL_PTR(text, arena.reallocate(grown, 16));
+    TEST_ASSERT_TRUE(arena.used() < before);
+}
+
+void test_buried_block_moves_when_grown() {
+    char* first = (char*)arena.allocate(8);
+    memcpy(first, "buried", 7);
+    arena.allocate(8);
+
+    char* moved = (char*)arena.reallocate(first, 64);
+    TEST_ASSERT_NOT_NULL(moved);
+    TEST_ASSERT_TRUE(moved != first);
+    TEST_ASSERT_EQUAL_STRING("buried", moved);
+
+    // Shrinking a buried block leaves it in place
+    TEST_ASSERT_EQUAL_PTR(first, arena.reallocate(first, 4));
+}
+
+void test_nested_scopes_release_in_stack_order() {
+    void* outer = nullptr;
+    {
+        JsonArenaScope message(arena);
+        outer = arena.allocate(100);
+        size_t used = arena.used();
+        {
+            // A reply sent while the inbound message is still in use
+            JsonArenaScope reply(arena);
+            arena.allocate(200);
+            TEST_ASSERT_TRUE(arena.used() > used);
+        }
+        TEST_ASSERT_EQUAL(used, arena.used());
+        TEST_ASSERT_TRUE(arena.owns(outer));
+    }
+    TEST_ASSERT_EQUAL(0, arena.used());
+    TEST_ASSERT_TRUE(arena.getHighWater() >= 300);
+}
+
+void test_deallocate_pops_only_the_last_block() {
+    void* a = arena.allocate(32);
+    size_t afterA = arena.used();
+    void* b = arena.allocate(32);
+    size_t afterB = arena.used();
+
+    arena.deallocate(a);   // Buried - nothing reclaimed
+    TEST_ASSERT_EQUAL(afterB, arena.used());
+
+    arena.deallocate(b);
+    TEST_ASSERT_EQUAL(afterA, arena.used());
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_allocations_are_aligned_and_owned);
+    RUN_TEST(test_hard_cap_fails_instead_of_growing);
+    RUN_TEST(test_last_block_grows_in_place);
+    RUN_TEST(test_buried_block_moves_when_grown);
+    RUN_TEST(test_nested_scopes_release_in_stack_order);
+    RUN_TEST(test_deallocate_pops_only_the_last_block);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,102 @@
+#include <unity.h>
+#include <string.h>
+#include "communication/json_writer.h"
+#include "communication/outbound_messages.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static char buffer[256];
+
+void setUp(void) {
+    memset(buffer, 'x', sizeof(buffer));
+}
+
+void tearDown(void) {
+}
+
+void test_strings_are_escaped() {
+    JsonWriter writer(buffer, sizeof(buffer));
+    writer.string("say \"hi\"\\\n\t\x01 ok");
+
+    TEST_ASSERT_TRUE(writer.ok());
+    TEST_ASSERT_EQUAL_STRING("\"say \\\"hi\\\"\\\\\\n\\t\\u0001 ok\"", buffer);
+}
+
+void test_utf8_passes_through() {
+    JsonWriter writer(buffer, sizeof(buffer));
+    writer.string("caf\xc3\xa9");
+    TEST_ASSERT_EQUAL_STRING("\"caf\xc3\xa9\"", buffer);
+}
+
+void test_numbers_booleans_and_null() {
+    JsonWriter writer(buffer, sizeof(buffer));
+    writer.number(0).literal(",").number(4294967295u).literal(",").boolean(true)
+          .literal(",").boolean(false).literal(",").string(nullptr);
+    TEST_ASSERT_EQUAL_STRING("0,4294967295,true,false,null", buffer);
+}
+
+void test_counting_pass_matches_written_length() {
+    JsonWriter measure(nullptr, 0);
+    OutboundMessages::toolResult(measure, "call_1", "line\nbreak", true);
+
+    JsonWriter writer(buffer, measure.length() + 1);
+    OutboundMessages::toolResult(writer, "call_1", "line\nbreak", true);
+
+    TEST_ASSERT_TRUE(writer.ok());
+    TEST_ASSERT_EQUAL(measure.length(), strlen(buffer));
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"type\":\"client_tool_result\",\"tool_call_id\":\"call_1\",\"result\":\"line\\nbreak\",\"is_error\":true}",
+        buffer);
+}
+
+void test_overflow_truncates_and_reports() {
+    JsonWriter writer(buffer, 8);
+    OutboundMessages::pong(writer, 42);
+
+    TEST_ASSERT_FALSE(writer.ok());
+    TEST_ASSERT_EQUAL_STRING("{\"type\"", buffer);
+    TEST_ASSERT_EQUAL('x', buffer[8]);
+    TEST_ASSERT_EQUAL(strlen("{\"type\":\"pong\",\"event_id\":42}"), writer.length());
+}
+
+void test_message_shapes() {
+    JsonWriter pong(buffer, sizeof(buffer));
+    OutboundMessages::pong(pong, 42);
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"pong\",\"event_id\":42}", buffer);
+
+    JsonWriter init(buffer, sizeof(buffer));
+    OutboundMessages::conversationInitiation(init, false);
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"conversation_initiation_client_data\"}", buffer);
+
+    JsonWriter text(buffer, sizeof(buffer));
+    OutboundMessages::userMessage(text, "hello");
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"user_message\",\"text\":\"hello\"}", buffer);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_strings_are_escaped);
+    RUN_TEST(test_utf8_passes_through);
+    RUN_TEST(test_numbers_booleans_and_null);
+    RUN_TEST(test_counting_pass_matches_written_length);
+    RUN_TEST(test_overflow_truncates_and_reports);
+    RUN_TEST(test_message_shapes);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
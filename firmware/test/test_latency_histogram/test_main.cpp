@@ -0,0 +1,132 @@
+#include <unity.h>
+#include <string.h>
+#include "telemetry/latency_histogram.h"
+#include "telemetry/latency_telemetry.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+LatencyHistogram histogram;
+
+void setUp(void) {
+    histogram.reset();
+}
+
+void tearDown(void) {
+    // Nothing to clean up
+}
+
+void test_empty_histogram_reports_zero() {
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getCount());
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getPercentile(50));
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getMean());
+}
+
+void test_small_values_are_exact() {
+    for (uint32_t v = 1; v <= 10; v++) {
+        histogram.record(v);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(10, histogram.getCount());
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.getMin());
+    TEST_ASSERT_EQUAL_UINT32(10, histogram.getMax());
+    TEST_ASSERT_EQUAL_UINT32(5, histogram.getPercentile(50));
+    TEST_ASSERT_EQUAL_UINT32(9, histogram.getPercentile(90));
+    TEST_ASSERT_EQUAL_UINT32(10, histogram.getPercentile(99));
+}
+
+void test_large_values_within_bucket_error() {
+    // 1..1000 ms uniformly: true p50 = 500, p90 = 900, p99 = 990
+    for (uint32_t v = 1; v <= 1000; v++) {
+        histogram.record(v);
+    }
+
+    uint32_t p50 = histogram.getPercentile(50);
+    uint32_t p90 = histogram.getPercentile(90);
+    uint32_t p99 = histogram.getPercentile(99);
+
+    TEST_ASSERT_UINT32_WITHIN(500 / 8, 500, p50);
+    TEST_ASSERT_UINT32_WITHIN(900 / 8, 900, p90);
+    TEST_ASSERT_UINT32_WITHIN(990 / 8, 990, p99);
+    TEST_ASSERT_TRUE(p50 >= 500 && p90 >= 900 && p99 >= 990);
+    TEST_ASSERT_EQUAL_UINT32(500, histogram.getMean());
+}
+
+void test_huge_values_are_clamped() {
+    histogram.record(0xFFFFFFFFUL);
+    histogram.record(5);
+
+    TEST_ASSERT_EQUAL_UINT32(2, histogram.getCount());
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFUL, histogram.getMax());
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFUL, histogram.getPercentile(99));
+}
+
+void test_telemetry_measures_first_event_per_turn() {
+    LatencyTelemetry telemetry;
+
+    telemetry.markUplinkChunk(1000);
+    telemetry.markUplinkChunk(1250);  // Last chunk of the turn
+    telemetry.markAgentResponse(2050);
+    telemetry.markAgentResponse(2300);  // Correction - same turn, ignored
+    telemetry.markAudio(2150);
+    telemetry.markAudio(2400);          // Later audio chunk, ignored
+
+    TEST_ASSERT_EQUAL_UINT32(1, telemetry.getResponseHistogram().getCount());
+    TEST_ASSERT_EQUAL_UINT32(800, telemetry.getResponseHistogram().getMax());
+    TEST_ASSERT_EQUAL_UINT32(1, telemetry.getAudioHistogram().getCount());
+    TEST_ASSERT_EQUAL_UINT32(900, telemetry.getAudioHistogram().getMax());
+}
+
+void test_telemetry_ignores_unmeasured_ping() {
+    LatencyTelemetry telemetry;
+
+    telemetry.recordPing(0);
+    telemetry.recordPing(85);
+
+    TEST_ASSERT_EQUAL_UINT32(1, telemetry.getPingHistogram().getCount());
+    TEST_ASSERT_EQUAL_UINT32(85, telemetry.getPingHistogram().getMax());
+}
+
+void test_telemetry_compact_format() {
+    LatencyTelemetry telemetry;
+    telemetry.recordPing(7);
+
+    char line[160];
+    size_t length = telemetry.format(line, sizeof(line));
+    TEST_ASSERT_EQUAL(strlen(line), length);
+    TEST_ASSERT_EQUAL_STRING("LAT ping n=1 p50=7 p90=7 p99=7 max=7 | resp n=0 p50=0 p90=0 p99=0 max=0"
+                             " | audio n=0 p50=0 p90=0 p99=0 max=0", line);
+
+    char small[12];
+    length = telemetry.format(small, sizeof(small));
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, length);
+    TEST_ASSERT_EQUAL_STRING("LAT ping n=", small);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_histogram_reports_zero);
+    RUN_TEST(test_small_values_are_exact);
+    RUN_TEST(test_large_values_within_bucket_error);
+    RUN_TEST(test_huge_values_are_clamped);
+    RUN_TEST(test_telemetry_measures_first_event_per_turn);
+    RUN_TEST(test_telemetry_ignores_unmeasured_ping);
+    RUN_TEST(test_telemetry_compact_format);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
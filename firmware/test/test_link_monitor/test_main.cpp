@@ -0,0 +1,118 @@
+#include <unity.h>
+#include "communication/link_monitor.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static LinkMonitor monitor;
+
+void setUp(void) {
+    monitor.reset();
+}
+
+void tearDown(void) {
+}
+
+void test_healthy_link_is_not_degraded() {
+    for (uint32_t t = 0; t < 10; t++) {
+        monitor.recordRssi(-55, t * 1000);
+        monitor.recordPing(80, t * 1000);
+        monitor.recordSend(true, t * 1000);
+    }
+    TEST_ASSERT_FALSE(monitor.isDegraded(10000));
+    TEST_ASSERT_EQUAL(LinkMonitor::SIGNAL_NONE, monitor.getLastSignal());
+    TEST_ASSERT_EQUAL_INT(-55, monitor.getRssi());
+}
+
+void test_one_noisy_rssi_sample_is_ignored() {
+    monitor.recordRssi(-55, 0);
+    monitor.recordRssi(-90, 1000);
+    monitor.recordRssi(-55, 2000);
+    TEST_ASSERT_FALSE(monitor.isDegraded(2000));
+}
+
+void test_weak_rssi_average_degrades() {
+    monitor.recordRssi(-55, 0);
+    uint32_t t = 0;
+    while (!monitor.isDegraded(t) && t < 20000) {
+        t += 1000;
+        monitor.recordRssi(-85, t);
+    }
+    TEST_ASSERT_TRUE(monitor.isDegraded(t));
+    TEST_ASSERT_EQUAL(LinkMonitor::SIGNAL_RSSI, monitor.getLastSignal());
+    TEST_ASSERT_TRUE(monitor.getRssi() < LINK_RSSI_DEGRADED_DBM);
+    TEST_ASSERT_TRUE(t > 1000);
+}
+
+void test_slow_ping_degrades() {
+    monitor.recordPing(LINK_PING_DEGRADED_MS, 0);
+    TEST_ASSERT_FALSE(monitor.isDegraded(0));
+    monitor.recordPing(LINK_PING_DEGRADED_MS + 1, 100);
+    TEST_ASSERT_TRUE(monitor.isDegraded(100));
+    TEST_ASSERT_EQUAL(LinkMonitor::SIGNAL_PING, monitor.getLastSignal());
+}
+
+void test_send_failure_degrades_and_counts() {
+    monitor.recordSend(false, 500);
+    monitor.recordSend(false, 600);
+    TEST_ASSERT_TRUE(monitor.isDegraded(600));
+    TEST_ASSERT_EQUAL(LinkMonitor::SIGNAL_SEND_FAILURE, monitor.getLastSignal());
+    TEST_ASSERT_EQUAL_UINT32(2, monitor.getSendFailures());
+}
+
+void test_recovers_after_quiet_period() {
+    monitor.recordPing(2000, 1000);
+    TEST_ASSERT_TRUE(monitor.isDegraded(1000 + LINK_RECOVERY_MS - 1));
+    TEST_ASSERT_FALSE(monitor.isDegraded(1000 + LINK_RECOVERY_MS));
+}
+
+void test_new_bad_signal_restarts_recovery() {
+    monitor.recordPing(2000, 0);
+    monitor.recordSend(false, LINK_RECOVERY_MS / 2);
+    TEST_ASSERT_TRUE(monitor.isDegraded(LINK_RECOVERY_MS));
+    TEST_ASSERT_FALSE(monitor.isDegraded(LINK_RECOVERY_MS / 2 + LINK_RECOVERY_MS));
+}
+
+void test_rssi_average_moves_a_quarter_per_sample() {
+    RssiAverage rssi;
+    TEST_ASSERT_FALSE(rssi.hasSample());
+    TEST_ASSERT_EQUAL_INT(0, rssi.get());
+
+    rssi.record(-60);
+    TEST_ASSERT_TRUE(rssi.hasSample());
+    TEST_ASSERT_EQUAL_INT(-60, rssi.get());
+    rssi.record(-80);
+    TEST_ASSERT_EQUAL_INT(-65, rssi.get());
+
+    rssi.reset();
+    TEST_ASSERT_FALSE(rssi.hasSample());
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_healthy_link_is_not_degraded);
+    RUN_TEST(test_one_noisy_rssi_sample_is_ignored);
+    RUN_TEST(test_weak_rssi_average_degrades);
+    RUN_TEST(test_slow_ping_degrades);
+    RUN_TEST(test_send_failure_degrades_and_counts);
+    RUN_TEST(test_recovers_after_quiet_period);
+    RUN_TEST(test_new_bad_signal_restarts_recovery);
+    RUN_TEST(test_rssi_average_moves_a_quarter_per_sample);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
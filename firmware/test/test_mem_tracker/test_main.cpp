@@ -0,0 +1,132 @@
+#include <unity.h>
+#include <string.h>
+#include "system/mem_tracker.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static MemHeapInfo fakeHeaps[MEM_REGION_COUNT];
+
+static bool fakeProbe(MemRegion region, MemHeapInfo& info) {
+    info = fakeHeaps[region];
+    return info.freeBytes != 0;
+}
+
+void setUp(void) {
+    memset(fakeHeaps, 0, sizeof(fakeHeaps));
+    memTracker.setHeapProbe(fakeProbe);
+    memTracker.resetStats();
+}
+
+void tearDown(void) {
+}
+
+void test_live_and_peak_bytes_per_tag_and_region() {
+    MemTagStats before = memTracker.getStats(MEM_TAG_SPEAKER);
+    void* a = memAlloc(MEM_TAG_SPEAKER, 1000);
+    void* b = memAllocPsram(MEM_TAG_SPEAKER, 4000);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    memset(a, 0x55, 1000);
+    memset(b, 0x55, 4000);
+
+    MemTagStats stats = memTracker.getStats(MEM_TAG_SPEAKER);
+    TEST_ASSERT_EQUAL_UINT32(before.liveBytes[MEM_INTERNAL] + 1000, stats.liveBytes[MEM_INTERNAL]);
+    TEST_ASSERT_EQUAL_UINT32(before.liveBytes[MEM_PSRAM] + 4000, stats.liveBytes[MEM_PSRAM]);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.allocations);
+
+    memFree(a);
+    memFree(b);
+    stats = memTracker.getStats(MEM_TAG_SPEAKER);
+    TEST_ASSERT_EQUAL_UINT32(before.liveBytes[MEM_INTERNAL], stats.liveBytes[MEM_INTERNAL]);
+    TEST_ASSERT_EQUAL_UINT32(before.liveBytes[MEM_INTERNAL] + 1000, stats.peakBytes[MEM_INTERNAL]);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.frees);
+
+    // Other tags are untouched
+    TEST_ASSERT_EQUAL_UINT32(0, memTracker.getStats(MEM_TAG_MICROPHONE).allocations);
+}
+
+void test_realloc_moves_the_count_and_keeps_data() {
+    uint8_t* data = (uint8_t*)memRealloc(MEM_TAG_NETWORK, nullptr, 16);
+    TEST_ASSERT_NOT_NULL(data);
+    for (int i = 0; i < 16; i++) {
+        data[i] = (uint8_t)i;
+    }
+    size_t live = memTracker.getStats(MEM_TAG_NETWORK).liveBytes[MEM_INTERNAL];
+
+    data = (uint8_t*)memRealloc(MEM_TAG_NETWORK, data, 64);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_EQUAL_UINT8(15, data[15]);
+    TEST_ASSERT_EQUAL_UINT32(live + 48, memTracker.getStats(MEM_TAG_NETWORK).liveBytes[MEM_INTERNAL]);
+
+    memFree(data);
+    TEST_ASSERT_EQUAL_UINT32(live - 16, memTracker.getStats(MEM_TAG_NETWORK).liveBytes[MEM_INTERNAL]);
+}
+
+void test_free_of_null_is_ignored() {
+    memFree(nullptr);
+    TEST_ASSERT_EQUAL_UINT32(0, memTracker.getStats(MEM_TAG_MICROPHONE).frees);
+}
+
+void test_failure_records_largest_block() {
+    fakeHeaps[MEM_INTERNAL] = {60000, 40000, 20000};
+    memTracker.recordFailure(MEM_TAG_SPEAKER, MEM_INTERNAL, 32000);
+
+    MemTagStats stats = memTracker.getStats(MEM_TAG_SPEAKER);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.failures);
+    TEST_ASSERT_EQUAL_UINT32(32000, stats.lastFailedSize);
+    TEST_ASSERT_EQUAL_UINT32(20000, stats.largestBlockAtFailure);
+}
+
+void test_fragmentation() {
+    fakeHeaps[MEM_INTERNAL] = {60000, 40000, 15000};
+    TEST_ASSERT_EQUAL_UINT32(75, memTracker.getFragmentation(MEM_INTERNAL));
+    // No PSRAM fitted
+    TEST_ASSERT_EQUAL_UINT32(0, memTracker.getFragmentation(MEM_PSRAM));
+}
+
+void test_format() {
+    char line[200];
+    fakeHeaps[MEM_INTERNAL] = {60000, 40000, 15000};
+    fakeHeaps[MEM_PSRAM] = {8000000, 7000000, 8000000};
+    memTracker.formatHeap(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("HEAP int free=60000 min=40000 largest=15000 frag=75% | "
+                             "psram free=8000000 min=7000000 largest=8000000 frag=0%",
+                             line);
+
+    void* block = memAllocPsram(MEM_TAG_MICROPHONE, 8000);
+    memTracker.recordFailure(MEM_TAG_MICROPHONE, MEM_INTERNAL, 2048);
+    memTracker.formatTag(MEM_TAG_MICROPHONE, line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("MEM mic int=0/0 psram=8000/8000 allocs=1 frees=0 fails=1 last_fail=2048 largest=15000", line);
+    memFree(block);
+
+    TEST_ASSERT_EQUAL_UINT32(10, memTracker.formatTag(MEM_TAG_MICROPHONE, line, 11));
+    TEST_ASSERT_EQUAL_STRING("MEM mic in", line);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_live_and_peak_bytes_per_tag_and_region);
+    RUN_TEST(test_realloc_moves_the_count_and_keeps_data);
+    RUN_TEST(test_free_of_null_is_ignored);
+    RUN_TEST(test_failure_records_largest_block);
+    RUN_TEST(test_fragmentation);
+    RUN_TEST(test_format);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,117 @@
+#include <unity.h>
+#include <string.h>
+#include "system/memory_plan.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static MemoryPlan* plan;
+
+void setUp(void) {
+    plan = new MemoryPlan();
+    memTracker.resetStats();
+}
+
+void tearDown(void) {
+    delete plan;
+}
+
+void test_regions_are_aligned_and_disjoint() {
+    int a = plan->add("a", 100, MEM_PSRAM);
+    int b = plan->add("b", 33, MEM_PSRAM);
+    int c = plan->add("c", 64, MEM_INTERNAL);
+    TEST_ASSERT_EQUAL_INT(0, a);
+    TEST_ASSERT_EQUAL_INT(2, c);
+    TEST_ASSERT_NULL(plan->get(a));
+
+    TEST_ASSERT_TRUE(plan->commit());
+    uint8_t* first = (uint8_t*)plan->get(a);
+    uint8_t* second = (uint8_t*)plan->get(b);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)first % MEM_PLAN_ALIGN);
+    TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)second % MEM_PLAN_ALIGN);
+    TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)plan->get(c) % MEM_PLAN_ALIGN);
+    TEST_ASSERT_TRUE(second >= first + 100);
+
+    // The whole region is usable
+    memset(first, 0xAA, 100);
+    memset(second, 0x55, 33);
+    TEST_ASSERT_EQUAL_UINT8(0xAA, first[99]);
+    TEST_ASSERT_EQUAL_UINT32(33, plan->getSize(b));
+    TEST_ASSERT_EQUAL_UINT32(112 + 48, plan->getTotal(MEM_PSRAM));
+}
+
+void test_one_allocation_per_memory_type() {
+    plan->add("a", 1000, MEM_PSRAM);
+    plan->add("b", 2000, MEM_PSRAM);
+    plan->add("c", 3000, MEM_PSRAM);
+    TEST_ASSERT_TRUE(plan->commit());
+    TEST_ASSERT_EQUAL_UINT32(1, memTracker.getStats(MEM_TAG_PLAN).allocations);
+
+    plan->add("d", 10, MEM_INTERNAL);
+    TEST_ASSERT_EQUAL_UINT32(3, plan->getRegionCount());  // Too late to add
+
+    plan->release();
+    TEST_ASSERT_FALSE(plan->isCommitted());
+    TEST_ASSERT_NULL(plan->get(0));
+    TEST_ASSERT_EQUAL_UINT32(0, memTracker.getStats(MEM_TAG_PLAN).liveBytes[MEM_PSRAM]);
+}
+
+void test_full_plan_rejects_regions() {
+    for (int i = 0; i < MEM_PLAN_MAX_REGIONS; i++) {
+        TEST_ASSERT_EQUAL_INT(i, plan->add("r", 8, MEM_INTERNAL));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, plan->add("r", 8, MEM_INTERNAL));
+}
+
+void test_sealed_tag_counts_late_allocations() {
+    memTracker.seal(MEM_TAG_SPEAKER);
+    TEST_ASSERT_TRUE(memTracker.isSealed(MEM_TAG_SPEAKER));
+    TEST_ASSERT_FALSE(memTracker.isSealed(MEM_TAG_MICROPHONE));
+
+    void* block = memAlloc(MEM_TAG_SPEAKER, 32);
+    memFree(block);
+    TEST_ASSERT_EQUAL_UINT32(1, memTracker.getStats(MEM_TAG_SPEAKER).lateAllocations);
+    TEST_ASSERT_EQUAL_UINT32(0, memTracker.getStats(MEM_TAG_MICROPHONE).lateAllocations);
+}
+
+void test_format() {
+    char line[160];
+    plan->add("mic_record", 1000, MEM_PSRAM);
+    plan->add("mic_staging", 512, MEM_INTERNAL);
+    plan->format(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("PLAN int=512 psram=1008 (not committed) | mic_record=1000@psram mic_staging=512@int", line);
+
+    TEST_ASSERT_TRUE(plan->commit());
+    plan->format(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("PLAN int=512 psram=1008 | mic_record=1000@psram mic_staging=512@int", line);
+
+    TEST_ASSERT_EQUAL_UINT32(10, plan->format(line, 11));
+    TEST_ASSERT_EQUAL_STRING("PLAN int=5", line);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_regions_are_aligned_and_disjoint);
+    RUN_TEST(test_one_allocation_per_memory_type);
+    RUN_TEST(test_full_plan_rejects_regions);
+    RUN_TEST(test_sealed_tag_counts_late_allocations);
+    RUN_TEST(test_format);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
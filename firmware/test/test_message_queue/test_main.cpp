@@ -0,0 +1,179 @@
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include "communication/message_queue.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <thread>
+#endif
+
+static const size_t TEST_CAPACITY = 256;
+
+MessageQueue queue;
+
+void setUp(void) {
+    TEST_ASSERT_TRUE(queue.begin(TEST_CAPACITY));
+}
+
+void tearDown(void) {
+    queue.end();
+}
+
+void test_messages_come_out_in_order() {
+    TEST_ASSERT_TRUE(queue.push(1, 10, 100, "one", 4));
+    TEST_ASSERT_TRUE(queue.push(2, 20, 200, "two!", 5));
+
+    QueuedMessage message;
+    TEST_ASSERT_TRUE(queue.front(message));
+    TEST_ASSERT_EQUAL(1, message.type);
+    TEST_ASSERT_EQUAL(10, message.arg);
+    TEST_ASSERT_EQUAL(100, message.enqueuedUs);
+    TEST_ASSERT_EQUAL(4, message.length);
+    TEST_ASSERT_EQUAL_STRING("one", (const char*)message.data);
+    queue.pop();
+
+    TEST_ASSERT_TRUE(queue.front(message));
+    TEST_ASSERT_EQUAL(2, message.type);
+    TEST_ASSERT_EQUAL_STRING("two!", (const char*)message.data);
+    queue.pop();
+
+    TEST_ASSERT_FALSE(queue.front(message));
+    TEST_ASSERT_TRUE(queue.isEmpty());
+}
+
+void test_full_queue_drops_instead_of_blocking() {
+    uint8_t payload[100] = {0};
+    TEST_ASSERT_TRUE(queue.push(1, 0, 0, payload, sizeof(payload)));
+    TEST_ASSERT_TRUE(queue.push(1, 0, 0, payload, sizeof(payload)));
+    TEST_ASSERT_FALSE(queue.push(1, 0, 0, payload, sizeof(payload)));
+    TEST_ASSERT_FALSE(queue.push(1, 0, 0, payload, TEST_CAPACITY));
+
+    TEST_ASSERT_EQUAL(2, queue.getPushed());
+    TEST_ASSERT_EQUAL(2, queue.getDropped());
+}
+
+void test_queue_sized_for_a_whole_recording_takes_it() {
+    // A full push-to-talk recording: 10 s of 16 kHz 16-bit audio
+    const size_t recordingBytes = 10 * 16000 * sizeof(int16_t);
+    uint8_t* recording = new uint8_t[recordingBytes];
+    memset(recording, 0x5A, recordingBytes);
+
+    TEST_ASSERT_FALSE(queue.push(1, 0, 0, recording, recordingBytes));
+    queue.end();
+    TEST_ASSERT_TRUE(queue.begin(MessageQueue::recordSize(recordingBytes)));
+    TEST_ASSERT_TRUE(queue.push(1, 0, 0, recording, recordingBytes));
+
+    QueuedMessage message;
+    TEST_ASSERT_TRUE(queue.front(message));
+    TEST_ASSERT_EQUAL(recordingBytes, message.length);
+    TEST_ASSERT_EQUAL_UINT8(0x5A, message.data[recordingBytes - 1]);
+    queue.pop();
+    TEST_ASSERT_TRUE(queue.isEmpty());
+    delete[] recording;
+}
+
+void test_messages_stay_contiguous_across_the_wrap() {
+    uint8_t payload[100];
+    QueuedMessage message;
+
+    // Leave the write position near the end, then free the front
+    memset(payload, 'a', sizeof(payload));
+    TEST_ASSERT_TRUE(queue.push(1, 0, 0, payload, sizeof(payload)));
+    TEST_ASSERT_TRUE(queue.push(2, 0, 0, payload, sizeof(payload)));
+    queue.front(message);
+    queue.pop();
+
+    // Doesn't fit in the tail: written at the start as one piece
+    memset(payload, 'b', sizeof(payload));
+    TEST_ASSERT_TRUE(queue.push(3, 0, 0, payload, sizeof(payload)));
+
+    TEST_ASSERT_TRUE(queue.front(message));
+    TEST_ASSERT_EQUAL(2, message.type);
+    queue.pop();
+
+    TEST_ASSERT_TRUE(queue.front(message));
+    TEST_ASSERT_EQUAL(3, message.type);
+    TEST_ASSERT_EQUAL(sizeof(payload), message.length);
+    TEST_ASSERT_EQUAL_MEMORY(payload, message.data, sizeof(payload));
+    queue.pop();
+
+    TEST_ASSERT_TRUE(queue.isEmpty());
+    TEST_ASSERT_EQUAL(0, queue.used());
+}
+
+void test_reserve_writes_in_place() {
+    uint8_t* payload = queue.reserve(6);
+    TEST_ASSERT_NOT_NULL(payload);
+    memcpy(payload, "a\0b\0c", 6);
+    queue.commit(7, 1, 0);
+
+    QueuedMessage message;
+    TEST_ASSERT_TRUE(queue.front(message));
+    TEST_ASSERT_EQUAL(7, message.type);
+    TEST_ASSERT_EQUAL_PTR(payload, message.data);
+    TEST_ASSERT_EQUAL_STRING("b", (const char*)message.data + 2);
+}
+
+#ifndef ARDUINO
+void test_producer_and_consumer_threads() {
+    const uint32_t COUNT = 20000;
+
+    std::thread producer([]() {
+        for (uint32_t i = 0; i < COUNT;) {
+            size_t length = 1 + i % 37;
+            uint8_t payload[64];
+            memset(payload, (uint8_t)i, length);
+            if (queue.push(1, i, 0, payload, length)) {
+                i++;
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    bool intact = true;
+    QueuedMessage message;
+    while (expected < COUNT) {
+        if (!queue.front(message)) {
+            continue;
+        }
+        intact = intact && message.arg == expected && message.length == 1 + expected % 37 &&
+                 message.data[message.length - 1] == (uint8_t)expected;
+        queue.pop();
+        expected++;
+    }
+    producer.join();
+
+    TEST_ASSERT_TRUE(intact);
+    TEST_ASSERT_TRUE(queue.isEmpty());
+}
+#endif
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_messages_come_out_in_order);
+    RUN_TEST(test_full_queue_drops_instead_of_blocking);
+    RUN_TEST(test_queue_sized_for_a_whole_recording_takes_it);
+    RUN_TEST(test_messages_stay_contiguous_across_the_wrap);
+    RUN_TEST(test_reserve_writes_in_place);
+#ifndef ARDUINO
+    RUN_TEST(test_producer_and_consumer_threads);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,143 @@
+#include <unity.h>
+#include "system/power_manager.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+enum TestState {
+    STATE_WAITING,
+    STATE_RECORDING,
+    STATE_PLAYING,
+    STATE_UNCONFIGURED
+};
+
+static PowerManager* power;
+static int applyCount;
+static PowerProfile lastApplied;
+static bool applierResult;
+
+static bool captureApply(const PowerProfile& profile) {
+    applyCount++;
+    lastApplied = profile;
+    return applierResult;
+}
+
+void setUp(void) {
+    static PowerManager instance;
+    instance = PowerManager();
+    power = &instance;
+    power->setProfile(STATE_WAITING, "waiting", {80, true, true});
+    power->setProfile(STATE_RECORDING, "recording", {240, false, false});
+    power->setProfile(STATE_PLAYING, "playing", {240, false, false});
+    power->setApplier(captureApply);
+    applyCount = 0;
+    lastApplied = {0, false, false};
+    applierResult = true;
+}
+
+void tearDown(void) {
+}
+
+void test_profile_applied_only_when_it_changes() {
+    power->enter(STATE_WAITING, 0);
+    TEST_ASSERT_EQUAL_INT(1, applyCount);
+    TEST_ASSERT_EQUAL_UINT16(80, lastApplied.cpuMhz);
+    TEST_ASSERT_TRUE(lastApplied.modemSleep);
+
+    power->enter(STATE_RECORDING, 100);
+    TEST_ASSERT_EQUAL_INT(2, applyCount);
+    TEST_ASSERT_EQUAL_UINT16(240, lastApplied.cpuMhz);
+    TEST_ASSERT_FALSE(lastApplied.lightSleep);
+
+    // Same profile as recording: nothing to do
+    power->enter(STATE_PLAYING, 200);
+    TEST_ASSERT_EQUAL_INT(2, applyCount);
+    TEST_ASSERT_EQUAL_UINT32(2, power->getSwitchCount());
+}
+
+void test_unconfigured_state_keeps_active_profile() {
+    power->enter(STATE_RECORDING, 0);
+    power->enter(STATE_UNCONFIGURED, 10);
+    TEST_ASSERT_EQUAL_INT(1, applyCount);
+    TEST_ASSERT_EQUAL_UINT16(240, power->getActiveProfile().cpuMhz);
+    TEST_ASSERT_EQUAL_UINT8(STATE_UNCONFIGURED, power->getState());
+
+    // Out of range is ignored
+    power->enter(POWER_MAX_STATES, 20);
+    TEST_ASSERT_EQUAL_UINT8(STATE_UNCONFIGURED, power->getState());
+    TEST_ASSERT_FALSE(power->setProfile(POWER_MAX_STATES, "x", {80, false, false}));
+}
+
+void test_time_in_state_accumulates() {
+    power->enter(STATE_WAITING, 1000);
+    power->enter(STATE_RECORDING, 4000);
+    power->enter(STATE_WAITING, 5000);
+
+    TEST_ASSERT_EQUAL_UINT32(3000 + 2500, power->getTimeInState(STATE_WAITING, 7500));
+    TEST_ASSERT_EQUAL_UINT32(1000, power->getTimeInState(STATE_RECORDING, 7500));
+    TEST_ASSERT_EQUAL_UINT32(0, power->getTimeInState(STATE_PLAYING, 7500));
+}
+
+void test_wake_latency_recorded_per_state() {
+    power->enter(STATE_WAITING, 0);
+    power->recordWake(900);
+    power->recordWake(1100);
+    power->enter(STATE_RECORDING, 10);
+    power->recordWake(20);
+
+    TEST_ASSERT_EQUAL_UINT32(2, power->getWakeLatency(STATE_WAITING).getCount());
+    TEST_ASSERT_EQUAL_UINT32(1100, power->getWakeLatency(STATE_WAITING).getMax());
+    TEST_ASSERT_EQUAL_UINT32(1, power->getWakeLatency(STATE_RECORDING).getCount());
+    TEST_ASSERT_EQUAL_UINT32(0, power->getWakeLatency(STATE_PLAYING).getCount());
+}
+
+void test_applier_failures_counted() {
+    applierResult = false;
+    power->enter(STATE_WAITING, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, power->getFailureCount());
+
+    // Still counts as the active profile, so it isn't retried on every entry
+    power->enter(STATE_WAITING, 10);
+    TEST_ASSERT_EQUAL_INT(1, applyCount);
+}
+
+void test_format() {
+    char line[160];
+    power->enter(STATE_WAITING, 0);
+    power->recordWake(10);
+    power->enter(STATE_RECORDING, 750);
+    power->recordWake(5);
+    power->format(line, sizeof(line), 1000);
+    TEST_ASSERT_EQUAL_STRING("POWER 240MHz sleep=none switches=2 | waiting 75% 10/10, recording 25% 5/5", line);
+
+    power->resetStats(1000);
+    power->format(line, sizeof(line), 1000);
+    TEST_ASSERT_EQUAL_STRING("POWER 240MHz sleep=none switches=0", line);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_profile_applied_only_when_it_changes);
+    RUN_TEST(test_unconfigured_state_keeps_active_profile);
+    RUN_TEST(test_time_in_state_accumulates);
+    RUN_TEST(test_wake_latency_recorded_per_state);
+    RUN_TEST(test_applier_failures_counted);
+    RUN_TEST(test_format);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,161 @@
+#include <unity.h>
+#include "system/timer_wheel.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static TimerWheel wheel;
+static int fireCount;
+static int order[8];
+static TimerId selfId;
+
+static void countFire() {
+    order[fireCount++] = 0;
+}
+
+static void fireA() {
+    order[fireCount++] = 1;
+}
+
+static void fireB() {
+    order[fireCount++] = 2;
+}
+
+static void rescheduleSelf() {
+    fireCount++;
+    if (fireCount < 3) {
+        selfId = wheel.schedule(0, rescheduleSelf, 0);
+    }
+}
+
+static void cancelOther() {
+    fireCount++;
+    wheel.cancel(selfId);
+}
+
+void setUp(void) {
+    wheel.reset();
+    fireCount = 0;
+    selfId = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_fires_at_deadline_not_before() {
+    wheel.schedule(100, countFire, 1000);
+    TEST_ASSERT_EQUAL(0, wheel.advance(1099));
+    TEST_ASSERT_EQUAL(1, wheel.advance(1100));
+    TEST_ASSERT_EQUAL_INT(1, fireCount);
+    TEST_ASSERT_EQUAL(0, wheel.advance(2000));
+    TEST_ASSERT_EQUAL(0, wheel.getPendingCount());
+}
+
+void test_longer_than_one_revolution_waits_its_round() {
+    uint32_t delay = TIMER_WHEEL_SLOTS * TIMER_WHEEL_TICK_MS * 3 + 50;
+    wheel.schedule(delay, countFire, 0);
+    for (uint32_t t = 0; t < delay; t += TIMER_WHEEL_TICK_MS) {
+        wheel.advance(t);
+    }
+    TEST_ASSERT_EQUAL_INT(0, fireCount);
+    wheel.advance(delay);
+    TEST_ASSERT_EQUAL_INT(1, fireCount);
+}
+
+void test_late_advance_fires_everything_due_in_order() {
+    wheel.schedule(500, fireB, 0);
+    wheel.schedule(20, fireA, 0);
+    wheel.schedule(60000, countFire, 0);
+    TEST_ASSERT_EQUAL(2, wheel.advance(5000));
+    TEST_ASSERT_EQUAL_INT(1, order[0]);
+    TEST_ASSERT_EQUAL_INT(2, order[1]);
+    TEST_ASSERT_EQUAL(1, wheel.getPendingCount());
+    TEST_ASSERT_EQUAL_UINT32(4980, wheel.getLateness().getMax());
+}
+
+void test_cancel_and_stale_handles() {
+    TimerId id = wheel.schedule(100, countFire, 0);
+    TEST_ASSERT_TRUE(wheel.isPending(id));
+    TEST_ASSERT_TRUE(wheel.cancel(id));
+    TEST_ASSERT_FALSE(wheel.cancel(id));
+
+    // The freed entry is reused; the old handle must not reach the new timer
+    TimerId reused = wheel.schedule(100, countFire, 0);
+    TEST_ASSERT_NOT_EQUAL(id, reused);
+    TEST_ASSERT_FALSE(wheel.cancel(id));
+    wheel.advance(100);
+    TEST_ASSERT_EQUAL_INT(1, fireCount);
+    TEST_ASSERT_FALSE(wheel.isPending(reused));
+}
+
+void test_callback_rescheduling_itself_runs_once_per_advance() {
+    selfId = wheel.schedule(0, rescheduleSelf, 0);
+    TEST_ASSERT_EQUAL(1, wheel.advance(TIMER_WHEEL_TICK_MS));
+    TEST_ASSERT_EQUAL(1, wheel.advance(TIMER_WHEEL_TICK_MS * 2));
+    TEST_ASSERT_EQUAL(1, wheel.advance(TIMER_WHEEL_TICK_MS * 3));
+    TEST_ASSERT_EQUAL(0, wheel.advance(TIMER_WHEEL_TICK_MS * 4));
+    TEST_ASSERT_EQUAL_INT(3, fireCount);
+}
+
+void test_callback_can_cancel_a_timer_due_in_the_same_advance() {
+    wheel.schedule(10, cancelOther, 0);
+    selfId = wheel.schedule(10, countFire, 0);
+    TEST_ASSERT_EQUAL(1, wheel.advance(10));
+    TEST_ASSERT_EQUAL_INT(1, fireCount);
+    TEST_ASSERT_EQUAL(0, wheel.getPendingCount());
+}
+
+void test_ms_until_next() {
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, wheel.getMsUntilNext(0));
+    wheel.schedule(1000, countFire, 5);
+    wheel.schedule(300, countFire, 5);
+    TEST_ASSERT_EQUAL_UINT32(300, wheel.getMsUntilNext(5));
+    TEST_ASSERT_EQUAL_UINT32(0, wheel.getMsUntilNext(305));
+}
+
+void test_pool_full_is_refused() {
+    for (int i = 0; i < TIMER_WHEEL_MAX_TIMERS; i++) {
+        TEST_ASSERT_NOT_EQUAL(0, wheel.schedule(100, countFire, 0));
+    }
+    TEST_ASSERT_EQUAL(0, wheel.schedule(100, countFire, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, wheel.getOverflowCount());
+}
+
+void test_millis_wraparound() {
+    uint32_t now = UINT32_MAX - 25;
+    wheel.schedule(50, countFire, now);
+    wheel.advance(now + 20);
+    TEST_ASSERT_EQUAL_INT(0, fireCount);
+    wheel.advance(now + 60);
+    TEST_ASSERT_EQUAL_INT(1, fireCount);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fires_at_deadline_not_before);
+    RUN_TEST(test_longer_than_one_revolution_waits_its_round);
+    RUN_TEST(test_late_advance_fires_everything_due_in_order);
+    RUN_TEST(test_cancel_and_stale_handles);
+    RUN_TEST(test_callback_rescheduling_itself_runs_once_per_advance);
+    RUN_TEST(test_callback_can_cancel_a_timer_due_in_the_same_advance);
+    RUN_TEST(test_ms_until_next);
+    RUN_TEST(test_pool_full_is_refused);
+    RUN_TEST(test_millis_wraparound);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,175 @@
+#include <unity.h>
+#include <string.h>
+#include "telemetry/turn_tracer.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static TurnTracer tracer;
+static int callbacks;
+
+static void countTurn(const TurnRecord&) {
+    callbacks++;
+}
+
+// One batch-mode turn starting at t: mic, uplink, transcript, response, audio, I2S, end
+static void playTurn(uint32_t t) {
+    tracer.mark(TURN_MIC_CAPTURE, t);
+    tracer.mark(TURN_UPLINK_SENT, t + 20);
+    tracer.mark(TURN_USER_TRANSCRIPT, t + 620);
+    tracer.mark(TURN_AGENT_RESPONSE, t + 1400);
+    tracer.mark(TURN_FIRST_AUDIO, t + 1700);
+    tracer.mark(TURN_FIRST_SAMPLE, t + 1710);
+    tracer.mark(TURN_PLAYBACK_END, t + 4000);
+}
+
+void setUp(void) {
+    tracer.reset();
+    tracer.onTurn(countTurn);
+    callbacks = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_turn_completes_after_settle() {
+    playTurn(1000);
+    tracer.flush(5000 + TURN_SETTLE_MS - 1);
+    TEST_ASSERT_EQUAL(0, tracer.getTurnCount());
+    tracer.flush(5000 + TURN_SETTLE_MS);
+    TEST_ASSERT_EQUAL(1, tracer.getTurnCount());
+    TEST_ASSERT_EQUAL_INT(1, callbacks);
+
+    const TurnRecord& record = tracer.getTurn(0);
+    TEST_ASSERT_EQUAL_UINT32(1, record.turn);
+    TEST_ASSERT_EQUAL_UINT32(1000, record.startMs);
+    TEST_ASSERT_EQUAL_INT32(20, TurnTracer::getStageMs(record, 0));
+    TEST_ASSERT_EQUAL_INT32(600, TurnTracer::getStageMs(record, 1));
+    TEST_ASSERT_EQUAL_INT32(780, TurnTracer::getStageMs(record, 2));
+    TEST_ASSERT_EQUAL_INT32(300, TurnTracer::getStageMs(record, 3));
+    TEST_ASSERT_EQUAL_INT32(10, TurnTracer::getStageMs(record, 4));
+    TEST_ASSERT_EQUAL_INT32(2290, TurnTracer::getStageMs(record, 5));
+    TEST_ASSERT_EQUAL_INT32(1710, TurnTracer::getFirstSoundMs(record));
+}
+
+void test_latest_mic_chunk_before_the_answer_counts() {
+    tracer.mark(TURN_MIC_CAPTURE, 0);
+    tracer.mark(TURN_MIC_CAPTURE, 250);
+    tracer.mark(TURN_MIC_CAPTURE, 500);
+    tracer.mark(TURN_USER_TRANSCRIPT, 900);
+    tracer.mark(TURN_MIC_CAPTURE, 1000);     // Next turn's
+    tracer.mark(TURN_FIRST_SAMPLE, 1500);
+    tracer.mark(TURN_PLAYBACK_END, 2000);
+    tracer.flush(2000 + TURN_SETTLE_MS);
+
+    TEST_ASSERT_EQUAL(1, tracer.getTurnCount());
+    TEST_ASSERT_EQUAL_UINT32(500, tracer.getTurn(0).startMs);
+    TEST_ASSERT_EQUAL_INT32(1000, TurnTracer::getFirstSoundMs(tracer.getTurn(0)));
+}
+
+void test_underrun_is_not_the_end() {
+    tracer.mark(TURN_FIRST_AUDIO, 0);
+    tracer.mark(TURN_FIRST_SAMPLE, 10);
+    tracer.mark(TURN_PLAYBACK_END, 500);
+    tracer.mark(TURN_FIRST_SAMPLE, 800);     // More audio arrived
+    tracer.flush(500 + TURN_SETTLE_MS);
+    TEST_ASSERT_EQUAL(0, tracer.getTurnCount());
+
+    tracer.mark(TURN_PLAYBACK_END, 3000);
+    tracer.flush(3000 + TURN_SETTLE_MS);
+    TEST_ASSERT_EQUAL(1, tracer.getTurnCount());
+    TEST_ASSERT_EQUAL_UINT16(3000, tracer.getTurn(0).offsetMs[TURN_PLAYBACK_END]);
+}
+
+void test_barge_in_transcript_closes_the_turn() {
+    tracer.mark(TURN_MIC_CAPTURE, 0);
+    tracer.mark(TURN_USER_TRANSCRIPT, 600);
+    tracer.mark(TURN_FIRST_AUDIO, 1500);
+    tracer.mark(TURN_FIRST_SAMPLE, 1510);
+    tracer.mark(TURN_MIC_CAPTURE, 2000);     // User talks over the agent
+    tracer.mark(TURN_USER_TRANSCRIPT, 2600);
+    TEST_ASSERT_EQUAL(1, tracer.getTurnCount());
+
+    const TurnRecord& record = tracer.getTurn(0);
+    TEST_ASSERT_EQUAL_UINT16(TURN_NOT_SEEN, record.offsetMs[TURN_PLAYBACK_END]);
+    TEST_ASSERT_EQUAL_INT32(-1, TurnTracer::getStageMs(record, 5));
+
+    // The new turn kept the mic chunk captured during playback
+    tracer.mark(TURN_FIRST_SAMPLE, 3000);
+    tracer.mark(TURN_PLAYBACK_END, 3100);
+    tracer.flush(3100 + TURN_SETTLE_MS);
+    TEST_ASSERT_EQUAL(2, tracer.getTurnCount());
+    TEST_ASSERT_EQUAL_UINT32(2000, tracer.getTurn(1).startMs);
+}
+
+void test_ring_keeps_the_latest_turns() {
+    for (uint32_t i = 0; i < TURN_TRACE_CAPACITY + 3; i++) {
+        playTurn(i * 10000);
+    }
+    tracer.flush(TURN_TRACE_CAPACITY * 10000 + 100000);
+    TEST_ASSERT_EQUAL(TURN_TRACE_CAPACITY, tracer.getTurnCount());
+    TEST_ASSERT_EQUAL_UINT32(TURN_TRACE_CAPACITY + 3, tracer.getCompletedTurns());
+    TEST_ASSERT_EQUAL_UINT32(4, tracer.getTurn(0).turn);
+}
+
+void test_summary_and_turn_lines() {
+    playTurn(0);
+    playTurn(10000);
+    tracer.flush(20000);
+
+    char line[256];
+    tracer.format(line, sizeof(line));
+    TEST_ASSERT_NOT_NULL(strstr(line, "TURNS n=2"));
+    TEST_ASSERT_NOT_NULL(strstr(line, "stt p50=600 p95=600"));
+    TEST_ASSERT_NOT_NULL(strstr(line, "first_sound p50=1710 p95=1710"));
+
+    TurnTracer::formatTurn(tracer.getTurn(1), line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("TURN 2 uplink=20 stt=600 llm=780 tts=300 buffer=10 play=2290 | first_sound=1710", line);
+}
+
+void test_export_layout() {
+    playTurn(70000);
+    tracer.flush(80000);
+
+    uint8_t out[64];
+    TEST_ASSERT_EQUAL(0, tracer.exportBinary(out, tracer.getExportSize() - 1));
+    size_t size = tracer.exportBinary(out, sizeof(out));
+    TEST_ASSERT_EQUAL(TURN_EXPORT_HEADER_SIZE + TURN_EXPORT_RECORD_SIZE, size);
+    TEST_ASSERT_EQUAL_MEMORY("TURN", out, 4);
+    TEST_ASSERT_EQUAL_UINT8(TURN_EXPORT_VERSION, out[4]);
+    TEST_ASSERT_EQUAL_UINT8(TURN_POINT_COUNT, out[5]);
+    TEST_ASSERT_EQUAL_UINT8(1, out[6]);
+
+    const uint8_t* record = out + TURN_EXPORT_HEADER_SIZE;
+    TEST_ASSERT_EQUAL_UINT8(1, record[0]);
+    TEST_ASSERT_EQUAL_UINT32(70000, record[4] | record[5] << 8 | record[6] << 16 | (uint32_t)record[7] << 24);
+    TEST_ASSERT_EQUAL_UINT16(1710, record[8 + 2 * TURN_FIRST_SAMPLE] | record[9 + 2 * TURN_FIRST_SAMPLE] << 8);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_turn_completes_after_settle);
+    RUN_TEST(test_latest_mic_chunk_before_the_answer_counts);
+    RUN_TEST(test_underrun_is_not_the_end);
+    RUN_TEST(test_barge_in_transcript_closes_the_turn);
+    RUN_TEST(test_ring_keeps_the_latest_turns);
+    RUN_TEST(test_summary_and_turn_lines);
+    RUN_TEST(test_export_layout);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,145 @@
+#include <unity.h>
+#include <string.h>
+#include "communication/uplink_controller.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static UplinkController* uplink;
+static int16_t speech[1600];
+static int16_t silence[1600];
+
+void setUp(void) {
+    static UplinkController instance;
+    instance = UplinkController();
+    uplink = &instance;
+    for (size_t i = 0; i < 1600; i++) {
+        speech[i] = (i & 1) ? 3000 : -3000;
+        silence[i] = (i & 1) ? 50 : -50;
+    }
+}
+
+void tearDown(void) {
+}
+
+void test_strong_link_steps_up_to_fast_after_recovery() {
+    uplink->recordRssi(-50);
+    uplink->recordPing(80);
+    uplink->recordSend(30);
+
+    // Starts at normal; better signals must hold before stepping up
+    TEST_ASSERT_FALSE(uplink->update(0));
+    TEST_ASSERT_FALSE(uplink->update(UPLINK_RECOVERY_MS - 1));
+    TEST_ASSERT_TRUE(uplink->update(UPLINK_RECOVERY_MS + 1));
+    TEST_ASSERT_EQUAL_INT(UPLINK_FAST, uplink->getMode());
+    TEST_ASSERT_EQUAL_UINT32(UPLINK_FAST_CHUNK_MS, uplink->getChunkMs());
+    TEST_ASSERT_EQUAL_STRING("recovered", uplink->getReason());
+}
+
+void test_weak_rssi_steps_down_at_once() {
+    uplink->recordRssi(-85);
+    TEST_ASSERT_TRUE(uplink->update(0));
+    TEST_ASSERT_EQUAL_INT(UPLINK_CONSERVE, uplink->getMode());
+    TEST_ASSERT_EQUAL_STRING("rssi", uplink->getReason());
+}
+
+void test_slow_ping_keeps_normal() {
+    uplink->recordRssi(-50);
+    uplink->recordPing(UPLINK_RTT_FAST_MS + 100);
+    uplink->update(0);
+    TEST_ASSERT_FALSE(uplink->update(UPLINK_RECOVERY_MS * 2));
+    TEST_ASSERT_EQUAL_INT(UPLINK_NORMAL, uplink->getMode());
+}
+
+void test_backlog_steps_down_then_gates() {
+    uplink->recordRssi(-50);
+    uplink->setBacklog(UPLINK_BACKLOG_HIGH_MS + 1);
+    TEST_ASSERT_TRUE(uplink->update(0));
+    TEST_ASSERT_EQUAL_INT(UPLINK_CONSERVE, uplink->getMode());
+    TEST_ASSERT_EQUAL_STRING("backlog", uplink->getReason());
+
+    uplink->setBacklog(UPLINK_BACKLOG_GATE_MS + 1);
+    TEST_ASSERT_TRUE(uplink->update(100));
+    TEST_ASSERT_EQUAL_INT(UPLINK_GATED, uplink->getMode());
+
+    // Still backed up: stays gated however good the link looks
+    uplink->setBacklog(UPLINK_BACKLOG_HIGH_MS + 1);
+    TEST_ASSERT_FALSE(uplink->update(100 + UPLINK_RECOVERY_MS * 2));
+    TEST_ASSERT_EQUAL_INT(UPLINK_GATED, uplink->getMode());
+
+    // Drained: one step at a time
+    uplink->setBacklog(0);
+    uplink->update(200 + UPLINK_RECOVERY_MS * 2);
+    TEST_ASSERT_TRUE(uplink->update(200 + UPLINK_RECOVERY_MS * 3));
+    TEST_ASSERT_EQUAL_INT(UPLINK_CONSERVE, uplink->getMode());
+}
+
+void test_slow_sends_step_down_one_level() {
+    uplink->recordRssi(-50);
+    uplink->recordSend(UPLINK_NORMAL_CHUNK_MS * 2);
+    TEST_ASSERT_TRUE(uplink->update(0));
+    TEST_ASSERT_EQUAL_INT(UPLINK_CONSERVE, uplink->getMode());
+    TEST_ASSERT_EQUAL_STRING("send", uplink->getReason());
+}
+
+void test_gated_mode_drops_silence_after_hangover() {
+    uplink->setBacklog(UPLINK_BACKLOG_GATE_MS + 1);
+    uplink->update(0);
+    TEST_ASSERT_EQUAL_INT(UPLINK_GATED, uplink->getMode());
+
+    // No speech yet: silence is dropped
+    TEST_ASSERT_FALSE(uplink->admit(silence, 1600, 0));
+    TEST_ASSERT_TRUE(uplink->admit(speech, 1600, 100));
+    // Trailing silence within the hangover still goes out
+    TEST_ASSERT_TRUE(uplink->admit(silence, 1600, 100 + UPLINK_VAD_HANGOVER_MS));
+    TEST_ASSERT_FALSE(uplink->admit(silence, 1600, 101 + UPLINK_VAD_HANGOVER_MS));
+    TEST_ASSERT_EQUAL_UINT32(2, uplink->getGatedCount());
+}
+
+void test_silence_sent_when_not_gated() {
+    TEST_ASSERT_TRUE(uplink->admit(silence, 1600, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, uplink->getGatedCount());
+}
+
+void test_format() {
+    char line[256];
+    uplink->recordRssi(-85);
+    uplink->recordPing(120);
+    uplink->update(0);
+    uplink->format(line, sizeof(line), 1000);
+    TEST_ASSERT_EQUAL_STRING("UPLINK mode=conserve chunk=500ms reason=rssi | send_ms p50=0 p99=0 backlog_ms=0 "
+                             "rssi=-85 rtt=120 | changes=1 gated=0 | fast=0% normal=0% conserve=100% gated=0%",
+                             line);
+
+    TEST_ASSERT_EQUAL_UINT32(10, uplink->format(line, 11, 1000));
+    TEST_ASSERT_EQUAL_STRING("UPLINK mod", line);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_strong_link_steps_up_to_fast_after_recovery);
+    RUN_TEST(test_weak_rssi_steps_down_at_once);
+    RUN_TEST(test_slow_ping_keeps_normal);
+    RUN_TEST(test_backlog_steps_down_then_gates);
+    RUN_TEST(test_slow_sends_step_down_one_level);
+    RUN_TEST(test_gated_mode_drops_silence_after_hangover);
+    RUN_TEST(test_silence_sent_when_not_gated);
+    RUN_TEST(test_format);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
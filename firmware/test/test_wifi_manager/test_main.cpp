@@ -25,12 +25,28 @@ void test_wifi_connect_failure_bad_credentials(void) {
     TEST_ASSERT_FALSE_MESSAGE(wifiManager.isConnected(), "isConnected returned true after failed connection");
 }
 
+void test_wifi_reconnect_uses_cache(void) {
+    wifiManager.clearCache();
+    TEST_ASSERT_TRUE(wifiManager.connect("Wokwi-GUEST", "", 15000));
+    TEST_ASSERT_FALSE(wifiManager.getConnectTiming().cached);
+
+    // The first connection saved the AP; the second goes straight to it
+    WiFi.disconnect();
+    delay(100);
+    TEST_ASSERT_TRUE(wifiManager.connect("Wokwi-GUEST", "", 15000));
+    const WiFiConnectTiming& timing = wifiManager.getConnectTiming();
+    TEST_ASSERT_TRUE_MESSAGE(timing.cached, "Reconnect did not use the cached AP");
+    TEST_ASSERT_FALSE(timing.fellBack);
+    TEST_ASSERT_TRUE(timing.totalMs > 0);
+}
+
 void setup() {
     delay(2000);
 
     UNITY_BEGIN();
     RUN_TEST(test_wifi_connect_success);
     RUN_TEST(test_wifi_connect_failure_bad_credentials);
+    RUN_TEST(test_wifi_reconnect_uses_cache);
 
     UNITY_END();
 }
@@ -0,0 +1,127 @@
+#include <unity.h>
+#include "communication/wifi_supervisor.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+static WiFiSupervisor* supervisor;
+
+void setUp(void) {
+    static WiFiSupervisor instance;
+    instance = WiFiSupervisor();
+    supervisor = &instance;
+}
+
+void tearDown(void) {
+}
+
+void test_nothing_to_do_while_up() {
+    supervisor->start(0);
+    supervisor->onConnected(300);
+    TEST_ASSERT_TRUE(supervisor->isUp());
+    TEST_ASSERT_EQUAL(WIFI_ACTION_NONE, supervisor->poll(60000));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, supervisor->getMsUntilNext(60000));
+}
+
+void test_lost_link_retries_after_short_delay() {
+    supervisor->start(0);
+    supervisor->onConnected(300);
+    supervisor->onDisconnected(1000);
+    TEST_ASSERT_EQUAL(WIFI_LINK_BACKOFF, supervisor->getState());
+    TEST_ASSERT_EQUAL_UINT32(1, supervisor->getOutageCount());
+    TEST_ASSERT_EQUAL_UINT32(WIFI_RECONNECT_MIN_MS, supervisor->getMsUntilNext(1000));
+
+    TEST_ASSERT_EQUAL(WIFI_ACTION_NONE, supervisor->poll(1000 + WIFI_RECONNECT_MIN_MS - 1));
+    TEST_ASSERT_EQUAL(WIFI_ACTION_RECONNECT, supervisor->poll(1000 + WIFI_RECONNECT_MIN_MS));
+    TEST_ASSERT_EQUAL(WIFI_LINK_CONNECTING, supervisor->getState());
+
+    // Back: the outage is measured from the loss
+    supervisor->onConnected(2500);
+    TEST_ASSERT_TRUE(supervisor->isUp());
+    TEST_ASSERT_EQUAL_UINT32(1500, supervisor->getOutageTime().getMax());
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor->getCurrentOutageMs(3000));
+}
+
+void test_failed_attempts_back_off_then_rescan() {
+    supervisor->start(0);
+    supervisor->onConnected(300);
+    supervisor->onDisconnected(1000);
+
+    uint32_t now = 1000 + WIFI_RECONNECT_MIN_MS;
+    uint32_t lastDelay = WIFI_RECONNECT_MIN_MS;
+    for (uint32_t failure = 1; failure <= WIFI_RESCAN_AFTER; failure++) {
+        TEST_ASSERT_EQUAL(WIFI_ACTION_RECONNECT, supervisor->poll(now));
+        supervisor->onDisconnected(now + 100);
+        uint32_t delay = supervisor->getMsUntilNext(now + 100);
+        TEST_ASSERT_TRUE(delay > lastDelay);
+        lastDelay = delay;
+        now += 100 + delay;
+    }
+
+    // Repeated events while waiting change nothing
+    supervisor->onDisconnected(now - 1);
+    TEST_ASSERT_EQUAL_UINT32(WIFI_RESCAN_AFTER, supervisor->getFailures());
+    TEST_ASSERT_EQUAL(WIFI_ACTION_RESCAN, supervisor->poll(now));
+    TEST_ASSERT_EQUAL_UINT32(WIFI_RESCAN_AFTER + 1, supervisor->getAttemptCount());
+}
+
+void test_backoff_is_capped() {
+    supervisor->start(0);
+    uint32_t now = 0;
+    for (int i = 0; i < 20; i++) {
+        supervisor->onDisconnected(now);
+        now += supervisor->getMsUntilNext(now);
+        supervisor->poll(now);
+    }
+    supervisor->onDisconnected(now);
+    TEST_ASSERT_EQUAL_UINT32(WIFI_RECONNECT_MAX_MS, supervisor->getMsUntilNext(now));
+}
+
+void test_silent_attempt_times_out() {
+    supervisor->start(0);
+    TEST_ASSERT_EQUAL_UINT32(WIFI_ATTEMPT_TIMEOUT_MS, supervisor->getMsUntilNext(0));
+    TEST_ASSERT_EQUAL(WIFI_ACTION_NONE, supervisor->poll(WIFI_ATTEMPT_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL(WIFI_LINK_BACKOFF, supervisor->getState());
+    TEST_ASSERT_EQUAL_UINT32(1, supervisor->getFailures());
+}
+
+void test_format() {
+    char line[160];
+    supervisor->start(0);
+    supervisor->onConnected(300);
+    supervisor->onDisconnected(1000);
+    supervisor->format(line, sizeof(line), 1200);
+    TEST_ASSERT_EQUAL_STRING("WIFISUP backoff down=200ms failures=0 next=300ms outages=1 attempts=0 "
+                             "outage_ms p50=0 p99=0 max=0",
+                             line);
+
+    TEST_ASSERT_EQUAL_UINT32(10, supervisor->format(line, 11, 1200));
+    TEST_ASSERT_EQUAL_STRING("WIFISUP ba", line);
+}
+
+int runUnityTests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_to_do_while_up);
+    RUN_TEST(test_lost_link_retries_after_short_delay);
+    RUN_TEST(test_failed_attempts_back_off_then_rescan);
+    RUN_TEST(test_backoff_is_capped);
+    RUN_TEST(test_silent_attempt_times_out);
+    RUN_TEST(test_format);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000);
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do here
+}
+#else
+int main(void) {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Check fragmented message reassembly end to end against the mock server.
+
+Usage (from the firmware directory, after `pio run -e host`):
+1. Text (base64 audio) messages split into 512-byte fragments:
+   python tools/fragment_check.py
+2. Binary audio frames, smaller fragments:
+   python tools/fragment_check.py --audio-encoding binary --fragment-size 200
+
+Starts tools/mock_elevenlabs_server.py with --fragment-size on a free port,
+runs the host program against it with --expect-fragments and exits with its
+status: non-zero if no agent audio arrived, nothing was reassembled or a
+fragmented message was dropped. The host program's "Fragments:" line gives
+the reassembled message count and throughput.
+"""
+
+import argparse
+import os
+import socket
+import subprocess
+import sys
+import time
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+SERVER = os.path.join(TOOLS_DIR, "mock_elevenlabs_server.py")
+DEFAULT_PROGRAM = os.path.join(TOOLS_DIR, "..", ".pio", "build", "host", "program")
+
+def free_port():
+    """Ask the OS for an unused local port."""
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+def wait_for_port(port, timeout):
+    """Wait until the server accepts connections."""
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            with socket.create_connection(("127.0.0.1", port), timeout=0.2):
+                return True
+        except OSError:
+            time.sleep(0.1)
+    return False
+
+def main():
+    parser = argparse.ArgumentParser(description='Check fragmented message reassembly against the mock server')
+    parser.add_argument('--program', default=DEFAULT_PROGRAM, help='Host program (default: .pio/build/host/program)')
+    parser.add_argument('--fragment-size', type=int, default=512,
+                       help='Server fragment size in bytes (default: 512)')
+    parser.add_argument('--audio-encoding', choices=['base64', 'binary'], default='base64',
+                       help='Agent audio transport (default: base64)')
+    parser.add_argument('--turns', type=int, default=2, help='Conversation turns (default: 2)')
+    args = parser.parse_args()
+
+    if not os.path.exists(args.program):
+        print(f"Error: {args.program} not found; build it with `pio run -e host`")
+        return 2
+
+    port = free_port()
+    server = subprocess.Popen([sys.executable, SERVER, "--port", str(port),
+                               "--fragment-size", str(args.fragment_size),
+                               "--audio-encoding", args.audio_encoding],
+                              stdout=subprocess.DEVNULL)
+    try:
+        if not wait_for_port(port, 5.0):
+            print("Error: mock server did not start")
+            return 2
+
+        command = [args.program, "--port", str(port), "--turns", str(args.turns),
+                   "--expect-fragments", "--quiet"]
+        if args.audio_encoding == "binary":
+            command.append("--binary-audio")
+        result = subprocess.run(command)
+    finally:
+        server.terminate()
+        server.wait()
+
+    print("Fragment check " + ("passed" if result.returncode == 0 else "FAILED"))
+    return result.returncode
+
+if __name__ == "__main__":
+    sys.exit(main())
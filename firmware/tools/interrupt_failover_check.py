@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""
+Check that agent audio plays after a reconnect that follows an interruption.
+
+Usage (from the firmware directory, after `pio run -e host`):
+1. Client polled inline:
+   python tools/interrupt_failover_check.py
+2. Client in the network task, fail over to the hot standby:
+   python tools/interrupt_failover_check.py --network-task --failover
+
+Starts tools/mock_elevenlabs_server.py with a script whose turn is ten
+audio chunks and, once they have been delivered, an interruption, then
+runs the host program against it. Once the first turn is done the server
+drops the connection (SIGUSR1, or SIGUSR2 with --failover so only the
+active connection goes and the standby takes over). The new conversation
+numbers its events from
+1 again, all below the old interruption's event ID, so its audio only
+plays if the client forgot that interruption. Exits non-zero unless the
+client reconnected and the turn on the new conversation produced audio.
+"""
+
+import argparse
+import json
+import os
+import re
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+SERVER = os.path.join(TOOLS_DIR, "mock_elevenlabs_server.py")
+DEFAULT_PROGRAM = os.path.join(TOOLS_DIR, "..", ".pio", "build", "host", "program")
+
+SCRIPT = {"on_turn": [
+    {"send": "agent_response", "text": "Let me tell you a long story."},
+    {"send": "audio", "chunks": 10, "chunk_ms": 100},
+    {"wait_ms": 300},           # Delivered first, and well inside the host's 1 s turn settle time
+    {"send": "interruption"}
+]}
+
+def free_port():
+    """Ask the OS for an unused local port."""
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.bind(("127.0.0.1", 0))
+        return s.getsockname()[1]
+
+def wait_for_port(port, timeout):
+    """Wait until the server accepts connections."""
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            with socket.create_connection(("127.0.0.1", port), timeout=0.2):
+                return True
+        except OSError:
+            time.sleep(0.1)
+    return False
+
+def main():
+    parser = argparse.ArgumentParser(description='Check that audio plays after an interruption and a reconnect')
+    parser.add_argument('--program', default=DEFAULT_PROGRAM, help='Host program (default: .pio/build/host/program)')
+    parser.add_argument('--network-task', action='store_true', help='Run the client in the network task')
+    parser.add_argument('--failover', action='store_true',
+                       help='Open the hot standby and drop only the active connection')
+    parser.add_argument('--duration', type=int, default=60, help='Give up after this many seconds (default: 60)')
+    args = parser.parse_args()
+
+    if not os.path.exists(args.program):
+        print(f"Error: {args.program} not found; build it with `pio run -e host`")
+        return 2
+
+    with tempfile.NamedTemporaryFile("w", suffix=".json", delete=False) as f:
+        json.dump(SCRIPT, f)
+        script_path = f.name
+
+    port = free_port()
+    # No pings, so the event IDs are just the audio chunks
+    server = subprocess.Popen([sys.executable, SERVER, "--port", str(port), "--script", script_path,
+                               "--ping-interval", "3600"],
+                              stdout=subprocess.DEVNULL)
+    turns = []
+    connects = 0
+    try:
+        if not wait_for_port(port, 5.0):
+            print("Error: mock server did not start")
+            return 2
+
+        command = [args.program, "--port", str(port), "--turns", "2", "--duration", str(args.duration), "--quiet"]
+        if args.network_task:
+            command.append("--network-task")
+        if args.failover:
+            command += ["--standby", "--weak-rssi-after", "0"]
+        host = subprocess.Popen(command, stderr=subprocess.PIPE, text=True)
+
+        dropped = False
+        for line in host.stderr:
+            sys.stderr.write(line)
+            match = re.search(r"\[HOST\] Turn (\d+): (\d+) audio frames", line)
+            if match:
+                turns.append(int(match.group(2)))
+                if not dropped:
+                    server.send_signal(signal.SIGUSR2 if args.failover else signal.SIGUSR1)
+                    dropped = True
+            match = re.search(r"turns with audio, (\d+) connects", line)
+            if match:
+                connects = int(match.group(1))
+        host.wait()
+    finally:
+        server.terminate()
+        server.wait()
+        os.unlink(script_path)
+
+    # The last turn is always on the new conversation: none can finish on a dropped one
+    ok = connects >= 2 and len(turns) >= 2 and turns[0] > 0 and turns[-1] > 0
+    print(f"Turns: {turns}, connects: {connects}")
+    print("Interrupt failover check " + ("passed" if ok else "FAILED"))
+    return 0 if ok else 1
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,472 @@
+#!/usr/bin/env python3
+"""
+Local mock of the ElevenLabs Conversational AI WebSocket endpoint.
+
+Usage:
+1. Start the server:
+   python mock_elevenlabs_server.py --port 8765
+2. Point a client at it (host build or a device on the same network):
+   .pio/build/host/program --host 127.0.0.1 --port 8765
+3. Impair the link to see how the client copes:
+   python mock_elevenlabs_server.py --latency-ms 80 --jitter-ms 30 --bandwidth-kbps 256
+   python mock_elevenlabs_server.py --disconnect-after 20 --fragment-size 1400
+
+The server speaks the subset of the conversation protocol the firmware uses:
+it answers conversation_initiation_client_data with
+conversation_initiation_metadata, sends periodic ping events and measures
+the pong RTT, and plays a scripted response (user_transcript,
+agent_response, audio, ...) whenever the user finishes a turn. A turn ends
+when no user_audio_chunk arrives for --turn-gap-ms, or on a user_message.
+
+Responses can be scripted with --script FILE, a JSON object with optional
+"on_connect", "on_turn" and "on_user_message" lists of steps:
+
+    {"on_turn": [
+        {"send": "user_transcript", "text": "what time is it"},
+        {"wait_ms": 300},
+        {"send": "agent_response", "text": "It is noon."},
+        {"send": "audio", "chunks": 20, "chunk_ms": 100},
+        {"send": "client_tool_call", "tool_name": "wag_tail", "parameters": {"times": 3}},
+        {"send": "interruption"},
+        {"disconnect": true}
+    ]}
+
+Audio goes out as base64 "audio" JSON events, or as binary frames
+(12-byte header: version, format, reserved, event_id, length - see
+src/communication/binary_audio_frame.h) when the client connects with
+audio_transport=binary or --audio-encoding binary forces it.
+
+Sending SIGUSR1 drops every open connection immediately. SIGUSR2 drops only
+connections with a conversation in progress, leaving idle (standby) ones.
+Pings start once the client has sent conversation_initiation_client_data.
+
+Only the Python 3 standard library is required.
+"""
+
+import argparse
+import asyncio
+import base64
+import hashlib
+import json
+import math
+import random
+import signal
+import struct
+import sys
+import time
+import urllib.parse
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+OP_CONTINUATION = 0x0
+OP_TEXT = 0x1
+OP_BINARY = 0x2
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+BINARY_AUDIO_VERSION = 1
+BINARY_AUDIO_HEADER = struct.Struct("<BBHII")
+BINARY_AUDIO_FORMATS = {16000: 1, 22050: 2, 24000: 3, 44100: 4}
+
+DEFAULT_SCRIPT = {
+    "on_connect": [],
+    "on_turn": [
+        {"send": "user_transcript", "text": "hello robot"},
+        {"wait_ms": 200},
+        {"send": "agent_response", "text": "Hello! How can I help you today?"},
+        {"send": "audio", "chunks": 10, "chunk_ms": 100},
+    ],
+    "on_user_message": [
+        {"send": "agent_response", "text": "Got your message."},
+        {"send": "audio", "chunks": 5, "chunk_ms": 100},
+    ],
+}
+
+def make_pcm(duration_ms, sample_rate, frequency=440.0, phase=0):
+    """Generate 16-bit mono PCM of a sine tone."""
+    samples = int(sample_rate * duration_ms / 1000)
+    data = bytearray(samples * 2)
+    for i in range(samples):
+        value = int(8000 * math.sin(2 * math.pi * frequency * (phase + i) / sample_rate))
+        struct.pack_into("<h", data, i * 2, value)
+    return bytes(data)
+
+class Connection:
+    """One client connection: framing, impairment and protocol state."""
+
+    def __init__(self, server, reader, writer):
+        self.server = server
+        self.args = server.args
+        self.reader = reader
+        self.writer = writer
+        self.peer = writer.get_extra_info("peername")
+        self.outbox = asyncio.Queue()
+        self.event_id = 0
+        self.closed = False
+        self.opened_at = time.monotonic()
+        self.last_send_due = 0.0
+        self.last_user_audio = None
+        self.turn_task = None
+        self.ping_sent = {}
+        self.last_ping_ms = None
+        self.initiated = False
+        self.binary_audio = False
+        self.stats = {"frames_in": 0, "bytes_in": 0, "frames_out": 0, "bytes_out": 0,
+                      "audio_in": 0, "audio_out": 0, "turns": 0}
+
+    # --- Framing -----------------------------------------------------------
+
+    async def handshake(self):
+        request = await self.reader.readuntil(b"\r\n\r\n")
+        lines = request.decode(errors="replace").split("\r\n")
+        path = lines[0].split(" ")[1] if len(lines[0].split(" ")) > 1 else "/"
+        query = urllib.parse.parse_qs(urllib.parse.urlparse(path).query)
+        if self.args.audio_encoding == "auto":
+            self.binary_audio = query.get("audio_transport", [""])[0] == "binary"
+        else:
+            self.binary_audio = self.args.audio_encoding == "binary"
+        headers = {}
+        for line in lines[1:]:
+            if ":" in line:
+                name, value = line.split(":", 1)
+                headers[name.strip().lower()] = value.strip()
+        key = headers.get("sec-websocket-key")
+        if not key:
+            self.writer.write(b"HTTP/1.1 400 Bad Request\r\n\r\n")
+            return False
+        accept = base64.b64encode(hashlib.sha1((key + WS_GUID).encode()).digest()).decode()
+        response = ("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                    f"Sec-WebSocket-Accept: {accept}\r\n")
+        if "sec-websocket-protocol" in headers:
+            protocol = headers["sec-websocket-protocol"].split(",")[0].strip()
+            response += f"Sec-WebSocket-Protocol: {protocol}\r\n"
+        self.writer.write((response + "\r\n").encode())
+        await self.writer.drain()
+        return True
+
+    async def read_frame(self):
+        header = await self.reader.readexactly(2)
+        fin = header[0] & 0x80
+        opcode = header[0] & 0x0F
+        masked = header[1] & 0x80
+        length = header[1] & 0x7F
+        if length == 126:
+            length = struct.unpack(">H", await self.reader.readexactly(2))[0]
+        elif length == 127:
+            length = struct.unpack(">Q", await self.reader.readexactly(8))[0]
+        mask = await self.reader.readexactly(4) if masked else None
+        payload = bytearray(await self.reader.readexactly(length))
+        if mask:
+            for i in range(length):
+                payload[i] ^= mask[i % 4]
+        return fin, opcode, bytes(payload)
+
+    @staticmethod
+    def encode_frame(opcode, payload, fin=True):
+        first = (0x80 if fin else 0) | opcode
+        length = len(payload)
+        if length < 126:
+            header = struct.pack(">BB", first, length)
+        elif length < 65536:
+            header = struct.pack(">BBH", first, 126, length)
+        else:
+            header = struct.pack(">BBQ", first, 127, length)
+        return header + payload
+
+    def frames_for(self, opcode, payload):
+        """Split a message into frames, honouring --fragment-size."""
+        size = self.args.fragment_size
+        if not size or len(payload) <= size or opcode >= OP_CLOSE:
+            return [self.encode_frame(opcode, payload)]
+        frames = []
+        for offset in range(0, len(payload), size):
+            piece = payload[offset:offset + size]
+            last = offset + size >= len(payload)
+            frames.append(self.encode_frame(opcode if offset == 0 else OP_CONTINUATION, piece, fin=last))
+        return frames
+
+    # --- Impaired outbound path -------------------------------------------
+
+    def send_json(self, message):
+        self.send_raw(OP_TEXT, json.dumps(message).encode())
+
+    def send_raw(self, opcode, payload):
+        if self.closed:
+            return
+        delay = self.args.latency_ms / 1000.0
+        if self.args.jitter_ms:
+            delay += random.uniform(-self.args.jitter_ms, self.args.jitter_ms) / 1000.0
+        # Messages never overtake each other, whatever the jitter
+        due = max(time.monotonic() + max(delay, 0.0), self.last_send_due)
+        self.last_send_due = due
+        self.outbox.put_nowait((due, opcode, payload))
+
+    async def sender(self):
+        rate = self.args.bandwidth_kbps * 1000 / 8 if self.args.bandwidth_kbps else None
+        while True:
+            due, opcode, payload = await self.outbox.get()
+            wait = due - time.monotonic()
+            if wait > 0:
+                await asyncio.sleep(wait)
+            for frame in self.frames_for(opcode, payload):
+                if rate:
+                    await asyncio.sleep(len(frame) / rate)
+                self.writer.write(frame)
+                await self.writer.drain()
+            self.stats["frames_out"] += 1
+            self.stats["bytes_out"] += len(payload)
+
+    # --- Protocol ----------------------------------------------------------
+
+    def next_event_id(self):
+        self.event_id += 1
+        return self.event_id
+
+    async def run_steps(self, steps):
+        for step in steps:
+            if "wait_ms" in step:
+                await asyncio.sleep(step["wait_ms"] / 1000.0)
+            elif step.get("disconnect"):
+                self.abort("scripted disconnect")
+                return
+            else:
+                await self.send_step(step)
+
+    async def send_step(self, step):
+        kind = step.get("send")
+        if kind == "metadata":
+            self.send_metadata()
+        elif kind == "user_transcript":
+            self.send_json({"type": "user_transcript",
+                            "user_transcription_event": {"user_transcript": step.get("text", "")}})
+        elif kind == "agent_response":
+            self.send_json({"type": "agent_response",
+                            "agent_response_event": {"agent_response": step.get("text", "")}})
+        elif kind == "audio":
+            await self.send_audio(step.get("chunks", 10), step.get("chunk_ms", 100))
+        elif kind == "ping":
+            self.send_ping()
+        elif kind == "interruption":
+            self.send_json({"type": "interruption", "interruption_event": {"event_id": self.event_id}})
+        elif kind == "client_tool_call":
+            self.send_json({"type": "client_tool_call", "client_tool_call": {
+                "tool_name": step.get("tool_name", "noop"),
+                "tool_call_id": step.get("tool_call_id", f"call_{self.next_event_id()}"),
+                "parameters": step.get("parameters", {})}})
+        elif kind == "vad_score":
+            self.send_json({"type": "vad_score", "vad_score_event": {"vad_score": step.get("score", 0.9)}})
+        else:
+            print(f"[{self.peer}] Unknown script step: {step}")
+
+    async def send_audio(self, chunks, chunk_ms):
+        phase = 0
+        for _ in range(chunks):
+            pcm = make_pcm(chunk_ms, self.args.sample_rate, phase=phase)
+            phase += len(pcm) // 2
+            if self.binary_audio:
+                header = BINARY_AUDIO_HEADER.pack(BINARY_AUDIO_VERSION, BINARY_AUDIO_FORMATS[self.args.sample_rate],
+                                                  0, self.next_event_id(), len(pcm))
+                self.send_raw(OP_BINARY, header + pcm)
+            else:
+                self.send_json({"type": "audio", "audio_event": {
+                    "audio_base_64": base64.b64encode(pcm).decode(), "event_id": self.next_event_id()}})
+            self.stats["audio_out"] += 1
+            if self.args.audio_pacing == "realtime":
+                await asyncio.sleep(chunk_ms / 1000.0)
+
+    def send_metadata(self):
+        self.send_json({"type": "conversation_initiation_metadata",
+                        "conversation_initiation_metadata_event": {
+                            "conversation_id": f"mock_{int(self.opened_at * 1000)}",
+                            "agent_output_audio_format": f"pcm_{self.args.sample_rate}",
+                            "user_input_audio_format": "pcm_16000"}})
+
+    def send_ping(self):
+        event_id = self.next_event_id()
+        self.ping_sent[event_id] = time.monotonic()
+        self.send_json({"type": "ping", "ping_event": {"event_id": event_id, "ping_ms": self.last_ping_ms}})
+
+    def start_turn(self, steps):
+        if self.turn_task and not self.turn_task.done():
+            return
+        self.stats["turns"] += 1
+        self.turn_task = asyncio.ensure_future(self.run_steps(steps))
+
+    def handle_message(self, message):
+        kind = message.get("type")
+        if "user_audio_chunk" in message:
+            self.stats["audio_in"] += 1
+            self.last_user_audio = time.monotonic()
+            if self.args.barge_in and self.turn_task and not self.turn_task.done():
+                # User talks over the agent - cancel the rest of the response
+                self.turn_task.cancel()
+                self.send_json({"type": "interruption", "interruption_event": {"event_id": self.event_id}})
+        elif kind == "conversation_initiation_client_data":
+            self.initiated = True
+            self.send_metadata()
+            asyncio.ensure_future(self.run_steps(self.server.script.get("on_connect", [])))
+        elif kind == "user_message":
+            self.start_turn(self.server.script.get("on_user_message", []))
+        elif kind == "pong":
+            sent = self.ping_sent.pop(message.get("event_id"), None)
+            if sent is not None:
+                self.last_ping_ms = int((time.monotonic() - sent) * 1000)
+        elif kind == "client_tool_result":
+            print(f"[{self.peer}] Tool result: {message.get('tool_call_id')} -> {message.get('result')}")
+
+    async def ticker(self):
+        """Periodic work: pings, end-of-turn detection, scheduled disconnects."""
+        next_ping = time.monotonic() + self.args.ping_interval
+        while True:
+            await asyncio.sleep(0.02)
+            now = time.monotonic()
+            if self.args.ping_interval and self.initiated and now >= next_ping:
+                self.send_ping()
+                next_ping = now + self.args.ping_interval
+            if self.last_user_audio and (now - self.last_user_audio) * 1000 >= self.args.turn_gap_ms:
+                self.last_user_audio = None
+                self.start_turn(self.server.script.get("on_turn", []))
+            if self.args.disconnect_after and now - self.opened_at >= self.args.disconnect_after:
+                self.abort("disconnect-after elapsed")
+                return
+
+    def abort(self, reason):
+        if not self.closed:
+            print(f"[{self.peer}] Dropping connection: {reason}")
+            self.closed = True
+            self.writer.transport.abort()
+
+    async def serve(self):
+        if not await self.handshake():
+            return
+        print(f"[{self.peer}] Connected ({'binary' if self.binary_audio else 'base64'} audio)")
+        tasks = [asyncio.ensure_future(self.sender()), asyncio.ensure_future(self.ticker())]
+        try:
+            fragments = []
+            while not self.closed:
+                fin, opcode, payload = await self.read_frame()
+                if opcode == OP_CLOSE:
+                    self.writer.write(self.encode_frame(OP_CLOSE, payload[:2]))
+                    break
+                if opcode == OP_PING:
+                    self.writer.write(self.encode_frame(OP_PONG, payload))
+                    continue
+                if opcode == OP_PONG:
+                    continue
+                fragments.append(payload)
+                if not fin:
+                    continue
+                data = b"".join(fragments)
+                fragments = []
+                self.stats["frames_in"] += 1
+                self.stats["bytes_in"] += len(data)
+                if opcode in (OP_TEXT, OP_CONTINUATION):
+                    try:
+                        self.handle_message(json.loads(data))
+                    except ValueError:
+                        print(f"[{self.peer}] Invalid JSON ({len(data)} bytes)")
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            self.closed = True
+            for task in tasks + ([self.turn_task] if self.turn_task else []):
+                task.cancel()
+            self.writer.close()
+            elapsed = time.monotonic() - self.opened_at
+            s = self.stats
+            print(f"[{self.peer}] Closed after {elapsed:.1f}s: in {s['frames_in']} frames/{s['bytes_in']} B "
+                  f"({s['audio_in']} audio), out {s['frames_out']} frames/{s['bytes_out']} B "
+                  f"({s['audio_out']} audio), {s['turns']} turns, last ping {self.last_ping_ms} ms")
+
+class MockServer:
+    def __init__(self, args, script):
+        self.args = args
+        self.script = script
+        self.connections = set()
+
+    async def handle(self, reader, writer):
+        connection = Connection(self, reader, writer)
+        self.connections.add(connection)
+        try:
+            await connection.serve()
+        finally:
+            self.connections.discard(connection)
+
+    def drop_all(self):
+        for connection in list(self.connections):
+            connection.abort("SIGUSR1")
+
+    def drop_active(self):
+        for connection in list(self.connections):
+            if connection.initiated:
+                connection.abort("SIGUSR2")
+
+def load_script(path):
+    """Load a response script, falling back to the built-in one."""
+    if not path:
+        return DEFAULT_SCRIPT
+    try:
+        with open(path, "r", encoding="utf-8") as f:
+            script = json.load(f)
+    except (OSError, ValueError) as e:
+        print(f"Error loading script: {e}")
+        return None
+    merged = dict(DEFAULT_SCRIPT)
+    merged.update(script)
+    return merged
+
+def main():
+    parser = argparse.ArgumentParser(description='Mock ElevenLabs Conversational AI WebSocket server')
+    parser.add_argument('--host', default='127.0.0.1', help='Address to listen on (default: 127.0.0.1)')
+    parser.add_argument('--port', type=int, default=8765, help='Port to listen on (default: 8765)')
+    parser.add_argument('--script', help='JSON response script (see module docstring)')
+    parser.add_argument('--sample-rate', type=int, default=16000, choices=sorted(BINARY_AUDIO_FORMATS),
+                       help='Agent audio sample rate in Hz (default: 16000)')
+    parser.add_argument('--audio-encoding', choices=['auto', 'base64', 'binary'], default='auto',
+                       help='Audio transport; auto follows the client\'s audio_transport parameter (default: auto)')
+    parser.add_argument('--audio-pacing', choices=['burst', 'realtime'], default='burst',
+                       help='Send audio chunks back-to-back or at playback rate (default: burst)')
+    parser.add_argument('--turn-gap-ms', type=int, default=500,
+                       help='Uplink silence that ends a user turn (default: 500)')
+    parser.add_argument('--ping-interval', type=float, default=5.0,
+                       help='Seconds between ping events, 0 to disable (default: 5)')
+    parser.add_argument('--latency-ms', type=float, default=0, help='One-way delay added to every message')
+    parser.add_argument('--jitter-ms', type=float, default=0, help='Uniform +/- jitter on top of --latency-ms')
+    parser.add_argument('--bandwidth-kbps', type=float, default=0, help='Downlink cap in kbit/s (0 = unlimited)')
+    parser.add_argument('--fragment-size', type=int, default=0,
+                       help='Split messages into WebSocket fragments of this many bytes')
+    parser.add_argument('--disconnect-after', type=float, default=0,
+                       help='Drop each connection after this many seconds')
+    parser.add_argument('--barge-in', action='store_true',
+                       help='Send an interruption when user audio arrives during a response')
+    parser.add_argument('--seed', type=int, help='Random seed for reproducible jitter')
+
+    args = parser.parse_args()
+    sys.stdout.reconfigure(line_buffering=True)
+    if args.seed is not None:
+        random.seed(args.seed)
+
+    script = load_script(args.script)
+    if script is None:
+        sys.exit(1)
+
+    server = MockServer(args, script)
+    loop = asyncio.new_event_loop()
+    asyncio.set_event_loop(loop)
+    listener = loop.run_until_complete(asyncio.start_server(server.handle, args.host, args.port))
+    if hasattr(signal, "SIGUSR1"):
+        loop.add_signal_handler(signal.SIGUSR1, server.drop_all)
+    if hasattr(signal, "SIGUSR2"):
+        loop.add_signal_handler(signal.SIGUSR2, server.drop_active)
+
+    print(f"Mock ElevenLabs server on ws://{args.host}:{args.port}/v1/convai/conversation")
+    try:
+        loop.run_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        listener.close()
+
+if __name__ == "__main__":
+    main()
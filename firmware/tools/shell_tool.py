@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""
+Scripted control of the device over its serial shell.
+
+Usage:
+    python shell_tool.py --port /dev/ttyACM0 ping
+    python shell_tool.py --port /dev/ttyACM0 cmd l
+    python shell_tool.py --port /dev/ttyACM0 metrics
+
+Requests and replies are binary frames (see src/system/command_shell.h)
+that share the port with the log. Log output that arrives while waiting
+for a reply is shown with --log. Requires pyserial.
+
+Frame layout (little-endian): 0xA5, uint8 type, uint8 seq, uint16 length,
+payload, uint16 CRC-16/CCITT-FALSE of everything after the sync byte.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+SYNC = 0xA5
+HEADER = struct.Struct("<BBH")
+PING, COMMAND, METRICS = 0x01, 0x02, 0x03
+REPLY = 0x80
+STATUS = {0: "ok", 1: "unknown command", 2: "bad request"}
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+def build_frame(frame_type, seq, payload=b""):
+    body = HEADER.pack(frame_type, seq, len(payload)) + payload
+    return bytes([SYNC]) + body + struct.pack("<H", crc16(body))
+
+class FrameReader:
+    """Splits the byte stream into frames and log text."""
+
+    def __init__(self, port, show_log):
+        self.port = port
+        self.show_log = show_log
+        self.buffer = bytearray()
+
+    def next_frame(self, timeout):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            frame = self._take_frame()
+            if frame is not None:
+                return frame
+            self.buffer += self.port.read(self.port.in_waiting or 1)
+        return None
+
+    def _take_frame(self):
+        while True:
+            start = self.buffer.find(bytes([SYNC]))
+            if start < 0:
+                self._log(self.buffer)
+                self.buffer.clear()
+                return None
+            self._log(self.buffer[:start])
+            del self.buffer[:start]
+
+            if len(self.buffer) < 1 + HEADER.size:
+                return None
+            frame_type, seq, length = HEADER.unpack_from(self.buffer, 1)
+            total = 1 + HEADER.size + length + 2
+            if len(self.buffer) < total:
+                return None
+
+            body = bytes(self.buffer[1:total - 2])
+            (crc,) = struct.unpack_from("<H", self.buffer, total - 2)
+            if crc == crc16(body):
+                del self.buffer[:total]
+                return frame_type, seq, body[HEADER.size:]
+
+            # Not a frame after all - a log byte that happened to match
+            self._log(self.buffer[:1])
+            del self.buffer[:1]
+
+    def _log(self, data):
+        if self.show_log and data:
+            sys.stderr.write(data.decode("utf-8", errors="replace"))
+
+def request(port, reader, frame_type, seq, payload, timeout):
+    port.write(build_frame(frame_type, seq, payload))
+    while True:
+        frame = reader.next_frame(timeout)
+        if frame is None:
+            return None
+        reply_type, reply_seq, body = frame
+        if reply_type == frame_type | REPLY and reply_seq == seq:
+            return body
+
+def main():
+    parser = argparse.ArgumentParser(description='Send commands and read metrics over the serial shell')
+    parser.add_argument('--port', required=True, help='Serial device')
+    parser.add_argument('--baud', type=int, default=115200, help='Baud rate (default 115200)')
+    parser.add_argument('--timeout', type=float, default=2.0, help='Seconds to wait for a reply')
+    parser.add_argument('--log', action='store_true', help='Show device log output on stderr')
+    commands = parser.add_subparsers(dest='command')
+    commands.add_parser('ping', help='Round-trip time to the shell')
+    cmd_parser = commands.add_parser('cmd', help='Run a shell command')
+    cmd_parser.add_argument('line', nargs='+', help='Command and arguments')
+    commands.add_parser('metrics', help='Print the telemetry lines')
+    args = parser.parse_args()
+
+    if args.command is None:
+        parser.print_help()
+        sys.exit(1)
+
+    try:
+        import serial
+    except ImportError:
+        print("pyserial is required: pip install pyserial")
+        sys.exit(1)
+
+    with serial.Serial(args.port, args.baud, timeout=0.05) as port:
+        reader = FrameReader(port, args.log)
+        seq = int(time.monotonic() * 1000) & 0xFF
+        # A newline first, so the device sees the sync byte at the start of a line
+        port.write(b"\n")
+
+        if args.command == 'ping':
+            start = time.monotonic()
+            reply = request(port, reader, PING, seq, b"ping", args.timeout)
+            if reply is None:
+                print("No reply")
+                sys.exit(1)
+            print(f"Reply in {(time.monotonic() - start) * 1000:.1f} ms")
+
+        elif args.command == 'cmd':
+            line = " ".join(args.line).encode()
+            reply = request(port, reader, COMMAND, seq, line, args.timeout)
+            if not reply:
+                print("No reply")
+                sys.exit(1)
+            print(STATUS.get(reply[0], f"status {reply[0]}"))
+            sys.exit(0 if reply[0] == 0 else 1)
+
+        elif args.command == 'metrics':
+            port.write(build_frame(METRICS, seq))
+            while True:
+                frame = reader.next_frame(args.timeout)
+                if frame is None:
+                    print("Timed out waiting for metrics")
+                    sys.exit(1)
+                reply_type, reply_seq, body = frame
+                if reply_type != METRICS | REPLY or reply_seq != seq:
+                    continue
+                if not body:
+                    break
+                print(body.decode("utf-8", errors="replace"))
+
+if __name__ == "__main__":
+    main()
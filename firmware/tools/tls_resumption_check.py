@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""
+Measure per-phase reconnect timing and demonstrate TLS session resumption.
+
+Usage:
+1. Local demo (starts a throwaway TLS server on 127.0.0.1):
+   python tls_resumption_check.py --attempts 5
+2. Compare against a full handshake on every attempt:
+   python tls_resumption_check.py --attempts 5 --no-resume --no-dns-cache
+3. Probe the real endpoint the firmware connects to:
+   python tls_resumption_check.py --host api.elevenlabs.io --port 443
+4. Check that its certificate chains to a root the firmware ships:
+   python tls_resumption_check.py --host api.elevenlabs.io --firmware-roots
+
+Each attempt is split into the same phases the firmware reports
+(DNS, TCP, TLS, WebSocket upgrade) so the numbers can be compared with the
+"[WS_CLIENT] Connect #n" lines printed over serial.
+
+Note: the local server needs the `openssl` command line tool to generate a
+self-signed certificate.
+"""
+
+import argparse
+import os
+import re
+import socket
+import ssl
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+CA_BUNDLE = os.path.join(TOOLS_DIR, "..", "src", "communication", "ca_bundle.cpp")
+
+UPGRADE_RESPONSE = (
+    b"HTTP/1.1 101 Switching Protocols\r\n"
+    b"Upgrade: websocket\r\n"
+    b"Connection: Upgrade\r\n"
+    b"Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n\r\n"
+)
+
+def generate_certificate(directory):
+    """Generate a self-signed certificate for localhost."""
+    cert_path = os.path.join(directory, "cert.pem")
+    key_path = os.path.join(directory, "key.pem")
+    try:
+        subprocess.run(
+            ["openssl", "req", "-x509", "-newkey", "rsa:2048", "-nodes",
+             "-keyout", key_path, "-out", cert_path, "-days", "1",
+             "-subj", "/CN=localhost", "-addext", "subjectAltName=DNS:localhost,IP:127.0.0.1"],
+            check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    except (OSError, subprocess.CalledProcessError) as e:
+        print(f"Error generating certificate: {e}")
+        return None, None
+    return cert_path, key_path
+
+def serve_tls(server_socket, context, stop_event):
+    """Accept connections and answer each upgrade request with a 101."""
+    server_socket.settimeout(0.2)
+    while not stop_event.is_set():
+        try:
+            raw, _ = server_socket.accept()
+        except socket.timeout:
+            continue
+        raw.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        try:
+            with context.wrap_socket(raw, server_side=True) as conn:
+                request = b""
+                while b"\r\n\r\n" not in request:
+                    data = conn.recv(4096)
+                    if not data:
+                        break
+                    request += data
+                conn.sendall(UPGRADE_RESPONSE)
+                conn.recv(1)  # Wait for the client to close
+        except (ssl.SSLError, OSError):
+            pass
+
+def start_local_server(cert_path, key_path, tls_version):
+    """Start the TLS server thread, returning (port, stop_event)."""
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.load_cert_chain(cert_path, key_path)
+    if tls_version == "1.2":
+        context.maximum_version = ssl.TLSVersion.TLSv1_2
+
+    server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server_socket.bind(("127.0.0.1", 0))
+    server_socket.listen(4)
+
+    stop_event = threading.Event()
+    thread = threading.Thread(target=serve_tls, args=(server_socket, context, stop_event), daemon=True)
+    thread.start()
+    return server_socket.getsockname()[1], stop_event
+
+def load_firmware_roots():
+    """Read the PEM roots out of the C string literals in ca_bundle.cpp."""
+    with open(CA_BUNDLE) as f:
+        lines = re.findall(r'^\s*"(.*)\\n";?$', f.read(), re.M)
+    return "\n".join(lines) + "\n"
+
+def check_firmware_roots(host, port):
+    """Verify the server against the firmware's roots only; return True if it chains to one."""
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    context.load_verify_locations(cadata=load_firmware_roots())
+    print(f"Firmware CA bundle: {len(context.get_ca_certs())} roots")
+    try:
+        with socket.create_connection((host, port), timeout=10) as raw:
+            with context.wrap_socket(raw, server_hostname=host) as tls:
+                issuer = dict(item[0] for item in tls.getpeercert()["issuer"])
+                print(f"{host} verified; certificate issued by {issuer.get('commonName', issuer)}")
+    except ssl.SSLCertVerificationError as e:
+        print(f"{host} does not chain to a firmware root: {e.verify_message}")
+        return False
+    except (OSError, ssl.SSLError) as e:
+        print(f"Cannot connect to {host}: {e}")
+        return False
+    return True
+
+def connect_once(host, port, context, session, dns_cache, path):
+    """Run one connect attempt and return (timings_ms, session, reused)."""
+    timings = {}
+
+    start = time.perf_counter()
+    if dns_cache is not None and host in dns_cache:
+        address = dns_cache[host]
+    else:
+        address = socket.getaddrinfo(host, port, socket.AF_INET, socket.SOCK_STREAM)[0][4]
+        if dns_cache is not None:
+            dns_cache[host] = address
+    timings["dns"] = (time.perf_counter() - start) * 1000
+
+    start = time.perf_counter()
+    raw = socket.create_connection(address, timeout=10)
+    raw.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    timings["tcp"] = (time.perf_counter() - start) * 1000
+
+    start = time.perf_counter()
+    tls = context.wrap_socket(raw, server_hostname=host, session=session)
+    timings["tls"] = (time.perf_counter() - start) * 1000
+    reused = tls.session_reused
+
+    start = time.perf_counter()
+    request = (f"GET {path} HTTP/1.1\r\nHost: {host}\r\nUpgrade: websocket\r\n"
+               f"Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+               f"Sec-WebSocket-Version: 13\r\n\r\n")
+    tls.sendall(request.encode())
+    response = b""
+    while b"\r\n\r\n" not in response:
+        data = tls.recv(4096)
+        if not data:
+            break
+        response += data
+    timings["upgrade"] = (time.perf_counter() - start) * 1000
+
+    # TLS 1.3 tickets arrive after the handshake, so grab the session last
+    new_session = tls.session
+    tls.close()
+    return timings, new_session, reused
+
+def main():
+    parser = argparse.ArgumentParser(description='Measure reconnect phases and TLS session resumption')
+    parser.add_argument('--host', default=None,
+                       help='Remote host to probe (default: start a local TLS server)')
+    parser.add_argument('--port', type=int, default=443,
+                       help='Remote port (default: 443)')
+    parser.add_argument('--path', default='/v1/convai/conversation',
+                       help='Upgrade request path')
+    parser.add_argument('--attempts', type=int, default=5,
+                       help='Number of connect attempts (default: 5)')
+    parser.add_argument('--tls-version', choices=['1.2', '1.3'], default='1.3',
+                       help='Highest TLS version to negotiate (default: 1.3)')
+    parser.add_argument('--no-resume', action='store_true',
+                       help='Do a full handshake on every attempt')
+    parser.add_argument('--no-dns-cache', action='store_true',
+                       help='Resolve the host on every attempt')
+    parser.add_argument('--firmware-roots', action='store_true',
+                       help='Only check that --host chains to a root in src/communication/ca_bundle.cpp')
+
+    args = parser.parse_args()
+
+    if args.firmware_roots:
+        if args.host is None:
+            print("Error: --firmware-roots needs --host")
+            sys.exit(2)
+        sys.exit(0 if check_firmware_roots(args.host, args.port) else 1)
+
+    context = ssl.create_default_context()
+    if args.tls_version == "1.2":
+        context.maximum_version = ssl.TLSVersion.TLSv1_2
+
+    stop_event = None
+    host, port = args.host, args.port
+    tmpdir = tempfile.TemporaryDirectory()
+    if host is None:
+        cert_path, key_path = generate_certificate(tmpdir.name)
+        if cert_path is None:
+            sys.exit(1)
+        port, stop_event = start_local_server(cert_path, key_path, args.tls_version)
+        host = "localhost"
+        context.load_verify_locations(cert_path)
+        print(f"Local TLS server listening on {host}:{port}")
+
+    dns_cache = None if args.no_dns_cache else {}
+    session = None
+    totals = []
+
+    print(f"{'#':>3} {'dns':>8} {'tcp':>8} {'tls':>8} {'upgrade':>8} {'total':>8}  resumed")
+    for attempt in range(args.attempts):
+        try:
+            timings, new_session, reused = connect_once(host, port, context, session, dns_cache, args.path)
+        except (OSError, ssl.SSLError) as e:
+            print(f"Attempt {attempt} failed: {e}")
+            sys.exit(1)
+        if not args.no_resume:
+            session = new_session
+
+        total = sum(timings.values())
+        totals.append((total, reused))
+        print(f"{attempt:>3} {timings['dns']:>7.1f}ms {timings['tcp']:>6.1f}ms {timings['tls']:>6.1f}ms "
+              f"{timings['upgrade']:>6.1f}ms {total:>6.1f}ms  {'yes' if reused else 'no'}")
+
+    if stop_event is not None:
+        stop_event.set()
+
+    full = [t for t, reused in totals if not reused]
+    resumed = [t for t, reused in totals if reused]
+    if full:
+        print(f"Full handshake average: {sum(full) / len(full):.1f} ms ({len(full)} attempts)")
+    if resumed:
+        print(f"Resumed handshake average: {sum(resumed) / len(resumed):.1f} ms ({len(resumed)} attempts)")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Conversation trace helper.
+
+Usage:
+1. Record on the device: type 'trace', talk to the robot, type 'trace' again
+2. Type 'dump' and capture the serial output to a file
+3. Extract the trace:
+   python trace_tool.py extract serial_output.txt session.trace
+4. Inspect it, or replay it through the host build of the client:
+   python trace_tool.py info session.trace
+   .pio/build/host/program --replay session.trace --repeat 20 --quiet
+
+Trace layout (little-endian): "ELTRACE1", uint32 version, uint32 reserved,
+then per message uint32 timestamp_ms, uint32 length, uint8 kind (0 text,
+1 binary), 3 reserved bytes and the payload.
+"""
+
+import argparse
+import base64
+import json
+import struct
+import sys
+from collections import OrderedDict
+
+MAGIC = b"ELTRACE1"
+HEADER = struct.Struct("<8sII")
+RECORD = struct.Struct("<IIB3x")
+
+def extract(log_path, trace_path):
+    """Rebuild a trace from TRACE: lines in a serial capture."""
+    chunks = []
+    expected = None
+    inside = False
+
+    try:
+        with open(log_path, "r", encoding="utf-8", errors="replace") as f:
+            for line in f:
+                line = line.strip()
+                if line.startswith("TRACE_BEGIN"):
+                    chunks = []
+                    inside = True
+                    parts = line.split()
+                    expected = int(parts[1]) if len(parts) > 1 else None
+                elif line.startswith("TRACE_END"):
+                    inside = False
+                elif inside and line.startswith("TRACE:"):
+                    chunks.append(line[len("TRACE:"):])
+    except OSError as e:
+        print(f"Error reading log: {e}")
+        return False
+
+    if not chunks:
+        print("No TRACE: lines found - did you run 'dump' on the device?")
+        return False
+
+    try:
+        data = b"".join(base64.b64decode(chunk) for chunk in chunks)
+    except ValueError as e:
+        print(f"Base64 decode error: {e}")
+        return False
+
+    if expected is not None and len(data) != expected:
+        print(f"Warning: expected {expected} bytes, got {len(data)} (lost serial lines?)")
+
+    with open(trace_path, "wb") as f:
+        f.write(data)
+    print(f"Wrote {len(data)} bytes to {trace_path}")
+    return True
+
+def read_records(data):
+    magic, version, _ = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != 1:
+        raise ValueError("not a version 1 trace")
+
+    offset = HEADER.size
+    while offset + RECORD.size <= len(data):
+        timestamp, length, kind = RECORD.unpack_from(data, offset)
+        offset += RECORD.size
+        if offset + length > len(data):
+            break
+        yield timestamp, kind, data[offset:offset + length]
+        offset += length
+
+def info(trace_path):
+    """Print per-type counts and sizes of a trace."""
+    try:
+        with open(trace_path, "rb") as f:
+            data = f.read()
+        records = list(read_records(data))
+    except (OSError, ValueError, struct.error) as e:
+        print(f"Error reading trace: {e}")
+        return False
+
+    types = OrderedDict()
+    for _, kind, payload in records:
+        name = "binary"
+        if kind == 0:
+            try:
+                name = json.loads(payload).get("type", "unknown")
+            except ValueError:
+                name = "invalid-json"
+        count, total = types.get(name, (0, 0))
+        types[name] = (count + 1, total + len(payload))
+
+    duration = records[-1][0] / 1000.0 if records else 0.0
+    print(f"{trace_path}: {len(records)} messages, {len(data)} bytes, {duration:.1f} s")
+    print(f"{'type':<36} {'count':>7} {'bytes':>10} {'avg':>8}")
+    for name, (count, total) in types.items():
+        print(f"{name:<36} {count:>7} {total:>10} {total // count:>8}")
+    return True
+
+def main():
+    parser = argparse.ArgumentParser(description='Extract and inspect conversation traces')
+    commands = parser.add_subparsers(dest='command')
+
+    extract_parser = commands.add_parser('extract', help='Rebuild a trace from a serial capture')
+    extract_parser.add_argument('log', help='Serial output containing TRACE: lines')
+    extract_parser.add_argument('trace', help='Output trace file')
+
+    info_parser = commands.add_parser('info', help='Summarize a trace')
+    info_parser.add_argument('trace', help='Trace file')
+
+    args = parser.parse_args()
+    if args.command == 'extract':
+        ok = extract(args.log, args.trace)
+    elif args.command == 'info':
+        ok = info(args.trace)
+    else:
+        parser.print_help()
+        ok = False
+
+    sys.exit(0 if ok else 1)
+
+if __name__ == "__main__":
+    main()
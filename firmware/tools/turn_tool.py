@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+Per-turn latency records helper.
+
+Usage:
+1. On the device, have a few turns of conversation, then type 'turns' and
+   capture the serial output to a file
+2. Extract the records:
+   python turn_tool.py extract serial_output.txt session.turns
+3. Print the per-turn breakdown and per-stage percentiles, or a CSV:
+   python turn_tool.py info session.turns
+   python turn_tool.py csv session.turns > turns.csv
+
+The host build writes the same file with --turn-trace FILE.
+
+Layout (little-endian): "TURN", uint8 version, uint8 point count, uint16
+record count, then per turn uint32 turn, uint32 start_ms and uint16
+offset_ms per point (0xFFFF: not reached), in the order of POINTS.
+"""
+
+import argparse
+import base64
+import struct
+import sys
+
+MAGIC = b"TURN"
+HEADER = struct.Struct("<4sBBH")
+NOT_SEEN = 0xFFFF
+
+POINTS = ["mic_capture", "uplink_sent", "user_transcript", "agent_response",
+          "first_audio", "first_sample", "playback_end"]
+STAGES = ["uplink", "stt", "llm", "tts", "buffer", "play"]
+
+def extract(log_path, turns_path):
+    """Rebuild the records from TURNS: lines in a serial capture."""
+    chunks = []
+    expected = None
+    inside = False
+
+    try:
+        with open(log_path, "r", encoding="utf-8", errors="replace") as f:
+            for line in f:
+                line = line.strip()
+                if line.startswith("TURNS_BEGIN"):
+                    chunks = []
+                    inside = True
+                    parts = line.split()
+                    expected = int(parts[1]) if len(parts) > 1 else None
+                elif line.startswith("TURNS_END"):
+                    inside = False
+                elif inside and line.startswith("TURNS:"):
+                    chunks.append(line[len("TURNS:"):])
+    except OSError as e:
+        print(f"Error reading log: {e}")
+        return False
+
+    if not chunks:
+        print("No TURNS: lines found - did you run 'turns' on the device?")
+        return False
+
+    try:
+        data = b"".join(base64.b64decode(chunk) for chunk in chunks)
+    except ValueError as e:
+        print(f"Base64 decode error: {e}")
+        return False
+
+    if expected is not None and len(data) != expected:
+        print(f"Warning: expected {expected} bytes, got {len(data)} (lost serial lines?)")
+
+    with open(turns_path, "wb") as f:
+        f.write(data)
+    print(f"Wrote {len(data)} bytes to {turns_path}")
+    return True
+
+def read_turns(data):
+    magic, version, points, count = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != 1:
+        raise ValueError("not a version 1 turn file")
+
+    record = struct.Struct(f"<II{points}H")
+    offset = HEADER.size
+    for _ in range(count):
+        turn, start_ms, *offsets = record.unpack_from(data, offset)
+        offset += record.size
+        yield turn, start_ms, [None if o == NOT_SEEN else o for o in offsets]
+
+def stage_ms(offsets, stage):
+    start, end = offsets[stage], offsets[stage + 1]
+    if start is None or end is None or end < start:
+        return None
+    return end - start
+
+def first_sound_ms(offsets):
+    mic, sample = offsets[0], offsets[5]
+    if mic is None or sample is None or sample < mic:
+        return None
+    return sample - mic
+
+def percentile(values, percent):
+    """Nearest rank, as on the device."""
+    values = sorted(values)
+    rank = max(1, -(-percent * len(values) // 100))
+    return values[rank - 1]
+
+def load(turns_path):
+    with open(turns_path, "rb") as f:
+        return list(read_turns(f.read()))
+
+def info(turns_path):
+    """Print each turn's stages and the per-stage p50/p95/max."""
+    try:
+        turns = load(turns_path)
+    except (OSError, ValueError, struct.error) as e:
+        print(f"Error reading turns: {e}")
+        return False
+
+    columns = STAGES + ["first_sound"]
+    print(f"{'turn':>6} " + " ".join(f"{name:>11}" for name in columns))
+    series = {name: [] for name in columns}
+    for turn, _, offsets in turns:
+        values = [stage_ms(offsets, i) for i in range(len(STAGES))] + [first_sound_ms(offsets)]
+        for name, value in zip(columns, values):
+            if value is not None:
+                series[name].append(value)
+        print(f"{turn:>6} " + " ".join(f"{'-' if v is None else v:>11}" for v in values))
+
+    print()
+    print(f"{'stage':<12} {'n':>5} {'p50':>7} {'p95':>7} {'max':>7}")
+    for name in columns:
+        values = series[name]
+        if values:
+            print(f"{name:<12} {len(values):>5} {percentile(values, 50):>7} "
+                  f"{percentile(values, 95):>7} {max(values):>7}")
+        else:
+            print(f"{name:<12} {0:>5} {'-':>7} {'-':>7} {'-':>7}")
+    return True
+
+def csv(turns_path):
+    """Print one row per turn with the raw point offsets."""
+    try:
+        turns = load(turns_path)
+    except (OSError, ValueError, struct.error) as e:
+        print(f"Error reading turns: {e}", file=sys.stderr)
+        return False
+
+    print(",".join(["turn", "start_ms"] + POINTS))
+    for turn, start_ms, offsets in turns:
+        print(",".join([str(turn), str(start_ms)] + ["" if o is None else str(o) for o in offsets]))
+    return True
+
+def main():
+    parser = argparse.ArgumentParser(description='Extract and inspect per-turn latency records')
+    commands = parser.add_subparsers(dest='command')
+
+    extract_parser = commands.add_parser('extract', help='Rebuild the records from a serial capture')
+    extract_parser.add_argument('log', help='Serial output containing TURNS: lines')
+    extract_parser.add_argument('turns', help='Output file')
+
+    info_parser = commands.add_parser('info', help='Per-turn breakdown and stage percentiles')
+    info_parser.add_argument('turns', help='Turn file')
+
+    csv_parser = commands.add_parser('csv', help='Raw point offsets as CSV')
+    csv_parser.add_argument('turns', help='Turn file')
+
+    args = parser.parse_args()
+    if args.command == 'extract':
+        ok = extract(args.log, args.turns)
+    elif args.command == 'info':
+        ok = info(args.turns)
+    elif args.command == 'csv':
+        ok = csv(args.turns)
+    else:
+        parser.print_help()
+        ok = False
+
+    sys.exit(0 if ok else 1)
+
+if __name__ == "__main__":
+    main()